@@ -0,0 +1,97 @@
+/* ROI acquisition: a packetized replay (the USB frame assembly path) run
+   as fast as it goes with the whole sensor and with smaller windows.
+   Reports the assembly cost per frame and the bytes kept, and checks every
+   delivered window against the same crop of the source frame.
+   Usage: bench_acquire [frames]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define REC_PATH "bench_acquire.tc1r"
+
+typedef struct { int x, y, w, h; const char* name; } window;
+
+static const window* cur;
+static uint16_t src[BENCH_W * BENCH_H];
+static int frames, wrong, recorded;
+
+static void check(const tc001_frame* f, void* user) {
+    (void)user;
+    frames++;
+    if (f->width != cur->w || f->height != cur->h || f->stride != cur->w * 2) { wrong++; return; }
+    /* ids keep counting on the second pass */
+    bench_fill_scene(src, BENCH_W, BENCH_H, (int)(f->frame_id % (uint32_t)recorded));
+    for (int y = 0; y < f->height; ++y) {
+        if (memcmp(f->data + (size_t)y * f->stride, src + (cur->y + y) * BENCH_W + cur->x,
+                   (size_t)f->width * 2)) {
+            wrong++;
+            return;
+        }
+    }
+}
+
+static void nothing(const tc001_frame* f, void* user) { (void)f; (void)user; }
+
+static void wait_done(tc001_handle* h) {
+    while (!tc001_replay_done(h)) {
+#ifdef _WIN32
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+}
+
+int main(int argc, char** argv) {
+    const int n = recorded = argc > 1 ? atoi(argv[1]) : 1000;
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < n; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    const window windows[] = {
+        { 0, 0, BENCH_W, BENCH_H, "whole sensor" },
+        { 64, 48, 128, 96, "128x96 centre" },
+        { 96, 72, 64, 48, "64x48 centre" },
+        { 0, 0, BENCH_W, 48, "top 48 rows" },
+        { 5, 3, 17, 11, "17x11, odd offsets" },
+    };
+    double whole_us = 0;
+    for (size_t k = 0; k < sizeof(windows) / sizeof(windows[0]); ++k) {
+        cur = &windows[k];
+        tc001_replay_options ro = { 0.0, 0, 0, 1 };
+        char err[256];
+        tc001_handle* h;
+        if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) { printf("%s\n", err); return 1; }
+        if (tc001_set_acquisition_roi(h, cur->x, cur->y, cur->w, cur->h) != TC001_OK) return 1;
+
+        /* timed pass with an empty callback, then a checked one */
+        const double t0 = bench_now_s();
+        tc001_start(h, nothing, NULL, err, sizeof err);
+        wait_done(h);
+        const double us = (bench_now_s() - t0) * 1e6 / n;
+        tc001_stop(h);
+        if (!k) whole_us = us;
+
+        frames = wrong = 0;
+        tc001_start(h, check, NULL, err, sizeof err);
+        wait_done(h);
+        tc001_close(h);
+        printf("%-20s %6.1f us/frame (%3.0f%%), %6zu bytes kept, %d frames, %d wrong\n", cur->name, us,
+               100.0 * us / whole_us, (size_t)cur->w * cur->h * 2, frames, wrong);
+    }
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
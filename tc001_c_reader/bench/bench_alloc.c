@@ -0,0 +1,117 @@
+/* Buffer allocation: a packetized replay (the device's frame assembly
+   path) with a frame pool, its buffers from the default heap, from an
+   arena through tc001_set_allocator, and in huge pages. A kernel sums
+   every delivered frame. Reports the cost per frame, the kernel's share,
+   and checks every frame is TC001_BUFFER_ALIGN aligned and, with the
+   arena, inside it. USB_DMA needs a device and is not run.
+   Usage: bench_alloc [frames]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define REC_PATH "bench_alloc.tc1r"
+#define ARENA    (16u << 20)
+
+static uint8_t* arena;
+static size_t arena_used;
+static int arena_allocs, arena_frees;
+static int in_arena;
+static uint64_t frames, misaligned, outside, sum;
+static double kernel_s;
+
+static void* arena_alloc(size_t size, size_t align, void* user) {
+    (void)user;
+    const size_t at = (size_t)((((uintptr_t)arena + arena_used + align - 1) & ~(uintptr_t)(align - 1)) -
+                               (uintptr_t)arena);
+    if (at + size > ARENA) return NULL;
+    arena_used = at + size;
+    arena_allocs++;
+    return arena + at;
+}
+
+static void arena_free(void* p, size_t size, void* user) {
+    (void)p;
+    (void)size;
+    (void)user;
+    arena_frees++;
+}
+
+static void kernel(const tc001_frame* f, void* user) {
+    (void)user;
+    frames++;
+    if ((uintptr_t)f->data % TC001_BUFFER_ALIGN) misaligned++;
+    if (in_arena && (f->data < arena || f->data >= arena + ARENA)) outside++;
+    const double t0 = bench_now_s();
+    const uint16_t* px = (const uint16_t*)f->data;
+    uint64_t s = 0;
+    for (int i = 0; i < f->width * f->height; ++i) s += px[i];
+    sum += s;
+    kernel_s += bench_now_s() - t0;
+}
+
+static int play(const char* name, int backing, int n) {
+    tc001_handle* h;
+    tc001_replay_options ro = { 0.0, 0, 0, 1 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) { printf("%s\n", err); exit(1); }
+    if (backing && tc001_set_buffer_backing(h, backing) != TC001_OK) {
+        printf("%-16s unavailable here\n", name);
+        tc001_close(h);
+        return 0;
+    }
+    if (tc001_set_frame_pool(h, 8) != TC001_OK) exit(1);
+    frames = misaligned = outside = 0;
+    kernel_s = 0;
+    const double t0 = bench_now_s();
+    tc001_start(h, kernel, NULL, err, sizeof err);
+    while (!tc001_replay_done(h)) {
+#ifdef _WIN32
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+    const double us = (bench_now_s() - t0) * 1e6 / n;
+    tc001_stop(h);
+    const tc001_status busy = tc001_set_allocator(NULL, NULL, NULL);
+    tc001_close(h);
+    printf("%-16s %6.1f us/frame, kernel %5.1f us; %llu frames, %llu misaligned, %llu outside the arena; "
+           "allocator swap while open: %s\n", name, us, kernel_s * 1e6 / n, (unsigned long long)frames,
+           (unsigned long long)misaligned, (unsigned long long)outside,
+           busy == TC001_ERR_STATE ? "refused" : "ALLOWED");
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? atoi(argv[1]) : 2000;
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < n; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    play("heap", 0, n);
+    arena = (uint8_t*)malloc(ARENA);
+    if (!arena || tc001_set_allocator(arena_alloc, arena_free, NULL) != TC001_OK) return 1;
+    in_arena = 1;
+    play("arena", 0, n);
+    printf("                 arena: %d allocations, %d frees, %zu bytes\n", arena_allocs, arena_frees,
+           arena_used);
+    in_arena = 0;
+    tc001_set_allocator(NULL, NULL, NULL);
+    play("huge pages", TC001_BACKING_HUGEPAGES, n);
+    free(arena);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
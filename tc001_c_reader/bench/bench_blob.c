@@ -0,0 +1,169 @@
+/* Hot/cold blob cost per frame (tc001_find_blobs) for raw and percentile
+   thresholds, 4- and 8-connectivity and a top-k cut, against a naive
+   flood-fill labeller. Every blob's area, centroid, bounding box and peak
+   is compared with the labeller's, in the same order (largest first).
+   Usage: bench_blob [iters]. */
+#include "bench_util.h"
+#include <math.h>
+#include <string.h>
+
+#define CAP     4096    /* output slots when nothing is cut */
+#define FRAMES  8       /* checked against the labeller */
+
+typedef struct {
+    const char* name;
+    tc001_blob_config cfg;
+    int cap;
+} test_case;
+
+static int cmp_u16(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+/* Same order as the library: largest first, then top-left first */
+static int blob_order(const void* a, const void* b) {
+    const tc001_blob* x = (const tc001_blob*)a;
+    const tc001_blob* y = (const tc001_blob*)b;
+    if (x->area != y->area) return x->area < y->area ? 1 : -1;
+    if (x->y0 != y->y0) return x->y0 < y->y0 ? -1 : 1;
+    return x->x0 < y->x0 ? -1 : (x->x0 > y->x0);
+}
+
+/* ===== Naive labeller ===== */
+static uint16_t percentile(const uint16_t* px, int n, float pct, uint16_t* sorted) {
+    memcpy(sorted, px, (size_t)n * 2);
+    qsort(sorted, (size_t)n, 2, cmp_u16);
+    return sorted[(size_t)((double)(n - 1) * pct / 100.0 + 0.5)];
+}
+
+static void flood(const uint16_t* px, int w, int h, const uint8_t* in, int* label, int* stack,
+                  int conn8, int start, int id, tc001_blob* b) {
+    int sp = 0;
+    double sx = 0, sy = 0;
+    memset(b, 0, sizeof(*b));
+    b->x0 = b->y0 = 0xFFFF;
+    label[start] = id;
+    stack[sp++] = start;
+    while (sp) {
+        const int i = stack[--sp], x = i % w, y = i / w;
+        b->area++;
+        sx += x;
+        sy += y;
+        if (x < b->x0) b->x0 = (uint16_t)x;
+        if (x > b->x1) b->x1 = (uint16_t)x;
+        if (y < b->y0) b->y0 = (uint16_t)y;
+        if (y > b->y1) b->y1 = (uint16_t)y;
+        if (b->area == 1 || (in[i] == 1 ? px[i] > b->peak_raw : px[i] < b->peak_raw)) b->peak_raw = px[i];
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((!dx && !dy) || (!conn8 && dx && dy)) continue;
+                const int nx = x + dx, ny = y + dy, j = ny * w + nx;
+                if (nx < 0 || ny < 0 || nx >= w || ny >= h || in[j] != in[i] || label[j]) continue;
+                label[j] = id;
+                stack[sp++] = j;
+            }
+        }
+    }
+    b->cx = (float)(sx / b->area);
+    b->cy = (float)(sy / b->area);
+    b->hot = in[start] == 1;
+}
+
+/* in[] is 1 for hot, 2 for cold, 0 for neither */
+static int naive_blobs(const uint16_t* px, int w, int h, const tc001_blob_config* cfg, int cap,
+                       tc001_blob* out, uint8_t* in, int* label, int* stack, uint16_t* sorted) {
+    const int n = w * h;
+    int hot_on = cfg->find_hot, cold_on = cfg->find_cold;
+    int hot = cfg->hot_raw, cold = cfg->cold_raw;
+    if (cfg->mode == TC001_BLOB_PERCENTILE) {
+        hot = percentile(px, n, cfg->hot_pct, sorted) + 1;
+        cold = percentile(px, n, cfg->cold_pct, sorted) - 1;
+    }
+    for (int i = 0; i < n; ++i)
+        in[i] = hot_on && px[i] >= hot ? 1 : cold_on && px[i] <= cold ? 2 : 0;
+    memset(label, 0, (size_t)n * sizeof(int));
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!in[i] || label[i]) continue;
+        tc001_blob b;
+        flood(px, w, h, in, label, stack, cfg->connectivity == 8, i, count + 1, &b);
+        if (b.area >= cfg->min_area) out[count++] = b;
+    }
+    qsort(out, (size_t)count, sizeof(tc001_blob), blob_order);
+    return count < cap ? count : cap;
+}
+
+/* ===== Scene ===== */
+/* The bench scene plus a cold patch, a diagonal chain (one blob under
+   8-connectivity, many under 4) and a row of small hot spots */
+static void fill(uint16_t* px, int w, int h, int seed) {
+    bench_fill_scene(px, w, h, seed);
+    for (int y = 20; y < 40; ++y)
+        for (int x = 180 + seed % 9; x < 220; ++x) px[y * w + x] = 15000;
+    for (int i = 0; i < 30; ++i) px[(150 - i) * w + 20 + i] = 30000;
+    for (int i = 0; i < 12; ++i)
+        for (int d = 0; d < 1 + i % 4; ++d) px[(170 + d) * w + 10 + i * 20 + d] = 25000;
+}
+
+static int same(const tc001_blob* a, const tc001_blob* b) {
+    return a->area == b->area && a->hot == b->hot && a->peak_raw == b->peak_raw &&
+           a->x0 == b->x0 && a->y0 == b->y0 && a->x1 == b->x1 && a->y1 == b->y1 &&
+           fabsf(a->cx - b->cx) < 1e-3f && fabsf(a->cy - b->cy) < 1e-3f;
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 500;
+    const int w = BENCH_W, h = BENCH_H, n = w * h;
+    static const test_case cases[] = {
+        { "raw, 4-connected",        { TC001_BLOB_RAW, 18600, 16000, 0, 0, 1, 1, 4, 1, 0 }, CAP },
+        { "raw, 8-connected",        { TC001_BLOB_RAW, 18600, 16000, 0, 0, 1, 1, 8, 1, 0 }, CAP },
+        { "raw noise, top 8",        { TC001_BLOB_RAW, 18014, 18001, 0, 0, 1, 1, 8, 1, 0 }, 8 },
+        { "percentile 99/1, 8-conn", { TC001_BLOB_PERCENTILE, 0, 0, 99.f, 1.f, 1, 1, 8, 1, 0 }, CAP },
+        { "percentile 90/10, 4-conn", { TC001_BLOB_PERCENTILE, 0, 0, 90.f, 10.f, 1, 1, 4, 2, 0 }, CAP },
+    };
+
+    uint16_t* px = (uint16_t*)malloc((size_t)n * 2);
+    uint16_t* sorted = (uint16_t*)malloc((size_t)n * 2);
+    uint8_t* in = (uint8_t*)malloc((size_t)n);
+    int* label = (int*)malloc((size_t)n * sizeof(int));
+    int* stack = (int*)malloc((size_t)n * sizeof(int));
+    tc001_blob* got = (tc001_blob*)malloc(CAP * sizeof(tc001_blob));
+    tc001_blob* want = (tc001_blob*)malloc((size_t)n * sizeof(tc001_blob));
+    if (!px || !sorted || !in || !label || !stack || !got || !want) return 1;
+    tc001_frame f = bench_frame(px, w, h);
+
+    for (size_t c = 0; c < sizeof cases / sizeof cases[0]; ++c) {
+        const test_case* t = &cases[c];
+        int count = 0, blobs = 0, wrong = 0;
+        for (int i = 0; i < FRAMES; ++i) {
+            fill(px, w, h, i);
+            if (tc001_find_blobs(&f, &t->cfg, NULL, got, t->cap, &count) != TC001_OK) return 1;
+            const int expect = naive_blobs(px, w, h, &t->cfg, t->cap, want, in, label, stack, sorted);
+            if (count != expect) wrong++;
+            for (int k = 0; k < count && k < expect; ++k)
+                if (!same(&got[k], &want[k])) wrong++;
+            blobs += expect;
+        }
+
+        double t0 = bench_now_s();
+        for (int i = 0; i < iters; ++i)
+            if (tc001_find_blobs(&f, &t->cfg, NULL, got, t->cap, &count) != TC001_OK) return 1;
+        const double us = (bench_now_s() - t0) * 1e6 / iters;
+        const int naive_iters = iters / 10 > 0 ? iters / 10 : 1;
+        t0 = bench_now_s();
+        for (int i = 0; i < naive_iters; ++i)
+            naive_blobs(px, w, h, &t->cfg, t->cap, want, in, label, stack, sorted);
+        const double naive_us = (bench_now_s() - t0) * 1e6 / naive_iters;
+        printf("%-25s %8.1f us/frame (flood fill %8.1f); %5.1f blobs/frame, %d wrong\n", t->name, us,
+               naive_us, (double)blobs / FRAMES, wrong);
+    }
+
+    free(px);
+    free(sorted);
+    free(in);
+    free(label);
+    free(stack);
+    free(got);
+    free(want);
+    return 0;
+}
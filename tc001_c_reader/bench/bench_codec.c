@@ -0,0 +1,70 @@
+/* Lossless codec: round-trip check, compression ratio and encode/decode
+   throughput over a moving synthetic scene, with a keyframe every 25
+   frames. Also reports how many 25 fps cameras one core could encode. */
+#include "bench_util.h"
+#include "tc001_codec.h"
+#include <string.h>
+
+#define SEQ_LEN 50
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 20;
+    const int w = BENCH_W, h = BENCH_H;
+    const size_t raw = (size_t)w * h * 2, cap = tc001_codec_max_bytes(w, h);
+
+    uint16_t* seq = (uint16_t*)malloc(raw * SEQ_LEN);
+    uint16_t* out = (uint16_t*)malloc(raw);
+    uint8_t* enc = (uint8_t*)malloc(cap * SEQ_LEN);
+    size_t* len = (size_t*)malloc(sizeof(size_t) * SEQ_LEN);
+    tc001_codec* e = NULL;
+    tc001_codec* d = NULL;
+    if (!seq || !out || !enc || !len) return 1;
+    if (tc001_codec_create(&e, w, h) != TC001_OK || tc001_codec_create(&d, w, h) != TC001_OK) return 1;
+    for (int i = 0; i < SEQ_LEN; ++i) bench_fill_scene(seq + (size_t)i * w * h, w, h, i);
+
+    /* round trip */
+    size_t total = 0;
+    for (int i = 0; i < SEQ_LEN; ++i) {
+        tc001_frame f = bench_frame(seq + (size_t)i * w * h, w, h);
+        if (tc001_encode_frame(e, &f, i % 25 == 0, enc + cap * i, cap, &len[i]) != TC001_OK ||
+            tc001_decode_frame(d, enc + cap * i, len[i], out, w * 2) != TC001_OK ||
+            memcmp(out, f.data, raw) != 0) {
+            printf("round trip FAILED at frame %d\n", i);
+            return 1;
+        }
+        total += len[i];
+    }
+    printf("round trip ok, %d frames, ratio %.2fx (%.0f bytes/frame)\n",
+           SEQ_LEN, (double)raw * SEQ_LEN / total, (double)total / SEQ_LEN);
+
+    double t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        tc001_codec_reset(e);
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            tc001_frame f = bench_frame(seq + (size_t)i * w * h, w, h);
+            tc001_encode_frame(e, &f, i % 25 == 0, enc + cap * i, cap, &len[i]);
+        }
+    }
+    double te = bench_now_s() - t0;
+    bench_report("encode", iters * SEQ_LEN, te, raw);
+
+    t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        tc001_codec_reset(d);
+        for (int i = 0; i < SEQ_LEN; ++i)
+            tc001_decode_frame(d, enc + cap * i, len[i], out, w * 2);
+    }
+    double td = bench_now_s() - t0;
+    bench_report("decode", iters * SEQ_LEN, td, raw);
+
+    printf("25 fps cameras per core: encode %.0f, decode %.0f\n",
+           iters * SEQ_LEN / te / 25.0, iters * SEQ_LEN / td / 25.0);
+
+    tc001_codec_destroy(e);
+    tc001_codec_destroy(d);
+    free(seq);
+    free(out);
+    free(enc);
+    free(len);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* tc001d serving a looping recording to 32 clients (separate threads,
+   each with its own connection and mapping): 16 raw U16, 8 U8 at half
+   rate and 8 palette RGB. Reports the attach time seen by the clients and
+   the daemon, the daemon's cost per camera frame, and what every client
+   received. Usage: bench_daemon [seconds] [speed]. POSIX only. */
+#include "bench_util.h"
+#include "tc001_daemon.h"
+#include "tc001_rec.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CLIENTS  32
+#define REC_LEN  50
+#define SOCK     "/tmp/tc001_bench_daemon.sock"
+#define REC_PATH "bench_daemon.tc1r"
+
+typedef struct {
+    tc001_daemon_sub_options opts;
+    tc001_daemon_client* c;
+    double attach_s;
+    volatile int stop;
+    uint64_t frames, torn;
+    uint32_t last_id;
+} subscriber;
+
+static void* read_frames(void* p) {
+    subscriber* s = (subscriber*)p;
+    tc001_shm_sub* sub = tc001_daemon_client_sub(s->c);
+    tc001_shm_view v;
+    while (!s->stop) {
+        if (tc001_shm_next(sub, &v, 20000000) != TC001_OK) continue;
+        volatile uint8_t sink = v.frame.data[0];
+        (void)sink;
+        if (!tc001_shm_view_valid(sub, &v)) { s->torn++; continue; }
+        s->frames++;
+        s->last_id = v.frame.frame_id;
+    }
+    return NULL;
+}
+
+static volatile int serving = 1;
+
+static void* serve(void* p) {
+    while (serving) tc001_daemon_serve((tc001_daemon*)p, 20);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    double secs = argc > 1 ? atof(argv[1]) : 2.0;
+    double speed = argc > 2 ? atof(argv[2]) : 4.0;
+    const size_t n = (size_t)BENCH_W * BENCH_H;
+
+    /* a short recording at 25 fps to loop */
+    uint16_t* px = (uint16_t*)malloc(n * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < REC_LEN; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    tc001_handle* h;
+    tc001_replay_options ro = { speed, 1, 0, 0 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) return 1;
+    tc001_daemon_options o = {0};
+    o.socket_path = SOCK;
+    tc001_daemon* d;
+    if (tc001_daemon_create(&d, h, &o) != TC001_OK || tc001_daemon_start(d, err, sizeof err) != TC001_OK)
+        return 1;
+    pthread_t server;
+    pthread_create(&server, NULL, serve, d);
+
+    uint8_t pal[768];
+    bench_palette(pal);
+    subscriber subs[CLIENTS];
+    memset(subs, 0, sizeof(subs));
+    pthread_t th[CLIENTS];
+    double attach_sum = 0, attach_max = 0;
+    for (int k = 0; k < CLIENTS; ++k) {
+        subscriber* s = &subs[k];
+        s->opts.format = k < 16 ? TC001_FMT_U16 : k < 24 ? TC001_FMT_U8 : TC001_FMT_RGB8;
+        s->opts.decimation = k >= 16 && k < 24 ? 2 : 1;
+        s->opts.palette = k >= 24 ? pal : NULL;
+        double t0 = bench_now_s();
+        if (tc001_daemon_subscribe(&s->c, SOCK, &s->opts) != TC001_OK) {
+            printf("client %d could not subscribe\n", k);
+            return 1;
+        }
+        s->attach_s = bench_now_s() - t0;
+        attach_sum += s->attach_s;
+        if (s->attach_s > attach_max) attach_max = s->attach_s;
+        pthread_create(&th[k], NULL, read_frames, s);
+    }
+
+    tc001_daemon_stats st0, st1;
+    tc001_daemon_get_stats(d, &st0);
+    usleep((useconds_t)(secs * 1e6));
+    tc001_daemon_get_stats(d, &st1);
+    for (int k = 0; k < CLIENTS; ++k) subs[k].stop = 1;
+    for (int k = 0; k < CLIENTS; ++k) pthread_join(th[k], NULL);
+
+    const uint64_t frames = st1.frames - st0.frames;
+    printf("attach (client side): mean %.0f us, max %.0f us\n", attach_sum / CLIENTS * 1e6, attach_max * 1e6);
+    printf("attach (daemon side): mean %.0f us, max %.0f us\n",
+           st1.attach_ns / 1e3 / (st1.attaches ? st1.attaches : 1), st1.attach_ns_max / 1e3);
+    printf("%d clients on %d streams: %llu camera frames in %.1f s, daemon %.1f us per frame\n",
+           st1.clients, st1.streams, (unsigned long long)frames, secs,
+           frames ? (st1.frame_ns - st0.frame_ns) / 1e3 / frames : 0.0);
+    static const char* names[] = { "u8", "u16", "rgb" };
+    for (int k = 0; k < CLIENTS; ++k) {
+        subscriber* s = &subs[k];
+        printf("  client %2d %-3s /%d: %llu frames, torn %llu\n", k, names[s->opts.format],
+               s->opts.decimation, (unsigned long long)s->frames, (unsigned long long)s->torn);
+        tc001_daemon_unsubscribe(s->c);
+    }
+
+    serving = 0;
+    pthread_join(server, NULL);
+    tc001_daemon_get_stats(d, &st1);
+    printf("after unsubscribing: %d clients, %d streams\n", st1.clients, st1.streams);
+    tc001_daemon_destroy(d);
+    tc001_close(h);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
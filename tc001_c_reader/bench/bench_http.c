@@ -0,0 +1,215 @@
+/* MJPEG over HTTP: frames are pushed at a camera-like rate while several
+   viewers read /stream over loopback and one more reads it far too slowly.
+   Reports how many JPEGs were encoded against what an encoder per viewer
+   would cost, what every viewer received, and what the slow one was
+   spared; then fetches /frame.jpg and /raw once. Linux only.
+   Usage: bench_http [viewers] [seconds] [fps]. */
+#include "bench_util.h"
+#include "tc001_http.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MAX_VIEWERS 31
+
+typedef struct {
+    int port;
+    int slow;                   /* sleeps between frames */
+    volatile int stop;
+    uint64_t frames, bytes, bad;
+    int fd;
+    char buf[65536];
+    size_t have;
+} viewer;
+
+/* rcvbuf > 0 shrinks the receive window, as a slow link would. */
+static int connect_get(int port, const char* path, int rcvbuf) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvbuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    char req[128];
+    int n = snprintf(req, sizeof req, "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof sa) != 0 || send(fd, req, (size_t)n, 0) != n) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Reads up to the next blank line into v->buf; returns its length (with
+   the blank line), 0 on error. */
+static size_t read_head(viewer* v) {
+    for (;;) {
+        v->buf[v->have] = '\0';
+        char* e = strstr(v->buf, "\r\n\r\n");
+        if (e) return (size_t)(e + 4 - v->buf);
+        if (v->have == sizeof(v->buf) - 1) return 0;
+        ssize_t n = recv(v->fd, v->buf + v->have, sizeof(v->buf) - 1 - v->have, 0);
+        if (n <= 0) return 0;
+        v->have += (size_t)n;
+    }
+}
+
+static void consume(viewer* v, size_t n) {
+    memmove(v->buf, v->buf + n, v->have - n);
+    v->have -= n;
+}
+
+/* Skips n bytes of body, from the buffer first. */
+static int skip(viewer* v, size_t n) {
+    size_t k = n < v->have ? n : v->have;
+    consume(v, k);
+    n -= k;
+    char sink[16384];
+    while (n) {
+        ssize_t r = recv(v->fd, sink, n < sizeof sink ? n : sizeof sink, 0);
+        if (r <= 0) return 0;
+        n -= (size_t)r;
+    }
+    return 1;
+}
+
+static void* watch(void* p) {
+    viewer* v = (viewer*)p;
+    v->fd = connect_get(v->port, "/stream", v->slow ? 4096 : 0);
+    size_t n = v->fd >= 0 ? read_head(v) : 0;
+    if (!n || strncmp(v->buf, "HTTP/1.1 200", 12)) { v->bad++; return NULL; }
+    consume(v, n);
+    while (!v->stop) {
+        if (!(n = read_head(v))) break;
+        const char* cl = strstr(v->buf, "Content-Length: ");
+        size_t len = cl ? strtoul(cl + 16, NULL, 10) : 0;
+        consume(v, n);
+        if (!len || !skip(v, len + 2)) { v->bad++; break; }
+        v->frames++;
+        v->bytes += len;
+        if (v->slow) usleep(250000);
+    }
+    close(v->fd);
+    return NULL;
+}
+
+static volatile int serving = 1;
+
+static void* serve(void* p) {
+    while (serving) tc001_http_serve((tc001_http*)p, 20);
+    return NULL;
+}
+
+/* One request; prints the status line and the X-TC001 headers. */
+static void fetch(int port, const char* path) {
+    static viewer v;
+    v.have = 0;
+    v.fd = connect_get(port, path, 0);
+    size_t n = v.fd >= 0 ? read_head(&v) : 0;
+    if (!n) { printf("GET %-11s failed\n", path); return; }
+    v.buf[n] = '\0';
+    const char* cl = strstr(v.buf, "Content-Length: ");
+    size_t len = cl ? strtoul(cl + 16, NULL, 10) : 0;
+    printf("GET %-11s %.*s, %zu bytes", path, (int)strcspn(v.buf, "\r"), v.buf, len);
+    for (const char* x = strstr(v.buf, "X-TC001-"); x; x = strstr(x + 1, "X-TC001-"))
+        printf(", %.*s", (int)strcspn(x + 8, "\r"), x + 8);
+    printf("\n");
+    close(v.fd);
+}
+
+static int fetch_port;
+static volatile int fetched;
+
+static void* fetch_all(void* p) {
+    (void)p;
+    fetch(fetch_port, "/frame.jpg");
+    fetch(fetch_port, "/raw");
+    fetch(fetch_port, "/missing");
+    fetched = 1;
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int nviewers = argc > 1 ? atoi(argv[1]) : 8;
+    double secs = argc > 2 ? atof(argv[2]) : 3.0;
+    double fps = argc > 3 ? atof(argv[3]) : 25.0;
+    if (nviewers < 1) nviewers = 1;
+    if (nviewers > MAX_VIEWERS) nviewers = MAX_VIEWERS;
+
+    uint8_t pal[768];
+    bench_palette(pal);
+    tc001_http_options o = {0};
+    o.palette = pal;
+    tc001_http* s;
+    if (tc001_http_create(&s, &o) != TC001_OK) { printf("cannot listen\n"); return 1; }
+    const int port = tc001_http_port(s);
+    pthread_t server;
+    pthread_create(&server, NULL, serve, s);
+
+    /* nviewers keeping up, plus one that reads a frame every 250 ms
+       through a small window */
+    static viewer vs[MAX_VIEWERS + 1];
+    pthread_t th[MAX_VIEWERS + 1];
+    for (int i = 0; i <= nviewers; ++i) {
+        vs[i].port = port;
+        vs[i].slow = i == nviewers;
+        pthread_create(&th[i], NULL, watch, &vs[i]);
+    }
+    tc001_http_stats st;
+    for (int i = 0; i < 100; ++i) {
+        tc001_http_get_stats(s, &st);
+        if (st.viewers == nviewers + 1) break;
+        usleep(10000);
+    }
+
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    const int frames = (int)(secs * fps);
+    const double t0 = bench_now_s();
+    for (int i = 0; i < frames; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        tc001_http_push(s, &f);
+        double wait = t0 + (i + 1) / fps - bench_now_s();
+        if (wait > 0) usleep((useconds_t)(wait * 1e6));
+    }
+    usleep(200000);
+    for (int i = 0; i <= nviewers; ++i) vs[i].stop = 1;
+    for (int i = 0; i <= nviewers; ++i) pthread_join(th[i], NULL);
+
+    tc001_http_get_stats(s, &st);
+    const double enc_us = st.encoded ? st.encode_ns / 1e3 / st.encoded : 0.0;
+    printf("%llu frames pushed at %.0f fps, %llu encoded once each: %.0f us and %.1f KB per frame\n",
+           (unsigned long long)st.frames, fps, (unsigned long long)st.encoded, enc_us,
+           st.encoded ? st.encoded_bytes / 1024.0 / st.encoded : 0.0);
+    printf("an encoder per viewer: %.0f us per frame for %d viewers\n", enc_us * (nviewers + 1), nviewers + 1);
+    for (int i = 0; i <= nviewers; ++i)
+        printf("  viewer %2d%s: %llu frames, %.1f MB%s\n", i, vs[i].slow ? " (slow)" : "       ",
+               (unsigned long long)vs[i].frames, vs[i].bytes / 1e6, vs[i].bad ? ", ERROR" : "");
+    printf("sent %llu frames, dropped %llu for slow viewers, skipped %llu, %.1f MB\n",
+           (unsigned long long)st.sent, (unsigned long long)st.dropped, (unsigned long long)st.skipped,
+           st.bytes_sent / 1e6);
+
+    /* one-shot endpoints answer with the next pushed frame */
+    pthread_t fetcher;
+    fetch_port = port;
+    pthread_create(&fetcher, NULL, fetch_all, NULL);
+    for (int i = frames; !fetched; ++i) {
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        tc001_http_push(s, &f);
+        usleep(40000);
+    }
+    pthread_join(fetcher, NULL);
+
+    serving = 0;
+    pthread_join(server, NULL);
+    tc001_http_destroy(s);
+    free(px);
+    return 0;
+}
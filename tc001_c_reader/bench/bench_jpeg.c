@@ -0,0 +1,106 @@
+/* Baseline JPEG encode time per preview frame: a U16 frame through AGC to
+   grayscale, the same frame through a palette, and the RGB frame that
+   image_writer renders. Then writes an MJPEG AVI of the sequence.
+   bench_jpeg_cv times OpenCV on the same frames for comparison. */
+#include "bench_util.h"
+#include "tc001_jpeg.h"
+#include <string.h>
+
+#define SEQ_LEN 50
+
+static int write_null(const void* buf, size_t n, void* user) {
+    (void)buf;
+    *(size_t*)user += n;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 20;
+    int quality = argc > 2 ? atoi(argv[2]) : 85;
+    const char* avi = argc > 3 ? argv[3] : "bench_jpeg.avi";
+    const int w = BENCH_W, h = BENCH_H;
+    const size_t n = (size_t)w * h, cap = tc001_jpeg_max_bytes(w, h, 1);
+
+    uint16_t* seq = (uint16_t*)malloc(n * 2 * SEQ_LEN);
+    uint8_t* gray = (uint8_t*)malloc(n * SEQ_LEN);
+    uint8_t* rgb = (uint8_t*)malloc(n * 3);
+    uint8_t* out = (uint8_t*)malloc(cap);
+    uint8_t pal[768];
+    tc001_jpeg* j = NULL;
+    if (!seq || !gray || !rgb || !out) return 1;
+    if (tc001_jpeg_create(&j, quality) != TC001_OK) return 1;
+    bench_palette(pal);
+    for (int i = 0; i < SEQ_LEN; ++i) {
+        bench_fill_scene(seq + n * i, w, h, i);
+        tc001_u16_to_u8(seq + n * i, (int)n, gray + n * i);
+    }
+
+    size_t len = 0, total = 0;
+    double t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            tc001_frame f = bench_frame(seq + n * i, w, h);
+            if (tc001_jpeg_encode_frame(j, &f, NULL, out, cap, &len) != TC001_OK) return 1;
+            total += len;
+        }
+    }
+    bench_report("u16 frame -> gray jpeg", iters * SEQ_LEN, bench_now_s() - t0, n * 2);
+    printf("  %.0f bytes/frame\n", (double)total / SEQ_LEN);
+
+    t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            if (tc001_jpeg_encode_indexed(j, gray + n * i, w, h, w, pal, out, cap, &len) != TC001_OK)
+                return 1;
+            total += len;
+        }
+    }
+    bench_report("u8 + palette -> 4:2:0 jpeg", iters * SEQ_LEN, bench_now_s() - t0, n);
+    printf("  %.0f bytes/frame\n", (double)total / SEQ_LEN);
+
+    t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            const uint8_t* g = gray + n * i;
+            for (size_t k = 0; k < n; ++k) rgb[3 * k] = rgb[3 * k + 1] = rgb[3 * k + 2] = g[k];
+            if (tc001_jpeg_encode_rgb(j, rgb, w, h, w * 3, out, cap, &len) != TC001_OK) return 1;
+            total += len;
+        }
+    }
+    bench_report("rgb -> 4:2:0 jpeg", iters * SEQ_LEN, bench_now_s() - t0, n * 3);
+    printf("  %.0f bytes/frame (includes gray -> rgb expansion)\n", (double)total / SEQ_LEN);
+
+    /* containers */
+    tc001_mjpeg* m = NULL;
+    size_t streamed = 0;
+    if (tc001_mjpeg_open_avi(&m, avi, w, h, 25.0) != TC001_OK) {
+        printf("cannot create %s\n", avi);
+        return 1;
+    }
+    t0 = bench_now_s();
+    for (int i = 0; i < SEQ_LEN; ++i) {
+        tc001_jpeg_encode_indexed(j, gray + n * i, w, h, w, pal, out, cap, &len);
+        if (tc001_mjpeg_write(m, out, len) != TC001_OK) return 1;
+    }
+    if (tc001_mjpeg_close(m) != TC001_OK) return 1;
+    bench_report("encode + avi write", SEQ_LEN, bench_now_s() - t0, 0);
+
+    if (tc001_mjpeg_open_multipart(&m, write_null, &streamed) != TC001_OK) return 1;
+    for (int i = 0; i < SEQ_LEN; ++i) {
+        tc001_frame f = bench_frame(seq + n * i, w, h);
+        tc001_jpeg_encode_frame(j, &f, pal, out, cap, &len);
+        tc001_mjpeg_write(m, out, len);
+    }
+    tc001_mjpeg_close(m);
+    printf("wrote %s (%d frames), multipart stream %zu bytes\n", avi, SEQ_LEN, streamed);
+
+    tc001_jpeg_destroy(j);
+    free(seq);
+    free(gray);
+    free(rgb);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/* The OpenCV path bench_jpeg is compared against: cv::imencode on the
+   same frames and quality (the encoder behind VideoWriter's MJPG), gray,
+   through a colour map, and as the RGB frame image_writer renders.
+   Built only when CMake finds OpenCV. */
+#include "bench_util.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#define SEQ_LEN 50
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 20;
+    int quality = argc > 2 ? atoi(argv[2]) : 85;
+    const int w = BENCH_W, h = BENCH_H;
+    const size_t n = (size_t)w * h;
+
+    std::vector<uint16_t> seq(n * SEQ_LEN);
+    std::vector<cv::Mat> gray(SEQ_LEN), rgb(SEQ_LEN);
+    uint8_t pal[768];
+    bench_palette(pal);
+    cv::Mat lut(1, 256, CV_8UC3);
+    for (int i = 0; i < 256; ++i)   /* OpenCV images are BGR */
+        lut.at<cv::Vec3b>(0, i) = cv::Vec3b(pal[3 * i + 2], pal[3 * i + 1], pal[3 * i]);
+    for (int i = 0; i < SEQ_LEN; ++i) {
+        bench_fill_scene(&seq[n * i], w, h, i);
+        gray[i].create(h, w, CV_8UC1);
+        tc001_u16_to_u8(&seq[n * i], (int)n, gray[i].ptr<uint8_t>());
+        cv::cvtColor(gray[i], rgb[i], cv::COLOR_GRAY2BGR);
+    }
+
+    const std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, quality };
+    std::vector<uint8_t> out;
+    size_t total = 0;
+
+    double t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            cv::Mat g(h, w, CV_8UC1);
+            tc001_u16_to_u8(&seq[n * i], (int)n, g.ptr<uint8_t>());
+            cv::imencode(".jpg", g, out, params);
+            total += out.size();
+        }
+    }
+    bench_report("opencv u16 -> gray jpeg", iters * SEQ_LEN, bench_now_s() - t0, n * 2);
+    printf("  %.0f bytes/frame\n", (double)total / SEQ_LEN);
+
+    t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            cv::Mat c3, c;
+            cv::cvtColor(gray[i], c3, cv::COLOR_GRAY2BGR);
+            cv::LUT(c3, lut, c);
+            cv::imencode(".jpg", c, out, params);
+            total += out.size();
+        }
+    }
+    bench_report("opencv u8 + lut -> jpeg", iters * SEQ_LEN, bench_now_s() - t0, n);
+    printf("  %.0f bytes/frame\n", (double)total / SEQ_LEN);
+
+    t0 = bench_now_s();
+    for (int it = 0; it < iters; ++it) {
+        total = 0;
+        for (int i = 0; i < SEQ_LEN; ++i) {
+            cv::imencode(".jpg", rgb[i], out, params);
+            total += out.size();
+        }
+    }
+    bench_report("opencv rgb -> jpeg", iters * SEQ_LEN, bench_now_s() - t0, n * 3);
+    printf("  %.0f bytes/frame\n", (double)total / SEQ_LEN);
+    return 0;
+}
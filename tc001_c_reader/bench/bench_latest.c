@@ -0,0 +1,143 @@
+/* Latest-frame mailbox under contention: a looping replay writes frames as
+   fast as it can while 8 reader threads copy the newest one, first polling
+   every 200 us (UI, watchdog, snapshot server) and then back to back.
+   Reports the writer's frame rate against running alone, what each reader
+   copied, and checks every copy against the frame it claims to be: rows
+   from two different frames would show. With fewer CPUs than threads the
+   back-to-back readers take CPU time from the writer, not a lock. POSIX
+   only.
+   Usage: bench_latest [seconds] [readers]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REC_LEN     64
+#define MAX_READERS 32
+#define REC_PATH    "bench_latest.tc1r"
+
+/* the first, middle and last pixel of every recorded frame */
+static uint16_t samples[REC_LEN][3];
+static tc001_handle* h;
+static volatile int stop;
+static volatile uint64_t written;
+
+typedef struct {
+    int poll_us;                /* 0 = back to back */
+    uint64_t copies, stale, wrong;
+    double copy_s;
+} reader;
+
+static void count(const tc001_frame* f, void* user) {
+    (void)f;
+    (void)user;
+    written++;
+}
+
+static void* read_latest(void* p) {
+    reader* r = (reader*)p;
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    uint32_t seq = 0;
+    tc001_frame info;
+    const int n = BENCH_W * BENCH_H;
+    while (!stop) {
+        const double t0 = bench_now_s();
+        if (tc001_peek_latest(h, px, (size_t)n * 2, &info, &seq) != TC001_OK) {
+            r->stale++;
+        } else {
+            r->copy_s += bench_now_s() - t0;
+            r->copies++;
+            /* frame ids keep counting across runs; timestamps step 40 ms
+               through every loop */
+            const uint16_t* want = samples[(info.timestamp_ns / 40000000) % REC_LEN];
+            if (px[0] != want[0] || px[n / 2] != want[1] || px[n - 1] != want[2]) r->wrong++;
+        }
+        if (r->poll_us) usleep((useconds_t)r->poll_us);
+    }
+    free(px);
+    return NULL;
+}
+
+/* Runs the writer for secs with nreaders readers; returns frames/s. */
+static double run(double secs, int nreaders, int poll_us, reader* rs) {
+    pthread_t th[MAX_READERS];
+    stop = 0;
+    written = 0;
+    memset(rs, 0, sizeof(reader) * MAX_READERS);
+    for (int i = 0; i < nreaders; ++i) {
+        rs[i].poll_us = poll_us;
+        pthread_create(&th[i], NULL, read_latest, &rs[i]);
+    }
+    char err[256];
+    const double t0 = bench_now_s();
+    if (tc001_start(h, count, NULL, err, sizeof err) != TC001_OK) { printf("start: %s\n", err); exit(1); }
+    usleep((useconds_t)(secs * 1e6));
+    tc001_stop(h);
+    const double fps = written / (bench_now_s() - t0);
+    stop = 1;
+    for (int i = 0; i < nreaders; ++i) pthread_join(th[i], NULL);
+    return fps;
+}
+
+static void report(const char* name, double fps, double alone, int nreaders, const reader* rs) {
+    uint64_t copies = 0, wrong = 0;
+    double copy_s = 0;
+    for (int i = 0; i < nreaders; ++i) {
+        copies += rs[i].copies;
+        wrong += rs[i].wrong;
+        copy_s += rs[i].copy_s;
+    }
+    printf("%-26s writer %8.0f frames/s (%3.0f%% of alone); readers %llu copies, %.1f us each, "
+           "%llu inconsistent\n", name, fps, 100.0 * fps / alone, (unsigned long long)copies,
+           copies ? copy_s * 1e6 / copies : 0.0, (unsigned long long)wrong);
+}
+
+int main(int argc, char** argv) {
+    const double secs = argc > 1 ? atof(argv[1]) : 1.0;
+    int nreaders = argc > 2 ? atoi(argv[2]) : 8;
+    if (nreaders < 1) nreaders = 1;
+    if (nreaders > MAX_READERS) nreaders = MAX_READERS;
+
+    const int n = BENCH_W * BENCH_H;
+    uint16_t* px = (uint16_t*)malloc((size_t)n * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < REC_LEN; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        px[0] = (uint16_t)i;            /* the scene repeats; these do not */
+        px[n / 2] = (uint16_t)(1000 + i);
+        px[n - 1] = (uint16_t)(2000 + i);
+        samples[i][0] = px[0];
+        samples[i][1] = px[n / 2];
+        samples[i][2] = px[n - 1];
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    tc001_replay_options ro = { 0.0, 1, 0, 0 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) { printf("%s\n", err); return 1; }
+    static reader rs[MAX_READERS];
+    const double off = run(secs, 0, 0, rs);
+    tc001_enable_latest(h, 1);
+    const double alone = run(secs, 0, 0, rs);
+    printf("%ld CPUs; writer without the mailbox %.0f frames/s\n", sysconf(_SC_NPROCESSORS_ONLN), off);
+    report("mailbox, no readers", alone, alone, 0, rs);
+    char name[64];
+    snprintf(name, sizeof name, "%d readers every 200 us", nreaders);
+    double fps = run(secs, nreaders, 200, rs);
+    report(name, fps, alone, nreaders, rs);
+    snprintf(name, sizeof name, "%d readers back to back", nreaders);
+    fps = run(secs, nreaders, 0, rs);
+    report(name, fps, alone, nreaders, rs);
+
+    tc001_close(h);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/* Fusion payload packing throughput: tc001_pack_frame against the
+   equivalent multi-pass approach (stats, memcpy, separate AGC). */
+#include <string.h>
+#include "bench_util.h"
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 2000;
+    const int w = BENCH_W, h = BENCH_H, n = w * h;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)n * 2);
+    uint8_t* u8 = (uint8_t*)malloc((size_t)n);
+    size_t cap = tc001_max_payload_bytes(w, h, 64, 48);
+    uint8_t* dst = (uint8_t*)malloc(cap);
+    if (!px || !u8 || !dst) return 1;
+    bench_fill_scene(px, w, h, 1);
+    tc001_frame f = bench_frame(px, w, h);
+
+    size_t got = tc001_pack_frame(&f, NULL, NULL, dst, cap, 64, 48, 1);
+    if (got != cap) { fprintf(stderr, "pack failed (%zu/%zu)\n", got, cap); return 1; }
+
+    double t0 = bench_now_s();
+    for (int i = 0; i < iters; ++i) {
+        f.frame_id = (uint32_t)i;
+        tc001_pack_frame(&f, NULL, NULL, dst, cap, 64, 48, 1);
+    }
+    bench_report("pack_frame 64x48 agc", iters, bench_now_s() - t0, cap);
+
+    t0 = bench_now_s();
+    for (int i = 0; i < iters; ++i)
+        tc001_pack_frame(&f, NULL, NULL, dst, cap, 0, 0, 0);
+    bench_report("pack_frame no thumb", iters, bench_now_s() - t0, (size_t)n * 2);
+
+    tc001_frame_stats st;
+    t0 = bench_now_s();
+    for (int i = 0; i < iters; ++i) {
+        tc001_compute_stats(&f, &st);
+        memcpy(dst, px, (size_t)n * 2);
+        tc001_u16_to_u8(px, n, u8);
+    }
+    bench_report("multi-pass baseline", iters, bench_now_s() - t0, (size_t)n * 2);
+
+    free(px); free(u8); free(dst);
+    return 0;
+}
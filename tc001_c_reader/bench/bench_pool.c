@@ -0,0 +1,126 @@
+/* Keeping frames past the callback: a consumer holds the last few frames
+   of a packetized replay (the device's frame assembly path), once by
+   copying each into its own ring and once by retaining pooled frames.
+   Reports the cost per frame of both, the pool's statistics, a run with
+   the pool too small for what is held, and checks every held frame is
+   still the one it was when it is let go.
+   Usage: bench_pool [frames] [held]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define REC_LEN  64
+#define MAX_HELD 32
+#define REC_PATH "bench_pool.tc1r"
+
+static int held;
+static int mode;                    /* 0 copy, 1 retain */
+static const tc001_frame* ring[MAX_HELD];
+static uint8_t* copies[MAX_HELD];
+static tc001_frame copy_info[MAX_HELD];
+static int next;
+static uint64_t frames, wrong, copied;
+
+/* px[0] of recorded frame i is i */
+static void check(const tc001_frame* f) {
+    const uint16_t first = (uint16_t)(f->data[0] | f->data[1] << 8);
+    if (first != (uint16_t)((f->timestamp_ns / 40000000) % REC_LEN)) wrong++;
+}
+
+static void keep(const tc001_frame* f, void* user) {
+    (void)user;
+    frames++;
+    const int i = next;
+    next = (next + 1) % held;
+    if (ring[i]) {                  /* the oldest frame leaves the pipeline */
+        check(ring[i]);
+        if (ring[i] != &copy_info[i]) tc001_frame_release(ring[i]);
+        ring[i] = NULL;
+    }
+    if (mode && (ring[i] = tc001_frame_retain(f))) return;
+    /* copy, as every consumer did before */
+    const size_t bytes = (size_t)f->stride * f->height;
+    memcpy(copies[i], f->data, bytes);
+    copy_info[i] = *f;
+    copy_info[i].data = copies[i];
+    copy_info[i].ref = NULL;
+    ring[i] = &copy_info[i];
+    copied++;
+}
+
+static double play(int pool_max, int retain, int n, tc001_pool_stats* st) {
+    tc001_handle* h;
+    tc001_replay_options ro = { 0.0, 0, 0, 1 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) { printf("%s\n", err); exit(1); }
+    if (pool_max) tc001_set_frame_pool(h, pool_max);
+    mode = retain;
+    next = 0;
+    frames = wrong = copied = 0;
+    const double t0 = bench_now_s();
+    tc001_start(h, keep, NULL, err, sizeof err);
+    while (!tc001_replay_done(h)) {
+#ifdef _WIN32
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+    const double us = (bench_now_s() - t0) * 1e6 / n;
+    tc001_stop(h);
+    for (int i = 0; i < held; ++i) {
+        if (!ring[i]) continue;
+        check(ring[i]);
+        if (ring[i] != &copy_info[i]) tc001_frame_release(ring[i]);
+        ring[i] = NULL;
+    }
+    tc001_get_pool_stats(h, st);
+    tc001_close(h);
+    return us;
+}
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? atoi(argv[1]) : 2000;
+    held = argc > 2 ? atoi(argv[2]) : 4;
+    if (held < 1) held = 1;
+    if (held > MAX_HELD) held = MAX_HELD;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < n; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        px[0] = (uint16_t)(i % REC_LEN);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+    for (int i = 0; i < MAX_HELD; ++i) copies[i] = (uint8_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+
+    tc001_pool_stats st;
+    const double base = play(0, 0, n, &st);
+    printf("holding the last %d of %d frames\n", held, n);
+    printf("copy each frame          %6.1f us/frame, %llu copies, %llu wrong\n", base,
+           (unsigned long long)copied, (unsigned long long)wrong);
+    struct { int pool; const char* name; } runs[] = {
+        { held + 2, "retain, pool held + 2" },
+        { held, "retain, pool held" },
+    };
+    for (int k = 0; k < 2; ++k) {
+        const double us = play(runs[k].pool, 1, n, &st);
+        printf("%-24s %6.1f us/frame, %llu copies, %llu wrong; pool %d/%d buffers, peak %d in use, "
+               "%llu retains, %llu exhausted\n", runs[k].name, us, (unsigned long long)copied,
+               (unsigned long long)wrong, st.buffers, st.max_buffers, st.peak_in_use,
+               (unsigned long long)st.retains, (unsigned long long)st.exhausted);
+    }
+    for (int i = 0; i < MAX_HELD; ++i) free(copies[i]);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
@@ -0,0 +1,51 @@
+/* Background recorder throughput: frames are pushed as fast as the writer
+   accepts them (TC001_REC_BLOCK), raw and lossless, through the page cache
+   and with direct I/O. Usage: bench_rec [frames] [path]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+
+static void run(const char* name, const char* path, int frames, const uint16_t* px,
+                tc001_rec_codec codec, int direct) {
+    tc001_recorder_options o = {0};
+    o.rec.codec = codec;
+    o.direct_io = direct;
+    o.policy = TC001_REC_BLOCK;
+    tc001_recorder* rc = NULL;
+    if (tc001_recorder_start(&rc, path, BENCH_W, BENCH_H, TC001_FMT_U16, &o, NULL, NULL) != TC001_OK) {
+        printf("%-28s cannot create %s\n", name, path);
+        return;
+    }
+    double t0 = bench_now_s();
+    for (int i = 0; i < frames; ++i) {
+        tc001_frame f = bench_frame(px + (size_t)(i % 8) * BENCH_W * BENCH_H, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        tc001_recorder_push(rc, &f);
+    }
+    tc001_recorder_stats st;
+    tc001_recorder_stats_get(rc, &st);
+    tc001_status fin = tc001_recorder_finish(rc);
+    double secs = bench_now_s() - t0;
+
+    bench_report(name, frames, secs, (size_t)BENCH_W * BENCH_H * 2);
+    printf("  %.0f fps, peak queue %u/%u, %llu writes, write us mean %u max %u%s%s\n",
+           frames / secs, st.queue_peak, st.queue_capacity, (unsigned long long)st.writes,
+           st.write_us_mean, st.write_us_max, direct && !st.direct_io ? ", no direct I/O" : "",
+           fin != TC001_OK ? ", FAILED" : "");
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    const char* path = argc > 2 ? argv[2] : "bench_rec.tc1r";
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2 * 8);
+    if (!px) return 1;
+    for (int i = 0; i < 8; ++i) bench_fill_scene(px + (size_t)i * BENCH_W * BENCH_H, BENCH_W, BENCH_H, i);
+
+    run("recorder raw", path, frames, px, TC001_REC_RAW, 0);
+    run("recorder raw, direct", path, frames, px, TC001_REC_RAW, 1);
+    run("recorder lossless", path, frames, px, TC001_REC_LOSSLESS, 0);
+    run("recorder lossless, direct", path, frames, px, TC001_REC_LOSSLESS, 1);
+    remove(path);
+    free(px);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/* Eight render contexts (one per simulated camera) rendering a palette
+   preview rotated 90 degrees, first one after another on one thread, then
+   each on its own thread at the same time. Contexts share nothing, so the
+   concurrent run should scale with the cores. Pass a directory to also
+   record one MJPEG AVI per context. */
+#include "bench_util.h"
+#include "tc001_render.h"
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define CAMERAS 8
+#define SEQ_LEN 16
+
+typedef struct {
+    tc001_render_ctx* ctx;
+    const uint16_t* seq;
+    int frames;
+    int failed;
+    double secs;
+} camera;
+
+static void run_camera(camera* c) {
+    const size_t n = (size_t)BENCH_W * BENCH_H;
+    double t0 = bench_now_s();
+    for (int i = 0; i < c->frames; ++i) {
+        tc001_frame f = bench_frame(c->seq + n * (i % SEQ_LEN), BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        if (tc001_render_frame(c->ctx, &f, NULL) != TC001_OK) c->failed = 1;
+    }
+    c->secs = bench_now_s() - t0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI camera_thread(LPVOID p) { run_camera((camera*)p); return 0; }
+#else
+static void* camera_thread(void* p) { run_camera((camera*)p); return NULL; }
+#endif
+
+static int open_cameras(camera* cams, const uint16_t* seq, int frames,
+                        const uint8_t* pal, const char* dir, const char* tag) {
+    for (int k = 0; k < CAMERAS; ++k) {
+        char path[512];
+        tc001_render_options o = {0};
+        o.rotation = 90;
+        o.palette = pal;
+        if (dir) {
+            snprintf(path, sizeof path, "%s/render_%s_%d.avi", dir, tag, k);
+            o.avi_path = path;
+        }
+        memset(&cams[k], 0, sizeof(cams[k]));
+        cams[k].seq = seq + (size_t)BENCH_W * BENCH_H * SEQ_LEN * k;
+        cams[k].frames = frames;
+        if (tc001_render_create(&cams[k].ctx, &o) != TC001_OK) return 0;
+    }
+    return 1;
+}
+
+static int close_cameras(camera* cams, const char* name, double wall) {
+    tc001_render_stats st, sum = {0};
+    int ok = 1;
+    for (int k = 0; k < CAMERAS; ++k) {
+        tc001_render_get_stats(cams[k].ctx, &st);
+        sum.frames += st.frames;
+        sum.render_ns += st.render_ns;
+        sum.encode_ns += st.encode_ns;
+        sum.encoded_bytes += st.encoded_bytes;
+        if (tc001_render_destroy(cams[k].ctx) != TC001_OK || cams[k].failed) ok = 0;
+    }
+    bench_report(name, (int)sum.frames, wall, (size_t)BENCH_W * BENCH_H * 2);
+    printf("  %.0f frames/s total, render %.1f us, encode %.1f us per frame",
+           sum.frames / wall, sum.render_ns / 1e3 / sum.frames, sum.encode_ns / 1e3 / sum.frames);
+    if (sum.encoded_bytes) printf(", %.0f bytes/frame", (double)sum.encoded_bytes / sum.frames);
+    printf("\n");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 500;
+    const char* dir = argc > 2 ? argv[2] : NULL;
+    const size_t n = (size_t)BENCH_W * BENCH_H;
+
+    uint16_t* seq = (uint16_t*)malloc(n * SEQ_LEN * CAMERAS * 2);
+    uint8_t pal[768];
+    if (!seq) return 1;
+    for (int i = 0; i < SEQ_LEN * CAMERAS; ++i) bench_fill_scene(seq + n * i, BENCH_W, BENCH_H, i);
+    bench_palette(pal);
+
+    camera cams[CAMERAS];
+    if (!open_cameras(cams, seq, frames, pal, dir, "seq")) return 1;
+    double t0 = bench_now_s();
+    for (int k = 0; k < CAMERAS; ++k) run_camera(&cams[k]);
+    double seq_wall = bench_now_s() - t0;
+    if (!close_cameras(cams, "8 contexts, one thread", seq_wall)) return 1;
+
+    if (!open_cameras(cams, seq, frames, pal, dir, "par")) return 1;
+    t0 = bench_now_s();
+#ifdef _WIN32
+    HANDLE th[CAMERAS];
+    for (int k = 0; k < CAMERAS; ++k) th[k] = CreateThread(NULL, 0, camera_thread, &cams[k], 0, NULL);
+    WaitForMultipleObjects(CAMERAS, th, TRUE, INFINITE);
+    for (int k = 0; k < CAMERAS; ++k) CloseHandle(th[k]);
+#else
+    pthread_t th[CAMERAS];
+    for (int k = 0; k < CAMERAS; ++k) pthread_create(&th[k], NULL, camera_thread, &cams[k]);
+    for (int k = 0; k < CAMERAS; ++k) pthread_join(th[k], NULL);
+#endif
+    double par_wall = bench_now_s() - t0;
+    double slowest = 0;
+    for (int k = 0; k < CAMERAS; ++k) if (cams[k].secs > slowest) slowest = cams[k].secs;
+    if (!close_cameras(cams, "8 contexts, 8 threads", par_wall)) return 1;
+    printf("speedup %.2fx, slowest camera %.0f frames/s\n", seq_wall / par_wall, frames / slowest);
+
+    free(seq);
+    return 0;
+}
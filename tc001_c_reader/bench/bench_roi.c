@@ -0,0 +1,92 @@
+/* ROI measurement cost per frame for 1, 100 and 10000 regions (a mix of
+   rectangles, spots and polygons), against a per-region pixel loop over
+   the same rectangles. */
+#include "bench_util.h"
+#include <math.h>
+
+static uint32_t rng = 12345u;
+static int rnd(int n) { rng = rng * 1664525u + 1013904223u; return (int)((rng >> 8) % (uint32_t)n); }
+
+typedef struct { int x, y, w, h; } rect;
+
+static void naive_rects(const tc001_frame* f, const rect* r, int n, tc001_roi_stats* out) {
+    for (int i = 0; i < n; ++i) {
+        uint16_t lo = 0xFFFF, hi = 0;
+        double s = 0, s2 = 0;
+        for (int y = r[i].y; y < r[i].y + r[i].h; ++y) {
+            const uint16_t* p = (const uint16_t*)(f->data + (size_t)y * f->stride);
+            for (int x = r[i].x; x < r[i].x + r[i].w; ++x) {
+                if (p[x] < lo) lo = p[x];
+                if (p[x] > hi) hi = p[x];
+                s += p[x];
+                s2 += (double)p[x] * p[x];
+            }
+        }
+        double n_px = (double)r[i].w * r[i].h, m = s / n_px;
+        out[i].count = (uint32_t)n_px;
+        out[i].min_raw = lo;
+        out[i].max_raw = hi;
+        out[i].mean_raw = (float)m;
+        out[i].stddev_raw = (float)sqrt(fmax(0.0, s2 / n_px - m * m));
+    }
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 500;
+    static const int counts[] = { 1, 100, 10000 };
+    const int w = BENCH_W, h = BENCH_H;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)w * h * 2);
+    tc001_roi_stats* out = (tc001_roi_stats*)malloc(10000 * sizeof(tc001_roi_stats));
+    rect* rects = (rect*)malloc(10000 * sizeof(rect));
+    if (!px || !out || !rects) return 1;
+    bench_fill_scene(px, w, h, 5);
+    tc001_frame f = bench_frame(px, w, h);
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        const int n = counts[c];
+        tc001_roi_set* mixed = NULL;
+        tc001_roi_set* boxes = NULL;
+        if (tc001_roi_set_create(&mixed, w, h) != TC001_OK ||
+            tc001_roi_set_create(&boxes, w, h) != TC001_OK) return 1;
+
+        for (int i = 0; i < n; ++i) {
+            rect r = { rnd(w - 64), rnd(h - 64), 4 + rnd(60), 4 + rnd(60) };
+            rects[i] = r;
+            tc001_roi_add_rect(boxes, r.x, r.y, r.w, r.h, NULL);
+            if (i % 3 == 0) {
+                tc001_roi_add_rect(mixed, r.x, r.y, r.w, r.h, NULL);
+            } else if (i % 3 == 1) {
+                tc001_roi_add_spot(mixed, r.x + 16, r.y + 16, 2 + rnd(14), NULL);
+            } else {
+                float poly[8] = { (float)r.x, (float)r.y, (float)(r.x + r.w), (float)r.y + 7.5f,
+                                  (float)(r.x + r.w) - 3.f, (float)(r.y + r.h),
+                                  (float)r.x + 1.5f, (float)(r.y + r.h) - 9.f };
+                tc001_roi_add_polygon(mixed, poly, 4, NULL);
+            }
+        }
+
+        char name[64];
+        int it = n >= 10000 ? iters / 10 + 1 : iters;
+        snprintf(name, sizeof name, "roi mixed x%d", n);
+        double t0 = bench_now_s();
+        for (int i = 0; i < it; ++i) tc001_roi_measure(mixed, &f, out, n);
+        bench_report(name, it, bench_now_s() - t0, 0);
+
+        snprintf(name, sizeof name, "roi rects x%d", n);
+        t0 = bench_now_s();
+        for (int i = 0; i < it; ++i) tc001_roi_measure(boxes, &f, out, n);
+        bench_report(name, it, bench_now_s() - t0, 0);
+
+        snprintf(name, sizeof name, "naive rect loop x%d", n);
+        t0 = bench_now_s();
+        for (int i = 0; i < it; ++i) naive_rects(&f, rects, n, out);
+        bench_report(name, it, bench_now_s() - t0, 0);
+
+        tc001_roi_set_destroy(mixed);
+        tc001_roi_set_destroy(boxes);
+    }
+
+    free(px); free(out); free(rects);
+    return 0;
+}
@@ -0,0 +1,136 @@
+/* Shared-memory frame ring: one publisher, several subscribers, each with
+   its own mapping of the segment (threads here; separate processes behave
+   the same). Reports the publish cost, what every subscriber read, skipped
+   and found torn, the publish -> read latency, and the reader table as
+   the publisher sees it. */
+#include "bench_util.h"
+#include "tc001_shm.h"
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define MAX_SUBS TC001_SHM_MAX_READERS
+#define SEQ_LEN  16
+
+typedef struct {
+    const char* name;
+    int fd;
+    volatile int stop;
+    volatile int ready;
+    uint64_t frames, torn, checksum;
+    double latency_sum, latency_max;
+} subscriber;
+
+static void run_subscriber(subscriber* s) {
+    tc001_shm_sub* sub;
+    if (tc001_shm_sub_open(&sub, s->name, s->fd) != TC001_OK) { s->ready = -1; return; }
+    s->ready = 1;
+    tc001_shm_view v;
+    while (!s->stop) {
+        if (tc001_shm_next(sub, &v, 20000000) != TC001_OK) continue;
+        double lat = bench_now_s() - v.frame.timestamp_ns * 1e-9;
+        /* touch one sample per row, as a consumer would read the frame */
+        uint64_t sum = 0;
+        for (int y = 0; y < v.frame.height; ++y) sum += v.frame.data[(size_t)y * v.frame.stride];
+        if (!tc001_shm_view_valid(sub, &v)) { s->torn++; continue; }
+        s->checksum += sum;
+        s->frames++;
+        s->latency_sum += lat;
+        if (lat > s->latency_max) s->latency_max = lat;
+    }
+    tc001_shm_sub_close(sub);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sub_thread(LPVOID p) { run_subscriber((subscriber*)p); return 0; }
+static void sleep_s(double s) { Sleep((DWORD)(s * 1000)); }
+#else
+static void* sub_thread(void* p) { run_subscriber((subscriber*)p); return NULL; }
+static void sleep_s(double s) { usleep((useconds_t)(s * 1e6)); }
+#endif
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    int nsubs = argc > 2 ? atoi(argv[2]) : 4;
+    double fps = argc > 3 ? atof(argv[3]) : 1000.0;
+    if (nsubs < 1) nsubs = 1;
+    if (nsubs > MAX_SUBS) nsubs = MAX_SUBS;
+    const int w = BENCH_W, h = BENCH_H;
+    const size_t n = (size_t)w * h;
+
+    uint16_t* seq = (uint16_t*)malloc(n * SEQ_LEN * 2);
+    if (!seq) return 1;
+    for (int i = 0; i < SEQ_LEN; ++i) bench_fill_scene(seq + n * i, w, h, i);
+
+    tc001_shm_options o = {0};
+    o.name = "/tc001-bench";
+    o.width = w;
+    o.height = h;
+    o.format = TC001_FMT_U16;
+    tc001_shm_pub* pub;
+    if (tc001_shm_pub_create(&pub, &o) != TC001_OK) {
+        o.name = NULL;      /* no shm names here: anonymous, by descriptor */
+        if (tc001_shm_pub_create(&pub, &o) != TC001_OK) return 1;
+    }
+
+    subscriber subs[MAX_SUBS];
+    memset(subs, 0, sizeof(subs));
+#ifdef _WIN32
+    HANDLE th[MAX_SUBS];
+#else
+    pthread_t th[MAX_SUBS];
+#endif
+    for (int k = 0; k < nsubs; ++k) {
+        subs[k].name = o.name;
+        subs[k].fd = tc001_shm_pub_fd(pub);
+#ifdef _WIN32
+        th[k] = CreateThread(NULL, 0, sub_thread, &subs[k], 0, NULL);
+#else
+        pthread_create(&th[k], NULL, sub_thread, &subs[k]);
+#endif
+        while (!subs[k].ready) sleep_s(0.001);
+        if (subs[k].ready < 0) return 1;
+    }
+
+    double publish = 0, t_start = bench_now_s();
+    tc001_shm_reader readers[MAX_SUBS];
+    int attached = 0;
+    for (int i = 0; i < frames; ++i) {
+        tc001_frame f = bench_frame(seq + n * (i % SEQ_LEN), w, h);
+        f.frame_id = (uint32_t)i;
+        double t0 = bench_now_s();
+        f.timestamp_ns = (int64_t)(t0 * 1e9);
+        if (tc001_shm_publish(pub, &f) != TC001_OK) return 1;
+        publish += bench_now_s() - t0;
+        if (i == frames / 2) attached = tc001_shm_pub_readers(pub, readers, MAX_SUBS);
+        double next = t_start + (i + 1) / fps;
+        double now = bench_now_s();
+        if (next > now) sleep_s(next - now);
+    }
+    sleep_s(0.05);
+    for (int k = 0; k < nsubs; ++k) subs[k].stop = 1;
+#ifdef _WIN32
+    WaitForMultipleObjects(nsubs, th, TRUE, INFINITE);
+    for (int k = 0; k < nsubs; ++k) CloseHandle(th[k]);
+#else
+    for (int k = 0; k < nsubs; ++k) pthread_join(th[k], NULL);
+#endif
+
+    bench_report("publish", frames, publish, n * 2);
+    printf("readers attached mid-run: %d\n", attached);
+    for (int k = 0; k < attached; ++k)
+        printf("  pid %d: last seq %u, lag %u, dropped %u\n", readers[k].pid,
+               readers[k].last_seq, readers[k].lag, readers[k].dropped);
+    for (int k = 0; k < nsubs; ++k) {
+        subscriber* s = &subs[k];
+        printf("sub %d: read %llu/%d torn %llu latency mean %.1f us max %.1f us\n", k,
+               (unsigned long long)s->frames, frames, (unsigned long long)s->torn,
+               s->frames ? s->latency_sum / s->frames * 1e6 : 0, s->latency_max * 1e6);
+    }
+    tc001_shm_pub_destroy(pub);
+    free(seq);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/* Early slices from a packetized replay at camera timing (25 fps, each
+   frame's packets spread over the frame interval as a device sends them).
+   A consumer that needs only the top band of rows takes it from the slice
+   callback and compares with waiting for the whole frame: reports how much
+   earlier the band is available and checks it against the delivered frame.
+   Usage: bench_slice [frames] [band_rows] [every_rows]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define REC_PATH "bench_slice.tc1r"
+
+static int band, every;
+static uint8_t band_copy[BENCH_W * BENCH_H * 2];
+static double band_at;              /* when the band of the current frame arrived */
+static uint32_t band_id;
+static int have_band;
+static double gain_sum, gain_min = 1e9, gain_max;
+static int frames, mismatched, slices;
+
+static void on_slice(const tc001_slice* s, void* user) {
+    (void)user;
+    slices++;
+    if (s->rows < band || (have_band && band_id == s->frame_id)) return;
+    band_at = bench_now_s();
+    band_id = s->frame_id;
+    have_band = 1;
+    memcpy(band_copy, s->data, (size_t)band * s->stride);
+}
+
+static void on_frame(const tc001_frame* f, void* user) {
+    (void)user;
+    const double now = bench_now_s();
+    /* the first frame's packets all come at once: nothing paces them */
+    if (!have_band || band_id != f->frame_id || f->frame_id == 0) return;
+    if (memcmp(band_copy, f->data, (size_t)band * f->stride)) mismatched++;
+    const double gain = now - band_at;
+    gain_sum += gain;
+    if (gain < gain_min) gain_min = gain;
+    if (gain > gain_max) gain_max = gain;
+    frames++;
+}
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? atoi(argv[1]) : 50;
+    band = argc > 2 ? atoi(argv[2]) : 48;
+    every = argc > 3 ? atoi(argv[3]) : 8;
+    if (band < 1 || band > BENCH_H || every < 1) return 1;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)BENCH_W * BENCH_H * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < n; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    tc001_handle* h;
+    tc001_replay_options ro = { 1.0, 0, 0, 1 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) { printf("replay: %s\n", err); return 1; }
+    tc001_set_slice_callback(h, every, on_slice, NULL);
+    if (tc001_start(h, on_frame, NULL, err, sizeof err) != TC001_OK) { printf("start: %s\n", err); return 1; }
+    while (!tc001_replay_done(h)) {
+#ifdef _WIN32
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
+    }
+    tc001_close(h);
+
+    if (!frames) { printf("no frames\n"); return 1; }
+    printf("%d frames at 25 fps, slices every %d rows (%d calls), band of %d of %d rows\n",
+           frames, every, slices, band, BENCH_H);
+    printf("band available %.2f ms before the whole frame (min %.2f, max %.2f) of a 40 ms period; "
+           "%d bands differ from the frame\n",
+           gain_sum / frames * 1e3, gain_min * 1e3, gain_max * 1e3, mismatched);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* Snapshot encode cost per format, then a burst of saved files: the
+   single-write tc001_snapshot_save against the old per-row fwrite BMP
+   writer (two unbuffered writes per row). */
+#include "bench_util.h"
+#include "tc001_snapshot.h"
+#include <string.h>
+
+#define BURST 200
+
+/* image_writer's original save_bmp, with setvbuf(_IONBF) so each fwrite
+   is a write call as on a stream that is flushed per row. */
+static void save_bmp_rows(const char* fname, const uint8_t* rgb, int w, int h) {
+    uint32_t row_bytes = (uint32_t)w * 3;
+    uint32_t pad_size  = (4 - (row_bytes % 4)) % 4;
+    uint32_t data_size = (row_bytes + pad_size) * (uint32_t)h;
+    uint8_t hdr[54] = { 'B', 'M' };
+    uint32_t v[] = { 54 + data_size, 0, 54, 40, (uint32_t)w, (uint32_t)h };
+    memcpy(hdr + 2, v, sizeof(v));
+    hdr[26] = 1;
+    hdr[28] = 24;
+    FILE* f = fopen(fname, "wb");
+    if (!f) return;
+    setvbuf(f, NULL, _IONBF, 0);
+    fwrite(hdr, 1, 54, f);
+    uint8_t pad[3] = { 0, 0, 0 };
+    for (int y = h - 1; y >= 0; y--) {
+        fwrite(rgb + (size_t)y * row_bytes, 1, row_bytes, f);
+        fwrite(pad, 1, pad_size, f);
+    }
+    fclose(f);
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 200;
+    const char* dir = argc > 2 ? argv[2] : ".";
+    const int w = BENCH_W, h = BENCH_H;
+    static const struct { tc001_snap_format fmt; const char* name; } fmts[] = {
+        { TC001_SNAP_BMP, "bmp" }, { TC001_SNAP_PNM, "pgm" },
+        { TC001_SNAP_PNG, "png" }, { TC001_SNAP_PNG_RLE, "png rle" }
+    };
+
+    uint16_t* px = (uint16_t*)malloc((size_t)w * h * 2);
+    uint8_t* gray = (uint8_t*)malloc((size_t)w * h);
+    uint8_t* rgb = (uint8_t*)malloc((size_t)w * h * 3);
+    size_t cap = tc001_snapshot_max_bytes(w, h, TC001_FMT_U16, 3, TC001_SNAP_PNG_RLE);
+    uint8_t* out = (uint8_t*)malloc(cap);
+    uint8_t pal[768];
+    if (!px || !gray || !rgb || !out) return 1;
+    bench_fill_scene(px, w, h, 1);
+    tc001_u16_to_u8(px, w * h, gray);
+    bench_palette(pal);
+    for (int i = 0; i < w * h; ++i) memcpy(rgb + 3 * i, pal + 3 * gray[i], 3);
+    tc001_frame f16 = bench_frame(px, w, h);
+
+    for (size_t k = 0; k < sizeof(fmts) / sizeof(fmts[0]); ++k) {
+        char name[64];
+        size_t len = 0;
+        snprintf(name, sizeof name, "u16 -> %s", fmts[k].name);
+        double t0 = bench_now_s();
+        for (int i = 0; i < iters; ++i)
+            if (tc001_snapshot_encode(&f16, fmts[k].fmt, out, cap, &len) != TC001_OK) return 1;
+        bench_report(name, iters, bench_now_s() - t0, (size_t)w * h * 2);
+        printf("  %zu bytes\n", len);
+
+        snprintf(name, sizeof name, "rgb -> %s", fmts[k].fmt == TC001_SNAP_PNM ? "ppm" : fmts[k].name);
+        t0 = bench_now_s();
+        for (int i = 0; i < iters; ++i)
+            if (tc001_snapshot_encode_rgb(rgb, w, h, w * 3, fmts[k].fmt, out, cap, &len) != TC001_OK)
+                return 1;
+        bench_report(name, iters, bench_now_s() - t0, (size_t)w * h * 3);
+        printf("  %zu bytes\n", len);
+    }
+
+    char path[512];
+    double t0 = bench_now_s();
+    for (int i = 0; i < BURST; ++i) {
+        snprintf(path, sizeof path, "%s/snap_rows_%03d.bmp", dir, i);
+        save_bmp_rows(path, rgb, w, h);
+    }
+    double rows = bench_now_s() - t0;
+    bench_report("burst bmp, write per row", BURST, rows, 0);
+
+    t0 = bench_now_s();
+    for (int i = 0; i < BURST; ++i) {
+        snprintf(path, sizeof path, "%s/snap_one_%03d.bmp", dir, i);
+        if (tc001_snapshot_save_rgb(path, rgb, w, h, w * 3, TC001_SNAP_BMP) != TC001_OK) return 1;
+    }
+    double one = bench_now_s() - t0;
+    bench_report("burst bmp, single write", BURST, one, 0);
+
+    t0 = bench_now_s();
+    for (int i = 0; i < BURST; ++i) {
+        snprintf(path, sizeof path, "%s/snap_raw_%03d.pgm", dir, i);
+        if (tc001_snapshot_save(path, &f16, TC001_SNAP_PNM) != TC001_OK) return 1;
+    }
+    bench_report("burst pgm16, single write", BURST, bench_now_s() - t0, 0);
+    printf("bmp frames/s: per row %.0f, single write %.0f\n", BURST / rows, BURST / one);
+
+    for (int i = 0; i < BURST; ++i) {
+        static const char* pre[] = { "snap_rows_%03d.bmp", "snap_one_%03d.bmp", "snap_raw_%03d.pgm" };
+        for (int p = 0; p < 3; ++p) {
+            char file[64];
+            snprintf(file, sizeof file, pre[p], i);
+            snprintf(path, sizeof path, "%s/%s", dir, file);
+            remove(path);
+        }
+    }
+    free(px);
+    free(gray);
+    free(rgb);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,149 @@
+/* Fan-out to eight consumers of one replayed stream (4 AGC U8, 4 palette
+   RGB8, two of each on a region), first as subscribers sharing the
+   conversions and then as one tc001_start callback rendering for each
+   consumer on its own, as glue code would. Then a slow LATEST and a slow
+   QUEUE subscriber (20 ms a frame) next to an inline one, to show the
+   capture thread does not wait for them. Usage: bench_subscribe [frames]. */
+#include "bench_util.h"
+#include "tc001_rec.h"
+#include "tc001_render.h"
+#include <string.h>
+
+#define CONSUMERS 8
+#define REC_PATH  "bench_subscribe.tc1r"
+
+static volatile uint32_t sink;
+
+static void touch(const tc001_frame* f, void* user) {
+    (void)user;
+    sink += f->data[(f->height / 2) * f->stride + f->width / 2];
+}
+
+/* Busy for ~20 ms: far slower than the replay. */
+static void slow(const tc001_frame* f, void* user) {
+    touch(f, user);
+    const double t = bench_now_s() + 0.02;
+    while (bench_now_s() < t) {}
+}
+
+static tc001_render_ctx* renderers[CONSUMERS];
+
+static void glue(const tc001_frame* f, void* user) {
+    (void)user;
+    tc001_render_image img;
+    for (int i = 0; i < CONSUMERS; ++i) {
+        tc001_render_frame(renderers[i], f, &img);
+        sink += img.rgb[0];
+    }
+}
+
+static tc001_handle* open_replay(double speed) {
+    tc001_handle* h;
+    tc001_replay_options ro = { speed, 0, 0, 0 };
+    char err[256];
+    if (tc001_open_replay(&h, REC_PATH, &ro, err, sizeof err) != TC001_OK) {
+        printf("replay: %s\n", err);
+        exit(1);
+    }
+    return h;
+}
+
+/* Plays the recording once; speed 0 runs as fast as the callbacks allow. */
+static double play(tc001_handle* h, tc001_frame_cb cb) {
+    char err[256];
+    const double t0 = bench_now_s();
+    if (tc001_start(h, cb, NULL, err, sizeof err) != TC001_OK) { printf("start: %s\n", err); exit(1); }
+    while (!tc001_replay_done(h)) {}
+    const double t = bench_now_s() - t0;
+    tc001_stop(h);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? atoi(argv[1]) : 500;
+    const size_t n = (size_t)BENCH_W * BENCH_H;
+    uint16_t* px = (uint16_t*)malloc(n * 2);
+    tc001_rec_writer* w;
+    if (!px || tc001_rec_create(&w, REC_PATH, BENCH_W, BENCH_H, TC001_FMT_U16, NULL, NULL, NULL) != TC001_OK)
+        return 1;
+    for (int i = 0; i < frames; ++i) {
+        bench_fill_scene(px, BENCH_W, BENCH_H, i);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        f.timestamp_ns = (int64_t)i * 40000000;
+        if (tc001_rec_write(w, &f) != TC001_OK) return 1;
+    }
+    if (tc001_rec_finish(w) != TC001_OK) return 1;
+
+    uint8_t pal[768];
+    bench_palette(pal);
+
+    /* replay alone, for the baseline */
+    tc001_handle* h = open_replay(0.0);
+    const double base = play(h, touch);
+    tc001_close(h);
+
+    /* subscribers */
+    h = open_replay(0.0);
+    tc001_subscription* subs[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; ++i) {
+        tc001_sub_options o = {0};
+        o.format = i < 4 ? TC001_FMT_U8 : TC001_FMT_RGB8;
+        o.palette = pal;
+        if (i % 4 >= 2) {
+            o.roi_x = 64;
+            o.roi_y = 48;
+            o.roi_w = 128;
+            o.roi_h = 96;
+        }
+        if (tc001_subscribe(h, touch, NULL, &o, &subs[i]) != TC001_OK) return 1;
+    }
+    const double shared = play(h, NULL);
+    tc001_sub_stats st;
+    tc001_sub_get_stats(subs[CONSUMERS - 1], &st);
+    tc001_close(h);
+
+    /* glue code: a renderer per consumer */
+    for (int i = 0; i < CONSUMERS; ++i) {
+        tc001_render_options ro = {0};
+        ro.palette = pal;
+        tc001_render_create(&renderers[i], &ro);
+    }
+    h = open_replay(0.0);
+    const double own = play(h, glue);
+    tc001_close(h);
+    for (int i = 0; i < CONSUMERS; ++i) tc001_render_destroy(renderers[i]);
+
+    const double us = 1e6 / frames;
+    printf("%d frames, replay alone           %7.1f us/frame\n", frames, base * us);
+    printf("%d subscribers, shared conversion  %7.1f us/frame (%llu delivered each)\n", CONSUMERS,
+           (shared - base) * us, (unsigned long long)st.delivered);
+    printf("%d renderers in one callback       %7.1f us/frame\n", CONSUMERS, (own - base) * us);
+
+    /* slow subscribers off the capture thread, at 250 fps */
+    h = open_replay(10.0);
+    tc001_subscription *fast, *latest, *queued;
+    tc001_sub_options o = {0};
+    o.format = TC001_FMT_U16;
+    tc001_subscribe(h, touch, NULL, &o, &fast);
+    o.policy = TC001_SUB_LATEST;
+    tc001_subscribe(h, slow, NULL, &o, &latest);
+    o.policy = TC001_SUB_QUEUE;
+    o.queue_frames = 8;
+    o.decimation = 2;
+    tc001_subscribe(h, slow, NULL, &o, &queued);
+    const double mixed = play(h, NULL);
+    printf("inline + 2 slow threaded at 250 fps: %.2f s for %d frames\n", mixed, frames);
+    tc001_subscription* all[3] = { fast, latest, queued };
+    const char* names[3] = { "inline", "latest", "queue 8, every 2nd" };
+    for (int i = 0; i < 3; ++i) {
+        tc001_sub_get_stats(all[i], &st);
+        printf("  %-20s delivered %4llu, dropped %4llu, skipped %4llu\n", names[i],
+               (unsigned long long)st.delivered, (unsigned long long)st.dropped,
+               (unsigned long long)st.skipped);
+    }
+    tc001_close(h);
+    remove(REC_PATH);
+    free(px);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/* Raw-to-temperature cost per frame for the three paths of
+   tc001_frame_to_temp: affine only (emissivity 1), a single emissivity
+   (the per-model table, its one-off build timed separately) and a
+   per-pixel emissivity plane, plus the centi-degree output. The plane is
+   filled with the model's emissivity, so the table and direct paths must
+   agree bit for bit; both are also checked against a double-precision
+   reference.
+   Usage: bench_temp [iters]. */
+#include "bench_util.h"
+#include <math.h>
+#include <string.h>
+
+#define TOL_K 0.01   /* float vs double reference, Kelvin */
+
+static double reference_k(const tc001_temp_model* m, double e, uint16_t raw) {
+    double k = (double)m->gain_K_per_raw * raw + m->offset_K;
+    if (e >= 1.0) return k;
+    double amb = m->ambient_C + 273.15, r = (k * k * k * k - (1.0 - e) * amb * amb * amb * amb) / e;
+    return sqrt(sqrt(r > 0 ? r : 0));
+}
+
+static double time_temp(const char* name, int iters, const tc001_frame* f, const tc001_temp_model* m,
+                        const float* plane, float* dst) {
+    double t0 = bench_now_s();
+    for (int i = 0; i < iters; ++i)
+        if (tc001_frame_to_temp(f, m, plane, TC001_TEMP_KELVIN, dst, f->width * 4) != TC001_OK) exit(1);
+    double s = bench_now_s() - t0;
+    bench_report(name, iters, s, (size_t)f->width * f->height * 2);
+    return s;
+}
+
+static int off_reference(const tc001_frame* f, const tc001_temp_model* m, double e, const float* k) {
+    const uint16_t* px = (const uint16_t*)f->data;
+    int bad = 0;
+    for (int i = 0; i < f->width * f->height; ++i)
+        if (fabs(k[i] - reference_k(m, e, px[i])) > TOL_K) bad++;
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 1000;
+    const int w = BENCH_W, h = BENCH_H, n = w * h;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)n * 2);
+    float* plane = (float*)malloc((size_t)n * 4);
+    float* affine = (float*)malloc((size_t)n * 4);
+    float* table = (float*)malloc((size_t)n * 4);
+    float* direct = (float*)malloc((size_t)n * 4);
+    int16_t* centi = (int16_t*)malloc((size_t)n * 2);
+    if (!px || !plane || !affine || !table || !direct || !centi) return 1;
+    bench_fill_scene(px, w, h, 1);
+    tc001_frame f = bench_frame(px, w, h);
+
+    tc001_temp_model m = {0};
+    m.has_temp = 1;
+    m.emissivity = 1.f;
+    m.ambient_C = 22.f;
+    m.gain_K_per_raw = 1.f / 64.f;
+    m.model_id = 1;
+    const tc001_temp_model unit_e = m;
+    time_temp("affine (e = 1)", iters, &f, &m, NULL, affine);
+
+    m.emissivity = 0.95f;
+    m.model_id = 2;
+    double t0 = bench_now_s();
+    if (tc001_frame_to_temp(&f, &m, NULL, TC001_TEMP_KELVIN, table, w * 4) != TC001_OK) return 1;
+    printf("%-28s %9.2f us, first frame only\n", "table build", (bench_now_s() - t0) * 1e6);
+    time_temp("table (e = 0.95)", iters, &f, &m, NULL, table);
+
+    for (int i = 0; i < n; ++i) plane[i] = m.emissivity;
+    time_temp("per-pixel plane", iters, &f, &m, plane, direct);
+
+    t0 = bench_now_s();
+    for (int i = 0; i < iters; ++i)
+        if (tc001_frame_to_centi_c(&f, &m, NULL, centi, w * 2) != TC001_OK) return 1;
+    bench_report("table -> centi C", iters, bench_now_s() - t0, (size_t)n * 2);
+
+    int differ = 0, centi_bad = 0;
+    for (int i = 0; i < n; ++i) {
+        if (memcmp(&table[i], &direct[i], sizeof(float))) differ++;
+        if (abs(centi[i] - (int)lrint((table[i] - 273.15) * 100.0)) > 1) centi_bad++;
+    }
+    printf("table vs plane: %d of %d pixels differ; centi C: %d off by more than 1\n", differ, n, centi_bad);
+    printf("vs double reference (> %.2f K): affine %d, table %d, plane %d\n", TOL_K,
+           off_reference(&f, &unit_e, 1.0, affine),
+           off_reference(&f, &m, m.emissivity, table), off_reference(&f, &m, m.emissivity, direct));
+
+    free(px);
+    free(plane);
+    free(affine);
+    free(table);
+    free(direct);
+    free(centi);
+    return 0;
+}
@@ -0,0 +1,27 @@
+/* Thumbnail downscale cost for integer and non-integer ratios. */
+#include "bench_util.h"
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 5000;
+    static const int dims[][2] = { {128, 96}, {64, 48}, {32, 24}, {100, 75}, {80, 60}, {37, 29} };
+    const int w = BENCH_W, h = BENCH_H;
+
+    uint16_t* px = (uint16_t*)malloc((size_t)w * h * 2);
+    uint8_t* dst = (uint8_t*)malloc((size_t)w * h);
+    if (!px || !dst) return 1;
+    bench_fill_scene(px, w, h, 3);
+    tc001_frame f = bench_frame(px, w, h);
+
+    for (size_t d = 0; d < sizeof(dims) / sizeof(dims[0]); ++d) {
+        int tw = dims[d][0], th = dims[d][1];
+        char name[64];
+        snprintf(name, sizeof name, "thumbnail %dx%d agc", tw, th);
+        double t0 = bench_now_s();
+        for (int i = 0; i < iters; ++i)
+            tc001_thumbnail(&f, dst, tw, th, tw, 1);
+        bench_report(name, iters, bench_now_s() - t0, (size_t)w * h * 2);
+    }
+
+    free(px); free(dst);
+    return 0;
+}
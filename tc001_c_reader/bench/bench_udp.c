@@ -0,0 +1,185 @@
+/* Tile-delta UDP streaming over loopback. A static background with a
+   moving warm blob is sent with and without sensor noise, with threshold
+   0 (lossless) and with a threshold that hides the noise, and once more
+   through a relay that drops packets. Every received frame is compared
+   with the frame that was sent: frames marked exact must be within the
+   threshold everywhere. Reports bandwidth against sending every frame
+   whole. POSIX only. Usage: bench_udp [frames] [loss_percent]. */
+#include "bench_util.h"
+#include "tc001_udp.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HISTORY 64
+
+typedef struct {
+    int noise;                  /* +- counts per frame on every pixel */
+    int threshold;
+    double loss;                /* fraction of packets the relay drops */
+    const char* name;
+} scenario;
+
+static uint16_t history[HISTORY][BENCH_W * BENCH_H];
+static volatile int sent_frames;
+static volatile int done;
+
+static void make_frame(uint16_t* px, int i, int noise) {
+    static uint32_t r = 12345;
+    for (int y = 0; y < BENCH_H; ++y) {
+        for (int x = 0; x < BENCH_W; ++x) {
+            int dx = x - (40 + i % 180), dy = y - 96;
+            int d2 = dx * dx + dy * dy;
+            int v = 18000 + ((x * 7 + y * 13) & 63) + (d2 < 400 ? (400 - d2) * 4 : 0);
+            if (noise) {
+                r = r * 1664525u + 1013904223u;
+                v += (int)(r >> 16) % (2 * noise + 1) - noise;
+            }
+            px[y * BENCH_W + x] = (uint16_t)v;
+        }
+    }
+}
+
+typedef struct {
+    tc001_udp_receiver* r;
+    int threshold;
+    uint64_t frames, exact, wrong, inexact;
+    int max_err;
+} checker;
+
+static void* check(void* p) {
+    checker* c = (checker*)p;
+    tc001_frame f;
+    tc001_udp_frame_info info;
+    while (!done) {
+        if (tc001_udp_receive(c->r, &f, &info, 50) != TC001_OK) continue;
+        c->frames++;
+        if (!info.exact) { c->inexact++; continue; }
+        if ((int)f.frame_id + HISTORY <= sent_frames) continue;   /* overwritten already */
+        const uint16_t* want = history[f.frame_id % HISTORY];
+        const uint16_t* got = (const uint16_t*)f.data;
+        int err = 0;
+        for (int k = 0; k < BENCH_W * BENCH_H; ++k) {
+            int d = abs((int)got[k] - (int)want[k]);
+            if (d > err) err = d;
+        }
+        if (err > c->max_err) c->max_err = err;
+        if (err > c->threshold) c->wrong++;
+        c->exact++;
+    }
+    return NULL;
+}
+
+/* Forwards datagrams from in_fd to port, dropping a fraction of them. */
+typedef struct {
+    int in_fd, port;
+    double loss;
+    uint64_t dropped;
+} relay;
+
+static void* forward(void* p) {
+    relay* rl = (relay*)p;
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof to);
+    to.sin_family = AF_INET;
+    to.sin_port = htons((uint16_t)rl->port);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { 0, 50000 };
+    setsockopt(rl->in_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    uint8_t buf[65536];
+    uint32_t r = 777;
+    while (!done) {
+        ssize_t n = recv(rl->in_fd, buf, sizeof buf, 0);
+        if (n <= 0) continue;
+        r = r * 1664525u + 1013904223u;
+        if ((r >> 8) % 10000 < rl->loss * 10000) { rl->dropped++; continue; }
+        sendto(rl->in_fd, buf, (size_t)n, 0, (struct sockaddr*)&to, sizeof to);
+    }
+    return NULL;
+}
+
+static void run(const scenario* sc, int frames) {
+    tc001_udp_receiver_options ro = {0};
+    ro.address = "127.0.0.1";
+    tc001_udp_receiver* r;
+    if (tc001_udp_receiver_create(&r, &ro) != TC001_OK) { printf("receiver failed\n"); exit(1); }
+
+    relay rl = { -1, tc001_udp_receiver_port(r), sc->loss, 0 };
+    int port = rl.port;
+    pthread_t relay_th;
+    if (sc->loss > 0) {
+        struct sockaddr_in sa;
+        socklen_t len = sizeof sa;
+        memset(&sa, 0, sizeof sa);
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        rl.in_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        int buf = 1 << 20;
+        setsockopt(rl.in_fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof buf);
+        bind(rl.in_fd, (struct sockaddr*)&sa, sizeof sa);
+        getsockname(rl.in_fd, (struct sockaddr*)&sa, &len);
+        port = ntohs(sa.sin_port);
+    }
+
+    tc001_udp_sender_options so = {0};
+    so.host = "127.0.0.1";
+    so.port = port;
+    so.threshold = sc->threshold;
+    tc001_udp_sender* s;
+    if (tc001_udp_sender_create(&s, &so) != TC001_OK) { printf("sender failed\n"); exit(1); }
+
+    done = 0;
+    sent_frames = 0;
+    checker c = { r, sc->threshold, 0, 0, 0, 0, 0 };
+    pthread_t check_th;
+    pthread_create(&check_th, NULL, check, &c);
+    if (sc->loss > 0) pthread_create(&relay_th, NULL, forward, &rl);
+
+    for (int i = 0; i < frames; ++i) {
+        uint16_t* px = history[i % HISTORY];
+        make_frame(px, i, sc->noise);
+        tc001_frame f = bench_frame(px, BENCH_W, BENCH_H);
+        f.frame_id = (uint32_t)i;
+        sent_frames = i + 1;
+        tc001_udp_send(s, &f);
+        usleep(2000);           /* ~400 fps; the checker keeps up */
+    }
+    usleep(100000);
+    done = 1;
+    pthread_join(check_th, NULL);
+    if (sc->loss > 0) {
+        pthread_join(relay_th, NULL);
+        close(rl.in_fd);
+    }
+
+    tc001_udp_sender_stats ss;
+    tc001_udp_receiver_stats rs;
+    tc001_udp_sender_get_stats(s, &ss);
+    tc001_udp_receiver_get_stats(r, &rs);
+    const double whole = (double)frames * BENCH_W * BENCH_H * 2;
+    printf("%-26s %5.1f%% of tiles, %6.1f KB/frame (%4.1f%% of raw), %5.1f us/frame to diff and pack\n",
+           sc->name, 100.0 * ss.tiles_sent / ss.tiles, ss.bytes / 1024.0 / ss.frames, 100.0 * ss.bytes / whole,
+           ss.diff_ns / 1e3 / ss.frames);
+    printf("%26s received %llu/%d, exact %llu (max error %d, over threshold %llu), inexact %llu, "
+           "lost %llu packets\n", "", (unsigned long long)c.frames, frames, (unsigned long long)c.exact,
+           c.max_err, (unsigned long long)c.wrong, (unsigned long long)c.inexact,
+           (unsigned long long)rs.lost);
+    tc001_udp_sender_destroy(s);
+    tc001_udp_receiver_destroy(r);
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 500;
+    double loss = argc > 2 ? atof(argv[2]) / 100.0 : 0.01;
+    const scenario scenarios[] = {
+        { 0, 0, 0.0, "static, lossless" },
+        { 2, 0, 0.0, "noise +-2, lossless" },
+        { 2, 4, 0.0, "noise +-2, threshold 4" },
+        { 2, 4, loss, "threshold 4, lossy relay" },
+    };
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) run(&scenarios[i], frames);
+    return 0;
+}
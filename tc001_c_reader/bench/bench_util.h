@@ -0,0 +1,71 @@
+#pragma once
+/* Shared helpers for the bench/ programs: timing and synthetic frames. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tc001.h"
+
+#ifdef _WIN32
+#include <windows.h>
+static inline double bench_now_s(void) {
+    LARGE_INTEGER f, t;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart / (double)f.QuadPart;
+}
+#else
+#include <time.h>
+static inline double bench_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+#define BENCH_W 256
+#define BENCH_H 192
+
+/* A warm blob over a noisy background, roughly what the sensor produces. */
+static inline void bench_fill_scene(uint16_t* px, int w, int h, int seed) {
+    uint32_t r = 0x9E3779B9u ^ (uint32_t)seed;
+    int cx = w / 3 + seed % 17, cy = h / 2;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            r = r * 1664525u + 1013904223u;
+            int dx = x - cx, dy = y - cy;
+            int d2 = dx * dx + dy * dy;
+            int v = 18000 + (d2 < 900 ? (900 - d2) * 3 : 0) + (int)(r >> 28);
+            px[y * w + x] = (uint16_t)v;
+        }
+    }
+}
+
+/* Black -> purple -> red -> yellow -> white, like the usual thermal
+   palettes: 256 RGB triplets. */
+static inline void bench_palette(uint8_t* pal) {
+    for (int i = 0; i < 256; ++i) {
+        int r = i * 2, g = i * 2 - 255;
+        int b = i < 64 ? i * 2 : i < 128 ? (128 - i) * 2 : (i - 192) * 4;
+        pal[3 * i]     = (uint8_t)(r > 255 ? 255 : r);
+        pal[3 * i + 1] = (uint8_t)(g < 0 ? 0 : g);
+        pal[3 * i + 2] = (uint8_t)(b < 0 ? 0 : b > 255 ? 255 : b);
+    }
+}
+
+static inline tc001_frame bench_frame(const uint16_t* px, int w, int h) {
+    tc001_frame f = {0};
+    f.width = w;
+    f.height = h;
+    f.stride = w * 2;
+    f.format = TC001_FMT_U16;
+    f.data = (const uint8_t*)px;
+    return f;
+}
+
+static inline void bench_report(const char* name, int iters, double secs, size_t bytes_per_iter) {
+    double us = secs * 1e6 / iters;
+    printf("%-28s %9.2f us/iter", name, us);
+    if (bytes_per_iter)
+        printf("  %8.2f MB/s", (double)bytes_per_iter * iters / secs / 1e6);
+    printf("\n");
+}
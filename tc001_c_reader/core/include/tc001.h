@@ -34,10 +34,19 @@ typedef enum {
   TC001_ERR_USB     = -3,
   TC001_ERR_ALLOC   = -4,
   TC001_ERR_STATE   = -5,
-  TC001_ERR_INTERNAL= -6
+  TC001_ERR_INTERNAL= -6,
+  TC001_ERR_IO      = -7
 } tc001_status;
 
-typedef enum { TC001_FMT_U8 = 0, TC001_FMT_U16 = 1 } tc001_format;
+typedef enum {
+  TC001_FMT_U8   = 0,
+  TC001_FMT_U16  = 1,
+  TC001_FMT_RGB8 = 2        /* 3 bytes per pixel, R first; rendered, never from the sensor */
+} tc001_format;
+
+struct tc001_frame_stats;
+struct tc001_blob;
+struct tc001_frame_ref;
 
 typedef struct {
   int width;
@@ -45,14 +54,20 @@ typedef struct {
   int stride;               /* bytes per row */
   int64_t timestamp_ns;     /* 0 if unknown */
   tc001_format format;
-  const uint8_t* data;      /* points to lib-owned buffer; copy if you need to keep it */
+  const uint8_t* data;      /* lib-owned; to keep it past the callback use
+                               tc001_frame_retain, or copy it when ref is NULL */
+  const struct tc001_frame_stats* stats; /* lib-owned; NULL unless tc001_enable_stats */
+  uint32_t frame_id;        /* increments per delivered frame */
+  const struct tc001_blob* blobs; /* lib-owned; NULL unless tc001_enable_blobs */
+  int blob_count;
+  const struct tc001_frame_ref* ref; /* set when tc001_frame_retain can keep the frame */
 } tc001_frame;
 
 typedef void (*tc001_frame_cb)(const tc001_frame* f, void* user);
 
-/* ===== Packed/fusion types (must come BEFORE APIs that use them) ===== */
-#pragma pack(push, 1)
-
+/* ===== Fusion types (must come BEFORE APIs that use them) ===== */
+/* Naturally aligned so a payload can be read in place, including on ARM.
+   The pre-v2 packed layout is only decoded, by tc001_payload_open. */
 typedef struct { float m[9];  } tc001_mat3;   /* row-major 3x3 */
 typedef struct { float m[16]; } tc001_mat4;   /* row-major 4x4 */
 
@@ -62,12 +77,13 @@ typedef struct {
   uint16_t width, height;
   uint16_t stride_bytes;
   uint8_t  pixel_format;    /* 0 = U16_LE */
-  uint8_t  _pad0[3];
+  uint8_t  _pad0[5];
 } tc001_frame_info;
 
-typedef struct {
+typedef struct tc001_frame_stats {
   uint16_t raw_min, raw_max;
   uint16_t p10_raw, median_raw, p90_raw;
+  uint16_t _pad0;
   uint32_t bad_pixel_count;
   uint32_t hist256[256];    /* histogram of the 8-bit preview */
 } tc001_frame_stats;
@@ -75,11 +91,11 @@ typedef struct {
 typedef struct {
   uint16_t w, h;            /* e.g., 64x48 */
   uint16_t pitch;           /* bytes per row (== w if tightly packed) */
-  /* followed by w*h bytes (0..255), row-major */
 } tc001_thumbnail8;
 
 typedef struct {
   uint8_t  has_temp;        /* 0/1 */
+  uint8_t  _pad0[3];
   float    emissivity;      /* if known */
   float    ambient_C;       /* if known */
   float    gain_K_per_raw;  /* Kelvin = gain * raw + offset */
@@ -93,20 +109,42 @@ typedef struct {
   tc001_mat3 K_rgb;         /* set identity if unused */
   tc001_mat4 T_therm_rgb;   /* therm->rgb (R|t), identity if unused */
   float     H_therm_to_rgb[9]; /* optional homography; 0 if unused */
+  uint32_t  _pad0;
 } tc001_calibration;
 
+#define TC001_PAYLOAD_MAGIC    0x50314354u   /* "TC1P" little-endian */
+#define TC001_PAYLOAD_VERSION  2
+#define TC001_PAYLOAD_ALIGN    64
+
+/* v2 payload header. Every field sits at its natural alignment and each
+   blob offset is a multiple of TC001_PAYLOAD_ALIGN, so a payload placed at a
+   64-byte aligned address (malloc'd, mmap'd, shm) can be used in place. */
 typedef struct {
+  uint32_t magic;           /* TC001_PAYLOAD_MAGIC */
+  uint16_t version;         /* TC001_PAYLOAD_VERSION */
+  uint16_t hdr_bytes;       /* sizeof(tc001_payload_hdr) of the writer */
+  uint32_t total_bytes;     /* total size, a multiple of TC001_PAYLOAD_ALIGN */
+  /* Offsets (from start of this struct) to variable-length blobs: */
+  uint32_t off_raw_u16;     /* info.height rows of info.stride_bytes */
+  uint32_t off_thumb_u8;    /* thumb.h rows of thumb.pitch; 0 if absent */
+  tc001_thumbnail8 thumb;   /* all zero if absent */
+  uint8_t  _pad0[6];        /* zero; info starts at 32 */
   tc001_frame_info  info;
   tc001_frame_stats stats;
   tc001_temp_model  temp;
   tc001_calibration calib;
-  /* Offsets (from start of this struct) to variable-length blobs: */
-  uint32_t off_raw_u16;     /* width * height * 2 */
-  uint32_t off_thumb_u8;    /* sizeof(tc001_thumbnail8) + w*h */
-  uint32_t total_bytes;     /* total size of the packed payload */
 } tc001_payload_hdr;
 
-#pragma pack(pop)
+/* A validated payload of either version. For v2, hdr points into the
+   buffer; a v1 header is converted into 'upgraded' and hdr points there.
+   v1 blobs may be unaligned, so raw_u16 is exposed as bytes. */
+typedef struct {
+  int version;
+  const tc001_payload_hdr* hdr;
+  const uint8_t* raw_u16;
+  const uint8_t* thumb_u8;  /* NULL if absent */
+  tc001_payload_hdr upgraded;
+} tc001_payload_view;
 
 /* ===== Device control / streaming ===== */
 TC001_API tc001_status tc001_open(tc001_handle** out,
@@ -125,18 +163,315 @@ TC001_API void         tc001_get_frame_dims(tc001_handle* h, int* w, int* hgt);
 
 TC001_API void         tc001_u16_to_u8(const uint16_t* in, int count, uint8_t* out);
 
+/* ===== Early slices ===== */
+/* The rows of a frame still being received, for consumers that need only
+   the top of the image and should not wait for the rest. */
+typedef struct {
+  const uint8_t* data;      /* row 0; rows [0, rows) are valid, only during the call */
+  int width, height;        /* of the whole frame */
+  int stride;               /* bytes per row */
+  int rows;                 /* rows received so far */
+  uint32_t frame_id;        /* the frame's id once it is delivered whole */
+} tc001_slice;
+
+typedef void (*tc001_slice_cb)(const tc001_slice* s, void* user);
+
+/* Calls cb on the USB thread each time another every_rows rows of the
+   current frame (U16) have arrived, and at its last row, before the frame
+   callback. A frame cut short fires slices but is never delivered. 0 rows
+   or NULL disables. Set before tc001_start or from a callback. Replay
+   handles fire slices only with tc001_replay_options.packetize. */
+TC001_API tc001_status tc001_set_slice_callback(tc001_handle* h, int every_rows,
+                                                tc001_slice_cb cb, void* user);
+
+/* ===== ROI acquisition ===== */
+/* Assembles only the window x, y, w x hgt of the sensor image: packet
+   payloads are clipped against the window's byte range on each row as they
+   arrive, and frames and slices are tightly packed w x hgt images. w or
+   hgt 0 restores the whole sensor. The window must lie inside the sensor.
+   Not while streaming (TC001_ERR_STATE); tc001_get_frame_dims reports the
+   window from then on, so set it before tc001_enable_shm and
+   tc001_subscribe. */
+TC001_API tc001_status tc001_set_acquisition_roi(tc001_handle* h, int x, int y, int w, int hgt);
+
+/* ===== Frame statistics ===== */
+/* Fills every tc001_frame_stats field from one pass over a U16 frame.
+   Percentiles are nearest-rank raw values; hist256 bins the same min/max
+   AGC that tc001_u16_to_u8 applies. */
+TC001_API tc001_status tc001_compute_stats(const tc001_frame* f, tc001_frame_stats* out);
+
+/* When enabled, the library computes stats once per frame and attaches them
+   to the delivered tc001_frame (f->stats). Safe to toggle while streaming. */
+TC001_API tc001_status tc001_enable_stats(tc001_handle* h, int enable);
+
+/* ===== Buffers ===== */
+/* Frame-sized buffers (USB transfer, frame assembly, pool, latest frame)
+   are TC001_BUFFER_ALIGN aligned. tc001_set_allocator routes them through
+   the caller's allocator instead of the heap: alloc gets the size and the
+   alignment it must honour, free gets the size back. Both NULL restores the
+   default. Process-wide; TC001_ERR_STATE while any such buffer exists, so
+   set it before opening the first handle. Pool buffers are allocated on
+   the acquisition thread, so the hooks must be thread safe. */
+#define TC001_BUFFER_ALIGN 64
+
+typedef void* (*tc001_alloc_fn)(size_t size, size_t align, void* user);
+typedef void  (*tc001_free_fn)(void* p, size_t size, void* user);
+
+TC001_API tc001_status tc001_set_allocator(tc001_alloc_fn alloc, tc001_free_fn free_fn, void* user);
+
+/* Where a handle's buffers live; flags, 0 = the allocator above.
+   HUGEPAGES puts the frame assembly and pool buffers (and the USB transfer
+   buffer) in huge pages: reserved ones when the system has them, else
+   transparent huge pages on Linux, large pages on Windows with the lock
+   pages privilege; each buffer takes whole pages. USB_DMA takes the
+   transfer buffer from the kernel (libusb_dev_mem_alloc) so the controller
+   writes into memory the process maps, with no copy in usbfs; Linux only,
+   devices only. Frames are still assembled from the packets by the
+   library, since every packet carries a header. TC001_ERR_ALLOC or
+   TC001_ERR_USB when the backing is unavailable, leaving the old one.
+   Call before tc001_set_frame_pool, not while streaming. */
+typedef enum {
+  TC001_BACKING_HUGEPAGES = 1,
+  TC001_BACKING_USB_DMA   = 2
+} tc001_backing;
+
+TC001_API tc001_status tc001_set_buffer_backing(tc001_handle* h, int flags);
+
+/* ===== Frame pool ===== */
+/* Frames in refcounted buffers, so a consumer can keep one past its
+   callback by pointer instead of copying it. Frames are assembled straight
+   into pooled buffers (a replay's are copied in once), grown on demand up
+   to max_buffers of one sensor frame each. When every buffer is retained,
+   frames are delivered from the handle's own buffer with f->ref NULL and
+   counted as exhausted. 0 disables. Not while streaming, nor while frames
+   are retained. */
+TC001_API tc001_status tc001_set_frame_pool(tc001_handle* h, int max_buffers);
+
+/* Keeps f alive; use the returned frame from then on (same pixels, stats
+   copied, no blobs). NULL when f->ref is NULL: copy f instead. Any thread;
+   a retained frame may be retained again. */
+TC001_API const tc001_frame* tc001_frame_retain(const tc001_frame* f);
+
+/* Drops one retain; the buffer returns to the pool with the last. Every
+   retained frame must be released before tc001_close. */
+TC001_API void         tc001_frame_release(const tc001_frame* f);
+
+typedef struct {
+  int      buffers;         /* allocated so far */
+  int      max_buffers;
+  int      in_use;          /* retained, being delivered or being filled */
+  int      peak_in_use;
+  uint64_t retains;
+  uint64_t exhausted;       /* frames delivered without a pooled buffer */
+} tc001_pool_stats;
+
+TC001_API void         tc001_get_pool_stats(tc001_handle* h, tc001_pool_stats* out);
+
+/* ===== Latest frame ===== */
+/* When enabled, the acquisition thread also copies every frame into a
+   double buffer that any thread can read with tc001_peek_latest, for
+   readers that only want the most recent frame. Safe to toggle while
+   streaming. */
+TC001_API tc001_status tc001_enable_latest(tc001_handle* h, int enable);
+
+/* Copies the newest frame's pixels (U16, rows packed) into dst and, if info
+   is not NULL, its metadata (data = dst; no stats or blobs). With seq not
+   NULL, *seq names the frame the caller already has (0 = none): while
+   nothing newer has arrived the call returns TC001_ERR_STATE without
+   copying, and on success *seq names the copied frame. TC001_ERR_STATE
+   also before the first frame or when not enabled, TC001_ERR_PARAM when
+   dst_cap is too small. Takes no lock and never delays the acquisition
+   thread: a copy overwritten meanwhile is simply retried. */
+TC001_API tc001_status tc001_peek_latest(tc001_handle* h, void* dst, size_t dst_cap,
+                                         tc001_frame* info, uint32_t* seq);
+
+/* ===== Thumbnails ===== */
+/* Area-averaging downscale of a U16 frame to thumb_w x thumb_h 8-bit pixels
+   (any ratio, integer or not; no upscaling). With use_agc the means go
+   through the min/max AGC of tc001_u16_to_u8, taking the range from
+   f->stats when attached; otherwise the high byte is kept. */
+TC001_API tc001_status tc001_thumbnail(const tc001_frame* f, uint8_t* dst,
+                                       int thumb_w, int thumb_h, int pitch,
+                                       int use_agc);
+
+/* ===== Temperature ===== */
+typedef enum { TC001_TEMP_KELVIN = 0, TC001_TEMP_CELSIUS = 1 } tc001_temp_unit;
+
+/* Converts a U16 frame with model m (has_temp must be set, else
+   TC001_ERR_STATE): Kelvin = gain_K_per_raw * raw + offset_K. When the
+   emissivity is in (0, 1) the result is corrected as a grey body against
+   ambient_C. emissivity, if not NULL, is a per-pixel plane (width * height,
+   rows tightly packed) that overrides m->emissivity. dst_stride is in bytes.
+   A single-emissivity model is tabulated once per thread and model_id. */
+TC001_API tc001_status tc001_frame_to_temp(const tc001_frame* f,
+                                           const tc001_temp_model* m,
+                                           const float* emissivity,
+                                           tc001_temp_unit unit,
+                                           float* dst, int dst_stride);
+
+/* Same, as hundredths of a degree Celsius, rounded and saturated to
+   [-327.68, 327.67] C. */
+TC001_API tc001_status tc001_frame_to_centi_c(const tc001_frame* f,
+                                              const tc001_temp_model* m,
+                                              const float* emissivity,
+                                              int16_t* dst, int dst_stride);
+
+/* ===== ROI measurement ===== */
+/* Regions are registered once against a fixed frame size and measured on
+   every frame in one call. Rectangles, spots (pixel centres within radius
+   of (cx, cy)) and polygons (even-odd fill, vertices as x,y pairs in pixel
+   units) are clipped to the frame. ids are indices into the results array,
+   in the order regions were added. A set is not safe for concurrent
+   measurement; use one per thread. */
+typedef struct tc001_roi_set tc001_roi_set;
+
+typedef struct {
+  uint32_t count;           /* pixels inside the frame; 0 leaves the rest 0 */
+  uint16_t min_raw, max_raw;
+  float    mean_raw, stddev_raw;
+} tc001_roi_stats;
+
+TC001_API tc001_status tc001_roi_set_create(tc001_roi_set** out, int width, int height);
+TC001_API void         tc001_roi_set_destroy(tc001_roi_set* s);
+TC001_API void         tc001_roi_clear(tc001_roi_set* s);
+TC001_API int          tc001_roi_count(const tc001_roi_set* s);
+
+TC001_API tc001_status tc001_roi_add_rect(tc001_roi_set* s, int x, int y, int w, int h, int* id);
+TC001_API tc001_status tc001_roi_add_spot(tc001_roi_set* s, int cx, int cy, int radius, int* id);
+TC001_API tc001_status tc001_roi_add_polygon(tc001_roi_set* s, const float* xy, int n, int* id);
+
+/* Fills out[0 .. tc001_roi_count(s) - 1]. Raw units; see
+   tc001_frame_to_temp for conversion. */
+TC001_API tc001_status tc001_roi_measure(tc001_roi_set* s, const tc001_frame* f,
+                                         tc001_roi_stats* out, int out_count);
+
+/* ===== Hot / cold blobs ===== */
+/* Connected regions above a hot threshold or below a cold one, labelled in
+   a single run-length pass over the raw plane. */
+typedef enum {
+  TC001_BLOB_RAW = 0,         /* fixed raw thresholds, inclusive */
+  TC001_BLOB_PERCENTILE = 1   /* strictly above / below the frame's percentile */
+} tc001_blob_mode;
+
+typedef struct {
+  tc001_blob_mode mode;
+  uint16_t hot_raw, cold_raw; /* TC001_BLOB_RAW: hot v >= hot_raw, cold v <= cold_raw */
+  float    hot_pct, cold_pct; /* TC001_BLOB_PERCENTILE, e.g. 99 and 1 */
+  int      find_hot, find_cold;
+  int      connectivity;      /* 4 or 8 */
+  uint32_t min_area;          /* smaller blobs are dropped */
+  int      max_blobs;         /* largest first, hot and cold together */
+} tc001_blob_config;
+
+typedef struct tc001_blob {
+  uint32_t area;              /* pixels */
+  float    cx, cy;            /* centroid, pixel units */
+  uint16_t x0, y0, x1, y1;    /* bounding box, inclusive */
+  uint16_t peak_x, peak_y;
+  uint16_t peak_raw;          /* hottest pixel of a hot blob, coldest of a cold one */
+  uint8_t  hot;               /* 1 hot, 0 cold */
+  uint8_t  _pad0;
+  float    peak_C;            /* NAN unless a temp model with has_temp applies */
+} tc001_blob;
+
+/* Finds blobs in any U16 frame; temp may be NULL. Writes at most cap blobs
+   and their number to *count. */
+TC001_API tc001_status tc001_find_blobs(const tc001_frame* f,
+                                        const tc001_blob_config* cfg,
+                                        const tc001_temp_model* temp,
+                                        tc001_blob* out, int cap, int* count);
+
+/* When set, blobs are found on the USB thread and attached to every
+   delivered frame (f->blobs, f->blob_count), with peak_C from the handle's
+   temp model. NULL disables. Set before tc001_start or from the frame
+   callback. */
+TC001_API tc001_status tc001_enable_blobs(tc001_handle* h, const tc001_blob_config* cfg);
+
+/* ===== Subscribers ===== */
+/* More consumers of a handle's frames than the one tc001_start callback,
+   each with its own rate, region, format and delivery thread. Conversions
+   are shared: the 8-bit AGC plane is computed once per frame for all U8
+   and RGB8 subscribers, and each distinct palette once for its RGB8
+   subscribers. The AGC range is the whole frame's (f->stats when
+   attached), so every region maps raw counts the same way. Subscribers
+   run after the stats and blob stages and before the tc001_start
+   callback, which may then be NULL. */
+typedef struct tc001_subscription tc001_subscription;
+
+typedef enum {
+  TC001_SUB_INLINE = 0,     /* on the capture thread; data points into library buffers */
+  TC001_SUB_LATEST = 1,     /* own thread; a busy subscriber gets the newest frame next */
+  TC001_SUB_QUEUE  = 2      /* own thread; queue_frames frames wait, newer ones are dropped */
+} tc001_sub_policy;
+
+typedef struct {
+  int decimation;           /* every n-th frame; 0 = 1 */
+  int roi_x, roi_y;         /* region, clipped to the frame */
+  int roi_w, roi_h;         /* 0 = the whole frame */
+  tc001_format format;      /* U16 raw, U8 AGC or RGB8 */
+  const uint8_t* palette;   /* RGB8: 256 RGB triplets, copied; NULL = gray */
+  tc001_sub_policy policy;
+  int queue_frames;         /* TC001_SUB_QUEUE; 0 = 4 */
+} tc001_sub_options;
+
+typedef struct {
+  uint64_t delivered;
+  uint64_t dropped;         /* the subscriber was still busy */
+  uint64_t skipped;         /* left out by decimation */
+} tc001_sub_stats;
+
+/* Adds a subscriber; opts NULL delivers every raw frame inline. Frames on
+   a subscriber's own thread carry f->stats (copied) but no blobs. Safe
+   from any thread, including frame callbacks, while streaming or not; out
+   may be NULL. */
+TC001_API tc001_status tc001_subscribe(tc001_handle* h, tc001_frame_cb cb, void* user,
+                                       const tc001_sub_options* opts, tc001_subscription** out);
+
+/* Removes s. When it returns, s's callback is not running and will not be
+   called again, except when called from an inline subscriber's callback:
+   then s goes once the current frame has been delivered. Not from s's own
+   thread.
+   tc001_close removes the rest. */
+TC001_API void         tc001_unsubscribe(tc001_handle* h, tc001_subscription* s);
+
+TC001_API void         tc001_sub_get_stats(const tc001_subscription* s, tc001_sub_stats* out);
+
 /* ===== Fusion payload helpers (exported!) ===== */
+/* v2 payload layout: tc001_payload_hdr, then the raw U16 plane (rows
+   tightly packed) and the thumbnail pixels, each starting on a
+   TC001_PAYLOAD_ALIGN boundary. thumb_w/thumb_h of 0 omit the thumbnail.
+   Stats, the raw copy and the thumbnail all come from a single read of the
+   frame. */
 TC001_API size_t tc001_max_payload_bytes(int w, int h, int thumb_w, int thumb_h);
 
+/* Packs the frame currently being delivered; call it from the frame
+   callback. Returns bytes written, or 0 when dst_cap is too small or no
+   frame is in flight. */
 TC001_API size_t tc001_pack_payload(tc001_handle* h,
                                     void* dst, size_t dst_cap,
                                     int thumb_w, int thumb_h,
                                     int use_agc);
 
+/* Same as tc001_pack_payload for any U16 frame; calib/temp may be NULL. */
+TC001_API size_t tc001_pack_frame(const tc001_frame* f,
+                                  const tc001_calibration* calib,
+                                  const tc001_temp_model* temp,
+                                  void* dst, size_t dst_cap,
+                                  int thumb_w, int thumb_h,
+                                  int use_agc);
+
+/* Stored in the handle and copied into every packed payload. Defaults are
+   identity matrices and has_temp = 0. Set before tc001_start or from the
+   frame callback. */
 TC001_API void   tc001_set_calibration(tc001_handle* h, const tc001_calibration* c);
 
 TC001_API void   tc001_set_temp_model(tc001_handle* h, const tc001_temp_model* t);
 
+/* Validates a v2 or legacy v1 payload of len bytes and fills *out. No copy
+   of the blobs is made; out borrows buf. */
+TC001_API tc001_status tc001_payload_open(const void* buf, size_t len,
+                                          tc001_payload_view* out);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,54 @@
+#pragma once
+/* Lossless codec for raw U16 thermal frames.
+
+   Each row is predicted spatially (LOCO-I median edge detector), temporally
+   (previous frame), or both (median predictor on the frame difference),
+   whichever is cheapest, and the residuals are Golomb-Rice coded with a
+   parameter chosen per 16 pixels. Rows that do not compress are stored raw,
+   so a frame never grows by more than a few bytes.
+
+   Delta frames depend on the previous frame, so a codec keeps state: use one
+   tc001_codec per direction and stream, feed frames in order, and start
+   decoding at a keyframe. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tc001_codec tc001_codec;
+
+typedef struct {
+  int      width, height;
+  int      keyframe;          /* decodable without the previous frame */
+  uint32_t seq;               /* encoder's frame counter */
+  size_t   bytes;             /* size of the encoded frame */
+} tc001_codec_info;
+
+TC001_API tc001_status tc001_codec_create(tc001_codec** out, int width, int height);
+TC001_API void         tc001_codec_destroy(tc001_codec* c);
+
+/* Forgets the previous frame: the next frame encoded is a keyframe, and a
+   decoder waits for one. */
+TC001_API void         tc001_codec_reset(tc001_codec* c);
+
+/* Upper bound on one encoded frame. */
+TC001_API size_t       tc001_codec_max_bytes(int width, int height);
+
+/* Encodes f (U16, the codec's size) into dst. keyframe forces a frame that
+   does not reference the previous one; the first frame always is. */
+TC001_API tc001_status tc001_encode_frame(tc001_codec* c, const tc001_frame* f, int keyframe,
+                                          void* dst, size_t dst_cap, size_t* written);
+
+/* Decodes one frame into dst (dst_stride in bytes). A delta frame that does
+   not follow the last decoded one returns TC001_ERR_STATE; corrupt input
+   returns TC001_ERR_PARAM. */
+TC001_API tc001_status tc001_decode_frame(tc001_codec* c, const void* src, size_t len,
+                                          uint16_t* dst, int dst_stride);
+
+/* Reads an encoded frame's header without decoding it. */
+TC001_API tc001_status tc001_codec_peek(const void* src, size_t len, tc001_codec_info* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+/* tc001d: one process owns a camera and serves its frames to local
+   clients over a Unix domain socket.
+
+   A client connects, sends one request (format, decimation, palette) and
+   receives the descriptor of a shared-memory frame ring (tc001_shm.h)
+   over SCM_RIGHTS; from then on it reads frames straight from the ring and
+   the socket only marks the subscription: closing it unsubscribes. Clients
+   asking for the same format, decimation and palette share one ring, so
+   each conversion runs once per frame however many clients want it, and
+   an attached client costs the daemon nothing per frame.
+
+   POSIX only; on Windows every function returns TC001_ERR_STATE. */
+#include "tc001.h"
+#include "tc001_shm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== Wire protocol (host byte order; both ends are local) ===== */
+#define TC001_DAEMON_MAGIC   0x44314354u   /* "TC1D" little-endian */
+#define TC001_DAEMON_VERSION 1
+
+typedef struct {
+  uint32_t magic, version;
+  uint32_t format;          /* tc001_format: U16 raw, U8 through the AGC, RGB8 */
+  uint32_t decimation;      /* every n-th camera frame; 0 = 1 */
+  uint32_t has_palette;     /* RGB8: palette holds 256 RGB triplets; else gray */
+  uint8_t  palette[768];
+} tc001_daemon_request;
+
+/* Answers a request; carries the ring's descriptor when status is OK. */
+typedef struct {
+  uint32_t magic;
+  int32_t  status;          /* tc001_status */
+  uint32_t width, height, format, decimation;
+} tc001_daemon_reply;
+
+/* ===== Server ===== */
+typedef struct tc001_daemon tc001_daemon;
+
+typedef struct {
+  const char* socket_path;  /* replaced if it exists */
+  int max_clients;          /* 0 = 64; also at most TC001_SHM_MAX_READERS per ring */
+  int slots;                /* ring depth per stream; 0 = 8 */
+} tc001_daemon_options;
+
+typedef struct {
+  int      clients;
+  int      streams;         /* distinct format/decimation/palette rings */
+  uint64_t frames;          /* delivered by the camera */
+  uint64_t published;       /* written to rings, all streams */
+  uint64_t frame_ns;        /* summed time converting and publishing */
+  uint64_t attaches, rejected;
+  uint64_t attach_ns, attach_ns_max;  /* request read -> reply sent */
+} tc001_daemon_stats;
+
+/* Binds the socket for h (opened with tc001_open or tc001_open_replay,
+   not started). h stays owned by the caller and must outlive d. */
+TC001_API tc001_status tc001_daemon_create(tc001_daemon** out, tc001_handle* h,
+                                           const tc001_daemon_options* opts);
+
+/* tc001_start with the daemon's frame callback. */
+TC001_API tc001_status tc001_daemon_start(tc001_daemon* d, char* err, size_t errcap);
+
+/* Accepts clients and answers their requests for up to timeout_ms; call
+   it in a loop. Frames are published on the handle's thread. */
+TC001_API tc001_status tc001_daemon_serve(tc001_daemon* d, int timeout_ms);
+
+TC001_API void         tc001_daemon_get_stats(tc001_daemon* d, tc001_daemon_stats* out);
+
+/* Stops the handle, drops every client and removes the socket. */
+TC001_API void         tc001_daemon_destroy(tc001_daemon* d);
+
+/* ===== Client ===== */
+typedef struct tc001_daemon_client tc001_daemon_client;
+
+typedef struct {
+  tc001_format format;      /* U16, U8 or RGB8 */
+  int decimation;           /* 0 = every frame */
+  const uint8_t* palette;   /* RGB8: 256 RGB triplets; NULL = gray */
+} tc001_daemon_sub_options;
+
+/* Connects, subscribes and maps the ring; read it with tc001_shm_next or
+   tc001_shm_latest on tc001_daemon_client_sub. opts NULL asks for raw U16
+   frames. */
+TC001_API tc001_status tc001_daemon_subscribe(tc001_daemon_client** out, const char* socket_path,
+                                              const tc001_daemon_sub_options* opts);
+
+TC001_API tc001_shm_sub* tc001_daemon_client_sub(tc001_daemon_client* c);
+
+/* Unmaps the ring and closes the connection. */
+TC001_API void         tc001_daemon_unsubscribe(tc001_daemon_client* c);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
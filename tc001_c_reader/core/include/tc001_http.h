@@ -0,0 +1,74 @@
+#pragma once
+/* Embedded HTTP server for viewing a camera in a browser.
+
+   Frames pushed to the server are encoded to JPEG once, whatever the
+   number of viewers, and the encoded buffer is shared by reference count
+   among every connection sending it. Sockets are non-blocking on one epoll
+   loop. A viewer that cannot keep up holds at most the frame it is sending
+   and the newest one after it; frames in between are dropped for that
+   viewer only, so a slow client never grows memory or delays the others.
+
+   Endpoints:
+     /            a page showing the stream
+     /stream      multipart/x-mixed-replace MJPEG, one part per frame
+     /frame.jpg   the next frame as one JPEG
+     /raw         the next frame's pixels, rows packed, little-endian;
+                  X-TC001-Width, -Height, -Format and -Frame headers
+                  describe it
+
+   Nothing is encoded or copied while nobody is asking for it. Linux only;
+   elsewhere every function returns TC001_ERR_STATE. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tc001_http tc001_http;
+
+typedef struct {
+  const char* address;      /* IPv4 address to bind; NULL = "127.0.0.1" */
+  int port;                 /* 0 = any free port (see tc001_http_port) */
+  int max_clients;          /* 0 = 32 */
+  int quality;              /* JPEG quality; 0 = 85 */
+  const uint8_t* palette;   /* 256 RGB triplets; NULL = grayscale; copied */
+} tc001_http_options;
+
+typedef struct {
+  int      clients;         /* connected */
+  int      viewers;         /* on /stream */
+  uint64_t frames;          /* pushed */
+  uint64_t skipped;         /* replaced before the server loop took them */
+  uint64_t encoded;         /* JPEGs encoded, once per frame */
+  uint64_t encoded_bytes;
+  uint64_t encode_ns;
+  uint64_t requests, rejected;
+  uint64_t sent;            /* frames fully written, all clients */
+  uint64_t dropped;         /* frames a slow viewer never got */
+  uint64_t bytes_sent;
+} tc001_http_stats;
+
+TC001_API tc001_status tc001_http_create(tc001_http** out, const tc001_http_options* opts);
+
+/* The bound port. */
+TC001_API int          tc001_http_port(const tc001_http* s);
+
+/* Hands a frame to the server; returns once it is encoded (if anyone is
+   watching). Call from one thread at a time, usually the frame callback. */
+TC001_API void         tc001_http_push(tc001_http* s, const tc001_frame* f);
+
+/* tc001_http_push as a tc001_frame_cb, for tc001_start(h, tc001_http_on_frame, s, ...). */
+TC001_API void         tc001_http_on_frame(const tc001_frame* f, void* server);
+
+/* Accepts connections, reads requests and sends frames for up to
+   timeout_ms; call it in a loop on one thread. */
+TC001_API tc001_status tc001_http_serve(tc001_http* s, int timeout_ms);
+
+TC001_API void         tc001_http_get_stats(tc001_http* s, tc001_http_stats* out);
+
+/* Closes every connection. Stop pushing first. */
+TC001_API void         tc001_http_destroy(tc001_http* s);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+/* Baseline JPEG encoder for preview frames, and MJPEG containers.
+
+   Grayscale frames are written as one component; RGB and palette frames as
+   YCbCr 4:2:0. Every JPEG carries its own quantisation and Huffman tables
+   (the standard Annex K ones), so frames decode on their own and can be
+   used as MJPEG frames as they are.
+
+   An encoder keeps per-size scratch and a cached palette; use one per
+   thread. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tc001_jpeg tc001_jpeg;
+
+/* quality 1..100 as in libjpeg; 0 = 85. */
+TC001_API tc001_status tc001_jpeg_create(tc001_jpeg** out, int quality);
+TC001_API void         tc001_jpeg_destroy(tc001_jpeg* j);
+
+/* Upper bound on one encoded frame; color selects the 4:2:0 layout. */
+TC001_API size_t       tc001_jpeg_max_bytes(int width, int height, int color);
+
+/* Each encoder writes one complete JPEG (SOI..EOI) into dst and returns
+   TC001_ERR_PARAM when it does not fit in dst_cap. pitch is in bytes. */
+TC001_API tc001_status tc001_jpeg_encode_gray(tc001_jpeg* j, const uint8_t* px,
+                                              int width, int height, int pitch,
+                                              void* dst, size_t dst_cap, size_t* written);
+
+/* rgb: 3 bytes per pixel, R first. */
+TC001_API tc001_status tc001_jpeg_encode_rgb(tc001_jpeg* j, const uint8_t* rgb,
+                                             int width, int height, int pitch,
+                                             void* dst, size_t dst_cap, size_t* written);
+
+/* idx: one palette index per pixel; palette: 256 RGB triplets. */
+TC001_API tc001_status tc001_jpeg_encode_indexed(tc001_jpeg* j, const uint8_t* idx,
+                                                 int width, int height, int pitch,
+                                                 const uint8_t* palette,
+                                                 void* dst, size_t dst_cap, size_t* written);
+
+/* A frame as delivered to the callback. U16 frames go through the min/max
+   AGC of tc001_u16_to_u8 (the range of f->stats when attached). With a
+   palette the 8-bit values index it, otherwise the JPEG is grayscale. */
+TC001_API tc001_status tc001_jpeg_encode_frame(tc001_jpeg* j, const tc001_frame* f,
+                                               const uint8_t* palette,
+                                               void* dst, size_t dst_cap, size_t* written);
+
+/* ===== MJPEG ===== */
+/* A stream of JPEG frames, either an AVI file (RIFF, MJPG, with an idx1
+   index) or multipart/x-mixed-replace parts handed to a write callback,
+   as served over HTTP. */
+typedef struct tc001_mjpeg tc001_mjpeg;
+
+/* Returns 0 when all n bytes were written. */
+typedef int (*tc001_write_fn)(const void* buf, size_t n, void* user);
+
+#define TC001_MJPEG_BOUNDARY "tc001frame"
+#define TC001_MJPEG_CONTENT_TYPE "multipart/x-mixed-replace; boundary=" TC001_MJPEG_BOUNDARY
+
+/* Creates (truncates) path. The AVI header is rewritten with the frame
+   count on close; until then the file plays up to its last frame in most
+   players but has no index. */
+TC001_API tc001_status tc001_mjpeg_open_avi(tc001_mjpeg** out, const char* path,
+                                            int width, int height, double fps);
+
+TC001_API tc001_status tc001_mjpeg_open_multipart(tc001_mjpeg** out,
+                                                  tc001_write_fn write, void* user);
+
+/* Appends one JPEG, as produced by the tc001_jpeg_encode_* functions. */
+TC001_API tc001_status tc001_mjpeg_write(tc001_mjpeg* m, const void* jpeg, size_t n);
+
+/* Finishes the stream (index and header, or the closing boundary) and
+   frees m, also on error. */
+TC001_API tc001_status tc001_mjpeg_close(tc001_mjpeg* m);
+
+/* Writes the header that precedes a JPEG of jpeg_bytes in a multipart
+   stream; the part ends with "\r\n" after the JPEG. Returns its length, or
+   0 when cap is too small. */
+TC001_API size_t       tc001_mjpeg_part_header(char* dst, size_t cap, size_t jpeg_bytes);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
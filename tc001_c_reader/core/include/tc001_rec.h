@@ -0,0 +1,171 @@
+#pragma once
+/* Recording container for frame streams.
+
+   A file is a tc001_rec_header, then one chunk per frame, then an index and
+   a footer written when the recording is finished. Everything is
+   little-endian and every chunk payload starts on a TC001_REC_ALIGN
+   boundary, so raw frames are read in place from a mapping.
+
+   Chunks are self-describing and checksummed, and are only ever appended,
+   so a recording cut short (crash, power loss, full disk) loses at most
+   the frames not yet written: readers rebuild the index by scanning, and
+   tc001_rec_recover makes the file complete again. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TC001_REC_MAGIC    0x52314354u   /* "TC1R" little-endian */
+#define TC001_REC_VERSION  1
+#define TC001_REC_ALIGN    64
+
+typedef enum {
+  TC001_REC_RAW      = 0,   /* rows tightly packed, readable in place */
+  TC001_REC_LOSSLESS = 1    /* tc001_codec frames; U16 only */
+} tc001_rec_codec;
+
+typedef struct {
+  uint32_t magic;           /* TC001_REC_MAGIC */
+  uint16_t version;         /* TC001_REC_VERSION */
+  uint16_t hdr_bytes;       /* sizeof(tc001_rec_header) of the writer */
+  uint16_t width, height;
+  uint8_t  format;          /* tc001_format */
+  uint8_t  codec;           /* tc001_rec_codec */
+  uint16_t keyframe_interval;
+  int64_t  created_ns;      /* Unix epoch */
+  uint32_t data_offset;     /* first chunk */
+  uint32_t _pad0;
+  tc001_temp_model  temp;
+  uint32_t _pad1;
+  tc001_calibration calib;
+} tc001_rec_header;
+
+/* ===== Writing ===== */
+typedef struct tc001_rec_writer tc001_rec_writer;
+
+typedef struct {
+  tc001_rec_codec codec;
+  int keyframe_interval;    /* TC001_REC_LOSSLESS: frames per keyframe; 0 = 25 */
+  int sync_every;           /* flush to disk every N frames; 0 = only at finish */
+} tc001_rec_options;
+
+/* Creates (truncates) path for frames of width x height in format. opts,
+   calib and temp may be NULL (raw, identity, no temperature model). */
+TC001_API tc001_status tc001_rec_create(tc001_rec_writer** out, const char* path,
+                                        int width, int height, tc001_format format,
+                                        const tc001_rec_options* opts,
+                                        const tc001_calibration* calib,
+                                        const tc001_temp_model* temp);
+
+/* Appends one frame; its size and format must match the recording. */
+TC001_API tc001_status tc001_rec_write(tc001_rec_writer* w, const tc001_frame* f);
+
+/* Writes the index and footer, syncs, and frees w (also on error). */
+TC001_API tc001_status tc001_rec_finish(tc001_rec_writer* w);
+
+/* Truncates an unfinished recording after its last intact chunk and
+   writes the index. A finished file is left alone. frames may be NULL. */
+TC001_API tc001_status tc001_rec_recover(const char* path, uint32_t* frames);
+
+/* ===== Background recorder ===== */
+/* Records from a writer thread, so the frame callback only copies the
+   frame into a bounded single-producer queue. Queued frames are encoded
+   and written in batches with one vectored write each. */
+typedef struct tc001_recorder tc001_recorder;
+
+typedef enum {
+  TC001_REC_DROP  = 0,      /* a full queue drops the new frame */
+  TC001_REC_BLOCK = 1       /* tc001_recorder_push waits for room */
+} tc001_rec_policy;
+
+typedef struct {
+  tc001_rec_options rec;
+  int queue_frames;         /* 0 = 64 */
+  int batch_frames;         /* most frames per write; 0 = 16 */
+  int direct_io;            /* bypass the page cache where supported */
+  tc001_rec_policy policy;
+} tc001_recorder_options;
+
+typedef struct {
+  uint64_t frames_queued;
+  uint64_t frames_written;
+  uint64_t frames_dropped;  /* queue full, or after a write error */
+  uint64_t bytes_written;
+  uint64_t writes;          /* write calls */
+  uint32_t queue_depth, queue_peak, queue_capacity;
+  uint32_t write_us_last, write_us_max, write_us_mean;
+  int      direct_io;       /* 1 when writes bypass the page cache */
+  tc001_status error;       /* first write error; recording stops there */
+} tc001_recorder_stats;
+
+/* Same arguments as tc001_rec_create; opts may be NULL. */
+TC001_API tc001_status tc001_recorder_start(tc001_recorder** out, const char* path,
+                                            int width, int height, tc001_format format,
+                                            const tc001_recorder_options* opts,
+                                            const tc001_calibration* calib,
+                                            const tc001_temp_model* temp);
+
+/* Queues a copy of f. Call from one thread at a time (the frame callback).
+   Returns TC001_ERR_STATE when the frame was dropped, or the writer's
+   error once writing has failed. */
+TC001_API tc001_status tc001_recorder_push(tc001_recorder* rc, const tc001_frame* f);
+
+/* Safe from any thread. */
+TC001_API void         tc001_recorder_stats_get(tc001_recorder* rc, tc001_recorder_stats* out);
+
+/* Writes everything queued, finishes the file and frees rc. */
+TC001_API tc001_status tc001_recorder_finish(tc001_recorder* rc);
+
+/* ===== Reading ===== */
+/* Maps the file; a missing or damaged index is rebuilt in memory by
+   scanning. A reader is not safe for concurrent use. */
+typedef struct tc001_rec_reader tc001_rec_reader;
+
+TC001_API tc001_status tc001_rec_open(tc001_rec_reader** out, const char* path);
+TC001_API void         tc001_rec_close(tc001_rec_reader* r);
+
+TC001_API const tc001_rec_header* tc001_rec_info(const tc001_rec_reader* r);
+TC001_API uint32_t     tc001_rec_frame_count(const tc001_rec_reader* r);
+
+/* 1 when the index was rebuilt by scanning (unfinished recording). */
+TC001_API int          tc001_rec_was_recovered(const tc001_rec_reader* r);
+
+/* Frame at index i, found in O(1) through the index. Raw frames point into
+   the mapping; lossless ones are decoded into the reader, from the nearest
+   keyframe unless i follows the previous read. f->data stays valid until
+   the next read or close. */
+TC001_API tc001_status tc001_rec_read(tc001_rec_reader* r, uint32_t i, tc001_frame* f);
+
+/* Index of the last frame with timestamp_ns <= ts (0 if none). */
+TC001_API uint32_t     tc001_rec_find_time(const tc001_rec_reader* r, int64_t ts);
+
+/* ===== Replay ===== */
+/* A handle that plays a U16 recording through the tc001_start callback,
+   with the recording's calibration and temperature model and the same
+   per-frame stages (stats, blobs) as a device. Frames carry their recorded
+   timestamps, shifted forward on each loop so they keep increasing. */
+typedef struct {
+  double   speed;           /* 1 = recorded timing, 4 = four times faster,
+                               0 = as fast as the callback returns */
+  int      loop;            /* start over at the end instead of stopping */
+  uint32_t first;           /* index of the first frame played */
+  int      packetize;       /* feed frames through the USB frame assembly in
+                               packets spread over the frame interval, as a
+                               camera sends them, for slice callbacks */
+} tc001_replay_options;
+
+/* Opens path in place of tc001_open; opts NULL plays once at speed 1. A
+   late frame is delivered late, never dropped, so the frame sequence is
+   the same at every speed. */
+TC001_API tc001_status tc001_open_replay(tc001_handle** out, const char* path,
+                                         const tc001_replay_options* opts,
+                                         char* err, size_t errcap);
+
+/* 1 once a non-looping replay has delivered its last frame; 0 for a
+   device handle. */
+TC001_API int          tc001_replay_done(tc001_handle* h);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+/* Preview rendering: a frame through the min/max AGC and a palette to a
+   rotated RGB image, optionally recorded as an MJPEG AVI.
+
+   A tc001_render_ctx owns everything one camera's preview needs (the
+   8-bit and RGB images, the palette, the JPEG encoder, the AVI writer and
+   the counters), and the library keeps no state of its own for it, so
+   contexts for different cameras can render on different threads at the
+   same time. A context itself is used by one thread at a time. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tc001_render_ctx tc001_render_ctx;
+
+typedef struct {
+  int rotation;             /* clockwise: 0, 90, 180 or 270 */
+  const uint8_t* palette;   /* 256 RGB triplets, copied; NULL = grayscale */
+  const char* avi_path;     /* also record an MJPEG AVI; NULL = render only */
+  double fps;               /* AVI frame rate; 0 = 25 */
+  int quality;              /* JPEG quality; 0 = 85 */
+} tc001_render_options;
+
+/* One rendered frame. rgb and gray belong to the context and stay valid
+   until its next tc001_render_frame. */
+typedef struct {
+  const uint8_t* rgb;       /* 3 bytes per pixel, R first */
+  const uint8_t* gray;      /* the 8-bit AGC image the palette indexed */
+  int width, height;        /* after rotation */
+  int pitch;                /* bytes per rgb row; gray rows are width bytes */
+  uint32_t index;           /* frames this context rendered before this one */
+  uint16_t raw_min, raw_max;
+  int flat;                 /* raw_min == raw_max: rendered black */
+} tc001_render_image;
+
+typedef struct {
+  uint64_t frames;          /* rendered */
+  uint64_t flat_frames;
+  uint64_t encoded_frames;  /* appended to the AVI */
+  uint64_t encoded_bytes;
+  uint64_t render_ns;       /* summed time spent rendering */
+  uint64_t encode_ns;       /* summed time spent encoding and writing */
+  tc001_status write_error; /* first AVI error; recording stops there */
+} tc001_render_stats;
+
+/* opts may be NULL (grayscale, unrotated, not recorded). The AVI is
+   created by the first tc001_render_frame, sized from that frame. */
+TC001_API tc001_status tc001_render_create(tc001_render_ctx** out, const tc001_render_options* opts);
+
+/* Closes the AVI (writing its index) and frees ctx. Returns the AVI's
+   first error, if any. */
+TC001_API tc001_status tc001_render_destroy(tc001_render_ctx* ctx);
+
+/* Renders a U8 or U16 frame (the range of f->stats when attached) and,
+   when recording, encodes it and appends it to the AVI. Returns the AVI
+   error the first time writing fails; later frames are rendered but not
+   recorded. The frame size may change only when not recording. out may be
+   NULL. */
+TC001_API tc001_status tc001_render_frame(tc001_render_ctx* ctx, const tc001_frame* f,
+                                          tc001_render_image* out);
+
+TC001_API void tc001_render_get_stats(const tc001_render_ctx* ctx, tc001_render_stats* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
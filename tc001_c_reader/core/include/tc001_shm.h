@@ -0,0 +1,100 @@
+#pragma once
+/* Shared-memory frame ring: one publisher process, many subscribers.
+
+   The publisher copies each frame once into the next slot of a ring in a
+   shared-memory segment (a POSIX shm_open name, or an anonymous memfd
+   whose descriptor is passed to subscribers). Every slot carries a
+   sequence lock, odd while the slot is written, so subscribers read frames
+   in place: no copies and no system calls once mapped. A view of a slot
+   stays readable until the publisher laps the ring; tc001_shm_view_valid
+   says whether it was overwritten while in use.
+
+   Each subscriber owns an entry in the segment's reader table where it
+   records the last frame it read, so the publisher can see how far behind
+   every reader is. On Windows the segment is a named file mapping and
+   descriptors are not available. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TC001_SHM_MAX_READERS 32
+
+typedef struct tc001_shm_pub tc001_shm_pub;
+typedef struct tc001_shm_sub tc001_shm_sub;
+
+typedef struct {
+  const char* name;         /* "/tc001-cam0"; NULL = anonymous (memfd) */
+  int slots;                /* ring depth, >= 2; 0 = 8 */
+  int width, height;        /* of every published frame */
+  tc001_format format;      /* U8, U16 or RGB8 */
+} tc001_shm_options;
+
+/* One reader table entry, as seen by the publisher. */
+typedef struct {
+  int      pid;             /* of the subscriber process */
+  uint32_t last_seq;        /* sequence number of the last frame it read */
+  uint32_t lag;             /* frames published since then */
+  uint32_t dropped;         /* frames it skipped because the ring lapped it */
+} tc001_shm_reader;
+
+/* Creates the segment (replacing a stale one of the same name). */
+TC001_API tc001_status tc001_shm_pub_create(tc001_shm_pub** out, const tc001_shm_options* opts);
+
+/* Unmaps and, for a named segment, unlinks it. Mapped subscribers keep
+   their mapping but see no new frames. */
+TC001_API void         tc001_shm_pub_destroy(tc001_shm_pub* p);
+
+/* The segment's descriptor, for passing to another process; -1 on
+   Windows. Stays owned by p. */
+TC001_API int          tc001_shm_pub_fd(const tc001_shm_pub* p);
+
+/* Copies f into the next slot. f must match the ring's size and format. */
+TC001_API tc001_status tc001_shm_publish(tc001_shm_pub* p, const tc001_frame* f);
+
+/* Frames published so far; the last one has sequence number count - 1. */
+TC001_API uint32_t     tc001_shm_pub_count(const tc001_shm_pub* p);
+
+/* Writes up to cap attached readers to out and returns how many are
+   attached. */
+TC001_API int          tc001_shm_pub_readers(const tc001_shm_pub* p, tc001_shm_reader* out, int cap);
+
+/* Publishes every frame the handle delivers, before the frame callback.
+   NULL stops. Set before tc001_start or from the frame callback; p must
+   outlive its use by h. */
+TC001_API tc001_status tc001_enable_shm(tc001_handle* h, tc001_shm_pub* p);
+
+/* ===== Subscriber ===== */
+/* A frame in the ring. frame.data points into the shared mapping;
+   frame.stats and frame.blobs are NULL. */
+typedef struct {
+  tc001_frame frame;
+  uint32_t    seq;          /* publish sequence number */
+  uint32_t    lock;         /* slot lock value when read */
+} tc001_shm_view;
+
+/* Maps a segment by name, or by descriptor (duplicated) when name is NULL,
+   and claims a reader table entry. TC001_ERR_STATE when all
+   TC001_SHM_MAX_READERS entries are taken. */
+TC001_API tc001_status tc001_shm_sub_open(tc001_shm_sub** out, const char* name, int fd);
+
+/* Releases the reader entry and unmaps. */
+TC001_API void         tc001_shm_sub_close(tc001_shm_sub* s);
+
+/* The most recent frame. TC001_ERR_STATE when none has been published. */
+TC001_API tc001_status tc001_shm_latest(tc001_shm_sub* s, tc001_shm_view* v);
+
+/* The frame after the last one read. When the ring lapped this reader it
+   resumes at the oldest frame still held and counts the skipped ones as
+   dropped. Waits up to timeout_ns (spinning, then sleeping in short
+   steps) and returns TC001_ERR_STATE when nothing new arrived. */
+TC001_API tc001_status tc001_shm_next(tc001_shm_sub* s, tc001_shm_view* v, int64_t timeout_ns);
+
+/* 1 while the slot behind v has not been overwritten. Check after using
+   the pixels: if it returns 0, what was read may be torn. */
+TC001_API int          tc001_shm_view_valid(const tc001_shm_sub* s, const tc001_shm_view* v);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
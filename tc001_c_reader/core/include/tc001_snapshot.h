@@ -0,0 +1,48 @@
+#pragma once
+/* Still-image snapshots: BMP, PGM/PPM and PNG.
+
+   Each file is assembled in one buffer and written with a single call, so
+   a burst of snapshots costs one write per frame. The _encode functions
+   fill a caller buffer (size it with tc001_snapshot_max_bytes); the _save
+   functions reuse a per-thread buffer and write path in one go.
+
+   PNG is written without zlib: TC001_SNAP_PNG stores the rows uncompressed
+   (deflate stored blocks), TC001_SNAP_PNG_RLE codes repeated bytes of the
+   Sub-filtered rows as runs, which pays off on flat and palette images. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  TC001_SNAP_BMP     = 0,   /* 24-bit; U16 frames go through the min/max AGC */
+  TC001_SNAP_PNM     = 1,   /* PGM (8 or 16 bit) for frames, PPM for RGB */
+  TC001_SNAP_PNG     = 2,   /* 8 or 16 bit gray, or RGB; stored */
+  TC001_SNAP_PNG_RLE = 3    /* as TC001_SNAP_PNG, run-length coded */
+} tc001_snap_format;
+
+/* Upper bound on the file size; channels is 1 for frames, 3 for RGB. */
+TC001_API size_t tc001_snapshot_max_bytes(int width, int height, tc001_format format,
+                                          int channels, tc001_snap_format fmt);
+
+/* A U8 or U16 frame as grayscale. PGM and PNG keep all 16 bits of U16
+   frames (samples big-endian in the file, as the formats require). */
+TC001_API tc001_status tc001_snapshot_encode(const tc001_frame* f, tc001_snap_format fmt,
+                                             void* dst, size_t dst_cap, size_t* written);
+
+/* rgb: 3 bytes per pixel, R first; pitch in bytes. */
+TC001_API tc001_status tc001_snapshot_encode_rgb(const uint8_t* rgb, int width, int height,
+                                                 int pitch, tc001_snap_format fmt,
+                                                 void* dst, size_t dst_cap, size_t* written);
+
+/* Encode and write path (created or truncated) with one write. */
+TC001_API tc001_status tc001_snapshot_save(const char* path, const tc001_frame* f,
+                                           tc001_snap_format fmt);
+TC001_API tc001_status tc001_snapshot_save_rgb(const char* path, const uint8_t* rgb,
+                                               int width, int height, int pitch,
+                                               tc001_snap_format fmt);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+/* Raw U16 frames over UDP, sending only the tiles that changed.
+
+   The sender splits each frame into square tiles and compares them with
+   what the receiver already holds; a tile goes out only when some pixel
+   moved by more than the threshold. Every keyframe_interval frames all
+   tiles are sent. Packets are RTP (version 2, dynamic payload type 96,
+   90 kHz timestamps) carrying a small frame header and whole tiles, so a
+   lost packet costs only the tiles in it.
+
+   The receiver's image is exactly the sender's reference: with threshold 0
+   that is the frame itself, otherwise every pixel is within threshold of
+   it. Tiles travel in index order, so a sequence gap tells the receiver
+   which tiles a lost packet may have carried; those stay stale until they
+   are sent again (when they change, or at the next keyframe) and frames
+   are marked inexact meanwhile. Pixels are little-endian on the wire.
+
+   A receiver follows one sender (RTP SSRC) at a time. Packets from another
+   are ignored while the current one is sending; once it has been silent
+   for a second the next sender is taken on from scratch: every tile is
+   invalid until its next keyframe, so a restarted sender should be given
+   a keyframe_interval (or tc001_udp_request_keyframe) to recover.
+
+   POSIX only; on Windows every function returns TC001_ERR_STATE. */
+#include "tc001.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TC001_UDP_PAYLOAD_TYPE 96
+
+/* ===== Sender ===== */
+typedef struct tc001_udp_sender tc001_udp_sender;
+
+typedef struct {
+  const char* host;         /* IPv4 address of the receiver */
+  int port;
+  int tile;                 /* tile edge in pixels, 4..32; 0 = 16 */
+  int threshold;            /* largest change a skipped tile may hide; 0 = lossless */
+  int keyframe_interval;    /* 0 = 25; < 0 = only the first frame */
+  int mtu;                  /* UDP payload bytes per packet; 0 = 1400 */
+} tc001_udp_sender_options;
+
+typedef struct {
+  uint64_t frames, keyframes;
+  uint64_t tiles, tiles_sent;     /* in all frames / actually sent */
+  uint64_t packets, bytes;        /* UDP payload bytes */
+  uint64_t send_errors;
+  uint64_t diff_ns;               /* comparing tiles and packing */
+} tc001_udp_sender_stats;
+
+TC001_API tc001_status tc001_udp_sender_create(tc001_udp_sender** out,
+                                               const tc001_udp_sender_options* opts);
+TC001_API void         tc001_udp_sender_destroy(tc001_udp_sender* s);
+
+/* Sends f (U16). Frames may change size; that forces a keyframe. */
+TC001_API tc001_status tc001_udp_send(tc001_udp_sender* s, const tc001_frame* f);
+
+/* Makes the next frame a keyframe, e.g. when a receiver (re)joins. */
+TC001_API void         tc001_udp_request_keyframe(tc001_udp_sender* s);
+
+TC001_API void         tc001_udp_sender_get_stats(const tc001_udp_sender* s, tc001_udp_sender_stats* out);
+
+/* ===== Receiver ===== */
+typedef struct tc001_udp_receiver tc001_udp_receiver;
+
+typedef struct {
+  const char* address;      /* IPv4 address to bind; NULL = any */
+  int port;                 /* 0 = any free port (see tc001_udp_receiver_port) */
+} tc001_udp_receiver_options;
+
+typedef struct {
+  int      exact;           /* every tile equal to the sender's reference */
+  int      keyframe;
+  int      tiles;           /* tiles updated by this frame */
+  int      complete;        /* every packet of this frame arrived */
+} tc001_udp_frame_info;
+
+typedef struct {
+  uint64_t frames, exact_frames;
+  uint64_t packets, bytes;
+  uint64_t lost;            /* sequence numbers never seen */
+  uint64_t late;            /* out of order or duplicate; ignored */
+  uint64_t invalid;
+  uint64_t foreign;         /* from a sender other than the one followed; ignored */
+  uint64_t sender_changes;  /* senders taken on after the first */
+} tc001_udp_receiver_stats;
+
+TC001_API tc001_status tc001_udp_receiver_create(tc001_udp_receiver** out,
+                                                 const tc001_udp_receiver_options* opts);
+TC001_API void         tc001_udp_receiver_destroy(tc001_udp_receiver* r);
+
+/* The bound port. */
+TC001_API int          tc001_udp_receiver_port(const tc001_udp_receiver* r);
+
+/* Waits up to timeout_ms for the next frame. out->data is the receiver's
+   image, valid until the next call; info may be NULL. TC001_ERR_STATE on
+   timeout. */
+TC001_API tc001_status tc001_udp_receive(tc001_udp_receiver* r, tc001_frame* out,
+                                         tc001_udp_frame_info* info, int timeout_ms);
+
+TC001_API void         tc001_udp_receiver_get_stats(const tc001_udp_receiver* r, tc001_udp_receiver_stats* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,40 @@
+#include "tc001_internal.h"
+
+/* Frame-sized buffers. live counts every one handed out, so the hooks are
+   never swapped while a buffer from the old ones could still be freed. */
+
+static tc001_alloc_fn   alloc_fn;
+static tc001_free_fn    free_fn;
+static void*            alloc_user;
+static tc001_atomic_int live;
+
+static void add(tc001_atomic_int* p, int d) {
+  int v;
+  do v = TC001_ATOMIC_LOAD(p);
+  while (!tc001__atomic_cas(p, v, v + d));
+}
+
+tc001_status tc001_set_allocator(tc001_alloc_fn alloc, tc001_free_fn free_fn_, void* user) {
+  if (!alloc != !free_fn_) return TC001_ERR_PARAM;
+  if (TC001_ATOMIC_LOAD(&live)) return TC001_ERR_STATE;
+  alloc_fn = alloc;
+  free_fn = free_fn_;
+  alloc_user = user;
+  return TC001_OK;
+}
+
+void* tc001__buf_alloc(size_t size, int huge) {
+  void* p = huge ? tc001__huge_alloc(size)
+          : alloc_fn ? alloc_fn(size, TC001_BUFFER_ALIGN, alloc_user)
+          : tc001__aligned_alloc(size, TC001_BUFFER_ALIGN);
+  if (p) add(&live, 1);
+  return p;
+}
+
+void tc001__buf_free(void* p, size_t size, int huge) {
+  if (!p) return;
+  if (huge) tc001__huge_free(p, size);
+  else if (free_fn) free_fn(p, size, alloc_user);
+  else tc001__aligned_free(p);
+  add(&live, -1);
+}
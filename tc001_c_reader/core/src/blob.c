@@ -0,0 +1,377 @@
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Hot/cold blob detection.
+
+   Each row is thresholded into a bit mask (SIMD compare, 16 pixels per
+   step), the mask is cut into runs, and every run becomes a label whose
+   area, coordinate sums, bounding box and peak are accumulated on the spot.
+   Runs that touch a run of the previous row are merged with union-find, the
+   surviving root carrying the combined totals. So the frame is read once,
+   nothing is relabelled, and the work beyond the mask scales with the
+   number of runs rather than pixels. Hot and cold use separate labellers
+   fed from the same row. */
+
+typedef struct { uint16_t x0, x1; uint32_t label; } run;   /* x1 exclusive */
+
+typedef struct {
+  uint32_t area;
+  uint64_t sx, sy;
+  uint16_t x0, y0, x1, y1;
+  uint16_t peak, px, py;
+} comp;
+
+typedef struct {
+  int      hot;
+  run*     prev;  run* cur;
+  int      np, nc;
+  uint32_t* parent;
+  comp*    comps;
+  size_t   n, cap;
+} labeller;
+
+struct tc001_blob_scratch {
+  uint64_t* bits;             /* one row of mask */
+  run*      runs;             /* 4 row buffers: prev/cur per polarity */
+  int       w;
+  labeller  pol[2];
+  tc001_blob* cand;
+  size_t    cand_cap;
+};
+
+/* ===== Scratch ===== */
+tc001_blob_scratch* tc001__blob_scratch_new(void) {
+  return (tc001_blob_scratch*)calloc(1, sizeof(tc001_blob_scratch));
+}
+
+void tc001__blob_scratch_free(tc001_blob_scratch* s) {
+  if (!s) return;
+  free(s->bits);
+  free(s->runs);
+  for (int i = 0; i < 2; ++i) {
+    free(s->pol[i].parent);
+    free(s->pol[i].comps);
+  }
+  free(s->cand);
+  free(s);
+}
+
+static tc001_status scratch_fit(tc001_blob_scratch* s, int w) {
+  if (s->w >= w) return TC001_OK;
+  /* a row holds at most (w + 1) / 2 runs */
+  size_t words = ((size_t)w + 63) / 64, per = (size_t)w / 2 + 1;
+  uint64_t* bits = (uint64_t*)realloc(s->bits, words * sizeof(uint64_t));
+  if (bits) s->bits = bits;
+  run* runs = (run*)realloc(s->runs, 4 * per * sizeof(run));
+  if (runs) s->runs = runs;
+  if (!bits || !runs) return TC001_ERR_ALLOC;
+  for (int i = 0; i < 2; ++i) {
+    s->pol[i].prev = s->runs + (2 * i) * per;
+    s->pol[i].cur  = s->runs + (2 * i + 1) * per;
+  }
+  s->w = w;
+  return TC001_OK;
+}
+
+/* ===== Masks ===== */
+static inline int ctz64(uint64_t m) {
+#if defined(_MSC_VER)
+  unsigned long i;
+  _BitScanForward64(&i, m);
+  return (int)i;
+#else
+  return __builtin_ctzll(m);
+#endif
+}
+
+/* bit x of bits = (hot ? p[x] >= t : p[x] <= t); bits past w are clear */
+static void row_mask(const uint16_t* p, int w, uint16_t t, int hot, uint64_t* bits) {
+  const int words = (w + 63) / 64;
+  memset(bits, 0, (size_t)words * sizeof(uint64_t));
+  int x = 0;
+#if defined(TC001_SSE2)
+  /* v >= t  <=>  sat(t - v) == 0 ;  v <= t  <=>  sat(v - t) == 0 */
+  const __m128i vt = _mm_set1_epi16((short)t), zero = _mm_setzero_si128();
+  for (; x + 16 <= w; x += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p + x));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p + x + 8));
+    __m128i da = hot ? _mm_subs_epu16(vt, a) : _mm_subs_epu16(a, vt);
+    __m128i db = hot ? _mm_subs_epu16(vt, b) : _mm_subs_epu16(b, vt);
+    __m128i m = _mm_packs_epi16(_mm_cmpeq_epi16(da, zero), _mm_cmpeq_epi16(db, zero));
+    bits[x >> 6] |= (uint64_t)(uint32_t)_mm_movemask_epi8(m) << (x & 63);
+  }
+#elif defined(TC001_NEON)
+  static const uint8_t lane_bit[16] = { 1,2,4,8,16,32,64,128, 1,2,4,8,16,32,64,128 };
+  const uint16x8_t vt = vdupq_n_u16(t);
+  const uint8x16_t lb = vld1q_u8(lane_bit);
+  for (; x + 16 <= w; x += 16) {
+    uint16x8_t a = vld1q_u16(p + x), b = vld1q_u16(p + x + 8);
+    uint16x8_t ma = hot ? vcgeq_u16(a, vt) : vcleq_u16(a, vt);
+    uint16x8_t mb = hot ? vcgeq_u16(b, vt) : vcleq_u16(b, vt);
+    uint8x16_t m = vandq_u8(vcombine_u8(vmovn_u16(ma), vmovn_u16(mb)), lb);
+    uint64_t bitsx = (uint64_t)vaddv_u8(vget_low_u8(m)) | ((uint64_t)vaddv_u8(vget_high_u8(m)) << 8);
+    bits[x >> 6] |= bitsx << (x & 63);
+  }
+#endif
+  for (; x < w; ++x)
+    if (hot ? p[x] >= t : p[x] <= t) bits[x >> 6] |= 1ull << (x & 63);
+}
+
+static inline int next_bit(const uint64_t* bits, int x, int w, int set) {
+  if (x >= w) return w;
+  int i = x >> 6;
+  const int words = (w + 63) / 64;
+  uint64_t m = (set ? bits[i] : ~bits[i]) & (~0ull << (x & 63));
+  while (!m) {
+    if (++i >= words) return w;
+    m = set ? bits[i] : ~bits[i];
+  }
+  int r = (i << 6) + ctz64(m);
+  return r < w ? r : w;
+}
+
+/* ===== Union-find ===== */
+static uint32_t find_root(uint32_t* parent, uint32_t a) {
+  while (parent[a] != a) {
+    parent[a] = parent[parent[a]];
+    a = parent[a];
+  }
+  return a;
+}
+
+static void unite(labeller* L, uint32_t a, uint32_t b) {
+  a = find_root(L->parent, a);
+  b = find_root(L->parent, b);
+  if (a == b) return;
+  if (a > b) { uint32_t t = a; a = b; b = t; }   /* keep the older label */
+  comp* ca = &L->comps[a];
+  const comp* cb = &L->comps[b];
+  ca->area += cb->area;
+  ca->sx += cb->sx;
+  ca->sy += cb->sy;
+  if (cb->x0 < ca->x0) ca->x0 = cb->x0;
+  if (cb->x1 > ca->x1) ca->x1 = cb->x1;
+  if (cb->y0 < ca->y0) ca->y0 = cb->y0;
+  if (cb->y1 > ca->y1) ca->y1 = cb->y1;
+  if (L->hot ? cb->peak > ca->peak : cb->peak < ca->peak) {
+    ca->peak = cb->peak; ca->px = cb->px; ca->py = cb->py;
+  }
+  L->parent[b] = a;
+}
+
+static int new_label(labeller* L, const uint16_t* p, int y, int x0, int x1) {
+  if (L->n == L->cap) {
+    size_t cap = L->cap ? L->cap * 2 : 256;
+    uint32_t* parent = (uint32_t*)realloc(L->parent, cap * sizeof(uint32_t));
+    if (parent) L->parent = parent;
+    comp* comps = (comp*)realloc(L->comps, cap * sizeof(comp));
+    if (comps) L->comps = comps;
+    if (!parent || !comps) return -1;
+    L->cap = cap;
+  }
+  uint32_t id = (uint32_t)L->n++;
+  comp* c = &L->comps[id];
+  const uint32_t len = (uint32_t)(x1 - x0);
+  c->area = len;
+  c->sx = (uint64_t)(x0 + x1 - 1) * len / 2;
+  c->sy = (uint64_t)y * len;
+  c->x0 = (uint16_t)x0; c->x1 = (uint16_t)(x1 - 1);
+  c->y0 = c->y1 = (uint16_t)y;
+  int best = x0;
+  for (int x = x0 + 1; x < x1; ++x)
+    if (L->hot ? p[x] > p[best] : p[x] < p[best]) best = x;
+  c->peak = p[best];
+  c->px = (uint16_t)best;
+  c->py = (uint16_t)y;
+  L->parent[id] = id;
+  L->cur[L->nc].x0 = (uint16_t)x0;
+  L->cur[L->nc].x1 = (uint16_t)x1;
+  L->cur[L->nc].label = id;
+  L->nc++;
+  return 0;
+}
+
+static tc001_status label_row(labeller* L, const uint64_t* bits, const uint16_t* p,
+                              int w, int y, int conn8)
+{
+  L->nc = 0;
+  for (int x = next_bit(bits, 0, w, 1); x < w; ) {
+    int e = next_bit(bits, x, w, 0);
+    if (new_label(L, p, y, x, e)) return TC001_ERR_ALLOC;
+    x = next_bit(bits, e, w, 1);
+  }
+
+  /* merge with touching runs of the row above */
+  const int d = conn8 ? 1 : 0;
+  int i = 0;
+  for (int j = 0; j < L->nc; ++j) {
+    const run* c = &L->cur[j];
+    while (i < L->np && L->prev[i].x1 + d <= c->x0) ++i;
+    for (int k = i; k < L->np && L->prev[k].x0 < c->x1 + d; ++k)
+      unite(L, c->label, L->prev[k].label);
+  }
+
+  run* t = L->prev; L->prev = L->cur; L->cur = t;
+  L->np = L->nc;
+  return TC001_OK;
+}
+
+/* ===== Detection ===== */
+void tc001__blob_thresh(const tc001_blob_config* cfg, const tc001_stats_scratch* s,
+                        uint32_t count, uint16_t lo, uint16_t hi, tc001_blob_thresh* t)
+{
+  t->hot_on = cfg->find_hot;
+  t->cold_on = cfg->find_cold;
+  if (cfg->mode != TC001_BLOB_PERCENTILE) {
+    t->hot = cfg->hot_raw;
+    t->cold = cfg->cold_raw;
+    return;
+  }
+  /* strict: above/below the percentile value, so a flat frame has no blobs */
+  if (t->hot_on) {
+    uint32_t r = (uint32_t)((double)(count - 1) * cfg->hot_pct / 100.0 + 0.5);
+    uint16_t v = tc001__stats_rank(s, count, lo, hi, r);
+    t->hot_on = v < 0xFFFF;
+    t->hot = (uint16_t)(v + 1);
+  }
+  if (t->cold_on) {
+    uint32_t r = (uint32_t)((double)(count - 1) * cfg->cold_pct / 100.0 + 0.5);
+    uint16_t v = tc001__stats_rank(s, count, lo, hi, r);
+    t->cold_on = v > 0;
+    t->cold = (uint16_t)(v - 1);
+  }
+}
+
+static int blob_order(const void* a, const void* b) {
+  const tc001_blob* x = (const tc001_blob*)a;
+  const tc001_blob* y = (const tc001_blob*)b;
+  if (x->area != y->area) return x->area < y->area ? 1 : -1;
+  if (x->y0 != y->y0) return x->y0 < y->y0 ? -1 : 1;
+  return x->x0 < y->x0 ? -1 : (x->x0 > y->x0);
+}
+
+/* Moves the k best of n to the front (max-heap on blob_order keeps the
+   worst kept blob at the top): noisy thresholds can yield thousands of
+   candidates for a handful of output slots. */
+static void sift(tc001_blob* b, size_t k, size_t i) {
+  for (;;) {
+    size_t l = 2 * i + 1, m = i;
+    if (l < k && blob_order(&b[l], &b[m]) > 0) m = l;
+    if (l + 1 < k && blob_order(&b[l + 1], &b[m]) > 0) m = l + 1;
+    if (m == i) return;
+    tc001_blob t = b[i]; b[i] = b[m]; b[m] = t;
+    i = m;
+  }
+}
+
+static void top_k(tc001_blob* b, size_t n, size_t k) {
+  if (k == 0) return;
+  for (size_t i = k / 2; i-- > 0; ) sift(b, k, i);
+  for (size_t i = k; i < n; ++i) {
+    if (blob_order(&b[i], &b[0]) >= 0) continue;
+    b[0] = b[i];
+    sift(b, k, 0);
+  }
+}
+
+tc001_status tc001__find_blobs(tc001_blob_scratch* s,
+                               const uint8_t* base, int w, int h, int stride,
+                               const tc001_blob_config* cfg, const tc001_blob_thresh* t,
+                               const tc001_temp_model* temp,
+                               tc001_blob* out, int cap, int* count)
+{
+  *count = 0;
+  if (w > 65535 || h > 65535) return TC001_ERR_PARAM;
+  tc001_status st = scratch_fit(s, w);
+  if (st != TC001_OK) return st;
+
+  const int on[2] = { t->hot_on, t->cold_on };
+  const uint16_t thr[2] = { t->hot, t->cold };
+  const int conn8 = cfg->connectivity == 8;
+  for (int k = 0; k < 2; ++k) {
+    s->pol[k].hot = k == 0;
+    s->pol[k].n = 0;
+    s->pol[k].np = 0;
+  }
+
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* p = (const uint16_t*)(base + (size_t)y * stride);
+    for (int k = 0; k < 2; ++k) {
+      if (!on[k]) continue;
+      row_mask(p, w, thr[k], k == 0, s->bits);
+      st = label_row(&s->pol[k], s->bits, p, w, y, conn8);
+      if (st != TC001_OK) return st;
+    }
+  }
+
+  /* roots are blobs */
+  size_t nc = 0;
+  for (int k = 0; k < 2; ++k) {
+    const labeller* L = &s->pol[k];
+    for (size_t i = 0; i < L->n; ++i) {
+      if (L->parent[i] != i || L->comps[i].area < cfg->min_area) continue;
+      if (nc == s->cand_cap) {
+        size_t c = s->cand_cap ? s->cand_cap * 2 : 64;
+        tc001_blob* q = (tc001_blob*)realloc(s->cand, c * sizeof(tc001_blob));
+        if (!q) return TC001_ERR_ALLOC;
+        s->cand = q; s->cand_cap = c;
+      }
+      const comp* c = &L->comps[i];
+      tc001_blob* b = &s->cand[nc++];
+      memset(b, 0, sizeof(*b));
+      b->area = c->area;
+      b->cx = (float)((double)c->sx / c->area);
+      b->cy = (float)((double)c->sy / c->area);
+      b->x0 = c->x0; b->y0 = c->y0; b->x1 = c->x1; b->y1 = c->y1;
+      b->peak_x = c->px; b->peak_y = c->py;
+      b->peak_raw = c->peak;
+      b->hot = (uint8_t)L->hot;
+      b->peak_C = NAN;
+    }
+  }
+
+  int n = (int)nc < cap ? (int)nc : cap;
+  if ((size_t)n < nc) top_k(s->cand, nc, (size_t)n);
+  qsort(s->cand, (size_t)n, sizeof(tc001_blob), blob_order);
+  for (int i = 0; i < n; ++i) {
+    out[i] = s->cand[i];
+    if (temp && temp->has_temp) out[i].peak_C = tc001__temp_c(temp, out[i].peak_raw);
+  }
+  *count = n;
+  return TC001_OK;
+}
+
+/* ===== Public API ===== */
+static TC001_THREAD_LOCAL tc001_blob_scratch* tls_blobs;
+
+tc001_status tc001_find_blobs(const tc001_frame* f, const tc001_blob_config* cfg,
+                              const tc001_temp_model* temp,
+                              tc001_blob* out, int cap, int* count)
+{
+  if (!f || !f->data || !cfg || !count || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width <= 0 || f->height <= 0 || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  if (cap < 0 || (cap && !out)) return TC001_ERR_PARAM;
+  if (!tls_blobs && !(tls_blobs = tc001__blob_scratch_new())) return TC001_ERR_ALLOC;
+
+  tc001_blob_thresh t;
+  if (cfg->mode == TC001_BLOB_PERCENTILE) {
+    tc001_stats_scratch* ss = tc001__stats_tls_scratch();
+    if (!ss) return TC001_ERR_ALLOC;
+    const uint32_t n = (uint32_t)f->width * (uint32_t)f->height;
+    uint16_t lo, hi;
+    tc001_frame_stats unused;
+    tc001__stats_scan(ss, f->data, f->width, f->height, f->stride, NULL, &lo, &hi);
+    tc001__blob_thresh(cfg, ss, n, lo, hi, &t);
+    tc001__stats_finish(ss, n, lo, hi, &unused);   /* leaves the bins clear */
+  } else {
+    tc001__blob_thresh(cfg, NULL, 0, 0, 0, &t);
+  }
+  return tc001__find_blobs(tls_blobs, f->data, f->width, f->height, f->stride,
+                           cfg, &t, temp, out, cap, count);
+}
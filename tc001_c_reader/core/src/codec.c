@@ -0,0 +1,512 @@
+#include "tc001_codec.h"
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Frame layout (little-endian):
+
+     u32 magic, u8 version, u8 flags, u16 width, u16 height, u16 reserved,
+     u32 seq, u32 bitstream bytes, then the bitstream.
+
+   Bitstream, LSB first, per row: 2-bit mode, then either w raw 16-bit
+   values or blocks of up to 16 Rice-coded residuals. Each block opens with
+   '1' (same k as the previous block) or '0' + 4-bit k. A residual u is
+   zigzag(v - prediction) mod 2^16 and codes as q = u >> k zeros, a one, and
+   the low k bits; q >= ESCAPE is written as ESCAPE zeros and 16 raw bits. */
+
+#define CODEC_MAGIC    0x5A314354u   /* "TC1Z" */
+#define CODEC_VERSION  1
+#define HDR_BYTES      20
+#define FLAG_KEY       1u
+#define BLOCK          16
+#define ESCAPE         24
+
+enum { MODE_MED = 0, MODE_TEMPORAL = 1, MODE_TMED = 2, MODE_RAW = 3 };
+
+struct tc001_codec {
+  int w, h;
+  uint16_t* prev;             /* last frame: encoder input / decoder output */
+  uint16_t* cur;              /* decoder work plane */
+  uint16_t* res;              /* 3 * w residual rows */
+  uint8_t*  ks;               /* per-block Rice parameter of the row */
+  int       have_prev;
+  uint32_t  seq;              /* encoder: next to write; decoder: last read */
+};
+
+/* ===== Codec object ===== */
+tc001_status tc001_codec_create(tc001_codec** out, int width, int height) {
+  if (!out || width <= 0 || height <= 0 || width > 65535 || height > 65535)
+    return TC001_ERR_PARAM;
+  tc001_codec* c = (tc001_codec*)calloc(1, sizeof(*c));
+  if (!c) return TC001_ERR_ALLOC;
+  const size_t n = (size_t)width * height;
+  c->w = width;
+  c->h = height;
+  c->prev = (uint16_t*)malloc(n * 2);
+  c->cur  = (uint16_t*)malloc(n * 2);
+  c->res  = (uint16_t*)malloc((size_t)width * 3 * 2);
+  c->ks   = (uint8_t*)malloc((size_t)width / BLOCK + 1);
+  if (!c->prev || !c->cur || !c->res || !c->ks) {
+    tc001_codec_destroy(c);
+    return TC001_ERR_ALLOC;
+  }
+  *out = c;
+  return TC001_OK;
+}
+
+void tc001_codec_destroy(tc001_codec* c) {
+  if (!c) return;
+  free(c->prev);
+  free(c->cur);
+  free(c->res);
+  free(c->ks);
+  free(c);
+}
+
+void tc001_codec_reset(tc001_codec* c) {
+  if (c) c->have_prev = 0;
+}
+
+size_t tc001_codec_max_bytes(int width, int height) {
+  if (width <= 0 || height <= 0) return 0;
+  /* a row never exceeds its raw form: 2 mode bits + 16 bits per pixel */
+  return HDR_BYTES + ((size_t)height * (2 + 16 * (size_t)width) + 7) / 8 + 8;
+}
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+static uint32_t get16(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | (get16(p + 2) << 16); }
+
+/* ===== Prediction ===== */
+/* Median edge detector with a + b - c saturated to [0, 65535]. The SIMD
+   and scalar forms must agree bit for bit: the decoder only has the
+   scalar one. */
+static inline uint16_t med(uint16_t a, uint16_t b, uint16_t c) {
+  uint32_t g = (uint32_t)a + b;
+  if (g > 0xFFFF) g = 0xFFFF;
+  g = g > c ? g - c : 0;
+  uint16_t mn = a < b ? a : b, mx = a < b ? b : a;
+  return (uint16_t)(g < mn ? mn : (g > mx ? mx : g));
+}
+
+static inline uint16_t zig(uint16_t r) {
+  return (uint16_t)((r << 1) ^ (uint16_t)((int16_t)r >> 15));
+}
+
+static inline uint16_t unzig(uint16_t u) {
+  return (uint16_t)((u >> 1) ^ (uint16_t)-(int16_t)(u & 1));
+}
+
+/* Residual rows. up is NULL on the first row. For MODE_TMED the inputs are
+   the biased differences to the previous frame, so one kernel serves both
+   spatial modes. */
+static void med_residuals(const uint16_t* v, const uint16_t* up, int w, uint16_t* res) {
+  if (!up) {
+    res[0] = zig(v[0]);
+    for (int x = 1; x < w; ++x) res[x] = zig((uint16_t)(v[x] - v[x - 1]));
+    return;
+  }
+  res[0] = zig((uint16_t)(v[0] - up[0]));
+  int x = 1;
+#if defined(TC001_SSE2)
+  for (; x + 8 <= w; x += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(v + x - 1));
+    __m128i b = _mm_loadu_si128((const __m128i*)(up + x));
+    __m128i c = _mm_loadu_si128((const __m128i*)(up + x - 1));
+    __m128i d = _mm_subs_epu16(a, b);
+    __m128i mn = _mm_sub_epi16(a, d), mx = _mm_add_epi16(b, d);
+    __m128i g = _mm_subs_epu16(_mm_adds_epu16(a, b), c);
+    g = _mm_sub_epi16(g, _mm_subs_epu16(g, mx));      /* min(g, mx) */
+    g = _mm_add_epi16(mn, _mm_subs_epu16(g, mn));     /* max(g, mn) */
+    __m128i r = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(v + x)), g);
+    _mm_storeu_si128((__m128i*)(res + x), _mm_xor_si128(_mm_slli_epi16(r, 1), _mm_srai_epi16(r, 15)));
+  }
+#elif defined(TC001_NEON)
+  for (; x + 8 <= w; x += 8) {
+    uint16x8_t a = vld1q_u16(v + x - 1), b = vld1q_u16(up + x), c = vld1q_u16(up + x - 1);
+    uint16x8_t g = vqsubq_u16(vqaddq_u16(a, b), c);
+    g = vmaxq_u16(vminq_u16(a, b), vminq_u16(g, vmaxq_u16(a, b)));
+    int16x8_t r = vreinterpretq_s16_u16(vsubq_u16(vld1q_u16(v + x), g));
+    vst1q_u16(res + x, vreinterpretq_u16_s16(veorq_s16(vshlq_n_s16(r, 1), vshrq_n_s16(r, 15))));
+  }
+#endif
+  for (; x < w; ++x) res[x] = zig((uint16_t)(v[x] - med(v[x - 1], up[x], up[x - 1])));
+}
+
+static void temporal_residuals(const uint16_t* v, const uint16_t* pv, int w, uint16_t* res) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  for (; x + 8 <= w; x += 8) {
+    __m128i r = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(v + x)),
+                              _mm_loadu_si128((const __m128i*)(pv + x)));
+    _mm_storeu_si128((__m128i*)(res + x), _mm_xor_si128(_mm_slli_epi16(r, 1), _mm_srai_epi16(r, 15)));
+  }
+#elif defined(TC001_NEON)
+  for (; x + 8 <= w; x += 8) {
+    int16x8_t r = vreinterpretq_s16_u16(vsubq_u16(vld1q_u16(v + x), vld1q_u16(pv + x)));
+    vst1q_u16(res + x, vreinterpretq_u16_s16(veorq_s16(vshlq_n_s16(r, 1), vshrq_n_s16(r, 15))));
+  }
+#endif
+  for (; x < w; ++x) res[x] = zig((uint16_t)(v[x] - pv[x]));
+}
+
+/* inverse of temporal_residuals: v = pv + unzig(res) */
+static void temporal_rebuild(const uint16_t* res, const uint16_t* pv, int w, uint16_t* v) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128i one = _mm_set1_epi16(1);
+  for (; x + 8 <= w; x += 8) {
+    __m128i u = _mm_loadu_si128((const __m128i*)(res + x));
+    __m128i d = _mm_xor_si128(_mm_srli_epi16(u, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(u, one)));
+    _mm_storeu_si128((__m128i*)(v + x), _mm_add_epi16(_mm_loadu_si128((const __m128i*)(pv + x)), d));
+  }
+#elif defined(TC001_NEON)
+  for (; x + 8 <= w; x += 8) {
+    uint16x8_t u = vld1q_u16(res + x);
+    uint16x8_t d = veorq_u16(vshrq_n_u16(u, 1),
+                             vreinterpretq_u16_s16(vnegq_s16(vreinterpretq_s16_u16(vandq_u16(u, vdupq_n_u16(1))))));
+    vst1q_u16(v + x, vaddq_u16(vld1q_u16(pv + x), d));
+  }
+#endif
+  for (; x < w; ++x) v[x] = (uint16_t)(pv[x] + unzig(res[x]));
+}
+
+/* biased difference to the previous frame: centred on 0x8000 so the
+   saturating median predictor does not wrap */
+static void diff_row(const uint16_t* v, const uint16_t* pv, int w, uint16_t* d) {
+  for (int x = 0; x < w; ++x) d[x] = (uint16_t)(v[x] - pv[x] + 0x8000);
+}
+
+static uint32_t row_cost(const uint16_t* res, int w) {
+  uint32_t s = 0;
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  for (; x + 8 <= w; x += 8) {
+    __m128i r = _mm_loadu_si128((const __m128i*)(res + x));
+    acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(r, zero), _mm_unpackhi_epi16(r, zero)));
+  }
+  uint32_t t[4];
+  _mm_storeu_si128((__m128i*)t, acc);
+  s = t[0] + t[1] + t[2] + t[3];
+#elif defined(TC001_NEON)
+  uint32x4_t acc = vdupq_n_u32(0);
+  for (; x + 8 <= w; x += 8) acc = vpadalq_u16(acc, vld1q_u16(res + x));
+  s = vaddvq_u32(acc);
+#endif
+  for (; x < w; ++x) s += res[x];
+  return s;
+}
+
+/* ===== Rice coding ===== */
+typedef struct {
+  uint8_t* p;
+  uint64_t acc;
+  int n;
+} bitw;
+
+static inline void bw_put(bitw* b, uint32_t v, int nbits) {   /* nbits <= 32 */
+  b->acc |= (uint64_t)v << b->n;
+  b->n += nbits;
+  if (b->n >= 32) {
+    put32(b->p, (uint32_t)b->acc);
+    b->p += 4;
+    b->acc >>= 32;
+    b->n -= 32;
+  }
+}
+
+static inline void bw_flush(bitw* b) {
+  while (b->n > 0) {
+    *b->p++ = (uint8_t)b->acc;
+    b->acc >>= 8;
+    b->n -= 8;
+  }
+  b->n = 0;
+}
+
+static uint32_t block_bits(const uint16_t* u, int n, int k) {
+  uint32_t bits = (uint32_t)n * (uint32_t)(k + 1);
+  for (int i = 0; i < n; ++i) {
+    uint32_t q = u[i] >> k;
+    bits += q < ESCAPE ? q : ESCAPE + 16 - (uint32_t)(k + 1);
+  }
+  return bits;
+}
+
+/* Picks k per block (into ks) and returns the row's coded size in bits,
+   mode bits excluded. k_prev is the running parameter across blocks. */
+static uint32_t plan_row(const uint16_t* res, int w, uint8_t* ks, int k_prev) {
+  uint32_t total = 0;
+  for (int b = 0, x = 0; x < w; ++b, x += BLOCK) {
+    const int n = w - x < BLOCK ? w - x : BLOCK;
+    uint32_t sum = 0;
+    for (int i = 0; i < n; ++i) sum += res[x + i];
+    int est = 0;
+    while (est < 15 && ((uint32_t)n << (est + 1)) <= sum) ++est;
+    int best_k = est;
+    uint32_t best = UINT32_MAX;
+    for (int k = est > 0 ? est - 1 : 0; k <= est + 1 && k <= 15; ++k) {
+      uint32_t bits = block_bits(res + x, n, k) + (k == k_prev ? 1 : 5);
+      if (bits < best) { best = bits; best_k = k; }
+    }
+    ks[b] = (uint8_t)best_k;
+    k_prev = best_k;
+    total += best;
+  }
+  return total;
+}
+
+static void code_row(bitw* bw, const uint16_t* res, int w, const uint8_t* ks, int* k_prev) {
+  for (int b = 0, x = 0; x < w; ++b, x += BLOCK) {
+    const int n = w - x < BLOCK ? w - x : BLOCK;
+    const int k = ks[b];
+    if (k == *k_prev) bw_put(bw, 1, 1);
+    else bw_put(bw, (uint32_t)k << 1, 5);
+    *k_prev = k;
+    const uint32_t mask = (1u << k) - 1;
+    for (int i = 0; i < n; ++i) {
+      const uint32_t u = res[x + i], q = u >> k;
+      if (q < ESCAPE) {
+        bw_put(bw, 1u << q, (int)q + 1);
+        if (k) bw_put(bw, u & mask, k);
+      } else {
+        bw_put(bw, 0, ESCAPE);
+        bw_put(bw, u, 16);
+      }
+    }
+  }
+}
+
+/* ===== Encode ===== */
+tc001_status tc001_encode_frame(tc001_codec* c, const tc001_frame* f, int keyframe,
+                                void* dst, size_t dst_cap, size_t* written)
+{
+  if (!c || !f || !f->data || !dst || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width != c->w || f->height != c->h || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  if (dst_cap < tc001_codec_max_bytes(c->w, c->h)) return TC001_ERR_PARAM;
+
+  const int w = c->w, h = c->h;
+  const int key = keyframe || !c->have_prev;
+  uint8_t* out = (uint8_t*)dst;
+  bitw bw = { out + HDR_BYTES, 0, 0 };
+  uint16_t* r_med = c->res;
+  uint16_t* r_alt = c->res + w;       /* temporal or tmed, whichever wins */
+  uint16_t* r_tmp = c->res + 2 * w;
+  int k_prev = 0;
+
+  /* biased diff rows for MODE_TMED; the decoder's plane is free here */
+  uint16_t* dcur = c->cur;
+  uint16_t* dup = NULL;
+
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* v = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    const uint16_t* up = y ? (const uint16_t*)(f->data + (size_t)(y - 1) * f->stride) : NULL;
+    const uint16_t* pv = c->prev + (size_t)y * w;
+
+    med_residuals(v, up, w, r_med);
+    const uint16_t* best = r_med;
+    int mode = MODE_MED;
+    uint32_t cost = row_cost(r_med, w);
+
+    if (!key) {
+      temporal_residuals(v, pv, w, r_alt);
+      uint32_t ct = row_cost(r_alt, w);
+      diff_row(v, pv, w, dcur);
+      med_residuals(dcur, dup, w, r_tmp);
+      uint32_t cm = row_cost(r_tmp, w);
+      if (ct < cost && ct <= cm) { best = r_alt; mode = MODE_TEMPORAL; cost = ct; }
+      else if (cm < cost) { best = r_tmp; mode = MODE_TMED; cost = cm; }
+      dup = dcur;
+      dcur += w;
+    }
+
+    uint32_t bits = plan_row(best, w, c->ks, k_prev);
+    if (bits >= 16u * (uint32_t)w) {
+      bw_put(&bw, MODE_RAW, 2);
+      for (int x = 0; x < w; ++x) bw_put(&bw, v[x], 16);
+    } else {
+      bw_put(&bw, (uint32_t)mode, 2);
+      code_row(&bw, best, w, c->ks, &k_prev);
+    }
+  }
+  bw_flush(&bw);
+
+  const size_t bytes = (size_t)(bw.p - (out + HDR_BYTES));
+  put32(out, CODEC_MAGIC);
+  out[4] = CODEC_VERSION;
+  out[5] = key ? FLAG_KEY : 0;
+  put16(out + 6, (uint32_t)w);
+  put16(out + 8, (uint32_t)h);
+  put16(out + 10, 0);
+  put32(out + 12, c->seq);
+  put32(out + 16, (uint32_t)bytes);
+
+  for (int y = 0; y < h; ++y)
+    memcpy(c->prev + (size_t)y * w, f->data + (size_t)y * f->stride, (size_t)w * 2);
+  c->have_prev = 1;
+  c->seq++;
+  if (written) *written = HDR_BYTES + bytes;
+  return TC001_OK;
+}
+
+/* ===== Decode ===== */
+typedef struct {
+  const uint8_t* p;
+  const uint8_t* end;
+  uint64_t acc;
+  int n;
+  int over;                   /* bytes consumed past the end */
+} bitr;
+
+static inline void br_fill(bitr* b) {
+  while (b->n <= 56) {
+    uint64_t byte = 0;
+    if (b->p < b->end) byte = *b->p++;
+    else b->over++;
+    b->acc |= byte << b->n;
+    b->n += 8;
+  }
+}
+
+static inline uint32_t br_take(bitr* b, int nbits) {
+  uint32_t v = (uint32_t)(b->acc & ((1ull << nbits) - 1));
+  b->acc >>= nbits;
+  b->n -= nbits;
+  return v;
+}
+
+static inline int ctz64(uint64_t m) {
+#if defined(_MSC_VER)
+  unsigned long i;
+  _BitScanForward64(&i, m);
+  return (int)i;
+#else
+  return __builtin_ctzll(m);
+#endif
+}
+
+static void decode_residuals(bitr* br, int w, uint16_t* res, int* k_prev) {
+  for (int x = 0; x < w; x += BLOCK) {
+    const int n = w - x < BLOCK ? w - x : BLOCK;
+    br_fill(br);
+    int k = *k_prev;
+    if (!br_take(br, 1)) k = (int)br_take(br, 4);
+    *k_prev = k;
+    for (int i = 0; i < n; ++i) {
+      br_fill(br);
+      int q = br->acc ? ctz64(br->acc) : 64;
+      if (q < ESCAPE) {
+        br_take(br, q + 1);
+        res[x + i] = (uint16_t)(((uint32_t)q << k) | (k ? br_take(br, k) : 0));
+      } else {
+        br_take(br, ESCAPE);
+        res[x + i] = (uint16_t)br_take(br, 16);
+      }
+    }
+  }
+}
+
+tc001_status tc001_codec_peek(const void* src, size_t len, tc001_codec_info* out) {
+  const uint8_t* b = (const uint8_t*)src;
+  if (!b || !out || len < HDR_BYTES || get32(b) != CODEC_MAGIC || b[4] != CODEC_VERSION)
+    return TC001_ERR_PARAM;
+  out->width = (int)get16(b + 6);
+  out->height = (int)get16(b + 8);
+  out->keyframe = (b[5] & FLAG_KEY) != 0;
+  out->seq = get32(b + 12);
+  out->bytes = HDR_BYTES + (size_t)get32(b + 16);
+  return out->bytes <= len ? TC001_OK : TC001_ERR_PARAM;
+}
+
+tc001_status tc001_decode_frame(tc001_codec* c, const void* src, size_t len,
+                                uint16_t* dst, int dst_stride)
+{
+  tc001_codec_info info;
+  if (!c || !dst || dst_stride < c->w * 2) return TC001_ERR_PARAM;
+  tc001_status st = tc001_codec_peek(src, len, &info);
+  if (st != TC001_OK) return st;
+  if (info.width != c->w || info.height != c->h) return TC001_ERR_PARAM;
+  if (!info.keyframe && (!c->have_prev || info.seq != c->seq + 1)) return TC001_ERR_STATE;
+
+  const int w = c->w, h = c->h;
+  const uint8_t* b = (const uint8_t*)src + HDR_BYTES;
+  bitr br = { b, b + (info.bytes - HDR_BYTES), 0, 0, 0 };
+  uint16_t* res = c->res;
+  uint16_t* dprev_row = NULL;         /* biased diff of the row above */
+  uint16_t* drow = c->res + w;
+  uint16_t* dswap = c->res + 2 * w;
+  int k_prev = 0;
+
+  for (int y = 0; y < h; ++y) {
+    uint16_t* v = c->cur + (size_t)y * w;
+    const uint16_t* up = y ? v - w : NULL;
+    const uint16_t* pv = c->prev + (size_t)y * w;
+
+    br_fill(&br);
+    const int mode = (int)br_take(&br, 2);
+    if (mode != MODE_MED && info.keyframe && mode != MODE_RAW) return TC001_ERR_PARAM;
+
+    if (mode == MODE_RAW) {
+      for (int x = 0; x < w; ++x) {
+        br_fill(&br);
+        v[x] = (uint16_t)br_take(&br, 16);
+      }
+    } else {
+      decode_residuals(&br, w, res, &k_prev);
+      if (mode == MODE_TEMPORAL) {
+        temporal_rebuild(res, pv, w, v);
+      } else if (mode == MODE_MED) {
+        if (!up) {
+          v[0] = unzig(res[0]);
+          for (int x = 1; x < w; ++x) v[x] = (uint16_t)(v[x - 1] + unzig(res[x]));
+        } else {
+          v[0] = (uint16_t)(up[0] + unzig(res[0]));
+          for (int x = 1; x < w; ++x)
+            v[x] = (uint16_t)(med(v[x - 1], up[x], up[x - 1]) + unzig(res[x]));
+        }
+      } else {
+        /* MODE_TMED: rebuild the biased diff row, then the pixels */
+        const uint16_t* du = NULL;
+        if (y) {
+          if (!dprev_row) {           /* row above was not TMED: derive it */
+            diff_row(up, pv - w, w, dswap);
+            du = dswap;
+          } else {
+            du = dprev_row;
+          }
+        }
+        if (!du) {
+          drow[0] = unzig(res[0]);
+          for (int x = 1; x < w; ++x) drow[x] = (uint16_t)(drow[x - 1] + unzig(res[x]));
+        } else {
+          drow[0] = (uint16_t)(du[0] + unzig(res[0]));
+          for (int x = 1; x < w; ++x)
+            drow[x] = (uint16_t)(med(drow[x - 1], du[x], du[x - 1]) + unzig(res[x]));
+        }
+        for (int x = 0; x < w; ++x) v[x] = (uint16_t)(drow[x] - 0x8000 + pv[x]);
+      }
+    }
+
+    /* keep the biased diff of this row for a TMED row below */
+    if (!info.keyframe) {
+      if (mode == MODE_TMED) {
+        uint16_t* t = drow; drow = dswap; dswap = t;
+        dprev_row = dswap;
+      } else {
+        dprev_row = NULL;
+      }
+    }
+  }
+  if (br.over > 8) return TC001_ERR_PARAM;   /* ran past the end: corrupt */
+
+  for (int y = 0; y < h; ++y)
+    memcpy((uint8_t*)dst + (size_t)y * dst_stride, c->cur + (size_t)y * w, (size_t)w * 2);
+  uint16_t* t = c->prev; c->prev = c->cur; c->cur = t;
+  c->have_prev = 1;
+  c->seq = info.seq;
+  return TC001_OK;
+}
@@ -0,0 +1,557 @@
+#include "tc001_daemon.h"
+#include "tc001_internal.h"
+#include <string.h>
+
+#ifdef _WIN32
+
+tc001_status tc001_daemon_create(tc001_daemon** out, tc001_handle* h, const tc001_daemon_options* opts) {
+  (void)out; (void)h; (void)opts;
+  return TC001_ERR_STATE;
+}
+tc001_status tc001_daemon_start(tc001_daemon* d, char* err, size_t errcap) {
+  (void)d; (void)err; (void)errcap;
+  return TC001_ERR_STATE;
+}
+tc001_status tc001_daemon_serve(tc001_daemon* d, int timeout_ms) {
+  (void)d; (void)timeout_ms;
+  return TC001_ERR_STATE;
+}
+void tc001_daemon_get_stats(tc001_daemon* d, tc001_daemon_stats* out) {
+  (void)d;
+  if (out) memset(out, 0, sizeof(*out));
+}
+void tc001_daemon_destroy(tc001_daemon* d) { (void)d; }
+
+tc001_status tc001_daemon_subscribe(tc001_daemon_client** out, const char* socket_path,
+                                    const tc001_daemon_sub_options* opts) {
+  (void)out; (void)socket_path; (void)opts;
+  return TC001_ERR_STATE;
+}
+tc001_shm_sub* tc001_daemon_client_sub(tc001_daemon_client* c) { (void)c; return NULL; }
+void tc001_daemon_unsubscribe(tc001_daemon_client* c) { (void)c; }
+
+#else
+
+#include "tc001_render.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0            /* SO_NOSIGPIPE is set instead */
+#endif
+
+#define DEFAULT_CLIENTS 64
+
+/* One ring per distinct request; its clients share the conversion. */
+typedef struct {
+  tc001_format      format;
+  uint32_t          decimation;
+  int               has_palette;
+  uint8_t           palette[768];
+  tc001_shm_pub*    pub;
+  tc001_render_ctx* render;       /* RGB8 */
+  uint32_t          tick;         /* camera frames seen, for decimation */
+  int               clients;
+} stream;
+
+typedef struct {
+  int     fd;                     /* -1 = free */
+  stream* stream;                 /* set once subscribed */
+  size_t  got;                    /* request bytes read so far */
+  tc001_daemon_request req;
+} client;
+
+struct tc001_daemon {
+  tc001_handle* h;
+  int           listen_fd;
+  char*         path;
+  int           slots;
+  int           started;
+
+  client*       clients;
+  int           max_clients;
+  struct pollfd* pfd;
+  int*          pfd_client;       /* client index behind pfd[i], -1 = listener */
+
+  /* shared with the frame callback */
+  pthread_mutex_t lock;
+  stream**      streams;
+  int           nstreams;
+  uint8_t*      u8;               /* this frame's U8 image, shared by U8 streams */
+  size_t        u8_cap;
+  tc001_daemon_stats stats;
+};
+
+static void set_nonblocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+}
+
+/* ===== Frames (handle thread) ===== */
+static int make_u8(tc001_daemon* d, const tc001_frame* f) {
+  const size_t n = (size_t)f->width * f->height;
+  if (n > d->u8_cap) {
+    uint8_t* p = (uint8_t*)realloc(d->u8, n);
+    if (!p) return 0;
+    d->u8 = p;
+    d->u8_cap = n;
+  }
+  uint16_t lo = 65535, hi = 0;
+  if (f->stats) {
+    lo = f->stats->raw_min;
+    hi = f->stats->raw_max;
+  } else {
+    for (int y = 0; y < f->height; ++y)
+      tc001__minmax_u16((const uint16_t*)(f->data + (size_t)y * f->stride), f->width, &lo, &hi);
+  }
+  const float scale = tc001__agc_scale(lo, hi);
+  for (int y = 0; y < f->height; ++y) {
+    const uint16_t* s = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    uint8_t* o = d->u8 + (size_t)y * f->width;
+    for (int x = 0; x < f->width; ++x) o[x] = tc001__agc_u8(s[x], lo, scale);
+  }
+  return 1;
+}
+
+static void on_frame(const tc001_frame* f, void* user) {
+  tc001_daemon* d = (tc001_daemon*)user;
+  const int64_t t0 = tc001__now_ns();
+  pthread_mutex_lock(&d->lock);
+  int have_u8 = 0;
+  for (int i = 0; i < d->nstreams; ++i) {
+    stream* s = d->streams[i];
+    if (s->tick++ % s->decimation) continue;
+    tc001_frame o = *f;
+    o.stats = NULL;
+    o.blobs = NULL;
+    o.blob_count = 0;
+    if (s->format == TC001_FMT_U8) {
+      if (!have_u8 && !(have_u8 = make_u8(d, f))) continue;
+      o.format = TC001_FMT_U8;
+      o.stride = f->width;
+      o.data = d->u8;
+    } else if (s->format == TC001_FMT_RGB8) {
+      tc001_render_image img;
+      if (tc001_render_frame(s->render, f, &img) != TC001_OK) continue;
+      o.format = TC001_FMT_RGB8;
+      o.stride = img.pitch;
+      o.data = img.rgb;
+    }
+    if (tc001_shm_publish(s->pub, &o) == TC001_OK) d->stats.published++;
+  }
+  d->stats.frames++;
+  d->stats.frame_ns += (uint64_t)(tc001__now_ns() - t0);
+  pthread_mutex_unlock(&d->lock);
+}
+
+/* ===== Streams (serve thread, under d->lock) ===== */
+static void stream_free(stream* s) {
+  tc001_shm_pub_destroy(s->pub);
+  tc001_render_destroy(s->render);
+  free(s);
+}
+
+static stream* stream_get(tc001_daemon* d, const tc001_daemon_request* r, tc001_status* st) {
+  const uint32_t decim = r->decimation ? r->decimation : 1;
+  const int has_palette = r->format == TC001_FMT_RGB8 && r->has_palette;
+  for (int i = 0; i < d->nstreams; ++i) {
+    stream* s = d->streams[i];
+    if ((uint32_t)s->format == r->format && s->decimation == decim && s->has_palette == has_palette &&
+        (!has_palette || memcmp(s->palette, r->palette, sizeof(s->palette)) == 0)) {
+      if (s->clients < TC001_SHM_MAX_READERS) return s;
+    }
+  }
+  if (d->nstreams == d->max_clients) {
+    *st = TC001_ERR_STATE;
+    return NULL;
+  }
+
+  stream* s = (stream*)calloc(1, sizeof(*s));
+  if (!s) {
+    *st = TC001_ERR_ALLOC;
+    return NULL;
+  }
+  s->format = (tc001_format)r->format;
+  s->decimation = decim;
+  s->has_palette = has_palette;
+  if (has_palette) memcpy(s->palette, r->palette, sizeof(s->palette));
+
+  int w, h;
+  tc001_get_frame_dims(d->h, &w, &h);
+  tc001_shm_options so = {0};
+  so.slots = d->slots;
+  so.width = w;
+  so.height = h;
+  so.format = s->format;
+  *st = tc001_shm_pub_create(&s->pub, &so);
+  if (*st == TC001_OK && s->format == TC001_FMT_RGB8) {
+    tc001_render_options ro = {0};
+    ro.palette = has_palette ? s->palette : NULL;
+    *st = tc001_render_create(&s->render, &ro);
+  }
+  if (*st != TC001_OK) {
+    stream_free(s);
+    return NULL;
+  }
+  d->streams[d->nstreams++] = s;
+  d->stats.streams = d->nstreams;
+  return s;
+}
+
+static void stream_release(tc001_daemon* d, stream* s) {
+  if (--s->clients > 0) return;
+  for (int i = 0; i < d->nstreams; ++i) {
+    if (d->streams[i] != s) continue;
+    d->streams[i] = d->streams[--d->nstreams];
+    break;
+  }
+  d->stats.streams = d->nstreams;
+  stream_free(s);
+}
+
+/* ===== Clients ===== */
+static void client_drop(tc001_daemon* d, client* c) {
+  close(c->fd);
+  c->fd = -1;
+  pthread_mutex_lock(&d->lock);
+  if (c->stream) {
+    stream_release(d, c->stream);
+    d->stats.clients--;
+  }
+  pthread_mutex_unlock(&d->lock);
+  c->stream = NULL;
+  c->got = 0;
+}
+
+static int send_reply(int fd, const tc001_daemon_reply* r, int ring_fd) {
+  struct iovec iov = { (void*)r, sizeof(*r) };
+  union { struct cmsghdr h; char buf[CMSG_SPACE(sizeof(int))]; } ctl;
+  struct msghdr m;
+  memset(&m, 0, sizeof(m));
+  m.msg_iov = &iov;
+  m.msg_iovlen = 1;
+  if (ring_fd >= 0) {
+    memset(&ctl, 0, sizeof(ctl));
+    m.msg_control = ctl.buf;
+    m.msg_controllen = sizeof(ctl.buf);
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&m);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &ring_fd, sizeof(int));
+  }
+  ssize_t n;
+  do n = sendmsg(fd, &m, MSG_NOSIGNAL); while (n < 0 && errno == EINTR);
+  return n == (ssize_t)sizeof(*r);
+}
+
+/* A complete request: find or create its stream and send the ring. */
+static void client_request(tc001_daemon* d, client* c) {
+  const int64_t t0 = tc001__now_ns();
+  const tc001_daemon_request* r = &c->req;
+  tc001_daemon_reply rep;
+  memset(&rep, 0, sizeof(rep));
+  rep.magic = TC001_DAEMON_MAGIC;
+  rep.status = TC001_ERR_PARAM;
+
+  stream* s = NULL;
+  int ring_fd = -1;
+  if (r->magic == TC001_DAEMON_MAGIC && r->version == TC001_DAEMON_VERSION &&
+      (r->format == TC001_FMT_U8 || r->format == TC001_FMT_U16 || r->format == TC001_FMT_RGB8)) {
+    tc001_status st = TC001_OK;
+    pthread_mutex_lock(&d->lock);
+    s = stream_get(d, r, &st);
+    if (s) {
+      s->clients++;
+      d->stats.clients++;
+      ring_fd = tc001_shm_pub_fd(s->pub);
+      int w, h;
+      tc001_get_frame_dims(d->h, &w, &h);
+      rep.width = (uint32_t)w;
+      rep.height = (uint32_t)h;
+      rep.format = (uint32_t)s->format;
+      rep.decimation = s->decimation;
+    }
+    pthread_mutex_unlock(&d->lock);
+    rep.status = s ? TC001_OK : st;
+  }
+
+  c->stream = s;
+  const int sent = send_reply(c->fd, &rep, ring_fd);
+  const uint64_t ns = (uint64_t)(tc001__now_ns() - t0);
+  pthread_mutex_lock(&d->lock);
+  if (sent && s) {
+    d->stats.attaches++;
+    d->stats.attach_ns += ns;
+    if (ns > d->stats.attach_ns_max) d->stats.attach_ns_max = ns;
+  } else {
+    d->stats.rejected++;
+  }
+  pthread_mutex_unlock(&d->lock);
+  if (!sent || !s) client_drop(d, c);
+}
+
+static void client_readable(tc001_daemon* d, client* c) {
+  for (;;) {
+    uint8_t sink[256];
+    uint8_t* dst = c->stream ? sink : (uint8_t*)&c->req + c->got;
+    size_t want = c->stream ? sizeof(sink) : sizeof(c->req) - c->got;
+    ssize_t n = recv(c->fd, dst, want, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (n <= 0) {                 /* closed: unsubscribe */
+      client_drop(d, c);
+      return;
+    }
+    if (c->stream) continue;      /* nothing more is expected; ignore */
+    c->got += (size_t)n;
+    if (c->got == sizeof(c->req)) {
+      client_request(d, c);
+      return;
+    }
+  }
+}
+
+static void accept_clients(tc001_daemon* d) {
+  for (;;) {
+    int fd = accept(d->listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    client* c = NULL;
+    for (int i = 0; i < d->max_clients && !c; ++i)
+      if (d->clients[i].fd < 0) c = &d->clients[i];
+    if (!c) {
+      close(fd);
+      pthread_mutex_lock(&d->lock);
+      d->stats.rejected++;
+      pthread_mutex_unlock(&d->lock);
+      continue;
+    }
+    set_nonblocking(fd);
+    c->fd = fd;
+    c->got = 0;
+    c->stream = NULL;
+  }
+}
+
+/* ===== Server ===== */
+tc001_status tc001_daemon_create(tc001_daemon** out, tc001_handle* h, const tc001_daemon_options* opts) {
+  if (!out || !h || !opts || !opts->socket_path || opts->max_clients < 0 || opts->slots < 0)
+    return TC001_ERR_PARAM;
+  struct sockaddr_un sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  const size_t len = strlen(opts->socket_path);
+  if (len >= sizeof(sa.sun_path)) return TC001_ERR_PARAM;
+  memcpy(sa.sun_path, opts->socket_path, len + 1);
+
+  tc001_daemon* d = (tc001_daemon*)calloc(1, sizeof(*d));
+  if (!d) return TC001_ERR_ALLOC;
+  d->h = h;
+  d->listen_fd = -1;
+  d->slots = opts->slots;
+  d->max_clients = opts->max_clients ? opts->max_clients : DEFAULT_CLIENTS;
+  pthread_mutex_init(&d->lock, NULL);
+  d->clients = (client*)calloc((size_t)d->max_clients, sizeof(client));
+  d->streams = (stream**)calloc((size_t)d->max_clients, sizeof(stream*));
+  d->pfd = (struct pollfd*)calloc((size_t)d->max_clients + 1, sizeof(struct pollfd));
+  d->pfd_client = (int*)calloc((size_t)d->max_clients + 1, sizeof(int));
+  d->path = (char*)malloc(len + 1);
+  if (!d->clients || !d->streams || !d->pfd || !d->pfd_client || !d->path) {
+    tc001_daemon_destroy(d);
+    return TC001_ERR_ALLOC;
+  }
+  memcpy(d->path, opts->socket_path, len + 1);
+  for (int i = 0; i < d->max_clients; ++i) d->clients[i].fd = -1;
+
+  unlink(d->path);                /* left by a daemon that did not exit cleanly */
+  d->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (d->listen_fd < 0 || bind(d->listen_fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 ||
+      listen(d->listen_fd, 64) != 0) {
+    tc001_daemon_destroy(d);
+    return TC001_ERR_IO;
+  }
+  set_nonblocking(d->listen_fd);
+  *out = d;
+  return TC001_OK;
+}
+
+tc001_status tc001_daemon_start(tc001_daemon* d, char* err, size_t errcap) {
+  if (!d) return TC001_ERR_PARAM;
+  tc001_status st = tc001_start(d->h, on_frame, d, err, errcap);
+  if (st == TC001_OK) d->started = 1;
+  return st;
+}
+
+tc001_status tc001_daemon_serve(tc001_daemon* d, int timeout_ms) {
+  if (!d) return TC001_ERR_PARAM;
+  int n = 0;
+  d->pfd[n].fd = d->listen_fd;
+  d->pfd[n].events = POLLIN;
+  d->pfd_client[n++] = -1;
+  for (int i = 0; i < d->max_clients; ++i) {
+    if (d->clients[i].fd < 0) continue;
+    d->pfd[n].fd = d->clients[i].fd;
+    d->pfd[n].events = POLLIN;
+    d->pfd_client[n++] = i;
+  }
+  int r = poll(d->pfd, (nfds_t)n, timeout_ms);
+  if (r < 0) return errno == EINTR ? TC001_OK : TC001_ERR_IO;
+  for (int i = 0; i < n && r > 0; ++i) {
+    if (!d->pfd[i].revents) continue;
+    --r;
+    if (d->pfd_client[i] < 0) {
+      accept_clients(d);
+      continue;
+    }
+    client* c = &d->clients[d->pfd_client[i]];
+    if (d->pfd[i].revents & POLLIN) client_readable(d, c);
+    else client_drop(d, c);       /* hang-up or error without data */
+  }
+  return TC001_OK;
+}
+
+void tc001_daemon_get_stats(tc001_daemon* d, tc001_daemon_stats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  if (!d) return;
+  pthread_mutex_lock(&d->lock);
+  *out = d->stats;
+  pthread_mutex_unlock(&d->lock);
+}
+
+void tc001_daemon_destroy(tc001_daemon* d) {
+  if (!d) return;
+  if (d->started) tc001_stop(d->h);
+  if (d->clients)
+    for (int i = 0; i < d->max_clients; ++i)
+      if (d->clients[i].fd >= 0) client_drop(d, &d->clients[i]);
+  for (int i = 0; i < d->nstreams; ++i) stream_free(d->streams[i]);
+  if (d->listen_fd >= 0) {
+    close(d->listen_fd);
+    unlink(d->path);
+  }
+  pthread_mutex_destroy(&d->lock);
+  free(d->clients);
+  free(d->streams);
+  free(d->pfd);
+  free(d->pfd_client);
+  free(d->path);
+  free(d->u8);
+  free(d);
+}
+
+/* ===== Client ===== */
+struct tc001_daemon_client {
+  int            fd;
+  tc001_shm_sub* sub;
+};
+
+static int write_all(int fd, const void* buf, size_t n) {
+  const uint8_t* p = (const uint8_t*)buf;
+  while (n) {
+    ssize_t r = send(fd, p, n, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) return 0;
+    p += r;
+    n -= (size_t)r;
+  }
+  return 1;
+}
+
+/* Reads the reply and the descriptor that comes with it (-1 if none). */
+static int read_reply(int fd, tc001_daemon_reply* rep, int* ring_fd) {
+  struct iovec iov = { rep, sizeof(*rep) };
+  union { struct cmsghdr h; char buf[CMSG_SPACE(sizeof(int))]; } ctl;
+  struct msghdr m;
+  memset(&m, 0, sizeof(m));
+  m.msg_iov = &iov;
+  m.msg_iovlen = 1;
+  m.msg_control = ctl.buf;
+  m.msg_controllen = sizeof(ctl.buf);
+  ssize_t n;
+  do n = recvmsg(fd, &m, 0); while (n < 0 && errno == EINTR);
+  *ring_fd = -1;
+  for (struct cmsghdr* cm = CMSG_FIRSTHDR(&m); n > 0 && cm; cm = CMSG_NXTHDR(&m, cm))
+    if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+      memcpy(ring_fd, CMSG_DATA(cm), sizeof(int));
+  /* the reply is small enough to arrive in one piece with its descriptor */
+  return n == (ssize_t)sizeof(*rep);
+}
+
+tc001_status tc001_daemon_subscribe(tc001_daemon_client** out, const char* socket_path,
+                                    const tc001_daemon_sub_options* opts) {
+  if (!out || !socket_path) return TC001_ERR_PARAM;
+  struct sockaddr_un sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  const size_t len = strlen(socket_path);
+  if (len >= sizeof(sa.sun_path)) return TC001_ERR_PARAM;
+  memcpy(sa.sun_path, socket_path, len + 1);
+
+  tc001_daemon_request req;
+  memset(&req, 0, sizeof(req));
+  req.magic = TC001_DAEMON_MAGIC;
+  req.version = TC001_DAEMON_VERSION;
+  req.format = opts ? (uint32_t)opts->format : TC001_FMT_U16;
+  req.decimation = opts && opts->decimation > 0 ? (uint32_t)opts->decimation : 1;
+  if (opts && opts->palette) {
+    req.has_palette = 1;
+    memcpy(req.palette, opts->palette, sizeof(req.palette));
+  }
+
+  tc001_daemon_client* c = (tc001_daemon_client*)calloc(1, sizeof(*c));
+  if (!c) return TC001_ERR_ALLOC;
+  c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (c->fd < 0) {
+    free(c);
+    return TC001_ERR_IO;
+  }
+  fcntl(c->fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(c->fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+  struct timeval tv = { 5, 0 };
+  setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+
+  tc001_daemon_reply rep;
+  int ring_fd = -1;
+  tc001_status st = TC001_ERR_IO;
+  if (connect(c->fd, (struct sockaddr*)&sa, sizeof(sa)) == 0 && write_all(c->fd, &req, sizeof(req)) &&
+      read_reply(c->fd, &rep, &ring_fd)) {
+    st = rep.magic != TC001_DAEMON_MAGIC ? TC001_ERR_IO
+       : rep.status != TC001_OK ? (tc001_status)rep.status
+       : ring_fd < 0 ? TC001_ERR_IO
+       : tc001_shm_sub_open(&c->sub, NULL, ring_fd);
+  }
+  if (ring_fd >= 0) close(ring_fd);   /* the mapping holds its own */
+  if (st != TC001_OK) {
+    tc001_daemon_unsubscribe(c);
+    return st;
+  }
+  *out = c;
+  return TC001_OK;
+}
+
+tc001_shm_sub* tc001_daemon_client_sub(tc001_daemon_client* c) { return c ? c->sub : NULL; }
+
+void tc001_daemon_unsubscribe(tc001_daemon_client* c) {
+  if (!c) return;
+  tc001_shm_sub_close(c->sub);
+  if (c->fd >= 0) close(c->fd);
+  free(c);
+}
+
+#endif
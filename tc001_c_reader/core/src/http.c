@@ -0,0 +1,591 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE               /* accept4 */
+#endif
+#include "tc001_http.h"
+#include "tc001_internal.h"
+#include <string.h>
+
+#ifndef __linux__
+
+tc001_status tc001_http_create(tc001_http** out, const tc001_http_options* opts) {
+  (void)out; (void)opts;
+  return TC001_ERR_STATE;
+}
+int  tc001_http_port(const tc001_http* s) { (void)s; return 0; }
+void tc001_http_push(tc001_http* s, const tc001_frame* f) { (void)s; (void)f; }
+void tc001_http_on_frame(const tc001_frame* f, void* server) { (void)f; (void)server; }
+tc001_status tc001_http_serve(tc001_http* s, int timeout_ms) {
+  (void)s; (void)timeout_ms;
+  return TC001_ERR_STATE;
+}
+void tc001_http_get_stats(tc001_http* s, tc001_http_stats* out) {
+  (void)s;
+  if (out) memset(out, 0, sizeof(*out));
+}
+void tc001_http_destroy(tc001_http* s) { (void)s; }
+
+#else
+
+#include "tc001_jpeg.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define DEFAULT_CLIENTS 32
+#define REQ_MAX    2048
+#define HEAD_MAX   1024
+#define PART_ROOM  128            /* multipart part header, written in front of the JPEG */
+#define POOL_MAX   8
+#define UNSENT_MAX (16 * 1024)    /* TCP_NOTSENT_LOWAT: a slow viewer reaches EAGAIN and
+                                     drops frames instead of queueing them in the kernel */
+#define EV_LISTEN  UINT64_MAX
+#define EV_WAKE    (UINT64_MAX - 1)
+
+/* ===== Frame buffers ===== */
+/* One frame, encoded or raw, shared by every connection sending it. The
+   reference count is only touched by the serve thread; push hands a buffer
+   over with one reference through s->pending_*. */
+typedef struct fbuf {
+  struct fbuf* next_free;
+  int          refs;
+  uint32_t     frame_id;
+  int          width, height;
+  tc001_format format;
+  size_t       cap;
+  uint8_t*     part;              /* JPEG: multipart header, JPEG, "\r\n" */
+  size_t       part_len;
+  uint8_t*     body;              /* the JPEG or the pixels alone */
+  size_t       body_len;
+  uint8_t      data[];
+} fbuf;
+
+enum { C_FREE, C_REQUEST, C_STREAM, C_JPEG, C_RAW, C_REPLY };
+
+typedef struct {
+  int     fd;
+  int     state;
+  size_t  got;
+  char    req[REQ_MAX];
+  char    head[HEAD_MAX];         /* response head (or a whole small reply) */
+  size_t  head_len, head_off;
+  fbuf*   cur;                    /* being sent after head */
+  const uint8_t* body;
+  size_t  body_len, body_off;
+  fbuf*   next;                   /* /stream: newest frame waiting behind cur */
+  int     last;                   /* close once everything queued is written */
+} client;
+
+struct tc001_http {
+  int         listen_fd, ep, wake_fd;
+  int         port;
+  client*     clients;
+  int         max_clients;
+  int         has_palette;
+  uint8_t     palette[768];
+  tc001_jpeg* jpeg;               /* push thread only */
+  tc001_http_stats io;            /* serve thread only; folded into stats */
+
+  pthread_mutex_t lock;
+  int         jpeg_waiters, raw_waiters;
+  fbuf*       pending_jpeg;
+  fbuf*       pending_raw;
+  fbuf*       pool;
+  int         pooled;
+  tc001_http_stats stats;
+};
+
+static int bytes_per_pixel(tc001_format f) {
+  return f == TC001_FMT_U8 ? 1 : f == TC001_FMT_RGB8 ? 3 : 2;
+}
+
+/* Under s->lock. */
+static void pool_put(tc001_http* s, fbuf* b) {
+  if (s->pooled == POOL_MAX) {
+    free(b);
+    return;
+  }
+  b->next_free = s->pool;
+  s->pool = b;
+  s->pooled++;
+}
+
+static void buf_release(tc001_http* s, fbuf* b) {
+  if (!b || --b->refs > 0) return;
+  pthread_mutex_lock(&s->lock);
+  pool_put(s, b);
+  pthread_mutex_unlock(&s->lock);
+}
+
+/* b (from the pool, may be NULL) resized to hold cap bytes. */
+static fbuf* buf_fit(fbuf* b, size_t cap) {
+  if (b && b->cap >= cap) return b;
+  free(b);
+  b = (fbuf*)malloc(sizeof(fbuf) + cap);
+  if (b) b->cap = cap;
+  return b;
+}
+
+/* ===== Push (frame thread) ===== */
+static int encode_jpeg(tc001_http* s, fbuf* b, const tc001_frame* f) {
+  size_t n = 0;
+  const int64_t t0 = tc001__now_ns();
+  if (tc001_jpeg_encode_frame(s->jpeg, f, s->has_palette ? s->palette : NULL,
+                              b->data + PART_ROOM, b->cap - PART_ROOM - 2, &n) != TC001_OK)
+    return 0;
+  char h[PART_ROOM];
+  const size_t hn = tc001_mjpeg_part_header(h, sizeof(h), n);
+  b->body = b->data + PART_ROOM;
+  b->body_len = n;
+  b->part = b->body - hn;
+  b->part_len = hn + n + 2;
+  memcpy(b->part, h, hn);
+  memcpy(b->body + n, "\r\n", 2);
+  const uint64_t ns = (uint64_t)(tc001__now_ns() - t0);
+  pthread_mutex_lock(&s->lock);
+  s->stats.encoded++;
+  s->stats.encoded_bytes += n;
+  s->stats.encode_ns += ns;
+  pthread_mutex_unlock(&s->lock);
+  return 1;
+}
+
+static void copy_raw(fbuf* b, const tc001_frame* f) {
+  const size_t row = (size_t)f->width * bytes_per_pixel(f->format);
+  for (int y = 0; y < f->height; ++y)
+    memcpy(b->data + (size_t)y * row, f->data + (size_t)y * f->stride, row);
+  b->body = b->data;
+  b->body_len = row * f->height;
+  b->part = NULL;
+  b->part_len = 0;
+}
+
+void tc001_http_push(tc001_http* s, const tc001_frame* f) {
+  if (!s || !f || !f->data) return;
+  pthread_mutex_lock(&s->lock);
+  s->stats.frames++;
+  const int want_jpeg = s->stats.viewers + s->jpeg_waiters > 0;
+  const int want_raw = s->raw_waiters > 0;
+  fbuf* jb = NULL;
+  fbuf* rb = NULL;
+  if (want_jpeg && s->pool) { jb = s->pool; s->pool = jb->next_free; s->pooled--; }
+  if (want_raw && s->pool) { rb = s->pool; s->pool = rb->next_free; s->pooled--; }
+  pthread_mutex_unlock(&s->lock);
+  if (!want_jpeg && !want_raw) return;
+
+  if (want_jpeg) {
+    jb = buf_fit(jb, PART_ROOM + tc001_jpeg_max_bytes(f->width, f->height, s->has_palette) + 2);
+    if (jb && !encode_jpeg(s, jb, f)) {
+      free(jb);
+      jb = NULL;
+    }
+  }
+  if (want_raw) {
+    rb = buf_fit(rb, (size_t)f->width * f->height * bytes_per_pixel(f->format));
+    if (rb) copy_raw(rb, f);
+  }
+  fbuf* bufs[2] = { jb, rb };
+  for (int i = 0; i < 2; ++i) {
+    if (!bufs[i]) continue;
+    bufs[i]->refs = 1;
+    bufs[i]->frame_id = f->frame_id;
+    bufs[i]->width = f->width;
+    bufs[i]->height = f->height;
+    bufs[i]->format = f->format;
+  }
+
+  pthread_mutex_lock(&s->lock);
+  if (jb) {
+    if (s->pending_jpeg) {        /* the serve loop never saw it */
+      pool_put(s, s->pending_jpeg);
+      s->stats.skipped++;
+    }
+    s->pending_jpeg = jb;
+  }
+  if (rb) {
+    if (s->pending_raw) pool_put(s, s->pending_raw);
+    s->pending_raw = rb;
+  }
+  pthread_mutex_unlock(&s->lock);
+  const uint64_t one = 1;
+  if (write(s->wake_fd, &one, sizeof(one)) < 0) { /* counter saturated: a wake is pending */ }
+}
+
+void tc001_http_on_frame(const tc001_frame* f, void* server) {
+  tc001_http_push((tc001_http*)server, f);
+}
+
+/* ===== Connections (serve thread) ===== */
+static const char* const STREAM_HEAD =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: " TC001_MJPEG_CONTENT_TYPE "\r\n"
+  "Cache-Control: no-cache, no-store\r\n"
+  "Connection: close\r\n\r\n";
+
+static const char* const PAGE =
+  "<!doctype html><title>TC001</title>"
+  "<body style=\"margin:0;background:#000\">"
+  "<img src=\"/stream\" style=\"width:100%;height:100vh;object-fit:contain\">";
+
+static void client_drop(tc001_http* s, client* c) {
+  close(c->fd);                   /* also leaves the epoll set */
+  pthread_mutex_lock(&s->lock);
+  if (c->state == C_STREAM) s->stats.viewers--;
+  else if (c->state == C_JPEG && !c->cur) s->jpeg_waiters--;
+  else if (c->state == C_RAW && !c->cur) s->raw_waiters--;
+  s->stats.clients--;
+  pthread_mutex_unlock(&s->lock);
+  buf_release(s, c->cur);
+  buf_release(s, c->next);
+  c->cur = c->next = NULL;
+  c->fd = -1;
+  c->state = C_FREE;
+}
+
+/* Queues the first head_len bytes of c->head. */
+static void client_head(client* c, size_t head_len) {
+  c->head_len = head_len;
+  c->head_off = 0;
+}
+
+/* Queues body, behind any head still unsent; takes one reference of b. */
+static void client_body(client* c, fbuf* b, const uint8_t* body, size_t body_len) {
+  c->cur = b;
+  c->body = body;
+  c->body_len = body_len;
+  c->body_off = 0;
+}
+
+/* Writes what is queued until the socket is full or the queue is empty. */
+static void client_flush(tc001_http* s, client* c) {
+  while (c->state != C_FREE) {
+    struct iovec v[2];
+    int n = 0;
+    if (c->head_off < c->head_len) {
+      v[n].iov_base = c->head + c->head_off;
+      v[n++].iov_len = c->head_len - c->head_off;
+    }
+    if (c->body_off < c->body_len) {
+      v[n].iov_base = (void*)(c->body + c->body_off);
+      v[n++].iov_len = c->body_len - c->body_off;
+    }
+    if (!n) {
+      if (c->cur) {
+        s->io.sent++;
+        buf_release(s, c->cur);
+        c->cur = NULL;
+        c->body_len = 0;
+      }
+      if (c->next) {              /* /stream: the newest frame, no head */
+        fbuf* b = c->next;
+        c->next = NULL;
+        client_body(c, b, b->part, b->part_len);
+        continue;
+      }
+      if (c->last) client_drop(s, c);
+      return;
+    }
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = v;
+    m.msg_iovlen = (size_t)n;
+    ssize_t w = sendmsg(c->fd, &m, MSG_NOSIGNAL);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) client_drop(s, c);
+      return;                     /* EPOLLOUT resumes */
+    }
+    s->io.bytes_sent += (uint64_t)w;
+    size_t k = (size_t)w;
+    const size_t hk = k < c->head_len - c->head_off ? k : c->head_len - c->head_off;
+    c->head_off += hk;
+    c->body_off += k - hk;
+  }
+}
+
+static void client_reply(tc001_http* s, client* c, int code, const char* reason) {
+  int n = snprintf(c->head, sizeof(c->head),
+                   "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", code, reason);
+  s->io.rejected++;
+  c->state = C_REPLY;
+  c->last = 1;
+  client_head(c, (size_t)n);
+}
+
+/* A complete request head is in c->req. */
+static void client_request(tc001_http* s, client* c) {
+  s->io.requests++;
+  char* path = NULL;
+  if (!strncmp(c->req, "GET ", 4)) {
+    path = c->req + 4;
+    path[strcspn(path, " ?\r\n")] = '\0';
+  }
+  if (!path) {
+    client_reply(s, c, 405, "Method Not Allowed");
+  } else if (!strcmp(path, "/") || !strcmp(path, "/index.html")) {
+    int n = snprintf(c->head, sizeof(c->head),
+                     "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n%s", strlen(PAGE), PAGE);
+    c->state = C_REPLY;
+    c->last = 1;
+    client_head(c, (size_t)n);
+  } else if (!strcmp(path, "/stream") || !strcmp(path, "/stream.mjpg")) {
+    c->state = C_STREAM;
+    memcpy(c->head, STREAM_HEAD, strlen(STREAM_HEAD));
+    client_head(c, strlen(STREAM_HEAD));
+    pthread_mutex_lock(&s->lock);
+    s->stats.viewers++;
+    pthread_mutex_unlock(&s->lock);
+  } else if (!strcmp(path, "/frame.jpg") || !strcmp(path, "/raw")) {
+    c->state = path[1] == 'r' ? C_RAW : C_JPEG;
+    pthread_mutex_lock(&s->lock);
+    if (c->state == C_RAW) s->raw_waiters++;
+    else s->jpeg_waiters++;
+    pthread_mutex_unlock(&s->lock);
+    return;                       /* answered with the next frame */
+  } else {
+    client_reply(s, c, 404, "Not Found");
+  }
+  client_flush(s, c);
+}
+
+static void client_readable(tc001_http* s, client* c) {
+  for (;;) {
+    char sink[512];
+    const int reading = c->state == C_REQUEST;
+    char* dst = reading ? c->req + c->got : sink;
+    size_t want = reading ? sizeof(c->req) - 1 - c->got : sizeof(sink);
+    ssize_t n = recv(c->fd, dst, want, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (n <= 0) {
+      client_drop(s, c);
+      return;
+    }
+    if (!reading) continue;       /* one request per connection; ignore the rest */
+    c->got += (size_t)n;
+    c->req[c->got] = '\0';
+    if (strstr(c->req, "\r\n\r\n")) client_request(s, c);
+    else if (c->got == sizeof(c->req) - 1) {
+      client_reply(s, c, 431, "Request Header Fields Too Large");
+      client_flush(s, c);
+    }
+    if (c->state == C_FREE) return;
+  }
+}
+
+static void accept_clients(tc001_http* s) {
+  for (;;) {
+    int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    int i = 0;
+    while (i < s->max_clients && s->clients[i].state != C_FREE) ++i;
+    if (i == s->max_clients) {
+      close(fd);
+      s->io.rejected++;
+      continue;
+    }
+    int one = 1, unsent = UNSENT_MAX;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &unsent, sizeof unsent);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.u64 = (uint64_t)i;
+    if (epoll_ctl(s->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      close(fd);
+      s->io.rejected++;
+      continue;
+    }
+    client* c = &s->clients[i];
+    c->fd = fd;
+    c->state = C_REQUEST;
+    c->got = 0;
+    c->head_len = c->head_off = 0;
+    c->body_len = c->body_off = 0;
+    c->last = 0;
+    pthread_mutex_lock(&s->lock);
+    s->stats.clients++;
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+/* Hands the newest frame to every connection waiting for one. */
+static void take_pending(tc001_http* s) {
+  uint64_t count;
+  if (read(s->wake_fd, &count, sizeof(count)) < 0) { /* spurious */ }
+  pthread_mutex_lock(&s->lock);
+  fbuf* jb = s->pending_jpeg;
+  fbuf* rb = s->pending_raw;
+  s->pending_jpeg = s->pending_raw = NULL;
+  pthread_mutex_unlock(&s->lock);
+
+  for (int i = 0; i < s->max_clients; ++i) {
+    client* c = &s->clients[i];
+    if (c->state == C_STREAM && jb) {
+      jb->refs++;
+      if (!c->cur) {
+        client_body(c, jb, jb->part, jb->part_len);
+      } else {
+        if (c->next) {
+          buf_release(s, c->next);
+          s->io.dropped++;
+        }
+        c->next = jb;
+      }
+    } else if ((c->state == C_JPEG && jb) || (c->state == C_RAW && rb)) {
+      if (c->cur) continue;
+      fbuf* b = c->state == C_JPEG ? jb : rb;
+      static const char* const fmt_names[] = { "u8", "u16le", "rgb8" };
+      int n = c->state == C_JPEG
+        ? snprintf(c->head, sizeof(c->head),
+                   "HTTP/1.1 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n"
+                   "Cache-Control: no-cache\r\nConnection: close\r\n\r\n", b->body_len)
+        : snprintf(c->head, sizeof(c->head),
+                   "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\n"
+                   "X-TC001-Width: %d\r\nX-TC001-Height: %d\r\nX-TC001-Format: %s\r\nX-TC001-Frame: %u\r\n"
+                   "Cache-Control: no-cache\r\nConnection: close\r\n\r\n",
+                   b->body_len, b->width, b->height, fmt_names[b->format], (unsigned)b->frame_id);
+      client_head(c, (size_t)n);
+      b->refs++;
+      client_body(c, b, b->body, b->body_len);
+      c->last = 1;
+      pthread_mutex_lock(&s->lock);
+      if (c->state == C_RAW) s->raw_waiters--;
+      else s->jpeg_waiters--;
+      pthread_mutex_unlock(&s->lock);
+    } else {
+      continue;
+    }
+    client_flush(s, c);
+  }
+  buf_release(s, jb);             /* push's reference */
+  buf_release(s, rb);
+}
+
+/* ===== Server ===== */
+tc001_status tc001_http_create(tc001_http** out, const tc001_http_options* opts) {
+  if (!out || !opts || opts->port < 0 || opts->port > 65535 || opts->max_clients < 0 ||
+      opts->quality < 0 || opts->quality > 100)
+    return TC001_ERR_PARAM;
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons((uint16_t)opts->port);
+  if (inet_pton(AF_INET, opts->address ? opts->address : "127.0.0.1", &sa.sin_addr) != 1)
+    return TC001_ERR_PARAM;
+
+  tc001_http* s = (tc001_http*)calloc(1, sizeof(*s));
+  if (!s) return TC001_ERR_ALLOC;
+  s->listen_fd = s->ep = s->wake_fd = -1;
+  s->max_clients = opts->max_clients ? opts->max_clients : DEFAULT_CLIENTS;
+  pthread_mutex_init(&s->lock, NULL);
+  if (opts->palette) {
+    s->has_palette = 1;
+    memcpy(s->palette, opts->palette, sizeof(s->palette));
+  }
+  s->clients = (client*)calloc((size_t)s->max_clients, sizeof(client));
+  if (!s->clients || tc001_jpeg_create(&s->jpeg, opts->quality) != TC001_OK) {
+    tc001_http_destroy(s);
+    return TC001_ERR_ALLOC;
+  }
+  for (int i = 0; i < s->max_clients; ++i) s->clients[i].fd = -1;
+
+  int one = 1;
+  socklen_t len = sizeof(sa);
+  s->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  s->ep = epoll_create1(EPOLL_CLOEXEC);
+  s->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (s->listen_fd < 0 || s->ep < 0 || s->wake_fd < 0 ||
+      setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one) != 0 ||
+      bind(s->listen_fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(s->listen_fd, 64) != 0 ||
+      getsockname(s->listen_fd, (struct sockaddr*)&sa, &len) != 0) {
+    tc001_http_destroy(s);
+    return TC001_ERR_IO;
+  }
+  s->port = ntohs(sa.sin_port);
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.u64 = EV_LISTEN;
+  epoll_ctl(s->ep, EPOLL_CTL_ADD, s->listen_fd, &ev);
+  ev.data.u64 = EV_WAKE;
+  epoll_ctl(s->ep, EPOLL_CTL_ADD, s->wake_fd, &ev);
+  *out = s;
+  return TC001_OK;
+}
+
+int tc001_http_port(const tc001_http* s) { return s ? s->port : 0; }
+
+tc001_status tc001_http_serve(tc001_http* s, int timeout_ms) {
+  if (!s) return TC001_ERR_PARAM;
+  struct epoll_event ev[64];
+  int n = epoll_wait(s->ep, ev, 64, timeout_ms);
+  if (n < 0 && errno != EINTR) return TC001_ERR_IO;
+  for (int i = 0; i < n; ++i) {
+    const uint64_t id = ev[i].data.u64;
+    if (id == EV_LISTEN) {
+      accept_clients(s);
+    } else if (id == EV_WAKE) {
+      take_pending(s);
+    } else {
+      /* a slot dropped and reused within this batch sees a stale event;
+         it only leads to a read or write that finds nothing to do */
+      client* c = &s->clients[id];
+      if (c->state != C_FREE && (ev[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+        client_readable(s, c);
+      if (c->state != C_FREE && (ev[i].events & EPOLLOUT)) client_flush(s, c);
+    }
+  }
+  pthread_mutex_lock(&s->lock);
+  s->stats.requests += s->io.requests;
+  s->stats.rejected += s->io.rejected;
+  s->stats.sent += s->io.sent;
+  s->stats.dropped += s->io.dropped;
+  s->stats.bytes_sent += s->io.bytes_sent;
+  pthread_mutex_unlock(&s->lock);
+  memset(&s->io, 0, sizeof(s->io));
+  return TC001_OK;
+}
+
+void tc001_http_get_stats(tc001_http* s, tc001_http_stats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  if (!s) return;
+  pthread_mutex_lock(&s->lock);
+  *out = s->stats;
+  pthread_mutex_unlock(&s->lock);
+}
+
+void tc001_http_destroy(tc001_http* s) {
+  if (!s) return;
+  if (s->clients)
+    for (int i = 0; i < s->max_clients; ++i)
+      if (s->clients[i].state != C_FREE) client_drop(s, &s->clients[i]);
+  free(s->pending_jpeg);
+  free(s->pending_raw);
+  while (s->pool) {
+    fbuf* b = s->pool;
+    s->pool = b->next_free;
+    free(b);
+  }
+  if (s->listen_fd >= 0) close(s->listen_fd);
+  if (s->ep >= 0) close(s->ep);
+  if (s->wake_fd >= 0) close(s->wake_fd);
+  tc001_jpeg_destroy(s->jpeg);
+  pthread_mutex_destroy(&s->lock);
+  free(s->clients);
+  free(s);
+}
+
+#endif
@@ -0,0 +1,702 @@
+#include "tc001_jpeg.h"
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Baseline sequential JPEG (SOF0), 8-bit samples, Huffman tables of
+   Annex K. Gray images are one component in 8x8 MCUs; colour images are
+   YCbCr with 2x2-subsampled chroma in 16x16 MCUs.
+
+   Samples are converted a strip (one MCU row) at a time into float planes,
+   level shifted, with the right and bottom edges replicated out to whole
+   MCUs. The forward DCT is the AAN float factorisation written once over
+   4-wide vectors: the column pass runs on whole rows, one 4x4 transpose
+   turns the intermediate around, and the row pass leaves the coefficients
+   transposed. The quantiser reciprocals are stored in the same transposed
+   order with the AAN output scale folded in, so quantisation is a multiply
+   and a round, and the zigzag table maps into transposed order. */
+
+#define STRIP_ROWS 16
+
+enum { SRC_GRAY, SRC_RGB, SRC_INDEXED };
+
+typedef struct {
+  uint16_t code[256];
+  uint8_t  len[256];
+} huff_table;
+
+struct tc001_jpeg {
+  uint8_t    qt[2][64];       /* natural order, as written to DQT */
+  float      recip[2][64];    /* transposed; 1 / (q * aan scale) */
+  uint8_t    zz[64];          /* zigzag position -> transposed index */
+  huff_table dc[2], ac[2];    /* 0 luma, 1 chroma */
+
+  float* plane[3];            /* Y, Cb, Cr strips of STRIP_ROWS x pw */
+  int    pw;                  /* floats per strip row, a multiple of 16 */
+
+  float   pal[3][256];        /* palette as level-shifted Y, Cb, Cr */
+  uint8_t pal_rgb[768];       /* palette pal was built from */
+  int     pal_ok;
+
+  uint8_t* agc;               /* tc001_jpeg_encode_frame: 8-bit plane */
+  size_t   agc_cap;
+};
+
+/* ===== Tables ===== */
+static const uint8_t ZIGZAG[64] = {
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static const uint8_t STD_QT[2][64] = {
+  { 16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99 },
+  { 17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99 }
+};
+
+static const uint8_t DC_BITS[2][16] = {
+  { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+  { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 }
+};
+static const uint8_t DC_VALS[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t AC_BITS[2][16] = {
+  { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d },
+  { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 }
+};
+static const uint8_t AC_VALS[2][162] = {
+  { 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa },
+  { 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa }
+};
+
+/* Canonical codes from the code-length counts (Annex C). */
+static void huff_build(huff_table* t, const uint8_t bits[16], const uint8_t* vals) {
+  unsigned code = 0;
+  int k = 0;
+  for (int len = 1; len <= 16; ++len) {
+    for (int i = 0; i < bits[len - 1]; ++i, ++k) {
+      t->code[vals[k]] = (uint16_t)code++;
+      t->len[vals[k]] = (uint8_t)len;
+    }
+    code <<= 1;
+  }
+}
+
+/* ===== Vectors ===== */
+#if defined(TC001_SSE2)
+typedef __m128 v4f;
+#define V_LOAD(p)      _mm_loadu_ps(p)
+#define V_STORE(p, v)  _mm_storeu_ps((p), (v))
+#define V_SET1(x)      _mm_set1_ps(x)
+#define V_ADD(a, b)    _mm_add_ps((a), (b))
+#define V_SUB(a, b)    _mm_sub_ps((a), (b))
+#define V_MUL(a, b)    _mm_mul_ps((a), (b))
+#define V_TRANSPOSE(a, b, c, d) _MM_TRANSPOSE4_PS(a, b, c, d)
+/* (a0+a1, a2+a3, b0+b1, b2+b3) */
+static inline v4f v_pairsum(v4f a, v4f b) {
+  return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                    _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+#elif defined(TC001_NEON)
+typedef float32x4_t v4f;
+#define V_LOAD(p)      vld1q_f32(p)
+#define V_STORE(p, v)  vst1q_f32((p), (v))
+#define V_SET1(x)      vdupq_n_f32(x)
+#define V_ADD(a, b)    vaddq_f32((a), (b))
+#define V_SUB(a, b)    vsubq_f32((a), (b))
+#define V_MUL(a, b)    vmulq_f32((a), (b))
+#define V_TRANSPOSE(a, b, c, d) do {                                 \
+    float32x4x2_t t0_ = vtrnq_f32((a), (b)), t1_ = vtrnq_f32((c), (d)); \
+    (a) = vcombine_f32(vget_low_f32(t0_.val[0]), vget_low_f32(t1_.val[0]));   \
+    (b) = vcombine_f32(vget_low_f32(t0_.val[1]), vget_low_f32(t1_.val[1]));   \
+    (c) = vcombine_f32(vget_high_f32(t0_.val[0]), vget_high_f32(t1_.val[0])); \
+    (d) = vcombine_f32(vget_high_f32(t0_.val[1]), vget_high_f32(t1_.val[1])); \
+  } while (0)
+static inline v4f v_pairsum(v4f a, v4f b) { return vpaddq_f32(a, b); }
+#else
+typedef struct { float f[4]; } v4f;
+static inline v4f v_load(const float* p) { v4f r; memcpy(r.f, p, sizeof(r.f)); return r; }
+static inline void v_store(float* p, v4f v) { memcpy(p, v.f, sizeof(v.f)); }
+static inline v4f v_set1(float x) { v4f r = {{ x, x, x, x }}; return r; }
+static inline v4f v_add(v4f a, v4f b) { for (int i = 0; i < 4; ++i) a.f[i] += b.f[i]; return a; }
+static inline v4f v_sub(v4f a, v4f b) { for (int i = 0; i < 4; ++i) a.f[i] -= b.f[i]; return a; }
+static inline v4f v_mul(v4f a, v4f b) { for (int i = 0; i < 4; ++i) a.f[i] *= b.f[i]; return a; }
+static inline void v_transpose(v4f* a, v4f* b, v4f* c, v4f* d) {
+  v4f r[4] = { *a, *b, *c, *d };
+  for (int i = 0; i < 4; ++i) {
+    a->f[i] = r[i].f[0]; b->f[i] = r[i].f[1]; c->f[i] = r[i].f[2]; d->f[i] = r[i].f[3];
+  }
+}
+static inline v4f v_pairsum(v4f a, v4f b) {
+  v4f r = {{ a.f[0] + a.f[1], a.f[2] + a.f[3], b.f[0] + b.f[1], b.f[2] + b.f[3] }};
+  return r;
+}
+#define V_LOAD(p)      v_load(p)
+#define V_STORE(p, v)  v_store((p), (v))
+#define V_SET1(x)      v_set1(x)
+#define V_ADD(a, b)    v_add((a), (b))
+#define V_SUB(a, b)    v_sub((a), (b))
+#define V_MUL(a, b)    v_mul((a), (b))
+#define V_TRANSPOSE(a, b, c, d) v_transpose(&(a), &(b), &(c), &(d))
+#endif
+
+/* ===== Sample conversion ===== */
+/* n samples to level-shifted floats. */
+static void gray_to_f(const uint8_t* s, float* d, int n) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128i z = _mm_setzero_si128();
+  const __m128 off = _mm_set1_ps(128.f);
+  for (; x + 16 <= n; x += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + x));
+    __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+    _mm_storeu_ps(d + x,      _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, z)), off));
+    _mm_storeu_ps(d + x + 4,  _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, z)), off));
+    _mm_storeu_ps(d + x + 8,  _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, z)), off));
+    _mm_storeu_ps(d + x + 12, _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, z)), off));
+  }
+#elif defined(TC001_NEON)
+  const float32x4_t off = vdupq_n_f32(128.f);
+  for (; x + 16 <= n; x += 16) {
+    uint8x16_t v = vld1q_u8(s + x);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(v)), hi = vmovl_u8(vget_high_u8(v));
+    vst1q_f32(d + x,      vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), off));
+    vst1q_f32(d + x + 4,  vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), off));
+    vst1q_f32(d + x + 8,  vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), off));
+    vst1q_f32(d + x + 12, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), off));
+  }
+#endif
+  for (; x < n; ++x) d[x] = (float)s[x] - 128.f;
+}
+
+/* JFIF YCbCr, Y level shifted; the chroma offset of 128 cancels the shift. */
+#define Y_R   0.299f
+#define Y_G   0.587f
+#define Y_B   0.114f
+#define CB_R -0.168736f
+#define CB_G -0.331264f
+#define CB_B  0.5f
+#define CR_R  0.5f
+#define CR_G -0.418688f
+#define CR_B -0.081312f
+
+/* n RGB pixels to Y, Cb, Cr. The bytes are spread into the three planes
+   first, then converted in place four pixels at a time. */
+static void rgb_to_ycc(const uint8_t* s, float* y, float* cb, float* cr, int n) {
+  for (int x = 0; x < n; ++x, s += 3) {
+    y[x] = s[0];
+    cb[x] = s[1];
+    cr[x] = s[2];
+  }
+  const v4f yr = V_SET1(Y_R), yg = V_SET1(Y_G), yb = V_SET1(Y_B), off = V_SET1(128.f);
+  const v4f br = V_SET1(CB_R), bg = V_SET1(CB_G), bb = V_SET1(CB_B);
+  const v4f rr = V_SET1(CR_R), rg = V_SET1(CR_G), rb = V_SET1(CR_B);
+  int x = 0;
+  for (; x + 4 <= n; x += 4) {
+    v4f r = V_LOAD(y + x), g = V_LOAD(cb + x), b = V_LOAD(cr + x);
+    V_STORE(y + x,  V_SUB(V_ADD(V_ADD(V_MUL(r, yr), V_MUL(g, yg)), V_MUL(b, yb)), off));
+    V_STORE(cb + x, V_ADD(V_ADD(V_MUL(r, br), V_MUL(g, bg)), V_MUL(b, bb)));
+    V_STORE(cr + x, V_ADD(V_ADD(V_MUL(r, rr), V_MUL(g, rg)), V_MUL(b, rb)));
+  }
+  for (; x < n; ++x) {
+    float r = y[x], g = cb[x], b = cr[x];
+    y[x]  = Y_R * r + Y_G * g + Y_B * b - 128.f;
+    cb[x] = CB_R * r + CB_G * g + CB_B * b;
+    cr[x] = CR_R * r + CR_G * g + CR_B * b;
+  }
+}
+
+static void palette_build(tc001_jpeg* j, const uint8_t* pal) {
+  for (int i = 0; i < 256; ++i) {
+    float r = pal[3 * i], g = pal[3 * i + 1], b = pal[3 * i + 2];
+    j->pal[0][i] = Y_R * r + Y_G * g + Y_B * b - 128.f;
+    j->pal[1][i] = CB_R * r + CB_G * g + CB_B * b;
+    j->pal[2][i] = CR_R * r + CR_G * g + CR_B * b;
+  }
+  memcpy(j->pal_rgb, pal, sizeof(j->pal_rgb));
+  j->pal_ok = 1;
+}
+
+/* Converts image rows y0 .. y0+rows-1 into the strip planes, repeating the
+   last column out to pw and the last row past the bottom edge. */
+static void fill_strip(tc001_jpeg* j, int kind, const uint8_t* px, int w, int h, int pitch,
+                       int y0, int rows) {
+  const int pw = j->pw, planes = kind == SRC_GRAY ? 1 : 3;
+  for (int r = 0; r < rows; ++r) {
+    float* d[3] = { j->plane[0] + (size_t)r * pw, j->plane[1] + (size_t)r * pw,
+                    j->plane[2] + (size_t)r * pw };
+    if (y0 + r >= h) {
+      for (int c = 0; c < planes; ++c) memcpy(d[c], d[c] - pw, (size_t)pw * sizeof(float));
+      continue;
+    }
+    const uint8_t* s = px + (size_t)(y0 + r) * pitch;
+    if (kind == SRC_GRAY) {
+      gray_to_f(s, d[0], w);
+    } else if (kind == SRC_RGB) {
+      rgb_to_ycc(s, d[0], d[1], d[2], w);
+    } else {
+      for (int x = 0; x < w; ++x) {
+        d[0][x] = j->pal[0][s[x]];
+        d[1][x] = j->pal[1][s[x]];
+        d[2][x] = j->pal[2][s[x]];
+      }
+    }
+    for (int c = 0; c < planes; ++c)
+      for (int x = w; x < pw; ++x) d[c][x] = d[c][w - 1];
+  }
+}
+
+/* 2x2 box average of the 16x16 chroma area at src into an 8x8 block. */
+static void downsample(const float* src, int stride, float* blk) {
+  const v4f quarter = V_SET1(0.25f);
+  for (int r = 0; r < 8; ++r) {
+    const float* a = src + (size_t)(2 * r) * stride;
+    const float* b = a + stride;
+    for (int half = 0; half < 2; ++half) {
+      v4f s0 = V_ADD(V_LOAD(a + 8 * half), V_LOAD(b + 8 * half));
+      v4f s1 = V_ADD(V_LOAD(a + 8 * half + 4), V_LOAD(b + 8 * half + 4));
+      V_STORE(blk + r * 8 + 4 * half, V_MUL(v_pairsum(s0, s1), quarter));
+    }
+  }
+}
+
+/* ===== DCT and quantisation ===== */
+/* One 8-point AAN pass over four lanes; d[k] becomes coefficient k, scaled
+   by aan[k] (folded into the quantiser). */
+static inline void aan8(v4f* d) {
+  const v4f c707 = V_SET1(0.707106781f), c382 = V_SET1(0.382683433f);
+  const v4f c541 = V_SET1(0.541196100f), c1306 = V_SET1(1.306562965f);
+  v4f t0 = V_ADD(d[0], d[7]), t7 = V_SUB(d[0], d[7]);
+  v4f t1 = V_ADD(d[1], d[6]), t6 = V_SUB(d[1], d[6]);
+  v4f t2 = V_ADD(d[2], d[5]), t5 = V_SUB(d[2], d[5]);
+  v4f t3 = V_ADD(d[3], d[4]), t4 = V_SUB(d[3], d[4]);
+
+  /* even part */
+  v4f t10 = V_ADD(t0, t3), t13 = V_SUB(t0, t3);
+  v4f t11 = V_ADD(t1, t2), t12 = V_SUB(t1, t2);
+  d[0] = V_ADD(t10, t11);
+  d[4] = V_SUB(t10, t11);
+  v4f z1 = V_MUL(V_ADD(t12, t13), c707);
+  d[2] = V_ADD(t13, z1);
+  d[6] = V_SUB(t13, z1);
+
+  /* odd part */
+  t10 = V_ADD(t4, t5);
+  t11 = V_ADD(t5, t6);
+  t12 = V_ADD(t6, t7);
+  v4f z5 = V_MUL(V_SUB(t10, t12), c382);
+  v4f z2 = V_ADD(V_MUL(t10, c541), z5);
+  v4f z4 = V_ADD(V_MUL(t12, c1306), z5);
+  v4f z3 = V_MUL(t11, c707);
+  v4f z11 = V_ADD(t7, z3), z13 = V_SUB(t7, z3);
+  d[5] = V_ADD(z13, z2);
+  d[3] = V_SUB(z13, z2);
+  d[1] = V_ADD(z11, z4);
+  d[7] = V_SUB(z11, z4);
+}
+
+/* 8x8 block at in (stride in floats) to scaled coefficients, out[u*8+v]
+   holding vertical frequency v, horizontal frequency u. */
+static void fdct(const float* in, int stride, float* out) {
+  float mid[64];
+  for (int half = 0; half < 2; ++half) {
+    v4f d[8];
+    for (int r = 0; r < 8; ++r) d[r] = V_LOAD(in + (size_t)r * stride + 4 * half);
+    aan8(d);
+    for (int v = 0; v < 8; ++v) V_STORE(mid + v * 8 + 4 * half, d[v]);
+  }
+  for (int g = 0; g < 2; ++g) {
+    v4f x[8];
+    for (int i = 0; i < 4; ++i) {
+      x[i]     = V_LOAD(mid + (4 * g + i) * 8);
+      x[i + 4] = V_LOAD(mid + (4 * g + i) * 8 + 4);
+    }
+    V_TRANSPOSE(x[0], x[1], x[2], x[3]);
+    V_TRANSPOSE(x[4], x[5], x[6], x[7]);
+    aan8(x);
+    for (int u = 0; u < 8; ++u) V_STORE(out + u * 8 + 4 * g, x[u]);
+  }
+}
+
+static void quantize(const float* coef, const float* recip, int16_t* q) {
+#if defined(TC001_SSE2)
+  for (int i = 0; i < 64; i += 8) {
+    __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(coef + i), _mm_loadu_ps(recip + i)));
+    __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(coef + i + 4), _mm_loadu_ps(recip + i + 4)));
+    _mm_storeu_si128((__m128i*)(q + i), _mm_packs_epi32(a, b));
+  }
+#elif defined(TC001_NEON)
+  for (int i = 0; i < 64; i += 8) {
+    int32x4_t a = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(coef + i), vld1q_f32(recip + i)));
+    int32x4_t b = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(coef + i + 4), vld1q_f32(recip + i + 4)));
+    vst1q_s16(q + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+#else
+  for (int i = 0; i < 64; ++i) q[i] = (int16_t)lrintf(coef[i] * recip[i]);
+#endif
+}
+
+/* ===== Entropy coding ===== */
+/* Bits go MSB first into acc; whole 32-bit words are flushed with 0xFF
+   bytes stuffed. A full dst sets overflow and drops further output. */
+typedef struct {
+  uint8_t* p;
+  uint8_t* end;
+  uint64_t acc;
+  int      n;                 /* pending bits, in the low end of acc */
+  int      overflow;
+} bit_writer;
+
+static void emit_byte(bit_writer* b, unsigned v) {
+  *b->p++ = (uint8_t)v;
+  if (v == 0xFF) *b->p++ = 0;
+}
+
+static void emit32(bit_writer* b, uint32_t w) {
+  if (b->end - b->p < 8) {
+    b->overflow = 1;
+    return;
+  }
+  if (!((~w - 0x01010101u) & w & 0x80808080u)) {   /* no 0xFF byte */
+    b->p[0] = (uint8_t)(w >> 24);
+    b->p[1] = (uint8_t)(w >> 16);
+    b->p[2] = (uint8_t)(w >> 8);
+    b->p[3] = (uint8_t)w;
+    b->p += 4;
+    return;
+  }
+  for (int s = 24; s >= 0; s -= 8) emit_byte(b, (w >> s) & 0xFF);
+}
+
+/* len <= 27 */
+static inline void put_bits(bit_writer* b, uint32_t bits, int len) {
+  b->acc = (b->acc << len) | bits;
+  b->n += len;
+  if (b->n >= 32) {
+    b->n -= 32;
+    emit32(b, (uint32_t)(b->acc >> b->n));
+  }
+}
+
+/* Pads the last byte with 1 bits. */
+static void flush_bits(bit_writer* b) {
+  int pad = (8 - (b->n & 7)) & 7;
+  b->acc = (b->acc << pad) | ((1u << pad) - 1);
+  b->n += pad;
+  if (b->end - b->p < 2 * (b->n / 8)) {
+    b->overflow = 1;
+    return;
+  }
+  for (; b->n > 0; b->n -= 8) emit_byte(b, (uint32_t)(b->acc >> (b->n - 8)) & 0xFF);
+}
+
+static inline int bit_length(unsigned v) {
+#if defined(_MSC_VER)
+  unsigned long i;
+  if (!_BitScanReverse(&i, v)) return 0;
+  return (int)i + 1;
+#else
+  return v ? 32 - __builtin_clz(v) : 0;
+#endif
+}
+
+static inline int ctz64(uint64_t m) {
+#if defined(_MSC_VER)
+  unsigned long i;
+  _BitScanForward64(&i, m);
+  return (int)i;
+#else
+  return __builtin_ctzll(m);
+#endif
+}
+
+/* Huffman code of sym followed by the magnitude bits of v, in one put. */
+static inline void put_coef(bit_writer* b, const huff_table* t, int sym_hi, int v) {
+  unsigned a = (unsigned)(v < 0 ? -v : v);
+  int nb = bit_length(a);
+  unsigned extra = (unsigned)(v < 0 ? v - 1 : v) & ((1u << nb) - 1);
+  int sym = sym_hi | nb;
+  put_bits(b, ((uint32_t)t->code[sym] << nb) | extra, t->len[sym] + nb);
+}
+
+/* q in transposed order. The nonzero AC coefficients are collected into a
+   zigzag-ordered mask first, so runs of zeros cost nothing to skip. */
+static void encode_block(bit_writer* b, const int16_t* q, const uint8_t* zz, int* dc_prev,
+                         const huff_table* dc, const huff_table* ac) {
+  put_coef(b, dc, 0, q[0] - *dc_prev);
+  *dc_prev = q[0];
+
+  int16_t z[64];
+  uint64_t nz = 0;
+  for (int k = 1; k < 64; ++k) {
+    int v = q[zz[k]];
+    z[k] = (int16_t)(v > 1023 ? 1023 : v < -1023 ? -1023 : v);   /* 10 bits in baseline */
+    nz |= (uint64_t)(v != 0) << k;
+  }
+  int last = 0;
+  while (nz) {
+    int k = ctz64(nz);
+    nz &= nz - 1;
+    int run = k - last - 1;
+    for (; run >= 16; run -= 16) put_bits(b, ac->code[0xF0], ac->len[0xF0]);   /* ZRL */
+    put_coef(b, ac, run << 4, z[k]);
+    last = k;
+  }
+  if (last != 63) put_bits(b, ac->code[0x00], ac->len[0x00]);   /* EOB */
+}
+
+static void code_block(tc001_jpeg* j, bit_writer* b, const float* src, int stride,
+                       int table, int* dc_prev) {
+  float coef[64];
+  int16_t q[64];
+  fdct(src, stride, coef);
+  quantize(coef, j->recip[table], q);
+  encode_block(b, q, j->zz, dc_prev, &j->dc[table], &j->ac[table]);
+}
+
+/* ===== Markers ===== */
+static uint8_t* put16(uint8_t* p, unsigned v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+  return p + 2;
+}
+
+static size_t headers_bytes(int color) {
+  const int t = color ? 2 : 1, nc = color ? 3 : 1;
+  size_t n = 2 + 18 + 4 + 65 * t + 10 + 3 * nc + 4 + 8 + 2 * nc;
+  for (int i = 0; i < t; ++i) n += 17 + 12 + 17 + 162;
+  return n;
+}
+
+/* SOI through SOS; dst has headers_bytes room. */
+static uint8_t* write_headers(const tc001_jpeg* j, uint8_t* p, int w, int h, int color) {
+  static const uint8_t jfif[18] = {
+    0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0
+  };
+  const int tables = color ? 2 : 1, nc = color ? 3 : 1;
+  p = put16(p, 0xFFD8);
+  memcpy(p, jfif, sizeof(jfif));
+  p += sizeof(jfif);
+
+  p = put16(p, 0xFFDB);
+  p = put16(p, 2 + 65 * tables);
+  for (int t = 0; t < tables; ++t) {
+    *p++ = (uint8_t)t;
+    for (int k = 0; k < 64; ++k) *p++ = j->qt[t][ZIGZAG[k]];
+  }
+
+  p = put16(p, 0xFFC0);
+  p = put16(p, 8 + 3 * nc);
+  *p++ = 8;
+  p = put16(p, (unsigned)h);
+  p = put16(p, (unsigned)w);
+  *p++ = (uint8_t)nc;
+  for (int c = 0; c < nc; ++c) {
+    *p++ = (uint8_t)(c + 1);
+    *p++ = color && c == 0 ? 0x22 : 0x11;
+    *p++ = (uint8_t)(c ? 1 : 0);
+  }
+
+  p = put16(p, 0xFFC4);
+  p = put16(p, 2 + tables * (17 + 12 + 17 + 162));
+  for (int t = 0; t < tables; ++t) {
+    *p++ = (uint8_t)t;
+    memcpy(p, DC_BITS[t], 16);
+    memcpy(p + 16, DC_VALS, 12);
+    p += 28;
+    *p++ = (uint8_t)(0x10 | t);
+    memcpy(p, AC_BITS[t], 16);
+    memcpy(p + 16, AC_VALS[t], 162);
+    p += 178;
+  }
+
+  p = put16(p, 0xFFDA);
+  p = put16(p, 6 + 2 * nc);
+  *p++ = (uint8_t)nc;
+  for (int c = 0; c < nc; ++c) {
+    *p++ = (uint8_t)(c + 1);
+    *p++ = c ? 0x11 : 0x00;
+  }
+  *p++ = 0;
+  *p++ = 63;
+  *p++ = 0;
+  return p;
+}
+
+/* ===== Encoder object ===== */
+tc001_status tc001_jpeg_create(tc001_jpeg** out, int quality) {
+  static const float aan[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+  };
+  if (!out || quality < 0 || quality > 100) return TC001_ERR_PARAM;
+  if (!quality) quality = 85;
+  tc001_jpeg* j = (tc001_jpeg*)calloc(1, sizeof(*j));
+  if (!j) return TC001_ERR_ALLOC;
+
+  /* libjpeg's quality scaling of the Annex K tables */
+  const int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+  for (int t = 0; t < 2; ++t) {
+    for (int i = 0; i < 64; ++i) {
+      int q = (STD_QT[t][i] * scale + 50) / 100;
+      j->qt[t][i] = (uint8_t)(q < 1 ? 1 : q > 255 ? 255 : q);
+    }
+    for (int v = 0; v < 8; ++v)
+      for (int u = 0; u < 8; ++u)
+        j->recip[t][u * 8 + v] = 1.f / (j->qt[t][v * 8 + u] * aan[v] * aan[u] * 8.f);
+    huff_build(&j->dc[t], DC_BITS[t], DC_VALS);
+    huff_build(&j->ac[t], AC_BITS[t], AC_VALS[t]);
+  }
+  for (int k = 0; k < 64; ++k) j->zz[k] = (uint8_t)((ZIGZAG[k] & 7) * 8 + (ZIGZAG[k] >> 3));
+  *out = j;
+  return TC001_OK;
+}
+
+void tc001_jpeg_destroy(tc001_jpeg* j) {
+  if (!j) return;
+  tc001__aligned_free(j->plane[0]);
+  free(j->agc);
+  free(j);
+}
+
+size_t tc001_jpeg_max_bytes(int width, int height, int color) {
+  if (width <= 0 || height <= 0) return 0;
+  const int mcu = color ? 16 : 8;
+  const size_t mcus = (size_t)((width + mcu - 1) / mcu) * (size_t)((height + mcu - 1) / mcu);
+  /* a block is at most 22 + 63 * 26 bits, doubled by stuffing */
+  return headers_bytes(color) + mcus * (color ? 6 : 1) * 416 + 16;
+}
+
+/* Grows the strip planes for a width of w. */
+static int ensure_strip(tc001_jpeg* j, int w) {
+  const int pw = (w + 15) & ~15;
+  if (pw <= j->pw) return 0;
+  const size_t plane = (size_t)pw * STRIP_ROWS;
+  float* p = (float*)tc001__aligned_alloc(plane * 3 * sizeof(float), 64);
+  if (!p) return -1;
+  tc001__aligned_free(j->plane[0]);
+  j->plane[0] = p;
+  j->plane[1] = p + plane;
+  j->plane[2] = p + 2 * plane;
+  j->pw = pw;
+  return 0;
+}
+
+static tc001_status encode(tc001_jpeg* j, int kind, const uint8_t* px, int w, int h, int pitch,
+                           const uint8_t* palette, void* dst, size_t dst_cap, size_t* written) {
+  if (!j || !px || !dst || !written || w <= 0 || h <= 0 || w > 65535 || h > 65535 ||
+      pitch < w * (kind == SRC_RGB ? 3 : 1) || (kind == SRC_INDEXED && !palette))
+    return TC001_ERR_PARAM;
+  const int color = kind != SRC_GRAY;
+  if (dst_cap < headers_bytes(color) + 2) return TC001_ERR_PARAM;
+  if (ensure_strip(j, w) != 0) return TC001_ERR_ALLOC;
+  if (kind == SRC_INDEXED && (!j->pal_ok || memcmp(j->pal_rgb, palette, sizeof(j->pal_rgb))))
+    palette_build(j, palette);
+
+  uint8_t* p = write_headers(j, (uint8_t*)dst, w, h, color);
+  bit_writer b = { p, (uint8_t*)dst + dst_cap - 2, 0, 0, 0 };   /* room for EOI */
+  const int pw = j->pw, mcu = color ? 16 : 8;
+  int dc_prev[3] = { 0, 0, 0 };
+  for (int y0 = 0; y0 < h && !b.overflow; y0 += mcu) {
+    fill_strip(j, kind, px, w, h, pitch, y0, mcu);
+    const float *Y = j->plane[0], *Cb = j->plane[1], *Cr = j->plane[2];
+    for (int x0 = 0; x0 < w; x0 += mcu) {
+      if (!color) {
+        code_block(j, &b, Y + x0, pw, 0, &dc_prev[0]);
+        continue;
+      }
+      float blk[64];
+      code_block(j, &b, Y + x0,              pw, 0, &dc_prev[0]);
+      code_block(j, &b, Y + x0 + 8,          pw, 0, &dc_prev[0]);
+      code_block(j, &b, Y + 8 * pw + x0,     pw, 0, &dc_prev[0]);
+      code_block(j, &b, Y + 8 * pw + x0 + 8, pw, 0, &dc_prev[0]);
+      downsample(Cb + x0, pw, blk);
+      code_block(j, &b, blk, 8, 1, &dc_prev[1]);
+      downsample(Cr + x0, pw, blk);
+      code_block(j, &b, blk, 8, 1, &dc_prev[2]);
+    }
+  }
+  flush_bits(&b);
+  if (b.overflow) return TC001_ERR_PARAM;
+  b.p = put16(b.p, 0xFFD9);
+  *written = (size_t)(b.p - (uint8_t*)dst);
+  return TC001_OK;
+}
+
+tc001_status tc001_jpeg_encode_gray(tc001_jpeg* j, const uint8_t* px, int width, int height, int pitch,
+                                    void* dst, size_t dst_cap, size_t* written) {
+  return encode(j, SRC_GRAY, px, width, height, pitch, NULL, dst, dst_cap, written);
+}
+
+tc001_status tc001_jpeg_encode_rgb(tc001_jpeg* j, const uint8_t* rgb, int width, int height, int pitch,
+                                   void* dst, size_t dst_cap, size_t* written) {
+  return encode(j, SRC_RGB, rgb, width, height, pitch, NULL, dst, dst_cap, written);
+}
+
+tc001_status tc001_jpeg_encode_indexed(tc001_jpeg* j, const uint8_t* idx, int width, int height, int pitch,
+                                       const uint8_t* palette,
+                                       void* dst, size_t dst_cap, size_t* written) {
+  return encode(j, SRC_INDEXED, idx, width, height, pitch, palette, dst, dst_cap, written);
+}
+
+tc001_status tc001_jpeg_encode_frame(tc001_jpeg* j, const tc001_frame* f, const uint8_t* palette,
+                                     void* dst, size_t dst_cap, size_t* written) {
+  if (!j || !f || !f->data || f->width <= 0 || f->height <= 0) return TC001_ERR_PARAM;
+  const int kind = palette ? SRC_INDEXED : SRC_GRAY;
+  if (f->format == TC001_FMT_U8)
+    return encode(j, kind, f->data, f->width, f->height, f->stride, palette, dst, dst_cap, written);
+  if (f->format != TC001_FMT_U16 || f->stride < f->width * 2) return TC001_ERR_PARAM;
+
+  const int w = f->width, h = f->height;
+  const size_t n = (size_t)w * h;
+  if (n > j->agc_cap) {
+    uint8_t* p = (uint8_t*)realloc(j->agc, n);
+    if (!p) return TC001_ERR_ALLOC;
+    j->agc = p;
+    j->agc_cap = n;
+  }
+  uint16_t lo = 65535, hi = 0;
+  if (f->stats) {
+    lo = f->stats->raw_min;
+    hi = f->stats->raw_max;
+  } else {
+    for (int y = 0; y < h; ++y)
+      tc001__minmax_u16((const uint16_t*)(f->data + (size_t)y * f->stride), w, &lo, &hi);
+  }
+  const float scale = tc001__agc_scale(lo, hi);
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* s = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    uint8_t* d = j->agc + (size_t)y * w;
+    for (int x = 0; x < w; ++x) d[x] = tc001__agc_u8(s[x], lo, scale);
+  }
+  return encode(j, kind, j->agc, w, h, w, palette, dst, dst_cap, written);
+}
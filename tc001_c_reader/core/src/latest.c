@@ -0,0 +1,115 @@
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Latest-frame mailbox: two buffers, each behind a sequence lock that is
+   odd while the acquisition thread writes it. The writer always fills the
+   buffer readers are not pointed at and then points them there, so a
+   reader retries only when the writer comes round to its buffer again
+   during one copy, two frames later. Readers never write shared state. */
+
+#define MAX_TRIES 64
+
+typedef struct {
+  tc001_atomic_int lock;
+  uint32_t seq;             /* frames published up to this one, from 1 */
+  int      width, height;
+  int64_t  timestamp_ns;
+  uint32_t frame_id;
+  uint8_t* data;
+} latest_buf;
+
+struct tc001_latest {
+  latest_buf buf[2];
+  tc001_atomic_int newest;  /* buffer readers copy; -1 = none yet */
+  uint32_t count;
+  size_t   bytes;           /* of each buffer */
+};
+
+void tc001__latest_publish(struct tc001_latest* l, const tc001_frame* f) {
+  const int i = TC001_ATOMIC_LOAD(&l->newest) == 0 ? 1 : 0;
+  latest_buf* b = &l->buf[i];
+  const size_t row = (size_t)f->width * 2;
+  TC001_ATOMIC_STORE(&b->lock, TC001_ATOMIC_LOAD(&b->lock) + 1);
+  TC001_ATOMIC_FENCE();     /* odd before any byte of the frame */
+  b->seq = ++l->count;
+  b->width = f->width;
+  b->height = f->height;
+  b->timestamp_ns = f->timestamp_ns;
+  b->frame_id = f->frame_id;
+  if ((size_t)f->stride == row) {
+    memcpy(b->data, f->data, row * f->height);
+  } else {
+    for (int y = 0; y < f->height; ++y) memcpy(b->data + y * row, f->data + (size_t)y * f->stride, row);
+  }
+  TC001_ATOMIC_STORE(&b->lock, TC001_ATOMIC_LOAD(&b->lock) + 1);
+  TC001_ATOMIC_STORE(&l->newest, i);
+}
+
+void tc001__latest_free(struct tc001_latest* l) {
+  if (!l) return;
+  tc001__buf_free(l->buf[0].data, l->bytes, 0);
+  tc001__buf_free(l->buf[1].data, l->bytes, 0);
+  free(l);
+}
+
+tc001_status tc001_enable_latest(tc001_handle* h, int enable) {
+  if (!h) return TC001_ERR_PARAM;
+  /* allocated before the flag is published and kept until close; sized for
+     the whole sensor, whatever the acquisition window */
+  if (enable && !h->latest) {
+    const size_t bytes = (size_t)h->src_w * h->src_h * 2;
+    struct tc001_latest* l = (struct tc001_latest*)calloc(1, sizeof(*l));
+    if (!l) return TC001_ERR_ALLOC;
+    l->bytes = bytes;
+    l->buf[0].data = (uint8_t*)tc001__buf_alloc(bytes, 0);
+    l->buf[1].data = (uint8_t*)tc001__buf_alloc(bytes, 0);
+    if (!l->buf[0].data || !l->buf[1].data) {
+      tc001__latest_free(l);
+      return TC001_ERR_ALLOC;
+    }
+    TC001_ATOMIC_STORE(&l->newest, -1);
+    h->latest = l;
+  }
+  TC001_ATOMIC_STORE(&h->want_latest, enable ? 1 : 0);
+  return TC001_OK;
+}
+
+tc001_status tc001_peek_latest(tc001_handle* h, void* dst, size_t dst_cap,
+                               tc001_frame* info, uint32_t* seq) {
+  if (!h || !dst) return TC001_ERR_PARAM;
+  if (!TC001_ATOMIC_LOAD(&h->want_latest)) return TC001_ERR_STATE;
+  struct tc001_latest* l = h->latest;
+  for (int tries = 0; tries < MAX_TRIES; ++tries) {
+    const int i = TC001_ATOMIC_LOAD(&l->newest);
+    if (i < 0) return TC001_ERR_STATE;
+    latest_buf* b = &l->buf[i];
+    const int lock = TC001_ATOMIC_LOAD(&b->lock);
+    if (lock & 1) continue;
+    const uint32_t n = b->seq;
+    const int w = b->width, hgt = b->height;
+    const int64_t ts = b->timestamp_ns;
+    const uint32_t id = b->frame_id;
+    const size_t bytes = (size_t)w * hgt * 2;
+    const int fresh = !seq || n != *seq;
+    if (fresh && bytes <= dst_cap) memcpy(dst, b->data, bytes);
+    TC001_ATOMIC_FENCE();
+    if (TC001_ATOMIC_LOAD(&b->lock) != lock) continue;
+
+    if (!fresh) return TC001_ERR_STATE;
+    if (bytes > dst_cap) return TC001_ERR_PARAM;
+    if (info) {
+      memset(info, 0, sizeof(*info));
+      info->width = w;
+      info->height = hgt;
+      info->stride = w * 2;
+      info->timestamp_ns = ts;
+      info->format = TC001_FMT_U16;
+      info->data = (const uint8_t*)dst;
+      info->frame_id = id;
+    }
+    if (seq) *seq = n;
+    return TC001_OK;
+  }
+  return TC001_ERR_STATE;
+}
@@ -0,0 +1,256 @@
+#include "tc001_jpeg.h"
+#include "tc001_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* AVI layout (RIFF, little-endian):
+
+     RIFF 'AVI '
+       LIST 'hdrl'  avih, LIST 'strl' { strh 'vids' 'MJPG', strf BITMAPINFOHEADER }
+       LIST 'movi'  one '00dc' chunk per JPEG, padded to even length
+       idx1         16 bytes per frame, offsets from the 'movi' fourcc
+
+   The header has a fixed size, so it is written with zero counts at open
+   and rewritten in place with the final counts and sizes on close. */
+
+#define AVI_HDR_BYTES  224
+#define AVI_MOVI_AT    220        /* the 'movi' fourcc */
+#define AVIF_HASINDEX  0x10u
+#define AVIIF_KEYFRAME 0x10u
+
+enum { KIND_AVI, KIND_MULTIPART };
+
+struct tc001_mjpeg {
+  int kind;
+  tc001_status error;         /* first failure; later writes return it */
+
+  /* AVI */
+  int      fd;
+  uint64_t pos;               /* end of the last chunk */
+  int      w, h;
+  double   fps;
+  uint32_t frames, max_bytes;
+  uint8_t* idx;               /* idx1 entries */
+  size_t   idx_len, idx_cap;
+
+  /* multipart */
+  tc001_write_fn write;
+  void* user;
+};
+
+static int grow(void** p, size_t* cap, size_t n, size_t elem) {
+  if (n <= *cap) return 0;
+  size_t c = *cap ? *cap * 2 : 256;
+  while (c < n) c *= 2;
+  void* q = realloc(*p, c * elem);
+  if (!q) return -1;
+  *p = q;
+  *cap = c;
+  return 0;
+}
+
+static uint8_t* le32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+static uint8_t* le16(uint8_t* p, unsigned v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static uint8_t* fourcc(uint8_t* p, const char* s) {
+  memcpy(p, s, 4);
+  return p + 4;
+}
+
+/* ===== AVI ===== */
+static void avi_header(const tc001_mjpeg* m, uint8_t* hdr) {
+  const uint64_t idx_end = m->pos + 8 + m->idx_len;
+  const uint32_t us = (uint32_t)(1e6 / m->fps + 0.5);
+  const uint32_t rate = (uint32_t)(m->fps * 1000.0 + 0.5);
+  const uint32_t image = (uint32_t)m->w * (uint32_t)m->h * 3;
+  uint8_t* p = hdr;
+
+  p = fourcc(p, "RIFF");
+  p = le32(p, (uint32_t)(idx_end - 8));
+  p = fourcc(p, "AVI ");
+
+  p = fourcc(p, "LIST");
+  p = le32(p, 192);
+  p = fourcc(p, "hdrl");
+  p = fourcc(p, "avih");
+  p = le32(p, 56);
+  p = le32(p, us);                          /* dwMicroSecPerFrame */
+  p = le32(p, (uint32_t)(m->max_bytes * m->fps));
+  p = le32(p, 0);                           /* dwPaddingGranularity */
+  p = le32(p, AVIF_HASINDEX);
+  p = le32(p, m->frames);                   /* dwTotalFrames */
+  p = le32(p, 0);                           /* dwInitialFrames */
+  p = le32(p, 1);                           /* dwStreams */
+  p = le32(p, m->max_bytes + 8);            /* dwSuggestedBufferSize */
+  p = le32(p, (uint32_t)m->w);
+  p = le32(p, (uint32_t)m->h);
+  memset(p, 0, 16);                         /* dwReserved */
+  p += 16;
+
+  p = fourcc(p, "LIST");
+  p = le32(p, 116);
+  p = fourcc(p, "strl");
+  p = fourcc(p, "strh");
+  p = le32(p, 56);
+  p = fourcc(p, "vids");
+  p = fourcc(p, "MJPG");
+  p = le32(p, 0);                           /* dwFlags */
+  p = le16(p, 0);                           /* wPriority */
+  p = le16(p, 0);                           /* wLanguage */
+  p = le32(p, 0);                           /* dwInitialFrames */
+  p = le32(p, 1000);                        /* dwScale */
+  p = le32(p, rate);                        /* dwRate: fps = rate / scale */
+  p = le32(p, 0);                           /* dwStart */
+  p = le32(p, m->frames);                   /* dwLength */
+  p = le32(p, m->max_bytes + 8);
+  p = le32(p, 0xFFFFFFFFu);                 /* dwQuality: default */
+  p = le32(p, 0);                           /* dwSampleSize */
+  p = le16(p, 0);                           /* rcFrame */
+  p = le16(p, 0);
+  p = le16(p, (unsigned)m->w);
+  p = le16(p, (unsigned)m->h);
+
+  p = fourcc(p, "strf");
+  p = le32(p, 40);
+  p = le32(p, 40);                          /* biSize */
+  p = le32(p, (uint32_t)m->w);
+  p = le32(p, (uint32_t)m->h);
+  p = le16(p, 1);                           /* biPlanes */
+  p = le16(p, 24);                          /* biBitCount */
+  p = fourcc(p, "MJPG");
+  p = le32(p, image);                       /* biSizeImage */
+  memset(p, 0, 16);                         /* resolution, palette */
+  p += 16;
+
+  p = fourcc(p, "LIST");
+  p = le32(p, (uint32_t)(m->pos - AVI_MOVI_AT));
+  p = fourcc(p, "movi");
+}
+
+tc001_status tc001_mjpeg_open_avi(tc001_mjpeg** out, const char* path,
+                                  int width, int height, double fps) {
+  if (!out || !path || width <= 0 || height <= 0 || width > 65535 || height > 65535 ||
+      !(fps > 0.0))
+    return TC001_ERR_PARAM;
+  tc001_mjpeg* m = (tc001_mjpeg*)calloc(1, sizeof(*m));
+  if (!m) return TC001_ERR_ALLOC;
+  m->kind = KIND_AVI;
+  m->w = width;
+  m->h = height;
+  m->fps = fps;
+  m->pos = AVI_HDR_BYTES;
+  m->fd = tc001__file_open(path, 1);
+  uint8_t hdr[AVI_HDR_BYTES];
+  avi_header(m, hdr);
+  if (m->fd < 0 || tc001__file_pwrite(m->fd, hdr, sizeof(hdr), 0) != 0) {
+    if (m->fd >= 0) tc001__file_close(m->fd);
+    free(m);
+    return TC001_ERR_IO;
+  }
+  *out = m;
+  return TC001_OK;
+}
+
+static tc001_status avi_write(tc001_mjpeg* m, const void* jpeg, size_t n) {
+  if (n > 0x7FFFFFF0u || m->pos + 8 + n + 1 > 0xFFFFFF00ull) return TC001_ERR_PARAM;
+  if (grow((void**)&m->idx, &m->idx_cap, m->idx_len + 16, 1) != 0) return TC001_ERR_ALLOC;
+
+  uint8_t ck[8];
+  static const uint8_t pad = 0;
+  fourcc(ck, "00dc");
+  le32(ck + 4, (uint32_t)n);
+  tc001_iovec v[3] = { { ck, 8 }, { jpeg, n }, { &pad, n & 1 } };
+  if (tc001__file_pwritev(m->fd, v, (n & 1) ? 3 : 2, m->pos) != 0) return TC001_ERR_IO;
+
+  uint8_t* e = m->idx + m->idx_len;
+  e = fourcc(e, "00dc");
+  e = le32(e, AVIIF_KEYFRAME);
+  e = le32(e, (uint32_t)(m->pos - AVI_MOVI_AT));
+  le32(e, (uint32_t)n);
+  m->idx_len += 16;
+  m->pos += 8 + n + (n & 1);
+  m->frames++;
+  if (n > m->max_bytes) m->max_bytes = (uint32_t)n;
+  return TC001_OK;
+}
+
+static tc001_status avi_close(tc001_mjpeg* m) {
+  uint8_t ck[8], hdr[AVI_HDR_BYTES];
+  fourcc(ck, "idx1");
+  le32(ck + 4, (uint32_t)m->idx_len);
+  tc001_iovec v[2] = { { ck, 8 }, { m->idx, m->idx_len } };
+  avi_header(m, hdr);
+  if (tc001__file_pwritev(m->fd, v, 2, m->pos) != 0 ||
+      tc001__file_pwrite(m->fd, hdr, sizeof(hdr), 0) != 0 ||
+      tc001__file_truncate(m->fd, m->pos + 8 + m->idx_len) != 0)
+    return TC001_ERR_IO;
+  return TC001_OK;
+}
+
+/* ===== Multipart ===== */
+size_t tc001_mjpeg_part_header(char* dst, size_t cap, size_t jpeg_bytes) {
+  if (!dst) return 0;
+  int n = snprintf(dst, cap,
+                   "--" TC001_MJPEG_BOUNDARY "\r\n"
+                   "Content-Type: image/jpeg\r\n"
+                   "Content-Length: %zu\r\n\r\n", jpeg_bytes);
+  return n > 0 && (size_t)n < cap ? (size_t)n : 0;
+}
+
+tc001_status tc001_mjpeg_open_multipart(tc001_mjpeg** out, tc001_write_fn write, void* user) {
+  if (!out || !write) return TC001_ERR_PARAM;
+  tc001_mjpeg* m = (tc001_mjpeg*)calloc(1, sizeof(*m));
+  if (!m) return TC001_ERR_ALLOC;
+  m->kind = KIND_MULTIPART;
+  m->fd = -1;
+  m->write = write;
+  m->user = user;
+  *out = m;
+  return TC001_OK;
+}
+
+static tc001_status part_write(tc001_mjpeg* m, const void* jpeg, size_t n) {
+  char hdr[128];
+  size_t hn = tc001_mjpeg_part_header(hdr, sizeof(hdr), n);
+  if (m->write(hdr, hn, m->user) != 0 || m->write(jpeg, n, m->user) != 0 ||
+      m->write("\r\n", 2, m->user) != 0)
+    return TC001_ERR_IO;
+  m->frames++;
+  return TC001_OK;
+}
+
+/* ===== Common ===== */
+tc001_status tc001_mjpeg_write(tc001_mjpeg* m, const void* jpeg, size_t n) {
+  if (!m || !jpeg || !n) return TC001_ERR_PARAM;
+  if (m->error != TC001_OK) return m->error;
+  tc001_status st = m->kind == KIND_AVI ? avi_write(m, jpeg, n) : part_write(m, jpeg, n);
+  if (st == TC001_ERR_IO) m->error = st;
+  return st;
+}
+
+tc001_status tc001_mjpeg_close(tc001_mjpeg* m) {
+  if (!m) return TC001_ERR_PARAM;
+  tc001_status st = m->error;
+  if (m->kind == KIND_AVI) {
+    if (st == TC001_OK) st = avi_close(m);
+    tc001__file_close(m->fd);
+  } else if (st == TC001_OK) {
+    static const char end[] = "--" TC001_MJPEG_BOUNDARY "--\r\n";
+    if (m->write(end, sizeof(end) - 1, m->user) != 0) st = TC001_ERR_IO;
+  }
+  free(m->idx);
+  free(m);
+  return st;
+}
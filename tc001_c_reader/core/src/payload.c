@@ -0,0 +1,241 @@
+#include "tc001_internal.h"
+#include <string.h>
+
+_Static_assert(sizeof(tc001_frame_info) == 24, "tc001_frame_info layout");
+_Static_assert(sizeof(tc001_frame_stats) == 1040, "tc001_frame_stats layout");
+_Static_assert(sizeof(tc001_temp_model) == 24, "tc001_temp_model layout");
+_Static_assert(sizeof(tc001_calibration) == 184, "tc001_calibration layout");
+_Static_assert(offsetof(tc001_payload_hdr, info) == 32, "payload info offset");
+_Static_assert(offsetof(tc001_payload_hdr, calib) % 8 == 0, "payload calib alignment");
+
+/* ===== Layout ===== */
+#define ALIGN_UP(n) (((n) + (TC001_PAYLOAD_ALIGN - 1)) & ~(size_t)(TC001_PAYLOAD_ALIGN - 1))
+
+typedef struct {
+  size_t off_raw, off_thumb, total;
+  int tw, th;
+} layout;
+
+static int payload_layout(int w, int h, int tw, int th, layout* l) {
+  if (w <= 0 || h <= 0) return 0;
+  if (tw <= 0 || th <= 0) tw = th = 0;
+  l->tw = tw > w ? w : tw;
+  l->th = th > h ? h : th;
+  l->off_raw = ALIGN_UP(sizeof(tc001_payload_hdr));
+  size_t end = l->off_raw + (size_t)w * (size_t)h * 2;
+  l->off_thumb = l->tw ? ALIGN_UP(end) : 0;
+  if (l->tw) end = l->off_thumb + (size_t)l->tw * (size_t)l->th;
+  l->total = ALIGN_UP(end);
+  return l->total <= UINT32_MAX;   /* offsets in the header are 32-bit */
+}
+
+size_t tc001_max_payload_bytes(int w, int h, int thumb_w, int thumb_h) {
+  layout l;
+  return payload_layout(w, h, thumb_w, thumb_h, &l) ? l.total : 0;
+}
+
+void tc001__calibration_identity(tc001_calibration* c) {
+  static const float I3[9]  = { 1,0,0, 0,1,0, 0,0,1 };
+  static const float I4[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+  memset(c, 0, sizeof(*c));
+  memcpy(c->K_therm.m, I3, sizeof(I3));
+  memcpy(c->K_rgb.m, I3, sizeof(I3));
+  memcpy(c->T_therm_rgb.m, I4, sizeof(I4));
+}
+
+/* ===== Packing ===== */
+size_t tc001_pack_frame(const tc001_frame* f,
+                        const tc001_calibration* calib,
+                        const tc001_temp_model* temp,
+                        void* dst, size_t dst_cap,
+                        int thumb_w, int thumb_h,
+                        int use_agc)
+{
+  if (!f || !f->data || !dst || f->format != TC001_FMT_U16) return 0;
+  if (f->width <= 0 || f->height <= 0 || f->stride < f->width * 2) return 0;
+
+  const int w = f->width, h = f->height;
+  layout l;
+  if (!payload_layout(w, h, thumb_w, thumb_h, &l) || dst_cap < l.total) return 0;
+
+  tc001_stats_scratch* s = tc001__stats_tls_scratch();
+  if (!s) return 0;
+
+  /* The header is assembled on the stack: dst carries no alignment
+     guarantee and the header is written once at the end. */
+  tc001_payload_hdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  uint8_t* out = (uint8_t*)dst;
+  hdr.magic        = TC001_PAYLOAD_MAGIC;
+  hdr.version      = TC001_PAYLOAD_VERSION;
+  hdr.hdr_bytes    = (uint16_t)sizeof(tc001_payload_hdr);
+  hdr.total_bytes  = (uint32_t)l.total;
+  hdr.off_raw_u16  = (uint32_t)l.off_raw;
+  hdr.off_thumb_u8 = (uint32_t)l.off_thumb;
+
+  /* Single read of the frame: raw copy, histogram, min/max, downscale */
+  tc001_scan_opts opts = { out + l.off_raw, l.tw, l.th };
+  uint16_t lo, hi;
+  if (tc001__stats_scan(s, f->data, w, h, f->stride, &opts, &lo, &hi) != TC001_OK) return 0;
+  tc001__stats_finish(s, (uint32_t)w * (uint32_t)h, lo, hi, &hdr.stats);
+
+  if (l.tw) {
+    hdr.thumb.w = (uint16_t)l.tw;
+    hdr.thumb.h = (uint16_t)l.th;
+    hdr.thumb.pitch = (uint16_t)l.tw;
+    tc001__thumb_finish(&s->thumb, lo, hi, use_agc, out + l.off_thumb, l.tw);
+  }
+
+  hdr.info.ts_ns        = (uint64_t)f->timestamp_ns;
+  hdr.info.frame_id     = f->frame_id;
+  hdr.info.width        = (uint16_t)w;
+  hdr.info.height       = (uint16_t)h;
+  hdr.info.stride_bytes = (uint16_t)(w * 2);
+  hdr.info.pixel_format = 0;   /* U16_LE */
+
+  if (temp) hdr.temp = *temp;
+  if (calib) hdr.calib = *calib;
+  else tc001__calibration_identity(&hdr.calib);
+
+  /* zero the alignment gaps so identical frames give identical bytes */
+  size_t raw_end  = l.off_raw + (size_t)w * h * 2;
+  size_t blob_end = l.tw ? l.off_thumb + (size_t)l.tw * l.th : raw_end;
+  memset(out + sizeof(hdr), 0, l.off_raw - sizeof(hdr));
+  if (l.tw) memset(out + raw_end, 0, l.off_thumb - raw_end);
+  memset(out + blob_end, 0, l.total - blob_end);
+
+  memcpy(out, &hdr, sizeof(hdr));
+  return l.total;
+}
+
+/* ===== Reading ===== */
+/* The v1 layout: the same fields under #pragma pack(1), no magic, and the
+   tc001_thumbnail8 header stored in front of its pixels. */
+#pragma pack(push, 1)
+typedef struct {
+  uint64_t ts_ns;
+  uint32_t frame_id;
+  uint16_t width, height, stride_bytes;
+  uint8_t  pixel_format, _pad0[3];
+} v1_info;
+
+typedef struct {
+  uint16_t raw_min, raw_max, p10_raw, median_raw, p90_raw;
+  uint32_t bad_pixel_count;
+  uint32_t hist256[256];
+} v1_stats;
+
+typedef struct {
+  uint8_t  has_temp;
+  float    emissivity, ambient_C, gain_K_per_raw, offset_K;
+  uint32_t model_id;
+} v1_temp;
+
+typedef struct {
+  uint64_t calib_hash;
+  float    K_therm[9], K_rgb[9], T_therm_rgb[16], H_therm_to_rgb[9];
+} v1_calib;
+
+typedef struct {
+  v1_info  info;
+  v1_stats stats;
+  v1_temp  temp;
+  v1_calib calib;
+  uint32_t off_raw_u16, off_thumb_u8, total_bytes;
+} v1_hdr;
+#pragma pack(pop)
+
+static tc001_status open_v1(const uint8_t* b, size_t len, tc001_payload_view* out) {
+  v1_hdr v;
+  if (len < sizeof(v)) return TC001_ERR_PARAM;
+  memcpy(&v, b, sizeof(v));
+
+  size_t raw_bytes = (size_t)v.info.height * v.info.stride_bytes;
+  if (v.total_bytes > len || v.off_raw_u16 < sizeof(v) ||
+      v.info.stride_bytes < (size_t)v.info.width * 2 ||
+      (size_t)v.off_raw_u16 + raw_bytes > v.total_bytes)
+    return TC001_ERR_PARAM;
+
+  tc001_payload_hdr* u = &out->upgraded;
+  memset(u, 0, sizeof(*u));
+  u->version     = 1;
+  u->hdr_bytes   = (uint16_t)sizeof(v);
+  u->total_bytes = v.total_bytes;
+  u->off_raw_u16 = v.off_raw_u16;
+
+  u->info.ts_ns        = v.info.ts_ns;
+  u->info.frame_id     = v.info.frame_id;
+  u->info.width        = v.info.width;
+  u->info.height       = v.info.height;
+  u->info.stride_bytes = v.info.stride_bytes;
+  u->info.pixel_format = v.info.pixel_format;
+
+  u->stats.raw_min         = v.stats.raw_min;
+  u->stats.raw_max         = v.stats.raw_max;
+  u->stats.p10_raw         = v.stats.p10_raw;
+  u->stats.median_raw      = v.stats.median_raw;
+  u->stats.p90_raw         = v.stats.p90_raw;
+  u->stats.bad_pixel_count = v.stats.bad_pixel_count;
+  memcpy(u->stats.hist256, v.stats.hist256, sizeof(u->stats.hist256));
+
+  u->temp.has_temp       = v.temp.has_temp;
+  u->temp.emissivity     = v.temp.emissivity;
+  u->temp.ambient_C      = v.temp.ambient_C;
+  u->temp.gain_K_per_raw = v.temp.gain_K_per_raw;
+  u->temp.offset_K       = v.temp.offset_K;
+  u->temp.model_id       = v.temp.model_id;
+
+  u->calib.calib_hash = v.calib.calib_hash;
+  memcpy(u->calib.K_therm.m, v.calib.K_therm, sizeof(v.calib.K_therm));
+  memcpy(u->calib.K_rgb.m, v.calib.K_rgb, sizeof(v.calib.K_rgb));
+  memcpy(u->calib.T_therm_rgb.m, v.calib.T_therm_rgb, sizeof(v.calib.T_therm_rgb));
+  memcpy(u->calib.H_therm_to_rgb, v.calib.H_therm_to_rgb, sizeof(v.calib.H_therm_to_rgb));
+
+  out->thumb_u8 = NULL;
+  if (v.off_thumb_u8) {
+    tc001_thumbnail8 t;
+    if ((size_t)v.off_thumb_u8 + sizeof(t) > v.total_bytes) return TC001_ERR_PARAM;
+    memcpy(&t, b + v.off_thumb_u8, sizeof(t));
+    if (t.pitch < t.w ||
+        (size_t)v.off_thumb_u8 + sizeof(t) + (size_t)t.pitch * t.h > v.total_bytes)
+      return TC001_ERR_PARAM;
+    u->thumb = t;
+    u->off_thumb_u8 = v.off_thumb_u8 + (uint32_t)sizeof(t);
+    out->thumb_u8 = b + u->off_thumb_u8;
+  }
+
+  out->version = 1;
+  out->hdr = u;
+  out->raw_u16 = b + v.off_raw_u16;
+  return TC001_OK;
+}
+
+tc001_status tc001_payload_open(const void* buf, size_t len, tc001_payload_view* out) {
+  if (!buf || !out) return TC001_ERR_PARAM;
+  const uint8_t* b = (const uint8_t*)buf;
+
+  uint32_t magic = 0;
+  if (len >= sizeof(magic)) memcpy(&magic, b, sizeof(magic));
+  if (magic != TC001_PAYLOAD_MAGIC) return open_v1(b, len, out);
+
+  /* v2 is read in place, which needs the header's natural alignment */
+  if (((uintptr_t)b & 7) != 0 || len < sizeof(tc001_payload_hdr)) return TC001_ERR_PARAM;
+  const tc001_payload_hdr* hd = (const tc001_payload_hdr*)b;
+  if (hd->version < 2 || hd->hdr_bytes < sizeof(tc001_payload_hdr)) return TC001_ERR_PARAM;
+
+  size_t raw_bytes = (size_t)hd->info.height * hd->info.stride_bytes;
+  if (hd->total_bytes > len || hd->off_raw_u16 < hd->hdr_bytes ||
+      hd->info.stride_bytes < (size_t)hd->info.width * 2 ||
+      (size_t)hd->off_raw_u16 + raw_bytes > hd->total_bytes)
+    return TC001_ERR_PARAM;
+  if (hd->off_thumb_u8 &&
+      (hd->thumb.pitch < hd->thumb.w ||
+       (size_t)hd->off_thumb_u8 + (size_t)hd->thumb.pitch * hd->thumb.h > hd->total_bytes))
+    return TC001_ERR_PARAM;
+
+  out->version  = hd->version;
+  out->hdr      = hd;
+  out->raw_u16  = b + hd->off_raw_u16;
+  out->thumb_u8 = hd->off_thumb_u8 ? b + hd->off_thumb_u8 : NULL;
+  return TC001_OK;
+}
@@ -1,4 +1,8 @@
+#define _GNU_SOURCE       /* O_DIRECT */
+#include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -9,3 +13,255 @@ static int tc001_thread_create(tc001_thread_t* t, void*(*fn)(void*), void* arg)
 }
 static void tc001_thread_join(tc001_thread_t t) { pthread_join(t, NULL); }
 static void tc001_sleep_ms(int ms) { usleep(ms * 1000); }
+
+#include "tc001_internal.h"
+
+int64_t tc001__now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t tc001__wall_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void tc001__sleep_ns(int64_t ns) {
+  if (ns <= 0) return;
+  struct timespec ts = { (time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL) };
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+void* tc001__aligned_alloc(size_t size, size_t align) {
+  void* p = NULL;
+  return posix_memalign(&p, align, size ? size : align) == 0 ? p : NULL;
+}
+
+void tc001__aligned_free(void* p) { free(p); }
+
+/* ===== Files ===== */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+int tc001__file_open(const char* path, int create) {
+  return open(path, O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0), 0644);
+}
+
+int tc001__file_pwrite(int fd, const void* buf, size_t n, uint64_t off) {
+  const uint8_t* p = (const uint8_t*)buf;
+  while (n) {
+    ssize_t r = pwrite(fd, p, n, (off_t)off);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += r; n -= (size_t)r; off += (uint64_t)r;
+  }
+  return 0;
+}
+
+int tc001__file_pwritev(int fd, const tc001_iovec* v, int n, uint64_t off) {
+#if defined(__ANDROID__) && __ANDROID_API__ < 24
+  for (int i = 0; i < n; off += v[i].len, ++i)
+    if (tc001__file_pwrite(fd, v[i].base, v[i].len, off) != 0) return -1;
+  return 0;
+#else
+  int i = 0;
+  size_t skip = 0;          /* bytes of v[i] already written */
+  while (i < n) {
+    struct iovec iov[64];
+    int m = 0;
+    for (int j = i; j < n && m < 64; ++j, ++m) {
+      iov[m].iov_base = (uint8_t*)v[j].base + (j == i ? skip : 0);
+      iov[m].iov_len = v[j].len - (j == i ? skip : 0);
+    }
+    ssize_t r = pwritev(fd, iov, m, (off_t)off);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    if (r == 0) return -1;
+    off += (uint64_t)r;
+    size_t left = (size_t)r;
+    while (i < n && left >= v[i].len - skip) { left -= v[i].len - skip; skip = 0; ++i; }
+    skip += left;
+  }
+  return 0;
+#endif
+}
+
+int tc001__file_open_direct(const char* path) {
+#if defined(O_DIRECT)
+  return open(path, O_WRONLY | O_CLOEXEC | O_DIRECT);
+#elif defined(__APPLE__)
+  int fd = open(path, O_WRONLY | O_CLOEXEC);
+  if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) != 0) { close(fd); fd = -1; }
+  return fd;
+#else
+  (void)path;
+  return -1;
+#endif
+}
+
+int tc001__file_sync(int fd) {
+#if defined(__APPLE__)
+  return fsync(fd);
+#else
+  return fdatasync(fd);
+#endif
+}
+
+int tc001__file_truncate(int fd, uint64_t size) { return ftruncate(fd, (off_t)size); }
+
+void tc001__file_close(int fd) { close(fd); }
+
+int tc001__map_file(const char* path, tc001_mapping* m) {
+  memset(m, 0, sizeof(*m));
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return -1; }
+  void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);                /* the mapping keeps the file referenced */
+  if (p == MAP_FAILED) return -1;
+  m->data = (const uint8_t*)p;
+  m->size = (uint64_t)st.st_size;
+  return 0;
+}
+
+void tc001__unmap_file(tc001_mapping* m) {
+  if (m->data) munmap((void*)m->data, (size_t)m->size);
+  memset(m, 0, sizeof(*m));
+}
+
+/* ===== Shared memory ===== */
+#include <signal.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+/* An anonymous segment without memfd: a private shm name, unlinked at once. */
+static int anon_shm(void) {
+#ifdef __ANDROID__
+  return -1;                /* no shm_open in bionic */
+#else
+  static tc001_atomic_int counter;
+  for (int tries = 0; tries < 16; ++tries) {
+    char name[64];
+    int n = TC001_ATOMIC_LOAD(&counter);
+    TC001_ATOMIC_STORE(&counter, n + 1);
+    snprintf(name, sizeof name, "/tc001-%d-%d-%d", (int)getpid(), n, tries);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+      shm_unlink(name);
+      return fd;
+    }
+    if (errno != EEXIST) return -1;
+  }
+  return -1;
+#endif
+}
+
+static int shm_map_fd(int fd, size_t size, tc001_shm_map* m) {
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) { close(fd); return -1; }
+  m->base = (uint8_t*)p;
+  m->size = size;
+  m->fd = fd;
+  return 0;
+}
+
+int tc001__shm_create(const char* name, size_t size, tc001_shm_map* m) {
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+  int fd = -1;
+  if (name) {
+#ifndef __ANDROID__
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+#endif
+  } else {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    fd = (int)syscall(SYS_memfd_create, "tc001", 1u /* MFD_CLOEXEC */);
+#endif
+    if (fd < 0) fd = anon_shm();
+  }
+  if (fd < 0) return -1;
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+#ifndef __ANDROID__
+    if (name) shm_unlink(name);
+#endif
+    return -1;
+  }
+  return shm_map_fd(fd, size, m);
+}
+
+int tc001__shm_open(const char* name, int fd, tc001_shm_map* m) {
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+#ifdef __ANDROID__
+  fd = name ? -1 : fcntl(fd, F_DUPFD_CLOEXEC, 0);
+#else
+  fd = name ? shm_open(name, O_RDWR, 0) : fcntl(fd, F_DUPFD_CLOEXEC, 0);
+#endif
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return -1; }
+  return shm_map_fd(fd, (size_t)st.st_size, m);
+}
+
+void tc001__shm_close(tc001_shm_map* m) {
+  if (m->base) munmap(m->base, m->size);
+  if (m->fd >= 0) close(m->fd);
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+}
+
+void tc001__shm_unlink(const char* name) {
+#ifndef __ANDROID__
+  if (name) shm_unlink(name);
+#endif
+}
+
+int tc001__pid(void) { return (int)getpid(); }
+
+int tc001__pid_alive(int pid) {
+  return pid > 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+
+/* ===== Huge pages ===== */
+/* 2 MiB, the default on x86-64 and on arm64 with 4 KiB pages */
+#define HUGE_PAGE ((size_t)2 << 20)
+
+static size_t huge_round(size_t size) { return (size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1); }
+
+void* tc001__huge_alloc(size_t size) {
+#if defined(MAP_HUGETLB) && defined(MADV_HUGEPAGE)
+  const size_t len = huge_round(size ? size : 1);
+  /* reserved pages (vm.nr_hugepages) first */
+  void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) return p;
+  /* then transparent huge pages, which need a range aligned to one */
+  uint8_t* q = (uint8_t*)mmap(NULL, len + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (q == MAP_FAILED) return NULL;
+  const size_t lead = (HUGE_PAGE - ((uintptr_t)q & (HUGE_PAGE - 1))) & (HUGE_PAGE - 1);
+  if (lead) munmap(q, lead);
+  munmap(q + lead + len, HUGE_PAGE - lead);
+  madvise(q + lead, len, MADV_HUGEPAGE);
+  return q + lead;
+#else
+  (void)size;
+  return NULL;
+#endif
+}
+
+void tc001__huge_free(void* p, size_t size) {
+  if (p) munmap(p, huge_round(size ? size : 1));
+}
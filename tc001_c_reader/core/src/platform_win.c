@@ -0,0 +1,184 @@
+#include <windows.h>
+#include <malloc.h>
+#include <stdio.h>
+#include "tc001_internal.h"
+
+int64_t tc001__now_ns(void) {
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER now;
+  if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  /* split to avoid overflowing counts * 1e9 */
+  int64_t s = now.QuadPart / freq.QuadPart;
+  int64_t r = now.QuadPart % freq.QuadPart;
+  return s * 1000000000LL + r * 1000000000LL / freq.QuadPart;
+}
+
+int64_t tc001__wall_ns(void) {
+  FILETIME ft;
+  GetSystemTimeAsFileTime(&ft);
+  /* 100 ns ticks since 1601 */
+  int64_t t = ((int64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+  return (t - 116444736000000000LL) * 100;
+}
+
+void tc001__sleep_ns(int64_t ns) {
+  /* Sleep() has millisecond granularity; round up so callers never wake early */
+  if (ns > 0) Sleep((DWORD)((ns + 999999) / 1000000));
+}
+
+void* tc001__aligned_alloc(size_t size, size_t align) {
+  return _aligned_malloc(size ? size : align, align);
+}
+
+void tc001__aligned_free(void* p) { _aligned_free(p); }
+
+/* ===== Files ===== */
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <string.h>
+#include <sys/stat.h>
+
+int tc001__file_open(const char* path, int create) {
+  int fd = -1;
+  _sopen_s(&fd, path, _O_RDWR | _O_BINARY | _O_NOINHERIT | (create ? _O_CREAT | _O_TRUNC : 0),
+           _SH_DENYWR, _S_IREAD | _S_IWRITE);
+  return fd;
+}
+
+int tc001__file_pwrite(int fd, const void* buf, size_t n, uint64_t off) {
+  /* OVERLAPPED carries the offset, so concurrent writers do not share a
+     file pointer */
+  HANDLE fh = (HANDLE)_get_osfhandle(fd);
+  const uint8_t* p = (const uint8_t*)buf;
+  while (n) {
+    OVERLAPPED ov = {0};
+    ov.Offset = (DWORD)off;
+    ov.OffsetHigh = (DWORD)(off >> 32);
+    DWORD chunk = n > 0x40000000u ? 0x40000000u : (DWORD)n, done = 0;
+    if (!WriteFile(fh, p, chunk, &done, &ov) || done == 0) return -1;
+    p += done; n -= done; off += done;
+  }
+  return 0;
+}
+
+int tc001__file_pwritev(int fd, const tc001_iovec* v, int n, uint64_t off) {
+  for (int i = 0; i < n; off += v[i].len, ++i)
+    if (tc001__file_pwrite(fd, v[i].base, v[i].len, off) != 0) return -1;
+  return 0;
+}
+
+/* FILE_FLAG_NO_BUFFERING has no CRT descriptor form; writes stay buffered */
+int tc001__file_open_direct(const char* path) { (void)path; return -1; }
+
+int tc001__file_sync(int fd) { return _commit(fd); }
+
+int tc001__file_truncate(int fd, uint64_t size) { return _chsize_s(fd, (__int64)size) ? -1 : 0; }
+
+void tc001__file_close(int fd) { _close(fd); }
+
+int tc001__map_file(const char* path, tc001_mapping* m) {
+  memset(m, 0, sizeof(*m));
+  HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (f == INVALID_HANDLE_VALUE) return -1;
+  LARGE_INTEGER sz;
+  HANDLE map = NULL;
+  if (GetFileSizeEx(f, &sz) && sz.QuadPart > 0)
+    map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(f);           /* the mapping object keeps the file referenced */
+  if (!map) return -1;
+  void* p = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+  if (!p) { CloseHandle(map); return -1; }
+  m->data = (const uint8_t*)p;
+  m->size = (uint64_t)sz.QuadPart;
+  m->os = map;
+  return 0;
+}
+
+void tc001__unmap_file(tc001_mapping* m) {
+  if (m->data) UnmapViewOfFile(m->data);
+  if (m->os) CloseHandle((HANDLE)m->os);
+  memset(m, 0, sizeof(*m));
+}
+
+/* ===== Shared memory ===== */
+/* Segment names are session-local mapping names; a leading '/' (the POSIX
+   form) is dropped. */
+static int mapping_name(const char* name, char* out, size_t cap) {
+  if (*name == '/') ++name;
+  int n = snprintf(out, cap, "Local\\%s", name);
+  return n > 0 && (size_t)n < cap;
+}
+
+int tc001__shm_create(const char* name, size_t size, tc001_shm_map* m) {
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+  char full[260];
+  if (name && !mapping_name(name, full, sizeof full)) return -1;
+  HANDLE map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                  (DWORD)((uint64_t)size >> 32), (DWORD)size,
+                                  name ? full : NULL);
+  if (!map) return -1;
+  void* p = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (!p) { CloseHandle(map); return -1; }
+  m->base = (uint8_t*)p;
+  m->size = size;
+  m->os = map;
+  return 0;
+}
+
+int tc001__shm_open(const char* name, int fd, tc001_shm_map* m) {
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+  char full[260];
+  if (!name || !mapping_name(name, full, sizeof full)) return -1;   /* no descriptors */
+  HANDLE map = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, full);
+  if (!map) return -1;
+  void* p = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION mi;
+  if (!p || !VirtualQuery(p, &mi, sizeof mi)) {
+    if (p) UnmapViewOfFile(p);
+    CloseHandle(map);
+    return -1;
+  }
+  m->base = (uint8_t*)p;
+  m->size = mi.RegionSize;
+  m->os = map;
+  return 0;
+}
+
+void tc001__shm_close(tc001_shm_map* m) {
+  if (m->base) UnmapViewOfFile(m->base);
+  if (m->os) CloseHandle((HANDLE)m->os);
+  memset(m, 0, sizeof(*m));
+  m->fd = -1;
+}
+
+/* the mapping goes away with its last handle */
+void tc001__shm_unlink(const char* name) { (void)name; }
+
+int tc001__pid(void) { return (int)GetCurrentProcessId(); }
+
+int tc001__pid_alive(int pid) {
+  HANDLE p = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+  if (!p) return GetLastError() == ERROR_ACCESS_DENIED;
+  int alive = WaitForSingleObject(p, 0) == WAIT_TIMEOUT;
+  CloseHandle(p);
+  return alive;
+}
+
+/* ===== Huge pages ===== */
+/* Large pages need SeLockMemoryPrivilege; without it VirtualAlloc fails. */
+void* tc001__huge_alloc(size_t size) {
+  const SIZE_T page = GetLargePageMinimum();
+  if (!page) return NULL;
+  const SIZE_T len = ((size ? size : 1) + page - 1) / page * page;
+  return VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+void tc001__huge_free(void* p, size_t size) {
+  (void)size;
+  if (p) VirtualFree(p, 0, MEM_RELEASE);
+}
@@ -0,0 +1,167 @@
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Frame pool: refcounted buffers of one sensor frame each. The capture
+   thread assembles into a pooled buffer, holds one reference while
+   delivering it, and keeps assembling into the same buffer when nobody
+   retained the frame; otherwise it takes a free one (refs 0, claimed with
+   a CAS) or allocates another, up to the maximum. Any thread releases.
+   Frames that do not start in the assembly buffer (a replay reading a
+   recording in place) are copied into a free buffer. */
+
+struct tc001_frame_ref {
+  tc001_atomic_int  refs;
+  struct tc001_pool* pool;
+  tc001_frame       frame;  /* what tc001_frame_retain returns */
+  tc001_frame_stats stats;
+  uint8_t*          data;
+};
+
+struct tc001_pool {
+  struct tc001_frame_ref** bufs;    /* max entries, the first n allocated */
+  tc001_atomic_int n;
+  int      max;
+  size_t   bytes;
+  struct tc001_frame_ref* fill;     /* assembly buffer; NULL = the spare */
+  uint8_t* spare;                   /* the handle's own frame_buf */
+  int      huge;                    /* TC001_BACKING_HUGEPAGES */
+  tc001_atomic_int peak;
+  tc001_atomic_i64 retains, exhausted;
+};
+
+static void add(tc001_atomic_int* p, int d) {
+  int v;
+  do v = TC001_ATOMIC_LOAD(p);
+  while (!tc001__atomic_cas(p, v, v + d));
+}
+
+static int in_use(const struct tc001_pool* p) {
+  const int n = TC001_ATOMIC_LOAD((tc001_atomic_int*)&p->n);
+  int k = 0;
+  for (int i = 0; i < n; ++i) k += TC001_ATOMIC_LOAD(&p->bufs[i]->refs) > 0;
+  return k;
+}
+
+/* A free buffer with one reference, or NULL when all max are taken.
+   Capture thread only. */
+static struct tc001_frame_ref* acquire(struct tc001_pool* p) {
+  const int n = TC001_ATOMIC_LOAD(&p->n);
+  struct tc001_frame_ref* r = NULL;
+  for (int i = 0; i < n && !r; ++i)
+    if (tc001__atomic_cas(&p->bufs[i]->refs, 0, 1)) r = p->bufs[i];
+  if (!r && n < p->max && (r = (struct tc001_frame_ref*)calloc(1, sizeof(*r)))) {
+    if (!(r->data = (uint8_t*)tc001__buf_alloc(p->bytes, p->huge))) {
+      free(r);
+      return NULL;
+    }
+    r->pool = p;
+    TC001_ATOMIC_STORE(&r->refs, 1);
+    p->bufs[n] = r;
+    TC001_ATOMIC_STORE(&p->n, n + 1);
+  }
+  if (r) {
+    const int k = in_use(p);
+    if (k > TC001_ATOMIC_LOAD(&p->peak)) TC001_ATOMIC_STORE(&p->peak, k);
+  }
+  return r;
+}
+
+/* Points the handle's assembly at a pooled buffer, or at the spare when
+   the pool is exhausted. */
+static void refill(struct tc001_handle* h, struct tc001_pool* p) {
+  if (!p->spare) return;            /* nothing is assembled */
+  p->fill = acquire(p);
+  h->frame_buf = p->fill ? p->fill->data : p->spare;
+}
+
+struct tc001_frame_ref* tc001__pool_take(struct tc001_handle* h, const uint8_t** data) {
+  struct tc001_pool* p = h->pool;
+  if (p->fill && *data == p->fill->data) return p->fill;
+  struct tc001_frame_ref* r = acquire(p);
+  if (!r) {
+    TC001_ATOMIC_INC64(&p->exhausted);
+    return NULL;
+  }
+  memcpy(r->data, *data, (size_t)h->width * h->height * 2);
+  *data = r->data;
+  return r;
+}
+
+void tc001__pool_fill(struct tc001_frame_ref* r, tc001_frame* f) {
+  f->ref = r;
+  r->frame = *f;
+  r->frame.blobs = NULL;
+  r->frame.blob_count = 0;
+  if (f->stats) {
+    r->stats = *f->stats;
+    r->frame.stats = &r->stats;
+  }
+}
+
+void tc001__pool_done(struct tc001_handle* h, struct tc001_frame_ref* r) {
+  struct tc001_pool* p = h->pool;
+  if (r && r == p->fill && TC001_ATOMIC_LOAD(&r->refs) == 1) return;  /* not retained: reuse */
+  if (r) add(&r->refs, -1);
+  if (r == p->fill || !p->fill) refill(h, p);
+}
+
+void tc001__pool_free(struct tc001_handle* h) {
+  struct tc001_pool* p = h->pool;
+  if (!p) return;
+  if (p->fill && h->frame_buf == p->fill->data) h->frame_buf = p->spare;
+  const int n = TC001_ATOMIC_LOAD(&p->n);
+  for (int i = 0; i < n; ++i) {
+    tc001__buf_free(p->bufs[i]->data, p->bytes, p->huge);
+    free(p->bufs[i]);
+  }
+  free(p->bufs);
+  free(p);
+  h->pool = NULL;
+}
+
+tc001_status tc001_set_frame_pool(tc001_handle* h, int max_buffers) {
+  if (!h || max_buffers < 0) return TC001_ERR_PARAM;
+  if (TC001_ATOMIC_LOAD(&h->running)) return TC001_ERR_STATE;
+  if (h->pool && in_use(h->pool) > (h->pool->fill ? 1 : 0)) return TC001_ERR_STATE;
+  tc001__pool_free(h);
+  if (!max_buffers) return TC001_OK;
+
+  struct tc001_pool* p = (struct tc001_pool*)calloc(1, sizeof(*p));
+  if (!p || !(p->bufs = (struct tc001_frame_ref**)calloc((size_t)max_buffers, sizeof(*p->bufs)))) {
+    free(p);
+    return TC001_ERR_ALLOC;
+  }
+  p->max = max_buffers;
+  p->bytes = (size_t)h->src_w * h->src_h * 2;
+  p->spare = h->frame_buf;
+  p->huge = h->backing & TC001_BACKING_HUGEPAGES;
+  h->pool = p;
+  refill(h, p);
+  return TC001_OK;
+}
+
+const tc001_frame* tc001_frame_retain(const tc001_frame* f) {
+  if (!f || !f->ref) return NULL;
+  struct tc001_frame_ref* r = (struct tc001_frame_ref*)f->ref;
+  add(&r->refs, 1);
+  TC001_ATOMIC_INC64(&r->pool->retains);
+  return &r->frame;
+}
+
+void tc001_frame_release(const tc001_frame* f) {
+  if (f && f->ref) add(&((struct tc001_frame_ref*)f->ref)->refs, -1);
+}
+
+void tc001_get_pool_stats(tc001_handle* h, tc001_pool_stats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  struct tc001_pool* p = h ? h->pool : NULL;
+  if (!p) return;
+  out->buffers = TC001_ATOMIC_LOAD(&p->n);
+  out->max_buffers = p->max;
+  out->in_use = in_use(p);
+  out->peak_in_use = TC001_ATOMIC_LOAD(&p->peak);
+  out->retains = (uint64_t)TC001_ATOMIC_LOAD64(&p->retains);
+  out->exhausted = (uint64_t)TC001_ATOMIC_LOAD64(&p->exhausted);
+}
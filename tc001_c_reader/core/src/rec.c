@@ -0,0 +1,505 @@
+#include "tc001_rec.h"
+#include "tc001_codec.h"
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* File layout after the header (padded to data_offset):
+
+     chunk:  chunk_hdr (64 bytes), payload, zero padding to TC001_REC_ALIGN
+     ...
+     index:  index_entry[count], at an aligned offset
+     footer: rec_footer, the last bytes of the file
+
+   A chunk is accepted by a scan only when its header checksum, sequence
+   number, bounds and payload checksum all agree, so a torn write at the
+   tail is never mistaken for a frame. */
+
+#define CHUNK_MAGIC   0x46314354u   /* "TC1F" */
+#define FOOTER_MAGIC  0x45314354u   /* "TC1E" */
+#define CHUNK_KEY     1u
+#define DEFAULT_KEYINT 25
+
+typedef struct {
+  uint32_t magic;           /* CHUNK_MAGIC */
+  uint32_t bytes;           /* payload, without padding */
+  uint32_t seq;             /* chunk number, from 0 */
+  uint32_t frame_id;
+  int64_t  timestamp_ns;
+  uint32_t flags;           /* CHUNK_KEY: decodable on its own */
+  uint32_t crc;             /* of the payload */
+  uint32_t hdr_crc;         /* of the fields above */
+  uint8_t  _pad0[28];
+} chunk_hdr;
+
+typedef struct {
+  uint64_t offset;          /* of the chunk header */
+  int64_t  timestamp_ns;
+  uint32_t frame_id;
+  uint32_t bytes;
+  uint32_t flags;
+  uint32_t _pad0;
+} index_entry;
+
+typedef struct {
+  uint32_t magic;           /* FOOTER_MAGIC */
+  uint32_t count;
+  uint64_t index_offset;
+  uint32_t index_crc;
+  uint32_t _pad0[3];
+} rec_footer;
+
+typedef char chunk_hdr_is_64[sizeof(chunk_hdr) == 64 ? 1 : -1];
+typedef char index_entry_is_32[sizeof(index_entry) == 32 ? 1 : -1];
+
+static uint64_t align_up(uint64_t v) {
+  return (v + TC001_REC_ALIGN - 1) & ~(uint64_t)(TC001_REC_ALIGN - 1);
+}
+
+static int grow(void** p, size_t* cap, size_t n, size_t elem) {
+  if (n <= *cap) return 0;
+  size_t c = *cap ? *cap : 256;
+  while (c < n) c *= 2;
+  void* q = realloc(*p, c * elem);
+  if (!q) return -1;
+  *p = q;
+  *cap = c;
+  return 0;
+}
+
+/* ===== CRC-32 (IEEE, as zlib) ===== */
+/* Slicing by 8: one table lookup per byte, eight of them independent.
+   crc_tab[0] is the byte-at-a-time table (reflected 0xEDB88320) and
+   crc_tab[k][b] the CRC of byte b followed by k zero bytes. Built on first
+   use; a thread arriving mid-build waits for it. */
+static uint32_t crc_tab[8][256];
+static tc001_atomic_int crc_state;   /* 0 none, 1 building, 2 ready */
+
+static const uint32_t (*crc_tables(void))[256] {
+  if (TC001_ATOMIC_LOAD(&crc_state) == 2) return (const uint32_t (*)[256])crc_tab;
+  if (tc001__atomic_cas(&crc_state, 0, 1)) {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint32_t c = b;
+      for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+      crc_tab[0][b] = c;
+    }
+    for (int k = 1; k < 8; ++k)
+      for (int b = 0; b < 256; ++b)
+        crc_tab[k][b] = (crc_tab[k - 1][b] >> 8) ^ crc_tab[0][crc_tab[k - 1][b] & 0xFF];
+    TC001_ATOMIC_STORE(&crc_state, 2);
+  }
+  while (TC001_ATOMIC_LOAD(&crc_state) != 2) tc001__sleep_ns(1000);
+  return (const uint32_t (*)[256])crc_tab;
+}
+
+uint32_t tc001__crc32(uint32_t crc, const void* buf, size_t n) {
+  const uint8_t* p = (const uint8_t*)buf;
+  const uint32_t (*t)[256] = crc_tables();
+  crc = ~crc;
+  for (; n >= 8; n -= 8, p += 8) {
+    uint32_t a = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+    uint32_t b = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+    crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][a >> 24] ^
+          t[3][b & 0xFF] ^ t[2][(b >> 8) & 0xFF] ^ t[1][(b >> 16) & 0xFF] ^ t[0][b >> 24];
+  }
+  for (; n; --n) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  return ~crc;
+}
+
+static uint32_t chunk_hdr_crc(const chunk_hdr* c) {
+  return tc001__crc32(0, c, offsetof(chunk_hdr, hdr_crc));
+}
+
+static size_t frame_bytes(int w, int h, tc001_format fmt) {
+  return (size_t)w * h * (fmt == TC001_FMT_U16 ? 2 : 1);
+}
+
+static tc001_status write_index(int fd, uint64_t pos, const index_entry* e, uint32_t n) {
+  rec_footer ft;
+  memset(&ft, 0, sizeof(ft));
+  ft.magic = FOOTER_MAGIC;
+  ft.count = n;
+  ft.index_offset = pos;
+  ft.index_crc = tc001__crc32(0, e, (size_t)n * sizeof(*e));
+  const uint64_t end = pos + (uint64_t)n * sizeof(*e) + sizeof(ft);
+  if ((n && tc001__file_pwrite(fd, e, (size_t)n * sizeof(*e), pos) != 0) ||
+      tc001__file_pwrite(fd, &ft, sizeof(ft), pos + (uint64_t)n * sizeof(*e)) != 0 ||
+      tc001__file_truncate(fd, end) != 0 ||
+      tc001__file_sync(fd) != 0)
+    return TC001_ERR_IO;
+  return TC001_OK;
+}
+
+/* ===== Writer ===== */
+struct tc001_rec_writer {
+  int      fd;
+  uint64_t pos;             /* end of the last chunk */
+  tc001_rec_header hdr;
+  size_t   raw_bytes;       /* one frame, rows tightly packed */
+  uint8_t* buf;             /* staging: chunk header, payload, padding */
+  size_t   buf_cap;
+  tc001_codec* codec;
+  index_entry* idx;
+  size_t   idx_n, idx_cap;  /* chunks on disk */
+  uint32_t seq;             /* chunks formatted */
+  int      sync_every, since_sync;
+  tc001_status err;         /* sticky: a failed write ends the recording */
+};
+
+tc001_status tc001_rec_create(tc001_rec_writer** out, const char* path,
+                              int width, int height, tc001_format format,
+                              const tc001_rec_options* opts,
+                              const tc001_calibration* calib,
+                              const tc001_temp_model* temp)
+{
+  if (!out || !path || width <= 0 || height <= 0 || width > 65535 || height > 65535)
+    return TC001_ERR_PARAM;
+  *out = NULL;
+  tc001_rec_options o = { TC001_REC_RAW, 0, 0 };
+  if (opts) o = *opts;
+  if (o.codec != TC001_REC_RAW && o.codec != TC001_REC_LOSSLESS) return TC001_ERR_PARAM;
+  if (format != TC001_FMT_U8 && format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (o.codec == TC001_REC_LOSSLESS && format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (o.keyframe_interval <= 0) o.keyframe_interval = DEFAULT_KEYINT;
+  if (o.keyframe_interval > 65535 || o.sync_every < 0) return TC001_ERR_PARAM;
+
+  tc001_rec_writer* w = (tc001_rec_writer*)calloc(1, sizeof(*w));
+  if (!w) return TC001_ERR_ALLOC;
+  w->fd = -1;
+  w->raw_bytes = frame_bytes(width, height, format);
+  w->sync_every = o.sync_every;
+
+  tc001_rec_header* hd = &w->hdr;
+  hd->magic = TC001_REC_MAGIC;
+  hd->version = TC001_REC_VERSION;
+  hd->hdr_bytes = (uint16_t)sizeof(*hd);
+  hd->width = (uint16_t)width;
+  hd->height = (uint16_t)height;
+  hd->format = (uint8_t)format;
+  hd->codec = (uint8_t)o.codec;
+  hd->keyframe_interval = (uint16_t)(o.codec == TC001_REC_LOSSLESS ? o.keyframe_interval : 1);
+  hd->created_ns = tc001__wall_ns();
+  /* a whole page, so chunks can also be written with O_DIRECT */
+  hd->data_offset = TC001_DIRECT_ALIGN;
+  if (temp) hd->temp = *temp;
+  if (calib) hd->calib = *calib;
+  else tc001__calibration_identity(&hd->calib);
+
+  size_t payload_cap = w->raw_bytes;
+  if (o.codec == TC001_REC_LOSSLESS) {
+    payload_cap = tc001_codec_max_bytes(width, height);
+    tc001_status st = tc001_codec_create(&w->codec, width, height);
+    if (st != TC001_OK) { tc001_rec_finish(w); return st; }
+  }
+  w->buf_cap = (size_t)align_up(sizeof(chunk_hdr) + payload_cap);
+  w->buf = (uint8_t*)calloc(1, w->buf_cap > hd->data_offset ? w->buf_cap : hd->data_offset);
+  if (!w->buf) { tc001_rec_finish(w); return TC001_ERR_ALLOC; }
+
+  w->fd = tc001__file_open(path, 1);
+  if (w->fd < 0) { tc001_rec_finish(w); return TC001_ERR_IO; }
+  memcpy(w->buf, hd, sizeof(*hd));
+  if (tc001__file_pwrite(w->fd, w->buf, hd->data_offset, 0) != 0) {
+    tc001_rec_finish(w);
+    return TC001_ERR_IO;
+  }
+  w->pos = hd->data_offset;
+  *out = w;
+  return TC001_OK;
+}
+
+size_t tc001__rec_chunk_cap(const tc001_rec_writer* w) {
+  return w->buf_cap;
+}
+
+int tc001__rec_fd(const tc001_rec_writer* w) {
+  return w->fd;
+}
+
+uint64_t tc001__rec_pos(const tc001_rec_writer* w) {
+  return w->pos;
+}
+
+tc001_status tc001__rec_chunk(tc001_rec_writer* w, const tc001_frame* f,
+                              uint8_t* dst, size_t* total_out)
+{
+  if (f->width != w->hdr.width || f->height != w->hdr.height ||
+      (int)f->format != w->hdr.format) return TC001_ERR_PARAM;
+  const size_t row = w->raw_bytes / w->hdr.height;
+  if (f->stride < (int)row) return TC001_ERR_PARAM;
+
+  uint8_t* payload = dst + sizeof(chunk_hdr);
+  size_t bytes = w->raw_bytes;
+  uint32_t flags = CHUNK_KEY;
+  if (w->codec) {
+    const int key = w->seq % w->hdr.keyframe_interval == 0;
+    tc001_status st = tc001_encode_frame(w->codec, f, key, payload,
+                                         w->buf_cap - sizeof(chunk_hdr), &bytes);
+    if (st != TC001_OK) return st;
+    if (!key) flags = 0;
+  } else if (f->data != payload || f->stride != (int)row) {
+    for (int y = 0; y < f->height; ++y)
+      memmove(payload + (size_t)y * row, f->data + (size_t)y * f->stride, row);
+  }
+  const size_t total = (size_t)align_up(sizeof(chunk_hdr) + bytes);
+  memset(payload + bytes, 0, total - sizeof(chunk_hdr) - bytes);
+
+  chunk_hdr* ch = (chunk_hdr*)dst;
+  memset(ch, 0, sizeof(*ch));
+  ch->magic = CHUNK_MAGIC;
+  ch->bytes = (uint32_t)bytes;
+  ch->seq = w->seq++;
+  ch->frame_id = f->frame_id;
+  ch->timestamp_ns = f->timestamp_ns;
+  ch->flags = flags;
+  ch->crc = tc001__crc32(0, payload, bytes);
+  ch->hdr_crc = chunk_hdr_crc(ch);
+  *total_out = total;
+  return TC001_OK;
+}
+
+tc001_status tc001__rec_append(tc001_rec_writer* w, const uint8_t* chunk, size_t total) {
+  if (grow((void**)&w->idx, &w->idx_cap, w->idx_n + 1, sizeof(index_entry)) != 0)
+    return w->err = TC001_ERR_ALLOC;
+  chunk_hdr ch;
+  memcpy(&ch, chunk, sizeof(ch));
+  index_entry* e = &w->idx[w->idx_n++];
+  memset(e, 0, sizeof(*e));
+  e->offset = w->pos;
+  e->timestamp_ns = ch.timestamp_ns;
+  e->frame_id = ch.frame_id;
+  e->bytes = ch.bytes;
+  e->flags = ch.flags;
+  w->pos += total;
+
+  if (w->sync_every && ++w->since_sync >= w->sync_every) {
+    w->since_sync = 0;
+    if (tc001__file_sync(w->fd) != 0) w->err = TC001_ERR_IO;
+  }
+  return w->err;
+}
+
+void tc001__rec_fail(tc001_rec_writer* w, tc001_status st) {
+  if (w->err == TC001_OK) w->err = st;
+}
+
+tc001_status tc001_rec_write(tc001_rec_writer* w, const tc001_frame* f) {
+  if (!w || !f || !f->data) return TC001_ERR_PARAM;
+  if (w->err != TC001_OK) return w->err;
+  size_t total;
+  tc001_status st = tc001__rec_chunk(w, f, w->buf, &total);
+  if (st != TC001_OK) return st;
+  if (tc001__file_pwrite(w->fd, w->buf, total, w->pos) != 0) {
+    w->err = TC001_ERR_IO;
+    return w->err;
+  }
+  return tc001__rec_append(w, w->buf, total);
+}
+
+tc001_status tc001_rec_finish(tc001_rec_writer* w) {
+  if (!w) return TC001_ERR_PARAM;
+  tc001_status st = w->err;
+  if (w->fd >= 0) {
+    if (st == TC001_OK) st = write_index(w->fd, w->pos, w->idx, (uint32_t)w->idx_n);
+    tc001__file_close(w->fd);
+  }
+  tc001_codec_destroy(w->codec);
+  free(w->buf);
+  free(w->idx);
+  free(w);
+  return st;
+}
+
+/* ===== Reader ===== */
+struct tc001_rec_reader {
+  tc001_mapping map;
+  tc001_rec_header hdr;
+  const index_entry* idx;   /* in the mapping, or owned after a scan */
+  index_entry* owned;
+  uint32_t count;
+  uint64_t data_end;        /* end of the last intact chunk */
+  int      recovered;
+  tc001_codec* codec;
+  uint16_t* plane;          /* last decoded lossless frame */
+  uint32_t last;
+  int      have_last;
+};
+
+static int read_footer(const tc001_mapping* m, uint64_t data_offset, rec_footer* ft) {
+  if (m->size < data_offset + sizeof(*ft)) return 0;
+  memcpy(ft, m->data + m->size - sizeof(*ft), sizeof(*ft));
+  if (ft->magic != FOOTER_MAGIC || ft->index_offset < data_offset) return 0;
+  if (ft->index_offset + (uint64_t)ft->count * sizeof(index_entry) + sizeof(*ft) != m->size) return 0;
+  return tc001__crc32(0, m->data + ft->index_offset, (size_t)ft->count * sizeof(index_entry))
+         == ft->index_crc;
+}
+
+/* Walks the chunks from data_offset and indexes every intact one. */
+static tc001_status scan_chunks(tc001_rec_reader* r) {
+  const tc001_mapping* m = &r->map;
+  uint64_t pos = r->hdr.data_offset;
+  size_t cap = 0;
+  r->count = 0;
+  while (pos + sizeof(chunk_hdr) <= m->size) {
+    chunk_hdr ch;
+    memcpy(&ch, m->data + pos, sizeof(ch));
+    if (ch.magic != CHUNK_MAGIC || ch.seq != r->count || ch.hdr_crc != chunk_hdr_crc(&ch)) break;
+    if (pos + sizeof(ch) + ch.bytes > m->size) break;
+    if (tc001__crc32(0, m->data + pos + sizeof(ch), ch.bytes) != ch.crc) break;
+    if (grow((void**)&r->owned, &cap, (size_t)r->count + 1, sizeof(index_entry)) != 0)
+      return TC001_ERR_ALLOC;
+    index_entry* e = &r->owned[r->count++];
+    memset(e, 0, sizeof(*e));
+    e->offset = pos;
+    e->timestamp_ns = ch.timestamp_ns;
+    e->frame_id = ch.frame_id;
+    e->bytes = ch.bytes;
+    e->flags = ch.flags;
+    pos = align_up(pos + sizeof(ch) + ch.bytes);
+  }
+  r->idx = r->owned;
+  r->data_end = pos;
+  r->recovered = 1;
+  return TC001_OK;
+}
+
+tc001_status tc001_rec_open(tc001_rec_reader** out, const char* path) {
+  if (!out || !path) return TC001_ERR_PARAM;
+  *out = NULL;
+  tc001_rec_reader* r = (tc001_rec_reader*)calloc(1, sizeof(*r));
+  if (!r) return TC001_ERR_ALLOC;
+  if (tc001__map_file(path, &r->map) != 0) { free(r); return TC001_ERR_IO; }
+
+  tc001_status st = TC001_ERR_PARAM;
+  const tc001_mapping* m = &r->map;
+  tc001_rec_header* hd = &r->hdr;
+  if (m->size < 8) goto FAIL;
+  memcpy(hd, m->data, 8);
+  if (hd->magic != TC001_REC_MAGIC || hd->version != TC001_REC_VERSION ||
+      hd->hdr_bytes < offsetof(tc001_rec_header, calib) || m->size < hd->hdr_bytes) goto FAIL;
+  memcpy(hd, m->data, hd->hdr_bytes < sizeof(*hd) ? hd->hdr_bytes : sizeof(*hd));
+  if (!hd->width || !hd->height || hd->data_offset < hd->hdr_bytes ||
+      hd->data_offset % TC001_REC_ALIGN || hd->codec > TC001_REC_LOSSLESS ||
+      hd->format > TC001_FMT_U16 || (hd->codec == TC001_REC_LOSSLESS && hd->format != TC001_FMT_U16))
+    goto FAIL;
+
+  rec_footer ft;
+  if (read_footer(m, hd->data_offset, &ft)) {
+    r->idx = (const index_entry*)(m->data + ft.index_offset);
+    r->count = ft.count;
+    r->data_end = ft.index_offset;
+  } else if ((st = scan_chunks(r)) != TC001_OK) {
+    goto FAIL;
+  }
+
+  if (hd->codec == TC001_REC_LOSSLESS) {
+    r->plane = (uint16_t*)malloc((size_t)hd->width * hd->height * 2);
+    st = r->plane ? tc001_codec_create(&r->codec, hd->width, hd->height) : TC001_ERR_ALLOC;
+    if (st != TC001_OK) goto FAIL;
+  }
+  *out = r;
+  return TC001_OK;
+
+FAIL:
+  tc001_rec_close(r);
+  return st;
+}
+
+void tc001_rec_close(tc001_rec_reader* r) {
+  if (!r) return;
+  tc001__unmap_file(&r->map);
+  free(r->owned);
+  tc001_codec_destroy(r->codec);
+  free(r->plane);
+  free(r);
+}
+
+const tc001_rec_header* tc001_rec_info(const tc001_rec_reader* r) {
+  return r ? &r->hdr : NULL;
+}
+
+uint32_t tc001_rec_frame_count(const tc001_rec_reader* r) {
+  return r ? r->count : 0;
+}
+
+int tc001_rec_was_recovered(const tc001_rec_reader* r) {
+  return r ? r->recovered : 0;
+}
+
+static tc001_status decode_at(tc001_rec_reader* r, uint32_t i) {
+  const index_entry* e = &r->idx[i];
+  if (e->offset + sizeof(chunk_hdr) + e->bytes > r->data_end) return TC001_ERR_PARAM;
+  return tc001_decode_frame(r->codec, r->map.data + e->offset + sizeof(chunk_hdr), e->bytes,
+                            r->plane, r->hdr.width * 2);
+}
+
+tc001_status tc001_rec_read(tc001_rec_reader* r, uint32_t i, tc001_frame* f) {
+  if (!r || !f || i >= r->count) return TC001_ERR_PARAM;
+  const index_entry* e = &r->idx[i];
+  const int bpp = r->hdr.format == TC001_FMT_U16 ? 2 : 1;
+  memset(f, 0, sizeof(*f));
+  f->width = r->hdr.width;
+  f->height = r->hdr.height;
+  f->stride = r->hdr.width * bpp;
+  f->timestamp_ns = e->timestamp_ns;
+  f->format = (tc001_format)r->hdr.format;
+  f->frame_id = e->frame_id;
+
+  if (!r->codec) {
+    if (e->offset + sizeof(chunk_hdr) + e->bytes > r->data_end ||
+        e->bytes != frame_bytes(f->width, f->height, f->format)) return TC001_ERR_PARAM;
+    f->data = r->map.data + e->offset + sizeof(chunk_hdr);
+    return TC001_OK;
+  }
+
+  if (!(r->have_last && r->last == i)) {
+    tc001_status st;
+    if (r->have_last && r->last + 1 == i) {
+      st = decode_at(r, i);
+    } else {
+      uint32_t k = i;
+      while (k > 0 && !(r->idx[k].flags & CHUNK_KEY)) --k;
+      tc001_codec_reset(r->codec);
+      st = TC001_OK;
+      for (; k <= i && st == TC001_OK; ++k) st = decode_at(r, k);
+    }
+    r->have_last = st == TC001_OK;
+    r->last = i;
+    if (st != TC001_OK) return st;
+  }
+  f->data = (const uint8_t*)r->plane;
+  return TC001_OK;
+}
+
+uint32_t tc001_rec_find_time(const tc001_rec_reader* r, int64_t ts) {
+  if (!r || !r->count) return 0;
+  uint32_t lo = 0, hi = r->count;          /* first entry with timestamp > ts */
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (r->idx[mid].timestamp_ns <= ts) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo ? lo - 1 : 0;
+}
+
+/* ===== Recovery ===== */
+tc001_status tc001_rec_recover(const char* path, uint32_t* frames) {
+  tc001_rec_reader* r = NULL;
+  tc001_status st = tc001_rec_open(&r, path);
+  if (st != TC001_OK) return st;
+  if (frames) *frames = r->count;
+  if (r->recovered) {
+    /* the index outlives the mapping; the file is rewritten behind it */
+    uint64_t end = r->data_end;
+    uint32_t n = r->count;
+    index_entry* idx = r->owned;
+    r->owned = NULL;
+    tc001_rec_close(r);
+    int fd = tc001__file_open(path, 0);
+    st = fd < 0 ? TC001_ERR_IO : write_index(fd, end, idx, n);
+    if (fd >= 0) tc001__file_close(fd);
+    free(idx);
+    return st;
+  }
+  tc001_rec_close(r);
+  return TC001_OK;
+}
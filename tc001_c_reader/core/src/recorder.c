@@ -0,0 +1,329 @@
+#include "tc001_rec.h"
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Background recorder: a single-producer / single-consumer ring of slots,
+   each big enough for one formatted chunk. The producer copies a raw frame
+   straight to its payload position (or beside it for the lossless codec),
+   and the writer thread formats chunks in place and writes a whole batch
+   at the end of the file with one pwritev.
+
+   With direct I/O the batch is gathered into a page-aligned staging buffer
+   instead. The last partial page stays in the buffer and is written again,
+   completed, by the next batch. */
+
+#define DEFAULT_QUEUE  64
+#define DEFAULT_BATCH  16
+#define IDLE_NS        1000000LL    /* writer poll when the queue is empty */
+#define FULL_NS        100000LL     /* TC001_REC_BLOCK producer poll */
+#define PAYLOAD_AT     64           /* chunk header size, see rec.c */
+
+typedef struct {
+  uint8_t*  chunk;          /* tc001__rec_chunk_cap bytes */
+  uint8_t*  raw;            /* lossless: the frame as pushed; else NULL */
+  int64_t   timestamp_ns;
+  uint32_t  frame_id;
+} slot;
+
+struct tc001_recorder {
+  tc001_rec_writer* w;
+  int       width, height;
+  tc001_format format;
+  size_t    row;            /* bytes per tightly packed row */
+  int       lossless;
+  tc001_rec_policy policy;
+
+  slot*     slots;
+  int       nslots;         /* queue capacity + 1 */
+  int       batch;
+  tc001_atomic_int head;    /* next slot the producer fills */
+  tc001_atomic_int tail;    /* next slot the writer drains */
+  tc001_atomic_int stop;
+  tc001_atomic_int err;     /* writer's first error, for the producer */
+
+  int       direct_fd;      /* -1 without direct I/O */
+  uint8_t*  stage;
+  size_t    stage_len;      /* valid bytes, from stage_off */
+  uint64_t  stage_off;      /* page-aligned file offset of stage[0] */
+
+  /* producer side */
+  tc001_atomic_i64 queued, dropped;   /* written by the producer only */
+  tc001_atomic_int peak;
+
+  /* writer side, published under a sequence count */
+  tc001_atomic_int     stats_seq;
+  tc001_recorder_stats ws;
+  uint64_t             write_us_sum;
+
+#ifdef _WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+};
+
+static int ring_depth(const tc001_recorder* rc, int head, int tail) {
+  return (head - tail + rc->nslots) % rc->nslots;
+}
+
+/* ===== Writer thread ===== */
+static int write_direct(tc001_recorder* rc, const tc001_iovec* v, int n) {
+  for (int i = 0; i < n; ++i) {
+    memcpy(rc->stage + rc->stage_len, v[i].base, v[i].len);
+    rc->stage_len += v[i].len;
+  }
+  const size_t page = TC001_DIRECT_ALIGN;
+  const size_t padded = (rc->stage_len + page - 1) & ~(page - 1);
+  memset(rc->stage + rc->stage_len, 0, padded - rc->stage_len);
+  if (tc001__file_pwrite(rc->direct_fd, rc->stage, padded, rc->stage_off) != 0) return -1;
+  const size_t full = rc->stage_len & ~(page - 1);
+  memmove(rc->stage, rc->stage + full, rc->stage_len - full);
+  rc->stage_len -= full;
+  rc->stage_off += full;
+  return 0;
+}
+
+static void publish(tc001_recorder* rc, const tc001_recorder_stats* s) {
+  TC001_ATOMIC_STORE(&rc->stats_seq, TC001_ATOMIC_LOAD(&rc->stats_seq) + 1);
+  TC001_ATOMIC_FENCE();     /* odd before any byte of the stats */
+  rc->ws = *s;
+  TC001_ATOMIC_FENCE();     /* every byte before the even count */
+  TC001_ATOMIC_STORE(&rc->stats_seq, TC001_ATOMIC_LOAD(&rc->stats_seq) + 1);
+}
+
+static void writer_run(tc001_recorder* rc) {
+  tc001_iovec v[256];
+  size_t len[256];
+  tc001_recorder_stats s = rc->ws;
+
+  for (;;) {
+    const int tail = TC001_ATOMIC_LOAD(&rc->tail);
+    const int head = TC001_ATOMIC_LOAD(&rc->head);
+    if (tail == head) {
+      if (TC001_ATOMIC_LOAD(&rc->stop)) break;
+      tc001__sleep_ns(IDLE_NS);
+      continue;
+    }
+    int n = ring_depth(rc, head, tail);
+    if (n > rc->batch) n = rc->batch;
+
+    int written = 0;
+    if (s.error == TC001_OK) {
+      int m = 0;
+      for (; m < n; ++m) {
+        slot* sl = &rc->slots[(tail + m) % rc->nslots];
+        tc001_frame f;
+        memset(&f, 0, sizeof(f));
+        f.width = rc->width;
+        f.height = rc->height;
+        f.stride = (int)rc->row;
+        f.format = rc->format;
+        f.timestamp_ns = sl->timestamp_ns;
+        f.frame_id = sl->frame_id;
+        f.data = sl->raw ? sl->raw : sl->chunk + PAYLOAD_AT;
+        tc001_status st = tc001__rec_chunk(rc->w, &f, sl->chunk, &len[m]);
+        if (st != TC001_OK) { s.error = st; break; }
+        v[m].base = sl->chunk;
+        v[m].len = len[m];
+      }
+
+      if (m > 0) {
+        const int64_t t0 = tc001__now_ns();
+        int r = rc->direct_fd >= 0 ? write_direct(rc, v, m)
+                                   : tc001__file_pwritev(tc001__rec_fd(rc->w), v, m,
+                                                         tc001__rec_pos(rc->w));
+        const uint32_t us = (uint32_t)((tc001__now_ns() - t0) / 1000);
+        s.writes++;
+        s.write_us_last = us;
+        if (us > s.write_us_max) s.write_us_max = us;
+        rc->write_us_sum += us;
+        s.write_us_mean = (uint32_t)(rc->write_us_sum / s.writes);
+
+        if (r != 0) s.error = TC001_ERR_IO;
+        for (int i = 0; i < m && s.error == TC001_OK; ++i) {
+          tc001_status st = tc001__rec_append(rc->w, v[i].base, len[i]);
+          if (st != TC001_OK) s.error = st;
+          else { ++written; s.bytes_written += len[i]; }
+        }
+      }
+      s.frames_written += (uint64_t)written;
+      if (s.error != TC001_OK) {
+        tc001__rec_fail(rc->w, s.error);
+        TC001_ATOMIC_STORE(&rc->err, (int)s.error);
+      }
+    }
+    /* after an error the queue is still drained, as dropped frames */
+    s.frames_dropped += (uint64_t)(n - written);
+
+    TC001_ATOMIC_STORE(&rc->tail, (tail + n) % rc->nslots);
+    publish(rc, &s);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI writer_loop(LPVOID p) {
+  writer_run((tc001_recorder*)p);
+  return 0;
+}
+#else
+static void* writer_loop(void* p) {
+  writer_run((tc001_recorder*)p);
+  return NULL;
+}
+#endif
+
+/* ===== Public API ===== */
+static void recorder_free(tc001_recorder* rc) {
+  if (rc->slots) {
+    for (int i = 0; i < rc->nslots; ++i) {
+      tc001__aligned_free(rc->slots[i].chunk);
+      free(rc->slots[i].raw);
+    }
+    free(rc->slots);
+  }
+  tc001__aligned_free(rc->stage);
+  if (rc->direct_fd >= 0) tc001__file_close(rc->direct_fd);
+  free(rc);
+}
+
+tc001_status tc001_recorder_start(tc001_recorder** out, const char* path,
+                                  int width, int height, tc001_format format,
+                                  const tc001_recorder_options* opts,
+                                  const tc001_calibration* calib,
+                                  const tc001_temp_model* temp)
+{
+  if (!out) return TC001_ERR_PARAM;
+  *out = NULL;
+  tc001_recorder_options o;
+  memset(&o, 0, sizeof(o));
+  if (opts) o = *opts;
+  if (o.queue_frames <= 0) o.queue_frames = DEFAULT_QUEUE;
+  if (o.batch_frames <= 0) o.batch_frames = DEFAULT_BATCH;
+  if (o.batch_frames > 256) o.batch_frames = 256;
+  if (o.policy != TC001_REC_DROP && o.policy != TC001_REC_BLOCK) return TC001_ERR_PARAM;
+
+  tc001_recorder* rc = (tc001_recorder*)calloc(1, sizeof(*rc));
+  if (!rc) return TC001_ERR_ALLOC;
+  rc->direct_fd = -1;
+  tc001_status st = tc001_rec_create(&rc->w, path, width, height, format, &o.rec, calib, temp);
+  if (st != TC001_OK) { recorder_free(rc); return st; }
+
+  rc->width = width;
+  rc->height = height;
+  rc->format = format;
+  rc->row = (size_t)width * (format == TC001_FMT_U16 ? 2 : 1);
+  rc->lossless = o.rec.codec == TC001_REC_LOSSLESS;
+  rc->policy = o.policy;
+  rc->batch = o.batch_frames;
+  rc->nslots = o.queue_frames + 1;
+  rc->ws.queue_capacity = (uint32_t)o.queue_frames;
+
+  const size_t cap = tc001__rec_chunk_cap(rc->w);
+  rc->slots = (slot*)calloc((size_t)rc->nslots, sizeof(slot));
+  if (!rc->slots) goto OOM;
+  for (int i = 0; i < rc->nslots; ++i) {
+    if (!(rc->slots[i].chunk = (uint8_t*)tc001__aligned_alloc(cap, TC001_REC_ALIGN))) goto OOM;
+    if (rc->lossless && !(rc->slots[i].raw = (uint8_t*)malloc(rc->row * height))) goto OOM;
+  }
+
+  if (o.direct_io && (rc->direct_fd = tc001__file_open_direct(path)) >= 0) {
+    rc->stage = (uint8_t*)tc001__aligned_alloc(cap * (size_t)rc->batch + TC001_DIRECT_ALIGN,
+                                               TC001_DIRECT_ALIGN);
+    if (!rc->stage) goto OOM;
+    rc->stage_off = tc001__rec_pos(rc->w);    /* the header fills a whole page */
+    rc->ws.direct_io = 1;
+  }
+
+#ifdef _WIN32
+  rc->thread = CreateThread(NULL, 0, writer_loop, rc, 0, NULL);
+  if (!rc->thread) st = TC001_ERR_INTERNAL;
+#else
+  if (pthread_create(&rc->thread, NULL, writer_loop, rc) != 0) st = TC001_ERR_INTERNAL;
+#endif
+  if (st != TC001_OK) {
+    tc001_rec_finish(rc->w);
+    recorder_free(rc);
+    return st;
+  }
+  *out = rc;
+  return TC001_OK;
+
+OOM:
+  tc001_rec_finish(rc->w);
+  recorder_free(rc);
+  return TC001_ERR_ALLOC;
+}
+
+tc001_status tc001_recorder_push(tc001_recorder* rc, const tc001_frame* f) {
+  if (!rc || !f || !f->data) return TC001_ERR_PARAM;
+  if (f->width != rc->width || f->height != rc->height || f->format != rc->format ||
+      f->stride < (int)rc->row) return TC001_ERR_PARAM;
+
+  const int head = TC001_ATOMIC_LOAD(&rc->head);
+  const int next = (head + 1) % rc->nslots;
+  for (;;) {
+    const int err = TC001_ATOMIC_LOAD(&rc->err);
+    if (err) return (tc001_status)err;
+    if (next != TC001_ATOMIC_LOAD(&rc->tail)) break;
+    if (rc->policy == TC001_REC_DROP) {
+      TC001_ATOMIC_STORE64(&rc->dropped, TC001_ATOMIC_LOAD64(&rc->dropped) + 1);
+      return TC001_ERR_STATE;
+    }
+    tc001__sleep_ns(FULL_NS);
+  }
+
+  slot* sl = &rc->slots[head];
+  uint8_t* dst = sl->raw ? sl->raw : sl->chunk + PAYLOAD_AT;
+  if (f->stride == (int)rc->row) {
+    memcpy(dst, f->data, rc->row * rc->height);
+  } else {
+    for (int y = 0; y < rc->height; ++y)
+      memcpy(dst + (size_t)y * rc->row, f->data + (size_t)y * f->stride, rc->row);
+  }
+  sl->timestamp_ns = f->timestamp_ns;
+  sl->frame_id = f->frame_id;
+  TC001_ATOMIC_STORE(&rc->head, next);
+
+  TC001_ATOMIC_STORE64(&rc->queued, TC001_ATOMIC_LOAD64(&rc->queued) + 1);
+  const int depth = ring_depth(rc, next, TC001_ATOMIC_LOAD(&rc->tail));
+  if (depth > TC001_ATOMIC_LOAD(&rc->peak)) TC001_ATOMIC_STORE(&rc->peak, depth);
+  return TC001_OK;
+}
+
+void tc001_recorder_stats_get(tc001_recorder* rc, tc001_recorder_stats* out) {
+  if (!rc || !out) return;
+  int seq;
+  do {
+    /* odd only for one struct copy on the writer thread */
+    while ((seq = TC001_ATOMIC_LOAD(&rc->stats_seq)) % 2) tc001__sleep_ns(1000);
+    *out = rc->ws;
+    TC001_ATOMIC_FENCE();   /* the copy before the re-check */
+  } while (TC001_ATOMIC_LOAD(&rc->stats_seq) != seq);
+  out->frames_queued = (uint64_t)TC001_ATOMIC_LOAD64(&rc->queued);
+  out->frames_dropped += (uint64_t)TC001_ATOMIC_LOAD64(&rc->dropped);
+  out->queue_peak = (uint32_t)TC001_ATOMIC_LOAD(&rc->peak);
+  out->queue_depth = (uint32_t)ring_depth(rc, TC001_ATOMIC_LOAD(&rc->head),
+                                          TC001_ATOMIC_LOAD(&rc->tail));
+}
+
+tc001_status tc001_recorder_finish(tc001_recorder* rc) {
+  if (!rc) return TC001_ERR_PARAM;
+  TC001_ATOMIC_STORE(&rc->stop, 1);
+#ifdef _WIN32
+  WaitForSingleObject(rc->thread, INFINITE);
+  CloseHandle(rc->thread);
+#else
+  pthread_join(rc->thread, NULL);
+#endif
+  /* the staged tail page is already on disk; the index goes after it
+     through the buffered descriptor, which also trims the padding */
+  if (rc->direct_fd >= 0) {
+    tc001__file_close(rc->direct_fd);
+    rc->direct_fd = -1;
+  }
+  tc001_status st = tc001_rec_finish(rc->w);
+  if (TC001_ATOMIC_LOAD(&rc->err)) st = (tc001_status)TC001_ATOMIC_LOAD(&rc->err);
+  recorder_free(rc);
+  return st;
+}
@@ -0,0 +1,221 @@
+#include "tc001_render.h"
+#include "tc001_jpeg.h"
+#include "tc001_internal.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct tc001_render_ctx {
+  int rotation;
+  int has_palette;
+  uint8_t palette[768];     /* identity ramp when grayscale */
+  uint8_t pal4[256][4];     /* the same, padded for 4-byte stores */
+
+  /* rendered images, grown on demand */
+  uint8_t* gray;
+  uint8_t* rgb;
+  uint8_t* row;             /* one AGC source row before rotating */
+  size_t   gray_cap, rgb_cap, row_cap;
+  int      out_w, out_h;
+
+  /* recording */
+  char*        avi_path;
+  double       fps;
+  int          quality;
+  tc001_jpeg*  jpeg;
+  tc001_mjpeg* avi;
+  uint8_t*     jpeg_buf;
+  size_t       jpeg_cap;
+  int          avi_w, avi_h;
+
+  tc001_render_stats stats;
+};
+
+static int grow(uint8_t** p, size_t* cap, size_t n) {
+  if (n <= *cap) return 1;
+  uint8_t* q = (uint8_t*)realloc(*p, n);
+  if (!q) return 0;
+  *p = q;
+  *cap = n;
+  return 1;
+}
+
+tc001_status tc001_render_create(tc001_render_ctx** out, const tc001_render_options* opts) {
+  if (!out) return TC001_ERR_PARAM;
+  tc001_render_options o = {0};
+  if (opts) o = *opts;
+  if (o.rotation != 0 && o.rotation != 90 && o.rotation != 180 && o.rotation != 270)
+    return TC001_ERR_PARAM;
+  if (o.quality < 0 || o.quality > 100 || o.fps < 0) return TC001_ERR_PARAM;
+
+  tc001_render_ctx* c = (tc001_render_ctx*)calloc(1, sizeof(*c));
+  if (!c) return TC001_ERR_ALLOC;
+  c->rotation = o.rotation;
+  c->has_palette = o.palette != NULL;
+  if (o.palette) {
+    memcpy(c->palette, o.palette, sizeof(c->palette));
+  } else {
+    for (int i = 0; i < 256; ++i) memset(c->palette + 3 * i, i, 3);
+  }
+  for (int i = 0; i < 256; ++i) memcpy(c->pal4[i], c->palette + 3 * i, 3);
+  c->fps = o.fps > 0 ? o.fps : 25.0;
+  c->quality = o.quality;
+  if (o.avi_path) {
+    size_t n = strlen(o.avi_path) + 1;
+    c->avi_path = (char*)malloc(n);
+    if (!c->avi_path) {
+      free(c);
+      return TC001_ERR_ALLOC;
+    }
+    memcpy(c->avi_path, o.avi_path, n);
+  }
+  *out = c;
+  return TC001_OK;
+}
+
+tc001_status tc001_render_destroy(tc001_render_ctx* c) {
+  if (!c) return TC001_ERR_PARAM;
+  tc001_status st = c->stats.write_error;
+  if (c->avi) {
+    tc001_status cs = tc001_mjpeg_close(c->avi);
+    if (st == TC001_OK) st = cs;
+  }
+  tc001_jpeg_destroy(c->jpeg);
+  free(c->jpeg_buf);
+  free(c->avi_path);
+  free(c->gray);
+  free(c->rgb);
+  free(c->row);
+  free(c);
+  return st;
+}
+
+/* ===== Rendering ===== */
+/* Writes one 8-bit source row y of a w x h frame into the rotated plane:
+   dst index = base + x * step. */
+static void put_row(const tc001_render_ctx* c, const uint8_t* s, int y, int w, int h) {
+  const int dw = c->out_w;
+  ptrdiff_t base, step;
+  switch (c->rotation) {
+  case 90:  base = h - 1 - y;                           step = dw;  break;
+  case 180: base = (ptrdiff_t)(h - 1 - y) * dw + w - 1; step = -1;  break;
+  case 270: base = (ptrdiff_t)(w - 1) * dw + y;         step = -dw; break;
+  default:  memcpy(c->gray + (size_t)y * dw, s, (size_t)w); return;
+  }
+  uint8_t* d = c->gray + base;
+  for (int x = 0; x < w; ++x, d += step) *d = s[x];
+}
+
+static tc001_status record(tc001_render_ctx* c) {
+  const int w = c->out_w, h = c->out_h;
+  if (!c->avi) {
+    c->jpeg_cap = tc001_jpeg_max_bytes(w, h, c->has_palette);
+    c->jpeg_buf = (uint8_t*)malloc(c->jpeg_cap);
+    if (!c->jpeg_buf) return TC001_ERR_ALLOC;
+    tc001_status st = tc001_jpeg_create(&c->jpeg, c->quality);
+    if (st == TC001_OK) st = tc001_mjpeg_open_avi(&c->avi, c->avi_path, w, h, c->fps);
+    if (st != TC001_OK) return st;
+    c->avi_w = w;
+    c->avi_h = h;
+  }
+  size_t len;
+  tc001_status st = c->has_palette
+    ? tc001_jpeg_encode_indexed(c->jpeg, c->gray, w, h, w, c->palette, c->jpeg_buf, c->jpeg_cap, &len)
+    : tc001_jpeg_encode_gray(c->jpeg, c->gray, w, h, w, c->jpeg_buf, c->jpeg_cap, &len);
+  if (st == TC001_OK) st = tc001_mjpeg_write(c->avi, c->jpeg_buf, len);
+  if (st != TC001_OK) return st;
+  c->stats.encoded_frames++;
+  c->stats.encoded_bytes += len;
+  return TC001_OK;
+}
+
+tc001_status tc001_render_frame(tc001_render_ctx* c, const tc001_frame* f, tc001_render_image* out) {
+  if (!c || !f || !f->data || f->width <= 0 || f->height <= 0) return TC001_ERR_PARAM;
+  const int w = f->width, h = f->height;
+  const int u16 = f->format == TC001_FMT_U16;
+  if (f->format != TC001_FMT_U8 && !u16) return TC001_ERR_PARAM;
+  if (f->stride < w * (u16 ? 2 : 1)) return TC001_ERR_PARAM;
+  const int turned = c->rotation == 90 || c->rotation == 270;
+  const int ow = turned ? h : w, oh = turned ? w : h;
+  const int recording = c->avi_path && c->stats.write_error == TC001_OK;
+  if (recording && c->avi && (ow != c->avi_w || oh != c->avi_h)) return TC001_ERR_PARAM;
+
+  const size_t n = (size_t)w * h;
+  if (!grow(&c->gray, &c->gray_cap, n) || !grow(&c->rgb, &c->rgb_cap, n * 3) ||
+      !grow(&c->row, &c->row_cap, (size_t)w))
+    return TC001_ERR_ALLOC;
+  c->out_w = ow;
+  c->out_h = oh;
+
+  const int64_t t0 = tc001__now_ns();
+  uint16_t lo = 65535, hi = 0;
+  if (u16) {
+    if (f->stats) {
+      lo = f->stats->raw_min;
+      hi = f->stats->raw_max;
+    } else {
+      for (int y = 0; y < h; ++y)
+        tc001__minmax_u16((const uint16_t*)(f->data + (size_t)y * f->stride), w, &lo, &hi);
+    }
+    const float scale = tc001__agc_scale(lo, hi);
+    for (int y = 0; y < h; ++y) {
+      const uint16_t* s = (const uint16_t*)(f->data + (size_t)y * f->stride);
+      uint8_t* d = c->rotation ? c->row : c->gray + (size_t)y * w;
+      for (int x = 0; x < w; ++x) d[x] = tc001__agc_u8(s[x], lo, scale);
+      if (c->rotation) put_row(c, d, y, w, h);
+    }
+  } else {
+    for (int y = 0; y < h; ++y) {
+      const uint8_t* s = f->data + (size_t)y * f->stride;
+      for (int x = 0; x < w; ++x) {
+        if (s[x] < lo) lo = s[x];
+        if (s[x] > hi) hi = s[x];
+      }
+      put_row(c, s, y, w, h);
+    }
+  }
+
+  /* palette lookup in output order, one 4-byte store per pixel (the pad
+     byte is overwritten by the next pixel); locals, since byte stores may
+     alias the context */
+  const uint8_t (*pal)[4] = c->pal4;
+  const uint8_t* g = c->gray;
+  uint8_t* d = c->rgb;
+  for (size_t i = 0; i + 1 < n; ++i, d += 3) memcpy(d, pal[g[i]], 4);
+  memcpy(d, pal[g[n - 1]], 3);
+  const int64_t t1 = tc001__now_ns();
+
+  const uint32_t index = (uint32_t)c->stats.frames;
+  c->stats.frames++;
+  c->stats.flat_frames += lo == hi;
+  c->stats.render_ns += (uint64_t)(t1 - t0);
+
+  tc001_status st = TC001_OK;
+  if (recording) {
+    st = record(c);
+    if (st != TC001_OK) c->stats.write_error = st;
+    c->stats.encode_ns += (uint64_t)(tc001__now_ns() - t1);
+  }
+
+  if (out) {
+    out->rgb = c->rgb;
+    out->gray = c->gray;
+    out->width = ow;
+    out->height = oh;
+    out->pitch = ow * 3;
+    out->index = index;
+    out->raw_min = lo;
+    out->raw_max = hi;
+    out->flat = lo == hi;
+  }
+  return st;
+}
+
+void tc001_render_get_stats(const tc001_render_ctx* c, tc001_render_stats* out) {
+  if (!out) return;
+  if (!c) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = c->stats;
+}
@@ -0,0 +1,206 @@
+#include "tc001_rec.h"
+#include "tc001_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Replay backend: a thread reads a recording and feeds each frame to
+   tc001__deliver_frame on a schedule derived from the recorded timestamps.
+   Packetized, a frame goes through tc001__frame_data in the payload sizes
+   of the camera's isochronous packets, paced over the interval since the
+   previous frame, and its timestamp is the time of its last packet. */
+
+#define MAX_NAP_NS   20000000LL   /* re-check the running flag this often */
+#define PACKET_BYTES 3060         /* 3072-byte packet less the UVC header */
+
+struct tc001_replay {
+  tc001_rec_reader* rec;
+  double   speed;
+  int      loop;
+  uint32_t first;
+  int      packetize;
+  tc001_atomic_int done;
+};
+
+static void seterr(char* out_buf, size_t out_cap, const char* msg) {
+  if (out_buf && out_cap) snprintf(out_buf, out_cap, "%s", msg);
+}
+
+tc001_status tc001_open_replay(tc001_handle** out, const char* path,
+                               const tc001_replay_options* opts,
+                               char* err, size_t errcap)
+{
+  if (!out || !path) return TC001_ERR_PARAM;
+  *out = NULL;
+  tc001_replay_options o = { 1.0, 0, 0, 0 };
+  if (opts) o = *opts;
+  if (!(o.speed >= 0)) return TC001_ERR_PARAM;
+
+  struct tc001_replay* r = (struct tc001_replay*)calloc(1, sizeof(*r));
+  struct tc001_handle* h = (struct tc001_handle*)calloc(1, sizeof(*h));
+  if (!r || !h) {
+    free(r); free(h);
+    seterr(err, errcap, "alloc");
+    return TC001_ERR_ALLOC;
+  }
+  tc001_status st = tc001_rec_open(&r->rec, path);
+  if (st != TC001_OK) {
+    free(r); free(h);
+    seterr(err, errcap, "cannot open recording");
+    return st;
+  }
+  const tc001_rec_header* hd = tc001_rec_info(r->rec);
+  if (hd->format != TC001_FMT_U16 || o.first >= tc001_rec_frame_count(r->rec)) {
+    tc001__replay_free(r); free(h);
+    seterr(err, errcap, hd->format != TC001_FMT_U16 ? "recording is not U16" : "no frames to play");
+    return TC001_ERR_PARAM;
+  }
+  r->speed = o.speed;
+  r->loop = o.loop;
+  r->first = o.first;
+  r->packetize = o.packetize;
+
+  h->replay = r;
+  h->width = h->src_w = hd->width;
+  h->height = h->src_h = hd->height;
+  if (o.packetize && !(h->frame_buf = (uint8_t*)tc001__buf_alloc((size_t)h->width * h->height * 2, 0))) {
+    tc001__replay_free(r); free(h);
+    seterr(err, errcap, "alloc");
+    return TC001_ERR_ALLOC;
+  }
+  h->calib = hd->calib;
+  h->temp = hd->temp;
+  *out = h;
+  return TC001_OK;
+}
+
+void tc001__replay_free(struct tc001_replay* r) {
+  if (!r) return;
+  tc001_rec_close(r->rec);
+  free(r);
+}
+
+int tc001_replay_done(tc001_handle* h) {
+  return h && h->replay ? (int)TC001_ATOMIC_LOAD(&h->replay->done) : 0;
+}
+
+/* Sleeps until the monotonic clock reaches due; 0 if stopped meanwhile. */
+static int wait_until(struct tc001_handle* h, int64_t due) {
+  for (;;) {
+    if (!TC001_ATOMIC_LOAD(&h->running)) return 0;
+    int64_t left = due - tc001__now_ns();
+    if (left <= 0) return 1;
+    tc001__sleep_ns(left < MAX_NAP_NS ? left : MAX_NAP_NS);
+  }
+}
+
+/* The acquisition window of a sensor image, packed into frame_buf. */
+static const uint8_t* crop(struct tc001_handle* h, const uint8_t* data) {
+  const size_t row = (size_t)h->src_w * 2, wb = (size_t)h->width * 2;
+  const uint8_t* s = data + h->roi_y * row + h->roi_x * 2;
+  for (int y = 0; y < h->height; ++y) memcpy(h->frame_buf + y * wb, s + y * row, wb);
+  return h->frame_buf;
+}
+
+/* Feeds one frame in packets, the k-th of n due at from + (due - from) *
+   (k + 1) / n; due 0 = unpaced. 0 if stopped meanwhile. */
+static int feed_packets(struct tc001_handle* h, const uint8_t* data, int64_t ts,
+                        int64_t from, int64_t due) {
+  const int size = h->src_w * h->src_h * 2;
+  const int n = (size + PACKET_BYTES - 1) / PACKET_BYTES;
+  for (int k = 0; k < n; ++k) {
+    if (due ? !wait_until(h, from + (due - from) * (k + 1) / n) : !TC001_ATOMIC_LOAD(&h->running))
+      return 0;
+    const int off = k * PACKET_BYTES;
+    tc001__frame_data(h, data + off, size - off < PACKET_BYTES ? size - off : PACKET_BYTES);
+  }
+  tc001__frame_end(h, ts);
+  return 1;
+}
+
+static void replay_run(struct tc001_handle* h) {
+  struct tc001_replay* r = h->replay;
+  const uint32_t n = tc001_rec_frame_count(r->rec);
+  int64_t t0 = 0, ts0 = 0, shift = 0, prev_due = 0;
+  int64_t rec_first = 0, rec_last = 0;
+  int started = 0;
+  uint32_t i = r->first;
+
+  while (TC001_ATOMIC_LOAD(&h->running)) {
+    if (i >= n) {
+      if (!r->loop) break;
+      /* next pass starts one mean frame interval after this one ended */
+      const uint32_t played = n - r->first;
+      shift += rec_last - rec_first + (played > 1 ? (rec_last - rec_first) / (played - 1) : 1);
+      i = r->first;
+    }
+    tc001_frame f;
+    if (tc001_rec_read(r->rec, i, &f) != TC001_OK) break;
+    if (i == r->first) rec_first = f.timestamp_ns;
+    rec_last = f.timestamp_ns;
+    const int64_t ts = f.timestamp_ns + shift;
+
+    int64_t due = 0;
+    if (r->speed > 0) {
+      if (!started) { t0 = prev_due = tc001__now_ns(); ts0 = ts; }
+      due = t0 + (int64_t)((double)(ts - ts0) / r->speed);
+      if (!r->packetize && !wait_until(h, due)) break;
+    }
+    started = 1;
+    if (r->packetize) {
+      if (!feed_packets(h, f.data, ts, prev_due, due)) break;
+      prev_due = due;
+    } else {
+      const int whole = h->width == h->src_w && h->height == h->src_h;
+      tc001__deliver_frame(h, whole ? f.data : crop(h, f.data), ts);
+    }
+    ++i;
+  }
+  TC001_ATOMIC_STORE(&r->done, 1);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI replay_loop(LPVOID p) {
+  replay_run((struct tc001_handle*)p);
+  return 0;
+}
+#else
+static void* replay_loop(void* p) {
+  replay_run((struct tc001_handle*)p);
+  return NULL;
+}
+#endif
+
+tc001_status tc001__replay_start(struct tc001_handle* h, char* err, size_t errcap) {
+  TC001_ATOMIC_STORE(&h->replay->done, 0);
+  h->frame_pos = 0;
+  h->frame_synced = 1;      /* packets start at row 0 */
+  TC001_ATOMIC_STORE(&h->running, 1);
+#ifdef _WIN32
+  h->thread = CreateThread(NULL, 0, replay_loop, h, 0, NULL);
+  if (!h->thread) {
+    TC001_ATOMIC_STORE(&h->running, 0);
+    seterr(err, errcap, "CreateThread failed");
+    return TC001_ERR_INTERNAL;
+  }
+#else
+  if (pthread_create(&h->thread, NULL, replay_loop, h) != 0) {
+    TC001_ATOMIC_STORE(&h->running, 0);
+    seterr(err, errcap, "pthread_create failed");
+    return TC001_ERR_INTERNAL;
+  }
+#endif
+  return TC001_OK;
+}
+
+void tc001__replay_stop(struct tc001_handle* h) {
+  if (!TC001_ATOMIC_LOAD(&h->running)) return;
+  TC001_ATOMIC_STORE(&h->running, 0);
+#ifdef _WIN32
+  WaitForSingleObject(h->thread, INFINITE);
+  CloseHandle(h->thread);
+  h->thread = NULL;
+#else
+  pthread_join(h->thread, NULL);
+#endif
+}
@@ -0,0 +1,465 @@
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ROI measurement.
+
+   Regions are compiled once, when added: rectangles are kept as clipped
+   boxes, spots and polygons become lists of horizontal spans. Per frame
+   there are two evaluation paths, picked by total ROI area:
+
+   - direct: each span is scanned (SIMD min/max/sum/sum of squares). Best
+     until the regions together cover the frame a few times over.
+   - tables: one pass builds summed-area tables of v and v^2, after which
+     a rectangle's sum and sum of squares (so mean and stddev) are O(1) and
+     a span's O(1). min/max still sweep the span's pixels (SIMD).
+   - tables + rmq: when the regions cover the frame many times over, per-row
+     sparse tables of min/max are built as well, making each span's min/max
+     O(1) too. Their build costs a few frame passes, so they only pay off
+     for thousands of overlapping regions. */
+
+#define TABLES_COVER  4       /* area > 4 frames: summed-area tables */
+#define RMQ_COVER     16      /* area > 16 frames: also sparse min/max */
+
+typedef struct { uint16_t y, x0, x1; } span;   /* x1 exclusive */
+
+enum { ROI_RECT, ROI_SPANS };
+
+typedef struct {
+  int kind;
+  int x0, y0, x1, y1;       /* ROI_RECT: clipped, exclusive upper bounds */
+  uint32_t first, n;        /* ROI_SPANS: range in spans[] */
+  uint32_t area;
+} roi;
+
+struct tc001_roi_set {
+  int w, h;
+  roi*  rois;  size_t n, cap;
+  span* spans; size_t span_n, span_cap;
+  uint64_t area;            /* summed over all ROIs */
+
+  uint8_t* lg;              /* floor(log2(len)) for len in [1, w] */
+  int levels;
+
+  /* per-frame tables, allocated on first use */
+  uint64_t* sat;            /* (w+1) * (h+1) running sums of v */
+  uint64_t* sat2;           /* ... and of v^2 */
+  uint16_t* rmin;           /* levels * w * h; level k covers 2^k pixels */
+  uint16_t* rmax;
+};
+
+typedef struct {
+  uint32_t n;
+  uint16_t lo, hi;
+  uint64_t s, s2;
+} acc;
+
+static int grow(void** p, size_t* cap, size_t n, size_t elem) {
+  if (*cap >= n) return 0;
+  size_t c = *cap ? *cap * 2 : 16;
+  while (c < n) c *= 2;
+  void* q = realloc(*p, c * elem);
+  if (!q) return -1;
+  *p = q; *cap = c;
+  return 0;
+}
+
+/* ===== Set ===== */
+tc001_status tc001_roi_set_create(tc001_roi_set** out, int width, int height) {
+  if (!out || width <= 0 || height <= 0 || width > 65535 || height > 65535)
+    return TC001_ERR_PARAM;
+  tc001_roi_set* s = (tc001_roi_set*)calloc(1, sizeof(*s));
+  if (!s) return TC001_ERR_ALLOC;
+  s->w = width;
+  s->h = height;
+  s->lg = (uint8_t*)malloc((size_t)width + 1);
+  if (!s->lg) { free(s); return TC001_ERR_ALLOC; }
+  s->lg[0] = 0;
+  s->lg[1] = 0;
+  for (int i = 2; i <= width; ++i) s->lg[i] = (uint8_t)(s->lg[i / 2] + 1);
+  s->levels = s->lg[width] + 1;
+  *out = s;
+  return TC001_OK;
+}
+
+void tc001_roi_set_destroy(tc001_roi_set* s) {
+  if (!s) return;
+  free(s->rois);
+  free(s->spans);
+  free(s->lg);
+  free(s->sat);
+  free(s->sat2);
+  free(s->rmin);
+  free(s->rmax);
+  free(s);
+}
+
+void tc001_roi_clear(tc001_roi_set* s) {
+  if (!s) return;
+  s->n = 0;
+  s->span_n = 0;
+  s->area = 0;
+}
+
+int tc001_roi_count(const tc001_roi_set* s) {
+  return s ? (int)s->n : 0;
+}
+
+static roi* push_roi(tc001_roi_set* s, int kind, int* id) {
+  if (grow((void**)&s->rois, &s->cap, s->n + 1, sizeof(roi))) return NULL;
+  roi* r = &s->rois[s->n];
+  memset(r, 0, sizeof(*r));
+  r->kind = kind;
+  r->first = (uint32_t)s->span_n;
+  if (id) *id = (int)s->n;
+  s->n++;
+  return r;
+}
+
+static int push_span(tc001_roi_set* s, roi* r, int y, int x0, int x1) {
+  if (x0 < 0) x0 = 0;
+  if (x1 > s->w) x1 = s->w;
+  if (y < 0 || y >= s->h || x0 >= x1) return 0;
+  if (grow((void**)&s->spans, &s->span_cap, s->span_n + 1, sizeof(span))) return -1;
+  span* sp = &s->spans[s->span_n++];
+  sp->y = (uint16_t)y;
+  sp->x0 = (uint16_t)x0;
+  sp->x1 = (uint16_t)x1;
+  r->n++;
+  r->area += (uint32_t)(x1 - x0);
+  return 0;
+}
+
+/* Span-built ROIs are added in one go: on OOM the partial ROI is dropped */
+static tc001_status finish_spans(tc001_roi_set* s, roi* r, int failed) {
+  if (failed) {
+    s->span_n = r->first;
+    s->n--;
+    return TC001_ERR_ALLOC;
+  }
+  s->area += r->area;
+  return TC001_OK;
+}
+
+tc001_status tc001_roi_add_rect(tc001_roi_set* s, int x, int y, int w, int h, int* id) {
+  if (!s || w < 0 || h < 0) return TC001_ERR_PARAM;
+  roi* r = push_roi(s, ROI_RECT, id);
+  if (!r) return TC001_ERR_ALLOC;
+  int64_t x1 = (int64_t)x + w, y1 = (int64_t)y + h;
+  r->x0 = x < 0 ? 0 : (x > s->w ? s->w : x);
+  r->y0 = y < 0 ? 0 : (y > s->h ? s->h : y);
+  r->x1 = (int)(x1 < r->x0 ? r->x0 : (x1 > s->w ? s->w : x1));
+  r->y1 = (int)(y1 < r->y0 ? r->y0 : (y1 > s->h ? s->h : y1));
+  r->area = (uint32_t)(r->x1 - r->x0) * (uint32_t)(r->y1 - r->y0);
+  s->area += r->area;
+  return TC001_OK;
+}
+
+tc001_status tc001_roi_add_spot(tc001_roi_set* s, int cx, int cy, int radius, int* id) {
+  if (!s || radius < 0) return TC001_ERR_PARAM;
+  roi* r = push_roi(s, ROI_SPANS, id);
+  if (!r) return TC001_ERR_ALLOC;
+  int failed = 0;
+  const int64_t r2 = (int64_t)radius * radius;
+  for (int dy = -radius; dy <= radius && !failed; ++dy) {
+    int64_t rem = r2 - (int64_t)dy * dy;
+    int64_t half = (int64_t)sqrt((double)rem);
+    while (half * half > rem) --half;
+    while ((half + 1) * (half + 1) <= rem) ++half;
+    failed = push_span(s, r, cy + dy, (int)(cx - half), (int)(cx + half + 1));
+  }
+  return finish_spans(s, r, failed);
+}
+
+tc001_status tc001_roi_add_polygon(tc001_roi_set* s, const float* xy, int n, int* id) {
+  if (!s || !xy || n < 3) return TC001_ERR_PARAM;
+  float* xs = (float*)malloc((size_t)n * sizeof(float));
+  if (!xs) return TC001_ERR_ALLOC;
+  roi* r = push_roi(s, ROI_SPANS, id);
+  if (!r) { free(xs); return TC001_ERR_ALLOC; }
+
+  float ymin = xy[1], ymax = xy[1];
+  for (int i = 1; i < n; ++i) {
+    if (xy[2*i+1] < ymin) ymin = xy[2*i+1];
+    if (xy[2*i+1] > ymax) ymax = xy[2*i+1];
+  }
+  int ya = (int)ceilf(ymin - 0.5f), yb = (int)ceilf(ymax - 0.5f);
+  if (ya < 0) ya = 0;
+  if (yb > s->h) yb = s->h;
+
+  /* Even-odd scanline fill sampled at pixel centres */
+  int failed = 0;
+  for (int y = ya; y < yb && !failed; ++y) {
+    const float yc = (float)y + 0.5f;
+    int k = 0;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+      float ay = xy[2*j+1], by = xy[2*i+1];
+      if ((ay <= yc) == (by <= yc)) continue;
+      float ax = xy[2*j], bx = xy[2*i];
+      float x = ax + (yc - ay) * (bx - ax) / (by - ay);
+      int m = k++;
+      while (m > 0 && xs[m-1] > x) { xs[m] = xs[m-1]; --m; }
+      xs[m] = x;
+    }
+    for (int i = 0; i + 1 < k && !failed; i += 2)
+      failed = push_span(s, r, y, (int)ceilf(xs[i] - 0.5f), (int)ceilf(xs[i+1] - 0.5f));
+  }
+  free(xs);
+  return finish_spans(s, r, failed);
+}
+
+/* ===== Direct path ===== */
+static void acc_init(acc* a) {
+  a->n = 0; a->lo = 0xFFFF; a->hi = 0; a->s = 0; a->s2 = 0;
+}
+
+static void scan_span(const uint16_t* p, int n, acc* a) {
+  int x = 0;
+  uint16_t lo = a->lo, hi = a->hi;
+  uint64_t s = 0, s2 = 0;
+#if defined(TC001_SSE2)
+  if (n >= 8) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmin = _mm_set1_epi16((short)0xFFFF), vmax = zero;
+    __m128i vs = zero, vs2 = zero;   /* u32 x4 / u64 x2 */
+    for (; x + 8 <= n; x += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(p + x));
+      /* unsigned min/max from saturating subtract */
+      vmin = _mm_sub_epi16(vmin, _mm_subs_epu16(vmin, v));
+      vmax = _mm_add_epi16(vmax, _mm_subs_epu16(v, vmax));
+      __m128i lo32 = _mm_unpacklo_epi16(v, zero), hi32 = _mm_unpackhi_epi16(v, zero);
+      vs = _mm_add_epi32(vs, _mm_add_epi32(lo32, hi32));
+      vs2 = _mm_add_epi64(vs2, _mm_mul_epu32(lo32, lo32));
+      vs2 = _mm_add_epi64(vs2, _mm_mul_epu32(_mm_srli_epi64(lo32, 32), _mm_srli_epi64(lo32, 32)));
+      vs2 = _mm_add_epi64(vs2, _mm_mul_epu32(hi32, hi32));
+      vs2 = _mm_add_epi64(vs2, _mm_mul_epu32(_mm_srli_epi64(hi32, 32), _mm_srli_epi64(hi32, 32)));
+    }
+    uint16_t mn[8], mx[8];
+    uint32_t t[4];
+    uint64_t t2[2];
+    _mm_storeu_si128((__m128i*)mn, vmin);
+    _mm_storeu_si128((__m128i*)mx, vmax);
+    _mm_storeu_si128((__m128i*)t, vs);
+    _mm_storeu_si128((__m128i*)t2, vs2);
+    for (int i = 0; i < 8; ++i) {
+      if (mn[i] < lo) lo = mn[i];
+      if (mx[i] > hi) hi = mx[i];
+    }
+    s = (uint64_t)t[0] + t[1] + t[2] + t[3];
+    s2 = t2[0] + t2[1];
+  }
+#elif defined(TC001_NEON)
+  if (n >= 8) {
+    uint16x8_t vmin = vdupq_n_u16(0xFFFF), vmax = vdupq_n_u16(0);
+    uint32x4_t vs = vdupq_n_u32(0);
+    uint64x2_t vs2 = vdupq_n_u64(0);
+    for (; x + 8 <= n; x += 8) {
+      uint16x8_t v = vld1q_u16(p + x);
+      vmin = vminq_u16(vmin, v);
+      vmax = vmaxq_u16(vmax, v);
+      vs = vpadalq_u16(vs, v);
+      vs2 = vpadalq_u32(vs2, vmull_u16(vget_low_u16(v), vget_low_u16(v)));
+      vs2 = vpadalq_u32(vs2, vmull_u16(vget_high_u16(v), vget_high_u16(v)));
+    }
+    uint16_t vlo = vminvq_u16(vmin), vhi = vmaxvq_u16(vmax);
+    if (vlo < lo) lo = vlo;
+    if (vhi > hi) hi = vhi;
+    s = vaddlvq_u32(vs);
+    s2 = vgetq_lane_u64(vs2, 0) + vgetq_lane_u64(vs2, 1);
+  }
+#endif
+  for (; x < n; ++x) {
+    uint32_t v = p[x];
+    if (v < lo) lo = (uint16_t)v;
+    if (v > hi) hi = (uint16_t)v;
+    s += v;
+    s2 += (uint64_t)v * v;
+  }
+  a->lo = lo; a->hi = hi;
+  a->s += s; a->s2 += s2;
+  a->n += (uint32_t)n;
+}
+
+static void eval_direct(const tc001_roi_set* s, const roi* r, const tc001_frame* f, acc* a) {
+  const uint8_t* base = f->data;
+  if (r->kind == ROI_RECT) {
+    for (int y = r->y0; y < r->y1; ++y)
+      scan_span((const uint16_t*)(base + (size_t)y * f->stride) + r->x0, r->x1 - r->x0, a);
+    return;
+  }
+  const span* sp = s->spans + r->first;
+  for (uint32_t i = 0; i < r->n; ++i)
+    scan_span((const uint16_t*)(base + (size_t)sp[i].y * f->stride) + sp[i].x0,
+              sp[i].x1 - sp[i].x0, a);
+}
+
+/* ===== Table path ===== */
+static tc001_status tables_alloc(tc001_roi_set* s, int rmq) {
+  if (!s->sat) {
+    size_t nsat = (size_t)(s->w + 1) * (s->h + 1);
+    s->sat  = (uint64_t*)calloc(nsat, sizeof(uint64_t));
+    s->sat2 = (uint64_t*)calloc(nsat, sizeof(uint64_t));
+    if (!s->sat || !s->sat2) {
+      free(s->sat); free(s->sat2);
+      s->sat = s->sat2 = NULL;
+      return TC001_ERR_ALLOC;
+    }
+  }
+  if (rmq && !s->rmin) {
+    size_t nr = (size_t)s->levels * s->w * s->h;
+    s->rmin = (uint16_t*)malloc(nr * sizeof(uint16_t));
+    s->rmax = (uint16_t*)malloc(nr * sizeof(uint16_t));
+    if (!s->rmin || !s->rmax) {
+      free(s->rmin); free(s->rmax);
+      s->rmin = s->rmax = NULL;
+      return TC001_ERR_ALLOC;
+    }
+  }
+  return TC001_OK;
+}
+
+/* Level k holds min/max over [x, x + 2^k); only x <= w - 2^k is valid */
+static void sparse_level(uint16_t* dmin, uint16_t* dmax,
+                         const uint16_t* smin, const uint16_t* smax, int n, int half)
+{
+  int x = 0;
+#if defined(TC001_SSE2)
+  /* unsigned 16-bit min/max from a saturating subtract */
+  for (; x + 8 <= n; x += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(smin + x));
+    __m128i b = _mm_loadu_si128((const __m128i*)(smin + x + half));
+    _mm_storeu_si128((__m128i*)(dmin + x), _mm_sub_epi16(a, _mm_subs_epu16(a, b)));
+    a = _mm_loadu_si128((const __m128i*)(smax + x));
+    b = _mm_loadu_si128((const __m128i*)(smax + x + half));
+    _mm_storeu_si128((__m128i*)(dmax + x), _mm_add_epi16(a, _mm_subs_epu16(b, a)));
+  }
+#elif defined(TC001_NEON)
+  for (; x + 8 <= n; x += 8) {
+    vst1q_u16(dmin + x, vminq_u16(vld1q_u16(smin + x), vld1q_u16(smin + x + half)));
+    vst1q_u16(dmax + x, vmaxq_u16(vld1q_u16(smax + x), vld1q_u16(smax + x + half)));
+  }
+#endif
+  for (; x < n; ++x) {
+    uint16_t a = smin[x], b = smin[x + half];
+    dmin[x] = a < b ? a : b;
+    a = smax[x]; b = smax[x + half];
+    dmax[x] = a > b ? a : b;
+  }
+}
+
+static void tables_build(tc001_roi_set* s, const tc001_frame* f, int rmq) {
+  const int w = s->w, h = s->h;
+  const size_t W1 = (size_t)w + 1, plane = (size_t)w * h;
+
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* p = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    const uint64_t* up = s->sat + (size_t)y * W1;
+    const uint64_t* up2 = s->sat2 + (size_t)y * W1;
+    uint64_t* row = s->sat + (size_t)(y + 1) * W1;
+    uint64_t* row2 = s->sat2 + (size_t)(y + 1) * W1;
+    uint64_t rs = 0, rs2 = 0;
+    for (int x = 0; x < w; ++x) {
+      uint64_t v = p[x];
+      rs += v;
+      rs2 += v * v;
+      row[x + 1] = up[x + 1] + rs;
+      row2[x + 1] = up2[x + 1] + rs2;
+    }
+    if (rmq) memcpy(s->rmin + (size_t)y * w, p, (size_t)w * 2);
+  }
+  if (!rmq) return;
+
+  memcpy(s->rmax, s->rmin, plane * 2);
+  for (int k = 1; k < s->levels; ++k) {
+    const int half = 1 << (k - 1), n = w - (1 << k) + 1;
+    for (int y = 0; y < h; ++y) {
+      size_t o = (size_t)y * w;
+      sparse_level(s->rmin + k * plane + o, s->rmax + k * plane + o,
+                   s->rmin + (k - 1) * plane + o, s->rmax + (k - 1) * plane + o, n, half);
+    }
+  }
+}
+
+static inline uint64_t sat_box(const uint64_t* t, size_t W1, int x0, int y0, int x1, int y1) {
+  return t[y1 * W1 + x1] - t[y0 * W1 + x1] - t[y1 * W1 + x0] + t[y0 * W1 + x0];
+}
+
+static inline void span_minmax(const tc001_roi_set* s, const tc001_frame* f, int rmq,
+                               int y, int x0, int x1, acc* a)
+{
+  if (!rmq) {
+    tc001__minmax_u16((const uint16_t*)(f->data + (size_t)y * f->stride) + x0,
+                      x1 - x0, &a->lo, &a->hi);
+    return;
+  }
+  const size_t plane = (size_t)s->w * s->h, o = (size_t)y * s->w;
+  const int k = s->lg[x1 - x0], x2 = x1 - (1 << k);
+  const uint16_t* mn = s->rmin + k * plane + o;
+  const uint16_t* mx = s->rmax + k * plane + o;
+  uint16_t lo = mn[x0] < mn[x2] ? mn[x0] : mn[x2];
+  uint16_t hi = mx[x0] > mx[x2] ? mx[x0] : mx[x2];
+  if (lo < a->lo) a->lo = lo;
+  if (hi > a->hi) a->hi = hi;
+}
+
+static void eval_tables(const tc001_roi_set* s, const roi* r, const tc001_frame* f,
+                        int rmq, acc* a)
+{
+  const size_t W1 = (size_t)s->w + 1;
+  if (r->kind == ROI_RECT) {
+    if (r->area == 0) return;
+    a->s  = sat_box(s->sat,  W1, r->x0, r->y0, r->x1, r->y1);
+    a->s2 = sat_box(s->sat2, W1, r->x0, r->y0, r->x1, r->y1);
+    a->n  = r->area;
+    for (int y = r->y0; y < r->y1; ++y) span_minmax(s, f, rmq, y, r->x0, r->x1, a);
+    return;
+  }
+  const span* sp = s->spans + r->first;
+  for (uint32_t i = 0; i < r->n; ++i) {
+    a->s  += sat_box(s->sat,  W1, sp[i].x0, sp[i].y, sp[i].x1, sp[i].y + 1);
+    a->s2 += sat_box(s->sat2, W1, sp[i].x0, sp[i].y, sp[i].x1, sp[i].y + 1);
+    span_minmax(s, f, rmq, sp[i].y, sp[i].x0, sp[i].x1, a);
+  }
+  a->n = r->area;
+}
+
+/* ===== Measurement ===== */
+static void acc_result(const acc* a, tc001_roi_stats* out) {
+  memset(out, 0, sizeof(*out));
+  if (a->n == 0) return;
+  double mean = (double)a->s / a->n;
+  double var = (double)a->s2 / a->n - mean * mean;
+  out->count = a->n;
+  out->min_raw = a->lo;
+  out->max_raw = a->hi;
+  out->mean_raw = (float)mean;
+  out->stddev_raw = (float)sqrt(var > 0.0 ? var : 0.0);
+}
+
+tc001_status tc001_roi_measure(tc001_roi_set* s, const tc001_frame* f,
+                               tc001_roi_stats* out, int out_count)
+{
+  if (!s || !f || !f->data || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width != s->w || f->height != s->h || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  if (s->n && (!out || out_count < (int)s->n)) return TC001_ERR_PARAM;
+
+  const uint64_t frame = (uint64_t)s->w * s->h;
+  const int tables = s->area > TABLES_COVER * frame;
+  const int rmq = s->area > RMQ_COVER * frame;
+  if (tables) {
+    tc001_status st = tables_alloc(s, rmq);
+    if (st != TC001_OK) return st;
+    tables_build(s, f, rmq);
+  }
+
+  for (size_t i = 0; i < s->n; ++i) {
+    acc a;
+    acc_init(&a);
+    if (tables) eval_tables(s, &s->rois[i], f, rmq, &a);
+    else eval_direct(s, &s->rois[i], f, &a);
+    acc_result(&a, &out[i]);
+  }
+  return TC001_OK;
+}
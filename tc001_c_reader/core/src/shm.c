@@ -0,0 +1,304 @@
+#include "tc001_shm.h"
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Segment layout, every part on its own cache line:
+
+     header     geometry, then the publish count, then the reader table
+     slot 0..   slot_header, then the frame rows (tightly packed)
+
+   The publisher is the only writer of the count and the slots; each
+   reader writes only its own table entry. */
+#define SHM_MAGIC   0x53314354u   /* "TC1S" little-endian */
+#define SHM_VERSION 1
+#define LINE        64
+#define SPIN_POLLS  256           /* count polls before sleeping */
+#define IDLE_NS     50000
+
+typedef struct {
+  tc001_atomic_int pid;     /* 0 = free */
+  tc001_atomic_int last_seq;
+  tc001_atomic_int dropped;
+  uint8_t _pad0[LINE - 3 * sizeof(tc001_atomic_int)];
+} reader_entry;
+
+typedef struct {
+  uint32_t magic, version;
+  uint32_t slots;
+  uint32_t slot_bytes;      /* slot stride, header included */
+  uint32_t width, height, row_bytes, format;
+  uint32_t header_bytes;    /* offset of slot 0 */
+  uint8_t  _pad0[LINE - 9 * sizeof(uint32_t)];
+  tc001_atomic_int count;   /* frames published */
+  uint8_t  _pad1[LINE - sizeof(tc001_atomic_int)];
+  reader_entry readers[TC001_SHM_MAX_READERS];
+} shm_header;
+
+typedef struct {
+  tc001_atomic_int lock;    /* odd while the slot is written */
+  tc001_atomic_int seq;     /* of the frame held */
+  int64_t  timestamp_ns;
+  uint32_t frame_id;
+  uint8_t  _pad0[LINE - 2 * sizeof(tc001_atomic_int) - sizeof(int64_t) - sizeof(uint32_t)];
+} slot_header;
+
+struct tc001_shm_pub {
+  tc001_shm_map map;
+  shm_header*   hdr;
+  char*         name;
+  uint32_t      count;
+};
+
+struct tc001_shm_sub {
+  tc001_shm_map map;
+  shm_header*   hdr;
+  reader_entry* me;
+  uint32_t      next;       /* sequence number tc001_shm_next returns */
+  uint32_t      dropped;
+};
+
+static size_t round_line(size_t n) { return (n + LINE - 1) & ~(size_t)(LINE - 1); }
+
+/* Sequence numbers wrap; they live in the segment as ints. */
+static uint32_t ld(tc001_atomic_int* p) { return (uint32_t)TC001_ATOMIC_LOAD(p); }
+static void     st(tc001_atomic_int* p, uint32_t v) { TC001_ATOMIC_STORE(p, (int)v); }
+
+static slot_header* slot_at(const shm_header* h, uint32_t seq) {
+  return (slot_header*)((uint8_t*)h + h->header_bytes + (size_t)(seq % h->slots) * h->slot_bytes);
+}
+
+static uint8_t* slot_data(slot_header* s) { return (uint8_t*)s + round_line(sizeof(slot_header)); }
+
+/* ===== Publisher ===== */
+tc001_status tc001_shm_pub_create(tc001_shm_pub** out, const tc001_shm_options* opts) {
+  if (!out || !opts || opts->width <= 0 || opts->height <= 0 || opts->slots < 0 || opts->slots == 1)
+    return TC001_ERR_PARAM;
+  const size_t bpp = opts->format == TC001_FMT_U8 ? 1 : opts->format == TC001_FMT_U16 ? 2
+                   : opts->format == TC001_FMT_RGB8 ? 3 : 0;
+  if (!bpp) return TC001_ERR_PARAM;
+  const uint32_t slots = opts->slots ? (uint32_t)opts->slots : 8;
+  const size_t row = (size_t)opts->width * bpp;
+  const size_t slot_bytes = round_line(sizeof(slot_header)) + round_line(row * opts->height);
+  const size_t header_bytes = round_line(sizeof(shm_header));
+  if (slot_bytes > UINT32_MAX) return TC001_ERR_PARAM;
+
+  tc001_shm_pub* p = (tc001_shm_pub*)calloc(1, sizeof(*p));
+  if (!p) return TC001_ERR_ALLOC;
+  if (opts->name) {
+    size_t n = strlen(opts->name) + 1;
+    if (!(p->name = (char*)malloc(n))) {
+      free(p);
+      return TC001_ERR_ALLOC;
+    }
+    memcpy(p->name, opts->name, n);
+  }
+  if (tc001__shm_create(opts->name, header_bytes + slots * slot_bytes, &p->map) != 0) {
+    free(p->name);
+    free(p);
+    return TC001_ERR_IO;
+  }
+
+  /* a new segment reads as zeros: every slot unlocked, no readers */
+  shm_header* h = p->hdr = (shm_header*)p->map.base;
+  h->version = SHM_VERSION;
+  h->slots = slots;
+  h->slot_bytes = (uint32_t)slot_bytes;
+  h->width = (uint32_t)opts->width;
+  h->height = (uint32_t)opts->height;
+  h->row_bytes = (uint32_t)row;
+  h->format = (uint32_t)opts->format;
+  h->header_bytes = (uint32_t)header_bytes;
+  TC001_ATOMIC_FENCE();
+  h->magic = SHM_MAGIC;     /* subscribers check it last */
+  *out = p;
+  return TC001_OK;
+}
+
+void tc001_shm_pub_destroy(tc001_shm_pub* p) {
+  if (!p) return;
+  tc001__shm_close(&p->map);
+  tc001__shm_unlink(p->name);
+  free(p->name);
+  free(p);
+}
+
+int tc001_shm_pub_fd(const tc001_shm_pub* p) { return p ? p->map.fd : -1; }
+
+uint32_t tc001_shm_pub_count(const tc001_shm_pub* p) { return p ? p->count : 0; }
+
+tc001_status tc001_shm_publish(tc001_shm_pub* p, const tc001_frame* f) {
+  if (!p || !f || !f->data) return TC001_ERR_PARAM;
+  shm_header* h = p->hdr;
+  if ((uint32_t)f->width != h->width || (uint32_t)f->height != h->height ||
+      (uint32_t)f->format != h->format || f->stride < (int)h->row_bytes)
+    return TC001_ERR_PARAM;
+
+  const uint32_t seq = p->count;
+  slot_header* s = slot_at(h, seq);
+  uint8_t* dst = slot_data(s);
+  const uint32_t lock = ld(&s->lock);
+  st(&s->lock, lock + 1);
+  TC001_ATOMIC_FENCE();     /* odd before any byte of the frame */
+  st(&s->seq, seq);
+  s->timestamp_ns = f->timestamp_ns;
+  s->frame_id = f->frame_id;
+  if ((uint32_t)f->stride == h->row_bytes) {
+    memcpy(dst, f->data, (size_t)h->row_bytes * h->height);
+  } else {
+    for (uint32_t y = 0; y < h->height; ++y)
+      memcpy(dst + (size_t)y * h->row_bytes, f->data + (size_t)y * f->stride, h->row_bytes);
+  }
+  st(&s->lock, lock + 2);
+  p->count = seq + 1;
+  st(&h->count, p->count);
+  return TC001_OK;
+}
+
+int tc001_shm_pub_readers(const tc001_shm_pub* p, tc001_shm_reader* out, int cap) {
+  if (!p) return 0;
+  shm_header* h = p->hdr;
+  int n = 0;
+  for (int i = 0; i < TC001_SHM_MAX_READERS; ++i) {
+    reader_entry* r = &h->readers[i];
+    const int pid = TC001_ATOMIC_LOAD(&r->pid);
+    if (!pid) continue;
+    if (!tc001__pid_alive(pid)) {
+      tc001__atomic_cas(&r->pid, pid, 0);   /* left by a process that died */
+      continue;
+    }
+    if (out && n < cap) {
+      tc001_shm_reader* o = &out[n];
+      o->pid = pid;
+      o->last_seq = ld(&r->last_seq);
+      o->lag = p->count - 1 - o->last_seq;
+      o->dropped = ld(&r->dropped);
+    }
+    ++n;
+  }
+  return n;
+}
+
+tc001_status tc001_enable_shm(tc001_handle* h, tc001_shm_pub* p) {
+  if (!h) return TC001_ERR_PARAM;
+  if (p && (p->hdr->format != TC001_FMT_U16 || p->hdr->width != (uint32_t)h->width ||
+            p->hdr->height != (uint32_t)h->height))
+    return TC001_ERR_PARAM;
+  h->shm = p;
+  return TC001_OK;
+}
+
+/* ===== Subscriber ===== */
+tc001_status tc001_shm_sub_open(tc001_shm_sub** out, const char* name, int fd) {
+  if (!out || (!name && fd < 0)) return TC001_ERR_PARAM;
+  tc001_shm_sub* s = (tc001_shm_sub*)calloc(1, sizeof(*s));
+  if (!s) return TC001_ERR_ALLOC;
+  if (tc001__shm_open(name, fd, &s->map) != 0) {
+    free(s);
+    return TC001_ERR_IO;
+  }
+  shm_header* h = s->hdr = (shm_header*)s->map.base;
+  if (s->map.size < sizeof(shm_header) || h->magic != SHM_MAGIC || h->version != SHM_VERSION ||
+      h->slots < 2 || (uint64_t)h->header_bytes + (uint64_t)h->slots * h->slot_bytes > s->map.size) {
+    tc001_shm_sub_close(s);
+    return TC001_ERR_PARAM;
+  }
+  TC001_ATOMIC_FENCE();     /* geometry after the magic */
+
+  const int pid = tc001__pid();
+  s->next = ld(&h->count);
+  for (int i = 0; i < TC001_SHM_MAX_READERS && !s->me; ++i) {
+    reader_entry* r = &h->readers[i];
+    if (TC001_ATOMIC_LOAD(&r->pid) == 0 && tc001__atomic_cas(&r->pid, 0, pid)) {
+      st(&r->last_seq, s->next - 1);
+      st(&r->dropped, 0);
+      s->me = r;
+    }
+  }
+  if (!s->me) {
+    tc001_shm_sub_close(s);
+    return TC001_ERR_STATE;
+  }
+  *out = s;
+  return TC001_OK;
+}
+
+void tc001_shm_sub_close(tc001_shm_sub* s) {
+  if (!s) return;
+  if (s->me) TC001_ATOMIC_STORE(&s->me->pid, 0);
+  tc001__shm_close(&s->map);
+  free(s);
+}
+
+/* Reads the header of the slot holding seq. 0 when that slot is being
+   written or already holds another frame. */
+static int read_slot(tc001_shm_sub* s, uint32_t seq, tc001_shm_view* v) {
+  shm_header* h = s->hdr;
+  slot_header* sl = slot_at(h, seq);
+  const uint32_t lock = ld(&sl->lock);
+  if (lock & 1) return 0;
+  const uint32_t held = ld(&sl->seq);
+  const int64_t ts = sl->timestamp_ns;
+  const uint32_t id = sl->frame_id;
+  TC001_ATOMIC_FENCE();
+  if (ld(&sl->lock) != lock || held != seq) return 0;
+
+  memset(v, 0, sizeof(*v));
+  v->frame.width = (int)h->width;
+  v->frame.height = (int)h->height;
+  v->frame.stride = (int)h->row_bytes;
+  v->frame.format = (tc001_format)h->format;
+  v->frame.timestamp_ns = ts;
+  v->frame.frame_id = id;
+  v->frame.data = slot_data(sl);
+  v->seq = seq;
+  v->lock = lock;
+
+  s->next = seq + 1;
+  st(&s->me->last_seq, seq);
+  return 1;
+}
+
+tc001_status tc001_shm_latest(tc001_shm_sub* s, tc001_shm_view* v) {
+  if (!s || !v) return TC001_ERR_PARAM;
+  /* a read only fails when the publisher laps the slot meanwhile */
+  for (int tries = 0; tries < 64; ++tries) {
+    const uint32_t count = ld(&s->hdr->count);
+    if (!count) return TC001_ERR_STATE;
+    if (read_slot(s, count - 1, v)) return TC001_OK;
+  }
+  return TC001_ERR_STATE;
+}
+
+tc001_status tc001_shm_next(tc001_shm_sub* s, tc001_shm_view* v, int64_t timeout_ns) {
+  if (!s || !v) return TC001_ERR_PARAM;
+  const uint32_t keep = s->hdr->slots - 1;   /* the newest slot may be in writing */
+  int64_t deadline = 0;
+  int polls = 0;
+  for (;;) {
+    const uint32_t count = ld(&s->hdr->count);
+    uint32_t want = s->next;
+    if ((int32_t)(count - want) > 0) {
+      if (count - want > keep) {
+        s->dropped += count - keep - want;
+        st(&s->me->dropped, s->dropped);
+        want = count - keep;
+      }
+      if (read_slot(s, want, v)) return TC001_OK;
+      s->next = want;
+      continue;             /* lapped while reading: the count has moved */
+    }
+    if (timeout_ns <= 0) return TC001_ERR_STATE;
+    if (++polls < SPIN_POLLS) continue;
+    const int64_t now = tc001__now_ns();
+    if (!deadline) deadline = now + timeout_ns;
+    else if (now >= deadline) return TC001_ERR_STATE;
+    tc001__sleep_ns(IDLE_NS);
+  }
+}
+
+int tc001_shm_view_valid(const tc001_shm_sub* s, const tc001_shm_view* v) {
+  if (!s || !v) return 0;
+  TC001_ATOMIC_FENCE();     /* the caller's reads of the pixels come first */
+  return ld(&slot_at(s->hdr, v->seq)->lock) == v->lock;
+}
@@ -0,0 +1,442 @@
+#include "tc001_snapshot.h"
+#include "tc001_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Every encoder checks dst_cap against tc001_snapshot_max_bytes up front
+   and then writes the file front to back without further checks. Rows are
+   produced in the file's sample order (BGR bottom-up for BMP, big-endian
+   for 16-bit PNM/PNG) by one row function per layout. */
+
+#define BMP_HDR   54
+#define PNM_HDR   32            /* "P5\n65535 65535\n65535\n" and margin */
+#define PNG_FIXED (8 + 25 + 12 + 2 + 4 + 12)   /* sig, IHDR, IDAT framing, zlib, IEND */
+#define STORED_MAX 65535
+
+typedef struct {
+  const uint8_t* data;
+  int w, h, stride;
+  int channels;             /* 1 gray, 3 RGB */
+  int bits;                 /* 8 or 16 */
+  uint16_t lo;              /* AGC, for 16-bit to BMP */
+  float    scale;
+} src_image;
+
+/* Per-thread growable buffers: rows or a filtered image, and whole files
+   for the _save functions. */
+typedef struct { uint8_t* p; size_t cap; } byte_buf;
+static TC001_THREAD_LOCAL byte_buf tls_work, tls_file;
+
+static uint8_t* buf_get(byte_buf* b, size_t n) {
+  if (n > b->cap) {
+    uint8_t* p = (uint8_t*)realloc(b->p, n);
+    if (!p) return NULL;
+    b->p = p;
+    b->cap = n;
+  }
+  return b->p;
+}
+
+static uint8_t* le32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+static uint8_t* le16(uint8_t* p, unsigned v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static uint8_t* be32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+  return p + 4;
+}
+
+/* ===== Rows ===== */
+static size_t file_row_bytes(const src_image* s) {
+  return (size_t)s->w * s->channels * (s->bits / 8);
+}
+
+/* Samples in file order: as stored for 8-bit, big-endian for 16-bit. */
+static void row_be(const src_image* s, int y, uint8_t* d) {
+  const uint8_t* r = s->data + (size_t)y * s->stride;
+  if (s->bits == 8) {
+    memcpy(d, r, (size_t)s->w * s->channels);
+    return;
+  }
+  const uint16_t* px = (const uint16_t*)r;
+  for (int x = 0; x < s->w; ++x) {
+    d[2 * x]     = (uint8_t)(px[x] >> 8);
+    d[2 * x + 1] = (uint8_t)px[x];
+  }
+}
+
+static void row_bgr(const src_image* s, int y, uint8_t* d) {
+  const uint8_t* r = s->data + (size_t)y * s->stride;
+  if (s->channels == 3) {
+    for (int x = 0; x < s->w; ++x, r += 3, d += 3) {
+      d[0] = r[2];
+      d[1] = r[1];
+      d[2] = r[0];
+    }
+  } else if (s->bits == 8) {
+    for (int x = 0; x < s->w; ++x, d += 3) d[0] = d[1] = d[2] = r[x];
+  } else {
+    const uint16_t* px = (const uint16_t*)r;
+    for (int x = 0; x < s->w; ++x, d += 3) d[0] = d[1] = d[2] = tc001__agc_u8(px[x], s->lo, s->scale);
+  }
+}
+
+/* ===== Checksums ===== */
+static uint32_t adler32(uint32_t adler, const uint8_t* p, size_t n) {
+  uint32_t a = adler & 0xFFFF, b = adler >> 16;
+  while (n) {
+    size_t k = n < 5552 ? n : 5552;   /* largest run without overflow (zlib NMAX) */
+    n -= k;
+    for (; k; --k) {
+      a += *p++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+/* ===== BMP ===== */
+static void encode_bmp(const src_image* s, uint8_t* dst, size_t* written) {
+  const size_t row = ((size_t)s->w * 3 + 3) & ~(size_t)3, data = row * s->h;
+  uint8_t* p = dst;
+  *p++ = 'B';
+  *p++ = 'M';
+  p = le32(p, (uint32_t)(BMP_HDR + data));
+  p = le32(p, 0);
+  p = le32(p, BMP_HDR);
+  p = le32(p, 40);
+  p = le32(p, (uint32_t)s->w);
+  p = le32(p, (uint32_t)s->h);        /* positive: bottom-up */
+  p = le16(p, 1);
+  p = le16(p, 24);
+  p = le32(p, 0);                     /* BI_RGB */
+  p = le32(p, (uint32_t)data);
+  p = le32(p, 2835);                  /* 72 dpi */
+  p = le32(p, 2835);
+  p = le32(p, 0);
+  p = le32(p, 0);
+  for (int y = 0; y < s->h; ++y) {
+    uint8_t* d = p + (size_t)(s->h - 1 - y) * row;
+    row_bgr(s, y, d);
+    memset(d + (size_t)s->w * 3, 0, row - (size_t)s->w * 3);
+  }
+  *written = BMP_HDR + data;
+}
+
+/* ===== PGM / PPM ===== */
+static void encode_pnm(const src_image* s, uint8_t* dst, size_t* written) {
+  int n = snprintf((char*)dst, PNM_HDR, "P%c\n%d %d\n%d\n", s->channels == 3 ? '6' : '5',
+                   s->w, s->h, s->bits == 16 ? 65535 : 255);
+  uint8_t* p = dst + n;
+  const size_t rb = file_row_bytes(s);
+  for (int y = 0; y < s->h; ++y, p += rb) row_be(s, y, p);
+  *written = (size_t)(p - dst);
+}
+
+/* ===== PNG ===== */
+static uint8_t* png_chunk_end(uint8_t* start, uint8_t* end) {
+  /* start: the length field; type and data follow */
+  const size_t len = (size_t)(end - start) - 8;
+  be32(start, (uint32_t)len);
+  return be32(end, tc001__crc32(0, start + 4, len + 4));
+}
+
+/* Filter-None scanlines in deflate stored blocks. */
+static tc001_status deflate_stored(const src_image* s, uint8_t** pp, uint32_t* adler) {
+  const size_t rb = file_row_bytes(s);
+  uint8_t* row = buf_get(&tls_work, rb + 1);
+  if (!row) return TC001_ERR_ALLOC;
+  uint8_t* p = *pp;
+  size_t total = (size_t)s->h * (rb + 1), left = 0;
+  uint32_t a = 1;
+  row[0] = 0;
+  for (int y = 0; y < s->h; ++y) {
+    row_be(s, y, row + 1);
+    a = adler32(a, row, rb + 1);
+    for (size_t off = 0; off < rb + 1;) {
+      if (!left) {
+        left = total < STORED_MAX ? total : STORED_MAX;
+        total -= left;
+        *p++ = total ? 0 : 1;          /* BFINAL on the last block, BTYPE 00 */
+        p = le16(p, (unsigned)left);
+        p = le16(p, (unsigned)~left & 0xFFFF);
+      }
+      size_t k = rb + 1 - off < left ? rb + 1 - off : left;
+      memcpy(p, row + off, k);
+      p += k;
+      off += k;
+      left -= k;
+    }
+  }
+  *pp = p;
+  *adler = a;
+  return TC001_OK;
+}
+
+/* LSB-first bit writer for deflate. */
+typedef struct {
+  uint8_t* p;
+  uint64_t acc;
+  int      n;
+} lsb_writer;
+
+static inline void lsb_put(lsb_writer* b, uint32_t bits, int len) {
+  b->acc |= (uint64_t)bits << b->n;
+  b->n += len;
+  if (b->n >= 32) {
+    b->p = le32(b->p, (uint32_t)b->acc);
+    b->acc >>= 32;
+    b->n -= 32;
+  }
+}
+
+static void lsb_flush(lsb_writer* b) {
+  for (; b->n > 0; b->n -= 8, b->acc >>= 8) *b->p++ = (uint8_t)b->acc;
+  b->n = 0;
+}
+
+static unsigned bit_reverse(unsigned v, int len) {
+  unsigned r = 0;
+  for (int i = 0; i < len; ++i, v >>= 1) r = (r << 1) | (v & 1);
+  return r;
+}
+
+/* Sub-filtered scanlines as one fixed-Huffman block whose only matches
+   are runs (distance 1), like zlib's Z_RLE strategy. */
+static tc001_status deflate_rle(const src_image* s, uint8_t** pp, uint32_t* adler) {
+  static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+  };
+  static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+  };
+  const size_t rb = file_row_bytes(s), n = (size_t)s->h * (rb + 1);
+  const int bpp = s->channels * (s->bits / 8);
+  uint8_t* f = buf_get(&tls_work, n);
+  if (!f) return TC001_ERR_ALLOC;
+
+  /* filtered image, Sub computed in place right to left */
+  for (int y = 0; y < s->h; ++y) {
+    uint8_t* r = f + (size_t)y * (rb + 1);
+    r[0] = 1;
+    row_be(s, y, r + 1);
+    for (size_t x = rb; x > (size_t)bpp; --x) r[x] = (uint8_t)(r[x] - r[x - bpp]);
+  }
+  *adler = adler32(1, f, n);
+
+  /* fixed codes (RFC 1951 3.2.6), reversed for LSB-first output */
+  uint16_t lit[256];
+  uint8_t  lit_len[256];
+  uint32_t run[259];                  /* length code, extra bits, distance 1 */
+  uint8_t  run_len[259];
+  for (int v = 0; v < 256; ++v) {
+    lit[v] = (uint16_t)(v < 144 ? bit_reverse(0x30 + v, 8) : bit_reverse(0x190 + v - 144, 9));
+    lit_len[v] = v < 144 ? 8 : 9;
+  }
+  for (int sym = 0, l = 3; l <= 258; ++l) {
+    while (sym < 28 && l >= len_base[sym + 1]) ++sym;
+    const int code = 257 + sym, eb = len_extra[sym];
+    const int cl = code < 280 ? 7 : 8;
+    const unsigned c = code < 280 ? bit_reverse(code - 256, 7) : bit_reverse(0xC0 + code - 280, 8);
+    run[l] = c | (uint32_t)(l - len_base[sym]) << cl;   /* distance code 0: five zero bits */
+    run_len[l] = (uint8_t)(cl + eb + 5);
+  }
+
+  lsb_writer b = { *pp, 0, 0 };
+  lsb_put(&b, 3, 3);                  /* BFINAL, BTYPE 01 */
+  for (size_t i = 0; i < n;) {
+    const uint8_t v = f[i];
+    lsb_put(&b, lit[v], lit_len[v]);
+    size_t r = 0, max = n - i - 1 < 258 ? n - i - 1 : 258;
+    while (r < max && f[i + 1 + r] == v) ++r;
+    if (r >= 3) {
+      lsb_put(&b, run[r], run_len[r]);
+      i += 1 + r;
+    } else {
+      i += 1;
+    }
+  }
+  lsb_put(&b, 0, 7);                  /* end of block */
+  lsb_flush(&b);
+  *pp = b.p;
+  return TC001_OK;
+}
+
+static tc001_status encode_png(const src_image* s, int rle, uint8_t* dst, size_t* written) {
+  static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  uint8_t* p = dst;
+  memcpy(p, sig, 8);
+  p += 8;
+
+  uint8_t* c = p;
+  p = be32(p + 4, 0x49484452u);       /* IHDR */
+  p = be32(p, (uint32_t)s->w);
+  p = be32(p, (uint32_t)s->h);
+  *p++ = (uint8_t)s->bits;
+  *p++ = s->channels == 3 ? 2 : 0;    /* truecolour or grayscale */
+  *p++ = 0;
+  *p++ = 0;
+  *p++ = 0;
+  p = png_chunk_end(c, p);
+
+  c = p;
+  p = be32(p + 4, 0x49444154u);       /* IDAT */
+  *p++ = 0x78;                        /* zlib: deflate, 32K window */
+  *p++ = 0x01;
+  uint32_t adler;
+  tc001_status st = rle ? deflate_rle(s, &p, &adler) : deflate_stored(s, &p, &adler);
+  if (st != TC001_OK) return st;
+  p = be32(p, adler);
+  p = png_chunk_end(c, p);
+
+  c = p;
+  p = be32(p + 4, 0x49454E44u);       /* IEND */
+  p = png_chunk_end(c, p);
+  *written = (size_t)(p - dst);
+  return TC001_OK;
+}
+
+/* ===== Entry points ===== */
+size_t tc001_snapshot_max_bytes(int width, int height, tc001_format format,
+                                int channels, tc001_snap_format fmt) {
+  if (width <= 0 || height <= 0 || (channels != 1 && channels != 3)) return 0;
+  const size_t bps = format == TC001_FMT_U16 && channels == 1 ? 2 : 1;
+  const size_t rb = (size_t)width * channels * bps, raw = (size_t)height * (rb + 1);
+  switch (fmt) {
+    case TC001_SNAP_BMP:
+      return BMP_HDR + (((size_t)width * 3 + 3) & ~(size_t)3) * height;
+    case TC001_SNAP_PNM:
+      return PNM_HDR + rb * height;
+    case TC001_SNAP_PNG:
+      return PNG_FIXED + raw + 5 * ((raw + STORED_MAX - 1) / STORED_MAX);
+    case TC001_SNAP_PNG_RLE:
+      /* 9 bits per literal at worst, plus a partly filled word */
+      return PNG_FIXED + raw + raw / 8 + 16;
+  }
+  return 0;
+}
+
+static tc001_status encode(const src_image* s, tc001_snap_format fmt,
+                           void* dst, size_t dst_cap, size_t* written) {
+  const size_t need = tc001_snapshot_max_bytes(s->w, s->h,
+                                               s->bits == 16 ? TC001_FMT_U16 : TC001_FMT_U8,
+                                               s->channels, fmt);
+  if (!need || !dst || !written || dst_cap < need) return TC001_ERR_PARAM;
+  switch (fmt) {
+    case TC001_SNAP_BMP:
+      encode_bmp(s, (uint8_t*)dst, written);
+      return TC001_OK;
+    case TC001_SNAP_PNM:
+      encode_pnm(s, (uint8_t*)dst, written);
+      return TC001_OK;
+    case TC001_SNAP_PNG:
+    case TC001_SNAP_PNG_RLE:
+      return encode_png(s, fmt == TC001_SNAP_PNG_RLE, (uint8_t*)dst, written);
+  }
+  return TC001_ERR_PARAM;
+}
+
+static tc001_status frame_image(const tc001_frame* f, tc001_snap_format fmt, src_image* s) {
+  if (!f || !f->data || f->width <= 0 || f->height <= 0 || f->width > 65535 || f->height > 65535)
+    return TC001_ERR_PARAM;
+  const int bits = f->format == TC001_FMT_U16 ? 16 : 8;
+  if ((f->format != TC001_FMT_U8 && f->format != TC001_FMT_U16) ||
+      f->stride < f->width * (bits / 8))
+    return TC001_ERR_PARAM;
+  memset(s, 0, sizeof(*s));
+  s->data = f->data;
+  s->w = f->width;
+  s->h = f->height;
+  s->stride = f->stride;
+  s->channels = 1;
+  s->bits = bits;
+  if (bits == 16 && fmt == TC001_SNAP_BMP) {
+    uint16_t lo = 65535, hi = 0;
+    if (f->stats) {
+      lo = f->stats->raw_min;
+      hi = f->stats->raw_max;
+    } else {
+      for (int y = 0; y < s->h; ++y)
+        tc001__minmax_u16((const uint16_t*)(s->data + (size_t)y * s->stride), s->w, &lo, &hi);
+    }
+    s->lo = lo;
+    s->scale = tc001__agc_scale(lo, hi);
+  }
+  return TC001_OK;
+}
+
+static tc001_status rgb_image(const uint8_t* rgb, int width, int height, int pitch, src_image* s) {
+  if (!rgb || width <= 0 || height <= 0 || width > 65535 || height > 65535 || pitch < width * 3)
+    return TC001_ERR_PARAM;
+  memset(s, 0, sizeof(*s));
+  s->data = rgb;
+  s->w = width;
+  s->h = height;
+  s->stride = pitch;
+  s->channels = 3;
+  s->bits = 8;
+  return TC001_OK;
+}
+
+tc001_status tc001_snapshot_encode(const tc001_frame* f, tc001_snap_format fmt,
+                                   void* dst, size_t dst_cap, size_t* written) {
+  src_image s;
+  tc001_status st = frame_image(f, fmt, &s);
+  return st != TC001_OK ? st : encode(&s, fmt, dst, dst_cap, written);
+}
+
+tc001_status tc001_snapshot_encode_rgb(const uint8_t* rgb, int width, int height, int pitch,
+                                       tc001_snap_format fmt,
+                                       void* dst, size_t dst_cap, size_t* written) {
+  src_image s;
+  tc001_status st = rgb_image(rgb, width, height, pitch, &s);
+  return st != TC001_OK ? st : encode(&s, fmt, dst, dst_cap, written);
+}
+
+static tc001_status save(const char* path, const src_image* s, tc001_snap_format fmt) {
+  const size_t cap = tc001_snapshot_max_bytes(s->w, s->h,
+                                              s->bits == 16 ? TC001_FMT_U16 : TC001_FMT_U8,
+                                              s->channels, fmt);
+  if (!path || !cap) return TC001_ERR_PARAM;
+  uint8_t* buf = buf_get(&tls_file, cap);
+  if (!buf) return TC001_ERR_ALLOC;
+  size_t n;
+  tc001_status st = encode(s, fmt, buf, cap, &n);
+  if (st != TC001_OK) return st;
+  int fd = tc001__file_open(path, 1);
+  if (fd < 0) return TC001_ERR_IO;
+  int rc = tc001__file_pwrite(fd, buf, n, 0);
+  tc001__file_close(fd);
+  return rc == 0 ? TC001_OK : TC001_ERR_IO;
+}
+
+tc001_status tc001_snapshot_save(const char* path, const tc001_frame* f, tc001_snap_format fmt) {
+  src_image s;
+  tc001_status st = frame_image(f, fmt, &s);
+  return st != TC001_OK ? st : save(path, &s, fmt);
+}
+
+tc001_status tc001_snapshot_save_rgb(const char* path, const uint8_t* rgb,
+                                     int width, int height, int pitch, tc001_snap_format fmt) {
+  src_image s;
+  tc001_status st = rgb_image(rgb, width, height, pitch, &s);
+  return st != TC001_OK ? st : save(path, &s, fmt);
+}
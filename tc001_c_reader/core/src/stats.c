@@ -0,0 +1,229 @@
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ===== Scratch ===== */
+int tc001__stats_scratch_init(tc001_stats_scratch* s) {
+  if (s->fine) return 0;
+  s->fine = (uint32_t*)calloc(TC001_HIST_BINS, sizeof(uint32_t));
+  return s->fine ? 0 : -1;
+}
+
+void tc001__stats_scratch_free(tc001_stats_scratch* s) {
+  free(s->fine);
+  tc001__thumb_plan_free(&s->thumb);
+  memset(s, 0, sizeof(*s));
+}
+
+/* ===== Pixel pass ===== */
+/* Min/max run in vector registers; the histogram scatter is inherently
+   scalar, so it is interleaved with the vector loads on the same row. The
+   optional copy and thumbnail downscale reuse the row while it is in L1. */
+tc001_status tc001__stats_scan(tc001_stats_scratch* s,
+                               const uint8_t* base, int w, int h, int stride,
+                               const tc001_scan_opts* opts,
+                               uint16_t* lo_out, uint16_t* hi_out)
+{
+  uint32_t* fine = s->fine;
+  uint16_t lo = 0xFFFF, hi = 0;
+  uint8_t* copy_to = opts ? opts->copy_to : NULL;
+  int thumb = 0;
+
+  if (opts && opts->thumb_w > 0 && opts->thumb_h > 0) {
+    tc001_status st = tc001__thumb_plan_init(&s->thumb, w, h, opts->thumb_w, opts->thumb_h);
+    if (st != TC001_OK) return st;
+    thumb = 1;
+  }
+
+#if defined(TC001_SSE2)
+  /* SSE2 only has signed 16-bit min/max: bias by 0x8000 to compare unsigned */
+  const __m128i bias = _mm_set1_epi16((short)0x8000);
+  __m128i vmin = _mm_set1_epi16(0x7FFF);
+  __m128i vmax = _mm_set1_epi16((short)0x8000);
+#elif defined(TC001_NEON)
+  uint16x8_t vmin = vdupq_n_u16(0xFFFF);
+  uint16x8_t vmax = vdupq_n_u16(0);
+#endif
+
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* p = (const uint16_t*)(base + (size_t)y * stride);
+    uint16_t* c = copy_to ? (uint16_t*)(copy_to + (size_t)y * w * 2) : NULL;
+    int x = 0;
+#if defined(TC001_SSE2)
+    for (; x + 8 <= w; x += 8) {
+      __m128i raw = _mm_loadu_si128((const __m128i*)(p + x));
+      __m128i v = _mm_xor_si128(raw, bias);
+      vmin = _mm_min_epi16(vmin, v);
+      vmax = _mm_max_epi16(vmax, v);
+      if (c) _mm_storeu_si128((__m128i*)(c + x), raw);
+      fine[p[x+0]]++; fine[p[x+1]]++; fine[p[x+2]]++; fine[p[x+3]]++;
+      fine[p[x+4]]++; fine[p[x+5]]++; fine[p[x+6]]++; fine[p[x+7]]++;
+    }
+#elif defined(TC001_NEON)
+    for (; x + 8 <= w; x += 8) {
+      uint16x8_t v = vld1q_u16(p + x);
+      vmin = vminq_u16(vmin, v);
+      vmax = vmaxq_u16(vmax, v);
+      if (c) vst1q_u16(c + x, v);
+      fine[p[x+0]]++; fine[p[x+1]]++; fine[p[x+2]]++; fine[p[x+3]]++;
+      fine[p[x+4]]++; fine[p[x+5]]++; fine[p[x+6]]++; fine[p[x+7]]++;
+    }
+#endif
+    for (; x < w; ++x) {
+      uint16_t v = p[x];
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+      if (c) c[x] = v;
+      fine[v]++;
+    }
+
+    if (thumb) tc001__thumb_row(&s->thumb, y, p);
+  }
+
+#if defined(TC001_SSE2)
+  uint16_t mn[8], mx[8];
+  _mm_storeu_si128((__m128i*)mn, _mm_xor_si128(vmin, bias));
+  _mm_storeu_si128((__m128i*)mx, _mm_xor_si128(vmax, bias));
+  for (int i = 0; i < 8; ++i) {
+    if (mn[i] < lo) lo = mn[i];
+    if (mx[i] > hi) hi = mx[i];
+  }
+#elif defined(TC001_NEON)
+  uint16_t vlo = vminvq_u16(vmin), vhi = vmaxvq_u16(vmax);
+  if (vlo < lo) lo = vlo;
+  if (vhi > hi) hi = vhi;
+#endif
+
+  *lo_out = lo;
+  *hi_out = hi;
+  return TC001_OK;
+}
+
+void tc001__minmax_u16(const uint16_t* px, int n, uint16_t* lo_io, uint16_t* hi_io) {
+  uint16_t lo = *lo_io, hi = *hi_io;
+  int i = 0;
+#if defined(TC001_SSE2)
+  const __m128i bias = _mm_set1_epi16((short)0x8000);
+  __m128i vmin = _mm_set1_epi16(0x7FFF);
+  __m128i vmax = _mm_set1_epi16((short)0x8000);
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(px + i)), bias);
+    vmin = _mm_min_epi16(vmin, v);
+    vmax = _mm_max_epi16(vmax, v);
+  }
+  uint16_t mn[8], mx[8];
+  _mm_storeu_si128((__m128i*)mn, _mm_xor_si128(vmin, bias));
+  _mm_storeu_si128((__m128i*)mx, _mm_xor_si128(vmax, bias));
+  for (int k = 0; k < 8 && n >= 8; ++k) {
+    if (mn[k] < lo) lo = mn[k];
+    if (mx[k] > hi) hi = mx[k];
+  }
+#elif defined(TC001_NEON)
+  if (n >= 8) {
+    uint16x8_t vmin = vdupq_n_u16(0xFFFF), vmax = vdupq_n_u16(0);
+    for (; i + 8 <= n; i += 8) {
+      uint16x8_t v = vld1q_u16(px + i);
+      vmin = vminq_u16(vmin, v);
+      vmax = vmaxq_u16(vmax, v);
+    }
+    uint16_t vlo = vminvq_u16(vmin), vhi = vmaxvq_u16(vmax);
+    if (vlo < lo) lo = vlo;
+    if (vhi > hi) hi = vhi;
+  }
+#endif
+  for (; i < n; ++i) {
+    if (px[i] < lo) lo = px[i];
+    if (px[i] > hi) hi = px[i];
+  }
+  *lo_io = lo;
+  *hi_io = hi;
+}
+
+/* ===== Histogram reduction ===== */
+void tc001__stats_finish(tc001_stats_scratch* s, uint32_t count,
+                         uint16_t lo, uint16_t hi, tc001_frame_stats* out)
+{
+  uint32_t* fine = s->fine;
+  uint32_t coarse[256];
+
+  memset(out, 0, sizeof(*out));
+  if (count == 0) return;
+
+  out->raw_min = lo;
+  out->raw_max = hi;
+  /* 0 and 0xFFFF are the sensor's dead/saturated codes */
+  out->bad_pixel_count = fine[0] + fine[0xFFFF];
+
+  /* Walk only the occupied range: builds the coarse (v >> 8) histogram for
+     the percentile search and the AGC'd preview histogram in one sweep. */
+  memset(coarse, 0, sizeof(coarse));
+  float scale = tc001__agc_scale(lo, hi);
+  for (uint32_t v = lo; v <= hi; ++v) {
+    uint32_t c = fine[v];
+    if (!c) continue;
+    coarse[v >> 8] += c;
+    out->hist256[tc001__agc_u8((uint16_t)v, lo, scale)] += c;
+  }
+
+  /* Coarse-to-fine percentile search: skip whole 256-value blocks, then
+     resolve the exact raw value inside the block that holds the rank.
+     Ranks are nearest-rank over count-1, ascending, so one sweep serves all. */
+  static const uint32_t pct[3] = { 10, 50, 90 };
+  uint16_t res[3];
+  uint32_t cum = 0;
+  uint32_t b = lo >> 8;
+  for (int k = 0; k < 3; ++k) {
+    uint32_t rank = (uint32_t)(((uint64_t)(count - 1) * pct[k] + 50) / 100);
+    while (b < (uint32_t)(hi >> 8) && cum + coarse[b] <= rank) cum += coarse[b++];
+    uint32_t v = b << 8;
+    if (v < lo) v = lo;
+    uint32_t c = cum;
+    while (v < hi && c + fine[v] <= rank) c += fine[v++];
+    res[k] = (uint16_t)v;
+  }
+  out->p10_raw    = res[0];
+  out->median_raw = res[1];
+  out->p90_raw    = res[2];
+
+  memset(fine + lo, 0, ((size_t)hi - lo + 1) * sizeof(uint32_t));
+}
+
+/* Raw value at a nearest-rank position, walking the fine histogram from
+   whichever end of [lo, hi] is closer; tails are short in practice. Call
+   before tc001__stats_finish clears the bins. */
+uint16_t tc001__stats_rank(const tc001_stats_scratch* s, uint32_t count,
+                           uint16_t lo, uint16_t hi, uint32_t rank)
+{
+  const uint32_t* fine = s->fine;
+  if (rank >= count) rank = count ? count - 1 : 0;
+  if (rank < count / 2) {
+    uint32_t v = lo, c = 0;
+    while (v < hi && c + fine[v] <= rank) c += fine[v++];
+    return (uint16_t)v;
+  }
+  uint32_t v = hi, c = 0, from_top = count - 1 - rank;
+  while (v > lo && c + fine[v] <= from_top) c += fine[v--];
+  return (uint16_t)v;
+}
+
+/* ===== Public API ===== */
+/* Scratch for callers without a handle. The histogram stays zeroed between
+   calls, so each thread pays the 256 KB allocation once. */
+static TC001_THREAD_LOCAL tc001_stats_scratch tls_scratch;
+
+tc001_stats_scratch* tc001__stats_tls_scratch(void) {
+  return tc001__stats_scratch_init(&tls_scratch) == 0 ? &tls_scratch : NULL;
+}
+
+tc001_status tc001_compute_stats(const tc001_frame* f, tc001_frame_stats* out) {
+  if (!f || !out || !f->data || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width <= 0 || f->height <= 0 || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  tc001_stats_scratch* s = tc001__stats_tls_scratch();
+  if (!s) return TC001_ERR_ALLOC;
+
+  uint16_t lo, hi;
+  tc001__stats_scan(s, f->data, f->width, f->height, f->stride, NULL, &lo, &hi);
+  tc001__stats_finish(s, (uint32_t)f->width * (uint32_t)f->height, lo, hi, out);
+  return TC001_OK;
+}
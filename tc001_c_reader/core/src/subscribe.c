@@ -0,0 +1,439 @@
+#include "tc001_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Frame fan-out. The capture thread walks the subscriber list once per
+   frame under a spin lock, converting lazily: the AGC plane and each
+   palette's RGB plane are filled by the first subscriber that needs them
+   and reused by the rest. An inline subscriber gets a view into those
+   planes (its region is an offset and a stride); a threaded one gets its
+   region copied into a slot of its own, a triple buffer for
+   TC001_SUB_LATEST and a single-producer ring for TC001_SUB_QUEUE. */
+
+#define DEFAULT_QUEUE 4
+#define IDLE_NS       100000LL    /* worker poll when nothing is pending */
+#define LOCK_NS       50000LL     /* tc001_subscribe while a frame is out */
+#define FRESH         4           /* LATEST: middle slot not yet taken */
+
+/* One whole-frame conversion, shared by every subscriber with the same
+   format and palette. */
+typedef struct {
+  tc001_format format;
+  int      has_palette;
+  uint8_t  palette[768];
+  uint8_t  pal4[256][4];    /* padded for 4-byte stores */
+  uint8_t* buf;
+  size_t   cap;
+  uint32_t done;            /* fanout frame the plane was filled for */
+  int      refs;
+} conv;
+
+typedef struct {
+  tc001_frame       f;
+  tc001_frame_stats stats;
+  uint8_t*          buf;
+} sub_slot;
+
+struct tc001_subscription {
+  tc001_frame_cb cb;
+  void*    user;
+  int      decimation;
+  uint32_t tick;
+  int      x, y, w, h;
+  int      bpp;
+  conv*    conv;            /* NULL for U16 */
+  tc001_sub_policy policy;
+  int      dead;            /* removed from a callback, freed after the frame */
+  struct tc001_subscription* next_dead;
+
+  /* threaded delivery */
+  sub_slot* slots;
+  int       nslots;
+  tc001_atomic_int head, tail;    /* QUEUE */
+  tc001_atomic_int middle;        /* LATEST: slot index | FRESH */
+  int       back, front;
+  tc001_atomic_int stop;
+  int       started;
+
+  tc001_atomic_i64 delivered, dropped, skipped;
+
+#ifdef _WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+};
+
+struct tc001_fanout {
+  tc001_subscription** subs;
+  int      n, cap;
+  conv**   convs;
+  int      nconv, conv_cap;
+  uint8_t* u8;              /* AGC plane, width bytes per row */
+  size_t   u8_cap;
+  uint32_t u8_done;
+  uint32_t frame;           /* frames fanned out, from 1 */
+};
+
+/* the handle whose subscribers this thread is calling, if any */
+static TC001_THREAD_LOCAL struct tc001_handle* dispatching;
+
+static void lock(struct tc001_handle* h) {
+  while (!tc001__atomic_cas(&h->sub_lock, 0, 1)) tc001__sleep_ns(LOCK_NS);
+}
+
+static void unlock(struct tc001_handle* h) {
+  TC001_ATOMIC_STORE(&h->sub_lock, 0);
+}
+
+static void bump(tc001_atomic_i64* c) {
+  TC001_ATOMIC_STORE64(c, TC001_ATOMIC_LOAD64(c) + 1);
+}
+
+static int grow(uint8_t** p, size_t* cap, size_t n) {
+  if (*cap >= n) return 1;
+  uint8_t* q = (uint8_t*)realloc(*p, n);
+  if (!q) return 0;
+  *p = q;
+  *cap = n;
+  return 1;
+}
+
+/* ===== Shared conversions ===== */
+static const uint8_t* u8_plane(struct tc001_fanout* fo, const tc001_frame* f) {
+  if (fo->u8_done == fo->frame) return fo->u8;
+  const int w = f->width, h = f->height;
+  if (!grow(&fo->u8, &fo->u8_cap, (size_t)w * h)) return NULL;
+  uint16_t lo = 65535, hi = 0;
+  if (f->stats) {
+    lo = f->stats->raw_min;
+    hi = f->stats->raw_max;
+  } else {
+    for (int y = 0; y < h; ++y)
+      tc001__minmax_u16((const uint16_t*)(f->data + (size_t)y * f->stride), w, &lo, &hi);
+  }
+  const float scale = tc001__agc_scale(lo, hi);
+  for (int y = 0; y < h; ++y) {
+    const uint16_t* s = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    uint8_t* d = fo->u8 + (size_t)y * w;
+    for (int x = 0; x < w; ++x) d[x] = tc001__agc_u8(s[x], lo, scale);
+  }
+  fo->u8_done = fo->frame;
+  return fo->u8;
+}
+
+/* The subscriber's plane for this frame and its stride. */
+static const uint8_t* plane(struct tc001_fanout* fo, const tc001_subscription* s,
+                            const tc001_frame* f, int* stride) {
+  if (!s->conv) {
+    *stride = f->stride;
+    return f->data;
+  }
+  const uint8_t* g = u8_plane(fo, f);
+  if (!g) return NULL;
+  conv* c = s->conv;
+  const size_t n = (size_t)f->width * f->height;
+  if (c->format == TC001_FMT_RGB8 && c->done != fo->frame) {
+    if (!grow(&c->buf, &c->cap, n * 3 + 1)) return NULL;
+    const uint8_t (*pal)[4] = c->pal4;
+    uint8_t* d = c->buf;
+    for (size_t i = 0; i < n; ++i, d += 3) memcpy(d, pal[g[i]], 4);
+    c->done = fo->frame;
+  }
+  *stride = f->width * s->bpp;
+  return c->format == TC001_FMT_RGB8 ? c->buf : g;
+}
+
+static conv* conv_get(struct tc001_fanout* fo, tc001_format format, const uint8_t* palette) {
+  for (int i = 0; i < fo->nconv; ++i) {
+    conv* c = fo->convs[i];
+    if (c->format != format || c->has_palette != (palette != NULL)) continue;
+    if (palette && memcmp(c->palette, palette, sizeof(c->palette))) continue;
+    c->refs++;
+    return c;
+  }
+  if (fo->nconv == fo->conv_cap) {
+    const int cap = fo->conv_cap ? fo->conv_cap * 2 : 4;
+    conv** p = (conv**)realloc(fo->convs, (size_t)cap * sizeof(*p));
+    if (!p) return NULL;
+    fo->convs = p;
+    fo->conv_cap = cap;
+  }
+  conv* c = (conv*)calloc(1, sizeof(*c));
+  if (!c) return NULL;
+  c->format = format;
+  c->has_palette = palette != NULL;
+  if (palette) memcpy(c->palette, palette, sizeof(c->palette));
+  else for (int i = 0; i < 256; ++i) memset(c->palette + 3 * i, i, 3);
+  for (int i = 0; i < 256; ++i) memcpy(c->pal4[i], c->palette + 3 * i, 3);
+  c->refs = 1;
+  fo->convs[fo->nconv++] = c;
+  return c;
+}
+
+static void conv_put(struct tc001_fanout* fo, conv* c) {
+  if (!c || --c->refs > 0) return;
+  for (int i = 0; i < fo->nconv; ++i) {
+    if (fo->convs[i] != c) continue;
+    fo->convs[i] = fo->convs[--fo->nconv];
+    break;
+  }
+  free(c->buf);
+  free(c);
+}
+
+/* ===== Subscriber threads ===== */
+static void copy_view(sub_slot* sl, const tc001_frame* v, int bpp) {
+  const size_t row = (size_t)v->width * bpp;
+  for (int y = 0; y < v->height; ++y)
+    memcpy(sl->buf + y * row, v->data + (size_t)y * v->stride, row);
+  sl->f = *v;
+  sl->f.data = sl->buf;
+  sl->f.stride = (int)row;
+  sl->f.blobs = NULL;
+  sl->f.blob_count = 0;
+  sl->f.ref = NULL;
+  if (v->stats) {
+    sl->stats = *v->stats;
+    sl->f.stats = &sl->stats;
+  }
+}
+
+static void push(tc001_subscription* s, const tc001_frame* v) {
+  if (s->policy == TC001_SUB_QUEUE) {
+    const int head = TC001_ATOMIC_LOAD(&s->head);
+    const int next = (head + 1) % s->nslots;
+    if (next == TC001_ATOMIC_LOAD(&s->tail)) { bump(&s->dropped); return; }
+    copy_view(&s->slots[head], v, s->bpp);
+    TC001_ATOMIC_STORE(&s->head, next);
+    return;
+  }
+  /* LATEST: fill the back slot, swap it into the middle */
+  copy_view(&s->slots[s->back], v, s->bpp);
+  int old;
+  do old = TC001_ATOMIC_LOAD(&s->middle);
+  while (!tc001__atomic_cas(&s->middle, old, s->back | FRESH));
+  if (old & FRESH) bump(&s->dropped);
+  s->back = old & ~FRESH;
+}
+
+/* The next pending slot, or NULL. */
+static sub_slot* take(tc001_subscription* s) {
+  if (s->policy == TC001_SUB_QUEUE) {
+    const int tail = TC001_ATOMIC_LOAD(&s->tail);
+    return tail == TC001_ATOMIC_LOAD(&s->head) ? NULL : &s->slots[tail];
+  }
+  for (;;) {
+    const int old = TC001_ATOMIC_LOAD(&s->middle);
+    if (!(old & FRESH)) return NULL;
+    if (tc001__atomic_cas(&s->middle, old, s->front)) {
+      s->front = old & ~FRESH;
+      return &s->slots[s->front];
+    }
+  }
+}
+
+static void release(tc001_subscription* s) {
+  if (s->policy == TC001_SUB_QUEUE)
+    TC001_ATOMIC_STORE(&s->tail, (TC001_ATOMIC_LOAD(&s->tail) + 1) % s->nslots);
+}
+
+static void sub_run(tc001_subscription* s) {
+  while (!TC001_ATOMIC_LOAD(&s->stop)) {
+    sub_slot* sl = take(s);
+    if (!sl) { tc001__sleep_ns(IDLE_NS); continue; }
+    s->cb(&sl->f, s->user);
+    release(s);
+    bump(&s->delivered);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sub_loop(LPVOID p) { sub_run((tc001_subscription*)p); return 0; }
+#else
+static void* sub_loop(void* p) { sub_run((tc001_subscription*)p); return NULL; }
+#endif
+
+static void sub_free(tc001_subscription* s) {
+  if (s->started) {
+    TC001_ATOMIC_STORE(&s->stop, 1);
+#ifdef _WIN32
+    WaitForSingleObject(s->thread, INFINITE);
+    CloseHandle(s->thread);
+#else
+    pthread_join(s->thread, NULL);
+#endif
+  }
+  if (s->slots) {
+    for (int i = 0; i < s->nslots; ++i) free(s->slots[i].buf);
+    free(s->slots);
+  }
+  free(s);
+}
+
+/* ===== Fan-out ===== */
+/* Takes subscriber i off the list; the caller frees it. */
+static tc001_subscription* fanout_remove(struct tc001_handle* h, int i) {
+  struct tc001_fanout* fo = h->fanout;
+  tc001_subscription* s = fo->subs[i];
+  memmove(fo->subs + i, fo->subs + i + 1, (size_t)(fo->n - i - 1) * sizeof(*fo->subs));
+  fo->n--;
+  conv_put(fo, s->conv);
+  TC001_ATOMIC_STORE(&h->sub_count, fo->n);
+  return s;
+}
+
+void tc001__fanout_deliver(struct tc001_handle* h, const tc001_frame* f) {
+  if (!TC001_ATOMIC_LOAD(&h->sub_count)) return;
+  lock(h);
+  struct tc001_fanout* fo = h->fanout;
+  fo->frame++;
+  dispatching = h;
+  for (int i = 0; i < fo->n; ++i) {
+    tc001_subscription* s = fo->subs[i];
+    if (s->dead) continue;
+    if (s->tick++ % (uint32_t)s->decimation) { bump(&s->skipped); continue; }
+    int stride;
+    const uint8_t* p = plane(fo, s, f, &stride);
+    if (!p || s->x + s->w > f->width || s->y + s->h > f->height) { bump(&s->dropped); continue; }
+    tc001_frame v = *f;
+    v.data = p + (size_t)s->y * stride + (size_t)s->x * s->bpp;
+    v.width = s->w;
+    v.height = s->h;
+    v.stride = stride;
+    v.format = s->conv ? s->conv->format : TC001_FMT_U16;
+    if (v.data != f->data || v.width != f->width || v.height != f->height) v.ref = NULL;
+    if (s->policy == TC001_SUB_INLINE) {
+      s->cb(&v, s->user);
+      bump(&s->delivered);
+    } else {
+      push(s, &v);
+    }
+  }
+  dispatching = NULL;
+  tc001_subscription* dead = NULL;
+  for (int i = fo->n - 1; i >= 0; --i) {
+    if (!fo->subs[i]->dead) continue;
+    tc001_subscription* s = fanout_remove(h, i);
+    s->next_dead = dead;
+    dead = s;
+  }
+  unlock(h);
+  /* joined outside the lock: a worker may be waiting for it in
+     tc001_subscribe or tc001_unsubscribe */
+  while (dead) {
+    tc001_subscription* s = dead;
+    dead = s->next_dead;
+    sub_free(s);
+  }
+}
+
+void tc001__fanout_free(struct tc001_handle* h) {
+  struct tc001_fanout* fo = h->fanout;
+  if (!fo) return;
+  while (fo->n) sub_free(fanout_remove(h, fo->n - 1));
+  free(fo->subs);
+  free(fo->convs);
+  free(fo->u8);
+  free(fo);
+  h->fanout = NULL;
+}
+
+/* ===== Public API ===== */
+tc001_status tc001_subscribe(tc001_handle* h, tc001_frame_cb cb, void* user,
+                             const tc001_sub_options* opts, tc001_subscription** out) {
+  if (!h || !cb) return TC001_ERR_PARAM;
+  tc001_sub_options o = {0};
+  if (opts) o = *opts;
+  else o.format = TC001_FMT_U16;
+  if (o.decimation < 0 || o.queue_frames < 0 || o.roi_w < 0 || o.roi_h < 0) return TC001_ERR_PARAM;
+  if ((unsigned)o.format > TC001_FMT_RGB8 || (unsigned)o.policy > TC001_SUB_QUEUE) return TC001_ERR_PARAM;
+
+  int x0 = 0, y0 = 0, x1 = h->width, y1 = h->height;
+  if (o.roi_w && o.roi_h) {
+    if (o.roi_x > x0) x0 = o.roi_x;
+    if (o.roi_y > y0) y0 = o.roi_y;
+    if (o.roi_x + o.roi_w < x1) x1 = o.roi_x + o.roi_w;
+    if (o.roi_y + o.roi_h < y1) y1 = o.roi_y + o.roi_h;
+  }
+  if (x1 <= x0 || y1 <= y0) return TC001_ERR_PARAM;
+
+  tc001_subscription* s = (tc001_subscription*)calloc(1, sizeof(*s));
+  if (!s) return TC001_ERR_ALLOC;
+  s->cb = cb;
+  s->user = user;
+  s->decimation = o.decimation ? o.decimation : 1;
+  s->x = x0;
+  s->y = y0;
+  s->w = x1 - x0;
+  s->h = y1 - y0;
+  s->bpp = o.format == TC001_FMT_U16 ? 2 : o.format == TC001_FMT_RGB8 ? 3 : 1;
+  s->policy = o.policy;
+
+  if (o.policy != TC001_SUB_INLINE) {
+    s->nslots = o.policy == TC001_SUB_LATEST ? 3 : (o.queue_frames ? o.queue_frames : DEFAULT_QUEUE) + 1;
+    s->slots = (sub_slot*)calloc((size_t)s->nslots, sizeof(*s->slots));
+    if (!s->slots) { sub_free(s); return TC001_ERR_ALLOC; }
+    for (int i = 0; i < s->nslots; ++i) {
+      s->slots[i].buf = (uint8_t*)malloc((size_t)s->w * s->h * s->bpp);
+      if (!s->slots[i].buf) { sub_free(s); return TC001_ERR_ALLOC; }
+    }
+    s->back = 0;
+    TC001_ATOMIC_STORE(&s->middle, 1);
+    s->front = 2;
+#ifdef _WIN32
+    s->thread = CreateThread(NULL, 0, sub_loop, s, 0, NULL);
+    s->started = s->thread != NULL;
+#else
+    s->started = pthread_create(&s->thread, NULL, sub_loop, s) == 0;
+#endif
+    if (!s->started) { sub_free(s); return TC001_ERR_INTERNAL; }
+  }
+
+  const int nested = dispatching == h;    /* the lock is ours already */
+  if (!nested) lock(h);
+  tc001_status st = TC001_OK;
+  struct tc001_fanout* fo = h->fanout;
+  if (!fo && !(fo = h->fanout = (struct tc001_fanout*)calloc(1, sizeof(*fo)))) st = TC001_ERR_ALLOC;
+  if (st == TC001_OK && fo->n == fo->cap) {
+    const int cap = fo->cap ? fo->cap * 2 : 8;
+    tc001_subscription** p = (tc001_subscription**)realloc(fo->subs, (size_t)cap * sizeof(*p));
+    if (p) { fo->subs = p; fo->cap = cap; }
+    else st = TC001_ERR_ALLOC;
+  }
+  if (st == TC001_OK && o.format != TC001_FMT_U16 &&
+      !(s->conv = conv_get(fo, o.format, o.format == TC001_FMT_RGB8 ? o.palette : NULL)))
+    st = TC001_ERR_ALLOC;
+  if (st == TC001_OK) {
+    fo->subs[fo->n++] = s;
+    TC001_ATOMIC_STORE(&h->sub_count, fo->n);
+  }
+  if (!nested) unlock(h);
+
+  if (st != TC001_OK) { sub_free(s); return st; }
+  if (out) *out = s;
+  return TC001_OK;
+}
+
+void tc001_unsubscribe(tc001_handle* h, tc001_subscription* s) {
+  if (!h || !s) return;
+  if (dispatching == h) { s->dead = 1; return; }
+  lock(h);
+  struct tc001_fanout* fo = h->fanout;
+  tc001_subscription* found = NULL;
+  for (int i = 0; fo && i < fo->n && !found; ++i)
+    if (fo->subs[i] == s) found = fanout_remove(h, i);
+  unlock(h);
+  /* joined outside the lock, so the capture thread does not wait on s */
+  if (found) sub_free(found);
+}
+
+void tc001_sub_get_stats(const tc001_subscription* s, tc001_sub_stats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  if (!s) return;
+  tc001_subscription* m = (tc001_subscription*)s;
+  out->delivered = (uint64_t)TC001_ATOMIC_LOAD64(&m->delivered);
+  out->dropped = (uint64_t)TC001_ATOMIC_LOAD64(&m->dropped);
+  out->skipped = (uint64_t)TC001_ATOMIC_LOAD64(&m->skipped);
+}
@@ -1,4 +1,5 @@
-#include "tc001.h"
+#include "tc001_internal.h"
+#include "tc001_shm.h"
 #include <libusb.h>
 #include <string.h>
 #include <stdlib.h>
@@ -7,17 +8,6 @@
 #include <windows.h>
 #endif
 #include <stddef.h>
-#if defined(_MSC_VER)
-  #include <windows.h>
-  typedef LONG tc001_atomic_int;
-  #define TC001_ATOMIC_LOAD(p)   InterlockedCompareExchange((p), 0, 0)
-  #define TC001_ATOMIC_STORE(p,v) InterlockedExchange((p), (LONG)(v))
-#else
-  #include <stdatomic.h>
-  typedef _Atomic int tc001_atomic_int;
-  #define TC001_ATOMIC_LOAD(p)   atomic_load((p))
-  #define TC001_ATOMIC_STORE(p,v) atomic_store((p), (v))
-#endif
 
 
 
@@ -34,25 +24,8 @@
 #define FRAME_HEIGHT  192
 #define PIXEL_SIZE    2
 #define FRAME_SIZE    (FRAME_WIDTH * FRAME_HEIGHT * PIXEL_SIZE)
+#define ISO_SIZE      (PACKET_SIZE * NUM_PACKETS)
 
-struct tc001_handle {
-  libusb_context* ctx;
-  libusb_device_handle* dev;
-  struct libusb_transfer* xfer;
-  uint8_t* iso_buf;
-  uint8_t* frame_buf;
-  int      frame_pos;
-
-  tc001_atomic_int running;
-  tc001_frame_cb cb;
-  void* cb_user;
-
-#ifdef _WIN32
-  HANDLE thread;
-#else
-  pthread_t thread;
-#endif
-};
 
 static void seterr(char* out_buf, size_t out_cap, const char* msg) {
     if (!out_buf || out_cap == 0) return;
@@ -68,13 +41,62 @@ static void seterr(char* out_buf, size_t out_cap, const char* msg) {
 #endif
 }
 
-static void fill_tc001_frame(struct tc001_handle* h, tc001_frame* f) {
-  f->width  = FRAME_WIDTH;
-  f->height = FRAME_HEIGHT;
-  f->stride = FRAME_WIDTH * PIXEL_SIZE;
-  f->timestamp_ns = 0;      /* can fill with clock if you wish */
+static void fill_tc001_frame(struct tc001_handle* h, tc001_frame* f,
+                             const uint8_t* data, int64_t timestamp_ns) {
+  f->width  = h->width;
+  f->height = h->height;
+  f->stride = h->width * PIXEL_SIZE;
+  f->timestamp_ns = timestamp_ns;
   f->format = TC001_FMT_U16;
-  f->data   = h->frame_buf;
+  f->data   = data;
+  f->stats  = NULL;
+  f->frame_id = h->frame_id++;
+  f->blobs  = NULL;
+  f->blob_count = 0;
+  f->ref    = NULL;
+}
+
+/* Runs once per completed frame on the backend thread, before the callback. */
+void tc001__deliver_frame(struct tc001_handle* h, const uint8_t* data, int64_t timestamp_ns) {
+  free(h->blobs_old);       /* no frame points at it any more */
+  h->blobs_old = NULL;
+  struct tc001_frame_ref* ref = h->pool ? tc001__pool_take(h, &data) : NULL;
+  tc001_frame f; fill_tc001_frame(h, &f, data, timestamp_ns);
+
+  /* subscribers first, so they do not wait on the stages below */
+  if (h->shm) tc001_shm_publish(h->shm, &f);
+  if (TC001_ATOMIC_LOAD(&h->want_latest)) tc001__latest_publish(h->latest, &f);
+
+  const int want_stats = TC001_ATOMIC_LOAD(&h->want_stats);
+  const int want_blobs = TC001_ATOMIC_LOAD(&h->want_blobs);
+  const uint32_t n = (uint32_t)(f.width * f.height);
+  tc001_blob_thresh bt;
+
+  /* percentile blob thresholds come from the stats histogram */
+  if (want_stats || (want_blobs && h->blob_cfg.mode == TC001_BLOB_PERCENTILE)) {
+    uint16_t lo, hi;
+    tc001__stats_scan(&h->stats_scratch, f.data, f.width, f.height, f.stride, NULL, &lo, &hi);
+    if (want_blobs) tc001__blob_thresh(&h->blob_cfg, &h->stats_scratch, n, lo, hi, &bt);
+    tc001__stats_finish(&h->stats_scratch, n, lo, hi, &h->stats);
+    if (want_stats) f.stats = &h->stats;
+  } else if (want_blobs) {
+    tc001__blob_thresh(&h->blob_cfg, NULL, 0, 0, 0, &bt);
+  }
+
+  if (want_blobs &&
+      tc001__find_blobs(h->blob_scratch, f.data, f.width, f.height, f.stride,
+                        &h->blob_cfg, &bt, &h->temp,
+                        h->blobs, h->blob_cfg.max_blobs, &f.blob_count) == TC001_OK)
+    f.blobs = h->blobs;
+
+  if (ref) tc001__pool_fill(ref, &f);
+
+  h->cur = &f;
+  tc001__fanout_deliver(h, &f);
+  if (h->cb) h->cb(&f, h->cb_user);
+  h->cur = NULL;
+
+  if (h->pool) tc001__pool_done(h, ref);
 }
 
 /* ===== Control sequence from your reader.c ===== */
@@ -144,6 +166,91 @@ static int send_commit(libusb_device_handle* dev) {
   );
 }
 
+/* ===== Frame assembly ===== */
+/* Copies the part of sensor bytes [pos, pos + len) that falls inside the
+   acquisition window, row by row, to its packed place in frame_buf. */
+static void copy_window(struct tc001_handle* h, const uint8_t* p, int pos, int len) {
+  const int row = h->src_w * PIXEL_SIZE;
+  const int wb = h->width * PIXEL_SIZE;
+  int y = pos / row, y_end = (pos + len - 1) / row;
+  if (y < h->roi_y) y = h->roi_y;
+  if (y_end >= h->roi_y + h->height) y_end = h->roi_y + h->height - 1;
+  for (; y <= y_end; ++y) {
+    const int start = y * row + h->roi_x * PIXEL_SIZE;
+    const int a = start > pos ? start : pos;
+    const int b = start + wb < pos + len ? start + wb : pos + len;
+    if (a < b)
+      memcpy(h->frame_buf + (size_t)(y - h->roi_y) * wb + (a - start), p + (a - pos), (size_t)(b - a));
+  }
+}
+
+void tc001__frame_data(struct tc001_handle* h, const uint8_t* p, int len) {
+  const int row = h->src_w * PIXEL_SIZE;
+  if (h->frame_pos + len > row * h->src_h) return;
+  if (h->width == h->src_w && h->height == h->src_h)
+    memcpy(h->frame_buf + h->frame_pos, p, len);
+  else
+    copy_window(h, p, h->frame_pos, len);
+  h->frame_pos += len;
+
+  if (!h->slice_cb || !h->frame_synced) return;
+  int rows = h->frame_pos / row - h->roi_y;
+  if (rows > h->height) rows = h->height;
+  if (rows < h->slice_next) return;
+  tc001_slice sl;
+  sl.data = h->frame_buf;
+  sl.width = h->width;
+  sl.height = h->height;
+  sl.stride = h->width * PIXEL_SIZE;
+  sl.rows = rows;
+  sl.frame_id = h->frame_id;
+  h->slice_cb(&sl, h->slice_user);
+  h->slice_next = rows + h->slice_every - rows % h->slice_every;
+  if (h->slice_next > h->height) h->slice_next = rows < h->height ? h->height : h->height + 1;
+}
+
+void tc001__frame_end(struct tc001_handle* h, int64_t timestamp_ns) {
+  if (h->frame_pos >= h->src_w * h->src_h * PIXEL_SIZE)
+    tc001__deliver_frame(h, h->frame_buf, timestamp_ns);
+  h->frame_pos = 0;
+  h->frame_synced = 1;
+  h->slice_next = h->slice_every;
+}
+
+tc001_status tc001_set_slice_callback(tc001_handle* h, int every_rows, tc001_slice_cb cb, void* user) {
+  if (!h || every_rows < 0) return TC001_ERR_PARAM;
+  if (!cb || !every_rows) {
+    h->slice_cb = NULL;
+    return TC001_OK;
+  }
+  h->slice_cb = cb;
+  h->slice_user = user;
+  h->slice_every = every_rows;
+  if (h->slice_next < every_rows) h->slice_next = every_rows;
+  return TC001_OK;
+}
+
+static size_t frame_bytes(const struct tc001_handle* h) {
+  return (size_t)h->src_w * h->src_h * PIXEL_SIZE;
+}
+
+tc001_status tc001_set_acquisition_roi(tc001_handle* h, int x, int y, int w, int hgt) {
+  if (!h) return TC001_ERR_PARAM;
+  if (TC001_ATOMIC_LOAD(&h->running)) return TC001_ERR_STATE;
+  if (!w || !hgt) { x = 0; y = 0; w = h->src_w; hgt = h->src_h; }
+  if (x < 0 || y < 0 || w < 0 || hgt < 0 || x + w > h->src_w || y + hgt > h->src_h)
+    return TC001_ERR_PARAM;
+  /* replay assembles frames only for a window or packetized */
+  if (!h->frame_buf &&
+      !(h->frame_buf = (uint8_t*)tc001__buf_alloc(frame_bytes(h), h->backing & TC001_BACKING_HUGEPAGES)))
+    return TC001_ERR_ALLOC;
+  h->roi_x = x;
+  h->roi_y = y;
+  h->width = w;
+  h->height = hgt;
+  return TC001_OK;
+}
+
 /* ===== ISO callback ===== */
 static void LIBUSB_CALL iso_cb(struct libusb_transfer* t) {
   struct tc001_handle* h = (struct tc001_handle*)t->user_data;
@@ -158,18 +265,9 @@ static void LIBUSB_CALL iso_cb(struct libusb_transfer* t) {
       uint8_t  flags   = data[1];
       int      payload = d->actual_length - hdr_len;
 
-      if (payload > 0 && h->frame_pos + payload <= FRAME_SIZE) {
-        memcpy(h->frame_buf + h->frame_pos, data + hdr_len, payload);
-        h->frame_pos += payload;
-      }
-
-      if (flags & 2) { /* EOF */
-        if (h->frame_pos >= FRAME_SIZE && h->cb) {
-          tc001_frame f; fill_tc001_frame(h, &f);
-          h->cb(&f, h->cb_user);
-        }
-        h->frame_pos = 0;
-      }
+      if (payload > 0) tc001__frame_data(h, data + hdr_len, payload);
+      /* EOF; monotonic timestamp, taken at EOF */
+      if (flags & 2) tc001__frame_end(h, tc001__now_ns());
     }
   }
 
@@ -256,20 +354,23 @@ tc001_status tc001_open(tc001_handle** out, uint16_t vid, uint16_t pid,
   }
 
   /* Buffers */
-  h->iso_buf   = (uint8_t*)malloc(PACKET_SIZE * NUM_PACKETS);
-  h->frame_buf = (uint8_t*)malloc(FRAME_SIZE);
+  h->iso_buf   = (uint8_t*)tc001__buf_alloc(ISO_SIZE, 0);
+  h->frame_buf = (uint8_t*)tc001__buf_alloc(FRAME_SIZE, 0);
   if (!h->iso_buf || !h->frame_buf) {
     seterr(err, errcap, "alloc buffers");
     goto FAIL_USB;
   }
   h->frame_pos = 0;
+  h->width = h->src_w = FRAME_WIDTH;
+  h->height = h->src_h = FRAME_HEIGHT;
+  tc001__calibration_identity(&h->calib);
 
   *out = h;
   return TC001_OK;
 
 FAIL_USB:
-  if (h->iso_buf) free(h->iso_buf);
-  if (h->frame_buf) free(h->frame_buf);
+  tc001__buf_free(h->iso_buf, ISO_SIZE, 0);
+  tc001__buf_free(h->frame_buf, FRAME_SIZE, 0);
   libusb_release_interface(h->dev, INTERFACE_NUMBER);
   libusb_close(h->dev);
   libusb_exit(h->ctx);
@@ -277,14 +378,77 @@ FAIL_USB:
   return TC001_ERR_USB;
 }
 
+/* ===== Buffer backing ===== */
+/* The transfer buffer from usbfs, which the controller writes into
+   directly; NULL where the kernel or libusb cannot. */
+static uint8_t* iso_dma_alloc(struct tc001_handle* h) {
+#if defined(LIBUSB_API_VERSION) && LIBUSB_API_VERSION >= 0x01000105
+  return libusb_dev_mem_alloc(h->dev, ISO_SIZE);
+#else
+  (void)h;
+  return NULL;
+#endif
+}
+
+static void iso_free(struct tc001_handle* h) {
+#if defined(LIBUSB_API_VERSION) && LIBUSB_API_VERSION >= 0x01000105
+  if (h->backing & TC001_BACKING_USB_DMA) {
+    libusb_dev_mem_free(h->dev, h->iso_buf, ISO_SIZE);
+    return;
+  }
+#endif
+  tc001__buf_free(h->iso_buf, ISO_SIZE, h->backing & TC001_BACKING_HUGEPAGES);
+}
+
+tc001_status tc001_set_buffer_backing(tc001_handle* h, int flags) {
+  if (!h || (flags & ~(TC001_BACKING_HUGEPAGES | TC001_BACKING_USB_DMA))) return TC001_ERR_PARAM;
+  if (h->replay && (flags & TC001_BACKING_USB_DMA)) return TC001_ERR_PARAM;
+  if (TC001_ATOMIC_LOAD(&h->running) || h->pool) return TC001_ERR_STATE;
+
+  /* new buffers first, so a backing that is unavailable changes nothing */
+  const int huge = flags & TC001_BACKING_HUGEPAGES;
+  uint8_t* frame = NULL;
+  if (h->frame_buf && !(frame = (uint8_t*)tc001__buf_alloc(frame_bytes(h), huge)))
+    return TC001_ERR_ALLOC;
+  if (!h->replay) {
+    uint8_t* iso = flags & TC001_BACKING_USB_DMA ? iso_dma_alloc(h)
+                                                 : (uint8_t*)tc001__buf_alloc(ISO_SIZE, huge);
+    if (!iso) {
+      tc001__buf_free(frame, frame_bytes(h), huge);
+      return flags & TC001_BACKING_USB_DMA ? TC001_ERR_USB : TC001_ERR_ALLOC;
+    }
+    iso_free(h);
+    h->iso_buf = iso;
+  }
+  tc001__buf_free(h->frame_buf, frame_bytes(h), h->backing & TC001_BACKING_HUGEPAGES);
+  h->frame_buf = frame;
+  h->backing = flags;
+  return TC001_OK;
+}
+
 void tc001_close(tc001_handle* h) {
   if (!h) return;
   tc001_stop(h);
-  libusb_release_interface(h->dev, INTERFACE_NUMBER);
-  libusb_close(h->dev);
-  libusb_exit(h->ctx);
-  free(h->iso_buf);
-  free(h->frame_buf);
+  if (h->replay) {
+    tc001__replay_free(h->replay);
+  } else {
+    iso_free(h);
+    libusb_release_interface(h->dev, INTERFACE_NUMBER);
+    libusb_close(h->dev);
+    libusb_exit(h->ctx);
+  }
+  tc001__pool_free(h);
+  tc001__buf_free(h->frame_buf, frame_bytes(h), h->backing & TC001_BACKING_HUGEPAGES);
+  tc001__handle_free(h);
+}
+
+void tc001__handle_free(struct tc001_handle* h) {
+  tc001__fanout_free(h);
+  tc001__latest_free(h->latest);
+  tc001__stats_scratch_free(&h->stats_scratch);
+  tc001__blob_scratch_free(h->blob_scratch);
+  free(h->blobs);
+  free(h->blobs_old);
   free(h);
 }
 
@@ -292,10 +456,14 @@ tc001_status tc001_start(tc001_handle* h,
                          tc001_frame_cb cb, void* user,
                          char* err, size_t errcap)
 {
-  if (!h || !cb) return TC001_ERR_PARAM;
+  if (!h) return TC001_ERR_PARAM;
   if (TC001_ATOMIC_LOAD(&h->running)) return TC001_ERR_STATE;
 
   h->cb = cb; h->cb_user = user;
+  if (h->replay) return tc001__replay_start(h, err, errcap);
+
+  h->frame_pos = 0;
+  h->frame_synced = 0;      /* the first packets may be mid-frame */
 
   h->xfer = libusb_alloc_transfer(NUM_PACKETS);
   if (!h->xfer) { seterr(err, errcap, "alloc transfer"); return TC001_ERR_ALLOC; }
@@ -332,6 +500,7 @@ tc001_status tc001_start(tc001_handle* h,
 
 void tc001_stop(tc001_handle* h) {
   if (!h) return;
+  if (h->replay) { tc001__replay_stop(h); return; }
   if (!TC001_ATOMIC_LOAD(&h->running)) return;
 
   TC001_ATOMIC_STORE(&h->running, 0);
@@ -357,21 +526,71 @@ void tc001_stop(tc001_handle* h) {
 }
 
 void tc001_get_frame_dims(tc001_handle* h, int* w, int* hgt) {
-  (void)h;
-  if (w) *w = FRAME_WIDTH;
-  if (hgt) *hgt = FRAME_HEIGHT;
+  if (w) *w = h ? h->width : FRAME_WIDTH;
+  if (hgt) *hgt = h ? h->height : FRAME_HEIGHT;
 }
 
 void tc001_u16_to_u8(const uint16_t* in, int count, uint8_t* out) {
   /* simple percentile AGC */
   if (!in || !out || count <= 0) return;
   uint16_t lo = 65535, hi = 0;
-  for (int i=0;i<count;i++){ if(in[i]<lo)lo=in[i]; if(in[i]>hi)hi=in[i]; }
-  float span = (float)(hi - lo); if (span < 1.f) span = 1.f;
-  for (int i=0;i<count;i++){
-    float v = (in[i]-lo)/span;
-    int u = (int)(v*255.f + 0.5f);
-    if (u<0) u=0; if (u>255) u=255;
-    out[i] = (uint8_t)u;
+  tc001__minmax_u16(in, count, &lo, &hi);
+  float scale = tc001__agc_scale(lo, hi);
+  for (int i=0;i<count;i++) out[i] = tc001__agc_u8(in[i], lo, scale);
+}
+
+tc001_status tc001_enable_stats(tc001_handle* h, int enable) {
+  if (!h) return TC001_ERR_PARAM;
+  /* scratch is allocated before the flag is published and kept until close */
+  if (enable && tc001__stats_scratch_init(&h->stats_scratch) != 0) return TC001_ERR_ALLOC;
+  TC001_ATOMIC_STORE(&h->want_stats, enable ? 1 : 0);
+  return TC001_OK;
+}
+
+tc001_status tc001_enable_blobs(tc001_handle* h, const tc001_blob_config* cfg) {
+  if (!h) return TC001_ERR_PARAM;
+  if (!cfg) {
+    TC001_ATOMIC_STORE(&h->want_blobs, 0);
+    return TC001_OK;
   }
+  if (cfg->max_blobs < 0) return TC001_ERR_PARAM;
+  if (cfg->mode == TC001_BLOB_PERCENTILE &&
+      tc001__stats_scratch_init(&h->stats_scratch) != 0) return TC001_ERR_ALLOC;
+  if (!h->blob_scratch && !(h->blob_scratch = tc001__blob_scratch_new()))
+    return TC001_ERR_ALLOC;
+  if (cfg->max_blobs > h->blob_cap) {
+    tc001_blob* b = (tc001_blob*)malloc((size_t)cfg->max_blobs * sizeof(tc001_blob));
+    if (!b) return TC001_ERR_ALLOC;
+    /* from a callback, the frame in flight still points at the old array:
+       keep it until the next frame (the first one replaced is that one) */
+    if (h->cur && !h->blobs_old) h->blobs_old = h->blobs;
+    else free(h->blobs);
+    h->blobs = b;
+    h->blob_cap = cfg->max_blobs;
+  }
+  h->blob_cfg = *cfg;
+  TC001_ATOMIC_STORE(&h->want_blobs, 1);
+  return TC001_OK;
+}
+
+size_t tc001_pack_payload(tc001_handle* h,
+                          void* dst, size_t dst_cap,
+                          int thumb_w, int thumb_h,
+                          int use_agc)
+{
+  if (!h || !h->cur) return 0;
+  return tc001_pack_frame(h->cur, &h->calib, &h->temp, dst, dst_cap,
+                          thumb_w, thumb_h, use_agc);
+}
+
+void tc001_set_calibration(tc001_handle* h, const tc001_calibration* c) {
+  if (!h) return;
+  if (c) h->calib = *c;
+  else tc001__calibration_identity(&h->calib);
+}
+
+void tc001_set_temp_model(tc001_handle* h, const tc001_temp_model* t) {
+  if (!h) return;
+  if (t) h->temp = *t;
+  else memset(&h->temp, 0, sizeof(h->temp));
 }
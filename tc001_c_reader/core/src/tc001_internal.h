@@ -0,0 +1,350 @@
+#pragma once
+/* Library-private declarations shared between core/src translation units.
+   Not installed; nothing here is part of the public ABI. */
+#include "tc001.h"
+#include "tc001_rec.h"
+
+#if defined(_MSC_VER)
+  #define TC001_THREAD_LOCAL __declspec(thread)
+#else
+  #define TC001_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(_MSC_VER)
+  #include <windows.h>
+  typedef LONG tc001_atomic_int;
+  #define TC001_ATOMIC_LOAD(p)   InterlockedCompareExchange((p), 0, 0)
+  #define TC001_ATOMIC_STORE(p,v) InterlockedExchange((p), (LONG)(v))
+  #define TC001_ATOMIC_FENCE()   MemoryBarrier()
+  static inline int tc001__atomic_cas(tc001_atomic_int* p, int expect, int desired) {
+    return InterlockedCompareExchange(p, (LONG)desired, (LONG)expect) == (LONG)expect;
+  }
+  typedef LONG64 tc001_atomic_i64;
+  #define TC001_ATOMIC_LOAD64(p)    InterlockedCompareExchange64((p), 0, 0)
+  #define TC001_ATOMIC_STORE64(p,v) InterlockedExchange64((p), (LONG64)(v))
+  #define TC001_ATOMIC_INC64(p)     InterlockedIncrement64((p))
+#else
+  #include <stdatomic.h>
+  typedef _Atomic int tc001_atomic_int;
+  #define TC001_ATOMIC_LOAD(p)   atomic_load((p))
+  #define TC001_ATOMIC_STORE(p,v) atomic_store((p), (v))
+  #define TC001_ATOMIC_FENCE()   atomic_thread_fence(memory_order_seq_cst)
+  static inline int tc001__atomic_cas(tc001_atomic_int* p, int expect, int desired) {
+    return atomic_compare_exchange_strong(p, &expect, desired);
+  }
+  typedef _Atomic int64_t tc001_atomic_i64;
+  #define TC001_ATOMIC_LOAD64(p)    atomic_load((p))
+  #define TC001_ATOMIC_STORE64(p,v) atomic_store((p), (int64_t)(v))
+  #define TC001_ATOMIC_INC64(p)     atomic_fetch_add((p), 1)
+#endif
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+/* ===== Platform ===== */
+int64_t tc001__now_ns(void);    /* monotonic clock */
+int64_t tc001__wall_ns(void);   /* Unix epoch */
+void    tc001__sleep_ns(int64_t ns);
+
+/* align must be a power of two and a multiple of sizeof(void*) */
+void* tc001__aligned_alloc(size_t size, size_t align);
+void  tc001__aligned_free(void* p);
+
+/* Huge pages, whole ones; NULL where there are none. Free with the size
+   that was allocated. */
+void* tc001__huge_alloc(size_t size);
+void  tc001__huge_free(void* p, size_t size);
+
+/* Files, as small integer descriptors (CRT descriptors on Windows). Writes
+   are positional and complete or fail; functions return 0 or -1. */
+int  tc001__file_open(const char* path, int create);   /* read/write; create truncates */
+int  tc001__file_pwrite(int fd, const void* buf, size_t n, uint64_t off);
+
+typedef struct { const void* base; size_t len; } tc001_iovec;
+int  tc001__file_pwritev(int fd, const tc001_iovec* v, int n, uint64_t off);
+
+/* Second descriptor on an existing file that bypasses the page cache
+   (O_DIRECT, F_NOCACHE); -1 where unsupported. Buffers, sizes and offsets
+   must be multiples of TC001_DIRECT_ALIGN. */
+#define TC001_DIRECT_ALIGN 4096
+int  tc001__file_open_direct(const char* path);
+int  tc001__file_sync(int fd);                         /* data to stable storage */
+int  tc001__file_truncate(int fd, uint64_t size);
+void tc001__file_close(int fd);
+
+/* Read-only whole-file mapping. */
+typedef struct {
+  const uint8_t* data;
+  uint64_t size;
+  void* os;                 /* platform mapping handle */
+} tc001_mapping;
+
+int  tc001__map_file(const char* path, tc001_mapping* m);
+void tc001__unmap_file(tc001_mapping* m);
+
+/* Shared memory, mapped read/write. create makes a named segment (a POSIX
+   shm name, or a Windows mapping name), replacing one left behind, or an
+   anonymous one (memfd) when name is NULL. open maps a named segment, or
+   a descriptor (duplicated) when name is NULL. fd is -1 on Windows. */
+typedef struct {
+  uint8_t* base;
+  size_t   size;
+  int      fd;
+  void*    os;                /* platform mapping handle */
+} tc001_shm_map;
+
+int  tc001__shm_create(const char* name, size_t size, tc001_shm_map* m);
+int  tc001__shm_open(const char* name, int fd, tc001_shm_map* m);
+void tc001__shm_close(tc001_shm_map* m);
+void tc001__shm_unlink(const char* name);
+
+int  tc001__pid(void);
+int  tc001__pid_alive(int pid);
+
+/* ===== AGC ===== */
+/* The min/max AGC shared by tc001_u16_to_u8, the 8-bit preview histogram
+   and thumbnails, so every producer of 8-bit data maps raw counts the same
+   way. scale is 255 / (hi - lo), computed once per frame. */
+static inline float tc001__agc_scale(uint16_t lo, uint16_t hi) {
+  float span = (float)(hi - lo);
+  return 255.f / (span < 1.f ? 1.f : span);
+}
+
+static inline uint8_t tc001__agc_u8(uint16_t v, uint16_t lo, float scale) {
+  float u = ((float)v - (float)lo) * scale + 0.5f;
+  if (u < 0.f) u = 0.f;
+  if (u > 255.f) u = 255.f;
+  return (uint8_t)(int)u;
+}
+
+/* ===== Thumbnails ===== */
+/* Streaming area-average downscale state (thumb.c). Buffers are grown on
+   demand and reused across frames. */
+typedef struct {
+  int w, h, tw, th;
+  int cur;                  /* which band holds the current thumbnail row */
+  float* band;              /* 2 * w column sums, scaled by row weight */
+  float* acc;               /* tw * th mean raw values */
+  struct { int x0, x1; float w0, w1; } *col;  /* per thumbnail column */
+  float  full_w, norm;
+  size_t band_cap, acc_cap, col_cap;
+} tc001_thumb_plan;
+
+tc001_status tc001__thumb_plan_init(tc001_thumb_plan* p, int w, int h, int tw, int th);
+void tc001__thumb_plan_free(tc001_thumb_plan* p);
+
+/* Feed source rows 0..h-1 in order; completed thumbnail rows land in acc. */
+void tc001__thumb_row(tc001_thumb_plan* p, int y, const uint16_t* px);
+
+/* Maps the means in acc to 8-bit: min/max AGC over [lo, hi] when use_agc,
+   otherwise the high byte. */
+void tc001__thumb_finish(const tc001_thumb_plan* p, uint16_t lo, uint16_t hi,
+                         int use_agc, uint8_t* dst, int pitch);
+
+/* Folds min/max of n pixels into *lo / *hi (SIMD). */
+void tc001__minmax_u16(const uint16_t* px, int n, uint16_t* lo, uint16_t* hi);
+
+/* ===== Frame statistics ===== */
+#define TC001_HIST_BINS 65536
+
+/* Full-resolution raw histogram. Must be all-zero on entry to
+   tc001__stats_scan; tc001__stats_finish leaves it all-zero again, so only
+   the [raw_min, raw_max] range is ever touched per frame. */
+typedef struct {
+  uint32_t* fine;
+  tc001_thumb_plan thumb;   /* used when a scan also builds a thumbnail */
+} tc001_stats_scratch;
+
+int  tc001__stats_scratch_init(tc001_stats_scratch* s);
+void tc001__stats_scratch_free(tc001_stats_scratch* s);
+
+/* Per-thread scratch for entry points that have no handle; NULL on OOM. */
+tc001_stats_scratch* tc001__stats_tls_scratch(void);
+
+/* Optional work fused into the stats pass so the frame is read only once. */
+typedef struct {
+  uint8_t* copy_to;         /* receives the plane, rows tightly packed */
+  int      thumb_w, thumb_h;/* downscale into s->thumb when both are > 0 */
+} tc001_scan_opts;
+
+/* One pass over a u16 plane: fills the fine histogram and returns min/max.
+   opts may be NULL. */
+tc001_status tc001__stats_scan(tc001_stats_scratch* s,
+                               const uint8_t* base, int w, int h, int stride,
+                               const tc001_scan_opts* opts,
+                               uint16_t* lo, uint16_t* hi);
+
+/* Derives every tc001_frame_stats field from the histogram (no pixel
+   access) and clears the touched bins. */
+void tc001__stats_finish(tc001_stats_scratch* s, uint32_t count,
+                         uint16_t lo, uint16_t hi, tc001_frame_stats* out);
+
+/* Raw value at nearest rank (0-based, ascending); before stats_finish. */
+uint16_t tc001__stats_rank(const tc001_stats_scratch* s, uint32_t count,
+                           uint16_t lo, uint16_t hi, uint32_t rank);
+
+/* ===== Temperature ===== */
+/* One raw value to Celsius; m must have has_temp set. */
+float tc001__temp_c(const tc001_temp_model* m, uint16_t raw);
+
+/* ===== Blobs ===== */
+typedef struct tc001_blob_scratch tc001_blob_scratch;
+
+tc001_blob_scratch* tc001__blob_scratch_new(void);
+void tc001__blob_scratch_free(tc001_blob_scratch* s);
+
+/* Raw thresholds for one frame, inclusive: hot is v >= hot, cold v <= cold */
+typedef struct {
+  int hot_on, cold_on;
+  uint16_t hot, cold;
+} tc001_blob_thresh;
+
+/* Resolves cfg against the frame. Percentile mode reads the fine histogram
+   of s (filled by tc001__stats_scan, not yet finished); s may be NULL for
+   fixed raw thresholds. */
+void tc001__blob_thresh(const tc001_blob_config* cfg, const tc001_stats_scratch* s,
+                        uint32_t count, uint16_t lo, uint16_t hi, tc001_blob_thresh* t);
+
+/* Labels hot and cold regions in one pass over the plane and writes the
+   largest blobs (at most cap) to out. temp may be NULL. */
+tc001_status tc001__find_blobs(tc001_blob_scratch* s,
+                               const uint8_t* base, int w, int h, int stride,
+                               const tc001_blob_config* cfg, const tc001_blob_thresh* t,
+                               const tc001_temp_model* temp,
+                               tc001_blob* out, int cap, int* count);
+
+/* ===== Recording ===== */
+/* CRC-32 as zlib computes it; pass 0 to start, the previous result to
+   continue. */
+uint32_t tc001__crc32(uint32_t crc, const void* buf, size_t n);
+
+/* Split form of tc001_rec_write for writers that do their own I/O: format
+   chunks in order with rec_chunk (into a buffer of rec_chunk_cap bytes,
+   TC001_REC_ALIGN aligned), write them at rec_pos, then rec_append each in
+   the same order. A raw frame whose rows already sit at the payload
+   position (dst + 64) is not copied. */
+size_t       tc001__rec_chunk_cap(const tc001_rec_writer* w);
+int          tc001__rec_fd(const tc001_rec_writer* w);
+uint64_t     tc001__rec_pos(const tc001_rec_writer* w);
+tc001_status tc001__rec_chunk(tc001_rec_writer* w, const tc001_frame* f,
+                              uint8_t* dst, size_t* total);
+tc001_status tc001__rec_append(tc001_rec_writer* w, const uint8_t* chunk, size_t total);
+void         tc001__rec_fail(tc001_rec_writer* w, tc001_status st);  /* sticky */
+
+/* ===== Payload ===== */
+void tc001__calibration_identity(tc001_calibration* c);
+
+/* ===== Buffers (alloc.c) ===== */
+/* Frame-sized buffers: tc001_set_allocator's hooks or the aligned heap, or
+   huge pages when huge is set. Free with the same size and huge. */
+void* tc001__buf_alloc(size_t size, int huge);
+void  tc001__buf_free(void* p, size_t size, int huge);
+
+/* ===== Handle ===== */
+/* One per tc001_open / tc001_open_replay. Fields past the frame source are
+   shared by both backends. */
+struct tc001_replay;
+
+struct tc001_handle {
+  /* USB backend (tc001.c) */
+  struct libusb_context*       ctx;
+  struct libusb_device_handle* dev;
+  struct libusb_transfer*      xfer;
+  uint8_t* iso_buf;
+  uint8_t* frame_buf;        /* src_w * src_h U16 pixels */
+  int      backing;          /* tc001_set_buffer_backing flags */
+  int      frame_pos;
+  int      frame_synced;     /* an EOF was seen, so frame_buf starts at row 0 */
+
+  /* tc001_set_slice_callback */
+  tc001_slice_cb slice_cb;
+  void*    slice_user;
+  int      slice_every;
+  int      slice_next;       /* rows that fire the next slice */
+
+  /* replay backend (replay.c); NULL for a device */
+  struct tc001_replay* replay;
+
+  int      width, height;    /* of delivered frames */
+  int      src_w, src_h;     /* of the sensor image, as packets carry it */
+  int      roi_x, roi_y;     /* tc001_set_acquisition_roi; width x height from here */
+
+  tc001_atomic_int running;
+  tc001_frame_cb cb;
+  void* cb_user;
+
+  tc001_atomic_int    want_stats;
+  tc001_stats_scratch stats_scratch;
+  tc001_frame_stats   stats;
+
+  tc001_atomic_int    want_blobs;
+  tc001_blob_config   blob_cfg;
+  tc001_blob_scratch* blob_scratch;
+  tc001_blob*         blobs;
+  int                 blob_cap;
+  tc001_blob*         blobs_old;  /* replaced during a callback; freed at the next frame */
+
+  struct tc001_shm_pub* shm;     /* tc001_enable_shm; NULL = not publishing */
+
+  struct tc001_pool*    pool;    /* tc001_set_frame_pool (pool.c); NULL = off */
+
+  tc001_atomic_int      want_latest;
+  struct tc001_latest*  latest;  /* tc001_enable_latest (latest.c) */
+
+  /* tc001_subscribe (subscribe.c); fanout is only touched under sub_lock */
+  tc001_atomic_int      sub_lock;
+  tc001_atomic_int      sub_count;
+  struct tc001_fanout*  fanout;
+
+  uint32_t           frame_id;
+  const tc001_frame* cur;        /* frame in flight, only during the callback */
+  tc001_calibration  calib;
+  tc001_temp_model   temp;
+
+#ifdef _WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+};
+
+/* Appends packet payload to frame_buf, firing the slice callback as rows
+   complete; tc001__frame_end delivers the frame if it is whole. Used by the
+   USB callback and by packetized replay. Only the acquisition window is
+   copied, packed; frame_buf holds src_w * src_h U16 pixels. */
+void tc001__frame_data(struct tc001_handle* h, const uint8_t* p, int len);
+void tc001__frame_end(struct tc001_handle* h, int64_t timestamp_ns);
+
+/* Runs the per-frame stages and the user callback for one U16 frame of
+   h->width x h->height, rows tightly packed. Called on the backend thread. */
+void tc001__deliver_frame(struct tc001_handle* h, const uint8_t* data, int64_t timestamp_ns);
+
+/* Frees the handle's per-frame state (stats, blobs, subscribers) and the
+   handle. */
+void tc001__handle_free(struct tc001_handle* h);
+
+/* Frame pool (pool.c). take finds or makes the pooled buffer holding
+   *data (copying it there and updating *data if needed; NULL when
+   exhausted), fill records the delivered frame in it, and done drops the
+   delivery's reference and picks the next assembly buffer. */
+struct tc001_frame_ref* tc001__pool_take(struct tc001_handle* h, const uint8_t** data);
+void tc001__pool_fill(struct tc001_frame_ref* r, tc001_frame* f);
+void tc001__pool_done(struct tc001_handle* h, struct tc001_frame_ref* r);
+void tc001__pool_free(struct tc001_handle* h);
+
+/* Copies f into the latest-frame mailbox (latest.c). */
+void tc001__latest_publish(struct tc001_latest* l, const tc001_frame* f);
+void tc001__latest_free(struct tc001_latest* l);
+
+/* Delivers f to the subscribers (subscribe.c); a no-op without any. */
+void tc001__fanout_deliver(struct tc001_handle* h, const tc001_frame* f);
+void tc001__fanout_free(struct tc001_handle* h);
+
+/* Replay backend entry points, used by tc001_start / tc001_stop /
+   tc001_close when h->replay is set. */
+tc001_status tc001__replay_start(struct tc001_handle* h, char* err, size_t errcap);
+void         tc001__replay_stop(struct tc001_handle* h);
+void         tc001__replay_free(struct tc001_replay* r);
@@ -0,0 +1,13 @@
+#pragma once
+/* Compile-time SIMD selection. SSE2 is baseline on x86-64 and NEON on
+   AArch64, so no extra compiler flags are needed; every kernel keeps a
+   scalar path for other targets. The NEON kernels use AArch64-only
+   intrinsics (across-vector reductions, vdivq, vcvtnq), so 32-bit ARM with
+   NEON takes the scalar path. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define TC001_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define TC001_NEON 1
+#endif
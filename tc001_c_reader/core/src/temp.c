@@ -0,0 +1,244 @@
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Raw counts to temperature.
+
+   The sensor model is affine in Kelvin (gain * raw + offset), which is one
+   multiply-add per pixel and vectorises directly. With an emissivity below 1
+   the apparent temperature is corrected as a grey body against the ambient
+   (reflected) temperature, in radiance ~ T^4 space:
+
+       T_obj^4 = (T_app^4 - (1 - e) * T_amb^4) / e
+
+   For a single emissivity that is a function of the raw count alone, so it
+   is tabulated once per model (65536 floats). A per-pixel emissivity plane
+   runs the same correction in SIMD instead. */
+
+#define KELVIN_0C   273.15f
+#define CHUNK       256       /* floats of stack scratch for centi output */
+
+typedef struct {
+  float gain, offset;       /* Kelvin = gain * raw + offset */
+  float e;                  /* scalar emissivity, 1 when unknown */
+  float amb4;               /* ambient Kelvin ^ 4 */
+} conv;
+
+static void conv_init(conv* c, const tc001_temp_model* m) {
+  float amb = m->ambient_C + KELVIN_0C;
+  c->gain = m->gain_K_per_raw;
+  c->offset = m->offset_K;
+  c->e = (m->emissivity > 0.f && m->emissivity < 1.f) ? m->emissivity : 1.f;
+  c->amb4 = amb * amb * amb * amb;
+}
+
+/* ===== Row kernels ===== */
+static void affine_row(const uint16_t* px, int n, float gain, float off, float* out) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 vg = _mm_set1_ps(gain), vo = _mm_set1_ps(off);
+  for (; x + 8 <= n; x += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(px + x));
+    __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+    __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+    _mm_storeu_ps(out + x,     _mm_add_ps(_mm_mul_ps(lo, vg), vo));
+    _mm_storeu_ps(out + x + 4, _mm_add_ps(_mm_mul_ps(hi, vg), vo));
+  }
+#elif defined(TC001_NEON)
+  const float32x4_t vo = vdupq_n_f32(off);
+  for (; x + 8 <= n; x += 8) {
+    uint16x8_t v = vld1q_u16(px + x);
+    float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+    float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+    vst1q_f32(out + x,     vmlaq_n_f32(vo, lo, gain));
+    vst1q_f32(out + x + 4, vmlaq_n_f32(vo, hi, gain));
+  }
+#endif
+  for (; x < n; ++x) out[x] = (float)px[x] * gain + off;
+}
+
+/* In place, Kelvin in and out (plus bias). e_px may be NULL, in which case
+   the scalar e applies; per-pixel values are clamped to [0.01, 1]. */
+static void grey_row(float* k, int n, const float* e_px, float e, float amb4, float bias) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128 one = _mm_set1_ps(1.f), emin = _mm_set1_ps(0.01f);
+  const __m128 va = _mm_set1_ps(amb4), vb = _mm_set1_ps(bias), zero = _mm_setzero_ps();
+  __m128 ve = _mm_set1_ps(e);
+  for (; x + 4 <= n; x += 4) {
+    if (e_px) ve = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(e_px + x), emin), one);
+    __m128 t = _mm_loadu_ps(k + x);
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 r = _mm_sub_ps(_mm_mul_ps(t2, t2), _mm_mul_ps(_mm_sub_ps(one, ve), va));
+    r = _mm_max_ps(_mm_div_ps(r, ve), zero);
+    _mm_storeu_ps(k + x, _mm_add_ps(_mm_sqrt_ps(_mm_sqrt_ps(r)), vb));
+  }
+#elif defined(TC001_NEON)
+  const float32x4_t one = vdupq_n_f32(1.f), emin = vdupq_n_f32(0.01f);
+  const float32x4_t va = vdupq_n_f32(amb4), vb = vdupq_n_f32(bias), zero = vdupq_n_f32(0.f);
+  float32x4_t ve = vdupq_n_f32(e);
+  for (; x + 4 <= n; x += 4) {
+    if (e_px) ve = vminq_f32(vmaxq_f32(vld1q_f32(e_px + x), emin), one);
+    float32x4_t t = vld1q_f32(k + x);
+    float32x4_t t2 = vmulq_f32(t, t);
+    float32x4_t r = vmlsq_f32(vmulq_f32(t2, t2), vsubq_f32(one, ve), va);
+    r = vmaxq_f32(vdivq_f32(r, ve), zero);
+    vst1q_f32(k + x, vaddq_f32(vsqrtq_f32(vsqrtq_f32(r)), vb));
+  }
+#endif
+  for (; x < n; ++x) {
+    float ex = e;
+    if (e_px) ex = e_px[x] < 0.01f ? 0.01f : (e_px[x] > 1.f ? 1.f : e_px[x]);
+    float t2 = k[x] * k[x];
+    float r = (t2 * t2 - (1.f - ex) * amb4) / ex;
+    k[x] = sqrtf(sqrtf(r > 0.f ? r : 0.f)) + bias;
+  }
+}
+
+static void lut_row(const uint16_t* px, int n, const float* lut, float bias, float* out) {
+  for (int x = 0; x < n; ++x) out[x] = lut[px[x]] + bias;
+}
+
+/* Kelvin to hundredths of a degree Celsius, rounded and saturated */
+static void centi_row(const float* k, int n, int16_t* out) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128 c0 = _mm_set1_ps(KELVIN_0C), s = _mm_set1_ps(100.f);
+  const __m128 lo = _mm_set1_ps(-32768.f), hi = _mm_set1_ps(32767.f);
+  for (; x + 8 <= n; x += 8) {
+    __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(k + x), c0), s);
+    __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(k + x + 4), c0), s);
+    a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+    b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+    _mm_storeu_si128((__m128i*)(out + x), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+#elif defined(TC001_NEON)
+  const float32x4_t c0 = vdupq_n_f32(KELVIN_0C);
+  for (; x + 8 <= n; x += 8) {
+    float32x4_t a = vmulq_n_f32(vsubq_f32(vld1q_f32(k + x), c0), 100.f);
+    float32x4_t b = vmulq_n_f32(vsubq_f32(vld1q_f32(k + x + 4), c0), 100.f);
+    vst1q_s16(out + x, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+  }
+#endif
+  for (; x < n; ++x) {
+    float c = (k[x] - KELVIN_0C) * 100.f;
+    c = c < -32768.f ? -32768.f : (c > 32767.f ? 32767.f : c);
+    out[x] = (int16_t)lrintf(c);
+  }
+}
+
+/* ===== Model LUT ===== */
+/* One table per thread, keyed by model_id and rebuilt when that model's
+   parameters change. Built with the row kernels so table and direct paths
+   agree bit for bit. */
+typedef struct {
+  float* tab;
+  int valid;
+  uint32_t model_id;
+  conv key;
+} temp_lut;
+
+static TC001_THREAD_LOCAL temp_lut tls_lut;
+
+static const float* lut_for(const tc001_temp_model* m, const conv* c) {
+  temp_lut* l = &tls_lut;
+  if (l->valid && l->model_id == m->model_id && memcmp(&l->key, c, sizeof(*c)) == 0)
+    return l->tab;
+  if (!l->tab && !(l->tab = (float*)malloc(65536 * sizeof(float)))) return NULL;
+
+  uint16_t raw[CHUNK];
+  for (uint32_t base = 0; base < 65536; base += CHUNK) {
+    for (int i = 0; i < CHUNK; ++i) raw[i] = (uint16_t)(base + i);
+    affine_row(raw, CHUNK, c->gain, c->offset, l->tab + base);
+    grey_row(l->tab + base, CHUNK, NULL, c->e, c->amb4, 0.f);
+  }
+  l->valid = 1;
+  l->model_id = m->model_id;
+  l->key = *c;
+  return l->tab;
+}
+
+/* ===== Conversion ===== */
+/* Single value through the same kernels, for per-object readouts */
+float tc001__temp_c(const tc001_temp_model* m, uint16_t raw) {
+  conv c;
+  float k;
+  conv_init(&c, m);
+  affine_row(&raw, 1, c.gain, c.offset, &k);
+  if (c.e < 1.f) grey_row(&k, 1, NULL, c.e, c.amb4, 0.f);
+  return k - KELVIN_0C;
+}
+
+/* Produces Kelvin + bias for one row (or part of one) */
+static void kelvin_row(const conv* c, const float* lut, const uint16_t* px,
+                       const float* e_px, int n, float bias, float* out)
+{
+  if (lut) {
+    lut_row(px, n, lut, bias, out);
+  } else if (e_px) {
+    affine_row(px, n, c->gain, c->offset, out);
+    grey_row(out, n, e_px, c->e, c->amb4, bias);
+  } else {
+    affine_row(px, n, c->gain, c->offset + bias, out);
+  }
+}
+
+static tc001_status prepare(const tc001_frame* f, const tc001_temp_model* m,
+                            const float* emissivity, const void* dst, int dst_stride,
+                            size_t elem, conv* c, const float** lut)
+{
+  if (!f || !f->data || !m || !dst || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width <= 0 || f->height <= 0 || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  if (dst_stride < 0 || (size_t)dst_stride < (size_t)f->width * elem) return TC001_ERR_PARAM;
+  if (!m->has_temp) return TC001_ERR_STATE;
+
+  conv_init(c, m);
+  *lut = NULL;
+  if (c->e < 1.f && !emissivity && !(*lut = lut_for(m, c))) return TC001_ERR_ALLOC;
+  return TC001_OK;
+}
+
+tc001_status tc001_frame_to_temp(const tc001_frame* f, const tc001_temp_model* m,
+                                 const float* emissivity, tc001_temp_unit unit,
+                                 float* dst, int dst_stride)
+{
+  conv c;
+  const float* lut;
+  tc001_status st = prepare(f, m, emissivity, dst, dst_stride, sizeof(float), &c, &lut);
+  if (st != TC001_OK) return st;
+
+  const float bias = unit == TC001_TEMP_CELSIUS ? -KELVIN_0C : 0.f;
+  for (int y = 0; y < f->height; ++y) {
+    const uint16_t* px = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    const float* e_px = emissivity ? emissivity + (size_t)y * f->width : NULL;
+    float* out = (float*)((uint8_t*)dst + (size_t)y * dst_stride);
+    kelvin_row(&c, lut, px, e_px, f->width, bias, out);
+  }
+  return TC001_OK;
+}
+
+tc001_status tc001_frame_to_centi_c(const tc001_frame* f, const tc001_temp_model* m,
+                                    const float* emissivity,
+                                    int16_t* dst, int dst_stride)
+{
+  conv c;
+  const float* lut;
+  tc001_status st = prepare(f, m, emissivity, dst, dst_stride, sizeof(int16_t), &c, &lut);
+  if (st != TC001_OK) return st;
+
+  float k[CHUNK];
+  for (int y = 0; y < f->height; ++y) {
+    const uint16_t* px = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    const float* e_px = emissivity ? emissivity + (size_t)y * f->width : NULL;
+    int16_t* out = (int16_t*)((uint8_t*)dst + (size_t)y * dst_stride);
+    for (int x = 0; x < f->width; x += CHUNK) {
+      int n = f->width - x < CHUNK ? f->width - x : CHUNK;
+      kelvin_row(&c, lut, px + x, e_px ? e_px + x : NULL, n, 0.f, k);
+      centi_row(k, n, out + x);
+    }
+  }
+  return TC001_OK;
+}
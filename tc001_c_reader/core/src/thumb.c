@@ -0,0 +1,222 @@
+#include "tc001_internal.h"
+#include "tc001_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Area-averaging downscale, done separably and streamed row by row.
+
+   On the scaled axis a source pixel x covers [x*tw, (x+1)*tw) and thumbnail
+   column j covers [j*w, (j+1)*w); the overlap is the integer weight of x in
+   j, and the weights of one column add up to w. Rows work the same way with
+   th and h. Because tw <= w and th <= h, a source row feeds at most two
+   thumbnail rows and a source column at most two thumbnail columns.
+
+   The per-pixel work is the vertical pass: each source row is widened to
+   float, scaled by its row weight and added into one or two band buffers,
+   which vectorises cleanly for any ratio. A band is collapsed horizontally
+   only when its thumbnail row is complete, i.e. th times per frame. */
+
+/* ===== Plan ===== */
+static int grow(void** p, size_t* cap, size_t n, size_t elem) {
+  if (*cap >= n) return 0;
+  void* q = realloc(*p, n * elem);
+  if (!q) return -1;
+  *p = q; *cap = n;
+  return 0;
+}
+
+tc001_status tc001__thumb_plan_init(tc001_thumb_plan* p, int w, int h, int tw, int th) {
+  if (w <= 0 || h <= 0 || tw <= 0 || th <= 0) return TC001_ERR_PARAM;
+  if (tw > w) tw = w;
+  if (th > h) th = h;
+
+  if (grow((void**)&p->band, &p->band_cap, (size_t)w * 2, sizeof(float)) ||
+      grow((void**)&p->acc, &p->acc_cap, (size_t)tw * th, sizeof(float)) ||
+      grow((void**)&p->col, &p->col_cap, (size_t)tw, sizeof(*p->col)))
+    return TC001_ERR_ALLOC;
+
+  p->w = w; p->h = h; p->tw = tw; p->th = th;
+  p->cur = 0;
+
+  for (int j = 0; j < tw; ++j) {
+    int64_t a = (int64_t)j * w, b = a + w;
+    int x0 = (int)(a / tw), x1 = (int)((b - 1) / tw);
+    int64_t first_end = (int64_t)(x0 + 1) * tw;
+    p->col[j].x0 = x0;
+    p->col[j].x1 = x1;
+    p->col[j].w0 = (float)((first_end < b ? first_end : b) - a);
+    p->col[j].w1 = (float)(b - (int64_t)x1 * tw);
+  }
+  p->full_w = (float)tw;
+  p->norm = 1.f / ((float)w * (float)h);
+
+  memset(p->band, 0, (size_t)w * 2 * sizeof(float));
+  return TC001_OK;
+}
+
+void tc001__thumb_plan_free(tc001_thumb_plan* p) {
+  free(p->band);
+  free(p->acc);
+  free(p->col);
+  memset(p, 0, sizeof(*p));
+}
+
+/* ===== Vertical pass ===== */
+static void band_add(float* band, const uint16_t* px, int w, float wt) {
+  int x = 0;
+#if defined(TC001_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 vw = _mm_set1_ps(wt);
+  for (; x + 8 <= w; x += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(px + x));
+    __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+    __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+    _mm_storeu_ps(band + x,     _mm_add_ps(_mm_loadu_ps(band + x),     _mm_mul_ps(lo, vw)));
+    _mm_storeu_ps(band + x + 4, _mm_add_ps(_mm_loadu_ps(band + x + 4), _mm_mul_ps(hi, vw)));
+  }
+#elif defined(TC001_NEON)
+  for (; x + 8 <= w; x += 8) {
+    uint16x8_t v = vld1q_u16(px + x);
+    float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+    float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+    vst1q_f32(band + x,     vmlaq_n_f32(vld1q_f32(band + x),     lo, wt));
+    vst1q_f32(band + x + 4, vmlaq_n_f32(vld1q_f32(band + x + 4), hi, wt));
+  }
+#endif
+  for (; x < w; ++x) band[x] += (float)px[x] * wt;
+}
+
+/* ===== Horizontal collapse ===== */
+/* Interior spans are short at thumbnail ratios (w / tw - 1 pixels), so the
+   vector reduction only pays off on long ones. */
+static float span_sum(const float* b, int x0, int x1) {
+  int x = x0;
+  float s = 0.f;
+#if defined(TC001_SSE2)
+  if (x1 - x0 >= 8) {
+    __m128 acc = _mm_setzero_ps();
+    for (; x + 4 <= x1; x += 4) acc = _mm_add_ps(acc, _mm_loadu_ps(b + x));
+    float t[4];
+    _mm_storeu_ps(t, acc);
+    s = (t[0] + t[1]) + (t[2] + t[3]);
+  }
+#elif defined(TC001_NEON)
+  if (x1 - x0 >= 8) {
+    float32x4_t acc = vdupq_n_f32(0.f);
+    for (; x + 4 <= x1; x += 4) acc = vaddq_f32(acc, vld1q_f32(b + x));
+    s = vaddvq_f32(acc);
+  }
+#endif
+  for (; x < x1; ++x) s += b[x];
+  return s;
+}
+
+static void collapse(tc001_thumb_plan* p, float* band, int ty) {
+  float* out = p->acc + (size_t)ty * p->tw;
+  const float full = p->full_w * p->norm;
+  for (int j = 0; j < p->tw; ++j) {
+    const int x0 = p->col[j].x0, x1 = p->col[j].x1;
+    float s = band[x0] * p->col[j].w0;
+    if (x1 > x0) s += band[x1] * p->col[j].w1;
+    s *= p->norm;
+    if (x1 > x0 + 1) s += span_sum(band, x0 + 1, x1) * full;
+    out[j] = s;
+  }
+  memset(band, 0, (size_t)p->w * sizeof(float));
+}
+
+void tc001__thumb_row(tc001_thumb_plan* p, int y, const uint16_t* px) {
+  const int64_t a = (int64_t)y * p->th, b = a + p->th;
+  const int ty = (int)(a / p->h);
+  const int64_t edge = (int64_t)(ty + 1) * p->h;
+  float* cur = p->band + (size_t)p->cur * p->w;
+
+  if (b <= edge) {
+    band_add(cur, px, p->w, (float)p->th);
+  } else {
+    float* nxt = p->band + (size_t)(p->cur ^ 1) * p->w;
+    band_add(cur, px, p->w, (float)(edge - a));
+    band_add(nxt, px, p->w, (float)(b - edge));
+  }
+
+  if (b >= edge) {
+    collapse(p, cur, ty);
+    p->cur ^= 1;
+  }
+}
+
+void tc001__thumb_finish(const tc001_thumb_plan* p, uint16_t lo, uint16_t hi,
+                         int use_agc, uint8_t* dst, int pitch)
+{
+  /* AGC maps the float mean directly, which matches tc001__agc_u8 on the
+     rounded mean except at exact .5 ties */
+  const float scale = tc001__agc_scale(lo, hi);
+  const float bias = use_agc ? -(float)lo : 0.f;
+  const float mul = use_agc ? scale : 1.f;
+  const float top = use_agc ? 255.f : 65535.f;
+  const int shift = use_agc ? 0 : 8;
+  for (int ty = 0; ty < p->th; ++ty) {
+    const float* m = p->acc + (size_t)ty * p->tw;
+    uint8_t* out = dst + (size_t)ty * pitch;
+    int tx = 0;
+#if defined(TC001_SSE2)
+    const __m128 vb = _mm_set1_ps(bias), vm = _mm_set1_ps(mul);
+    const __m128 vh = _mm_set1_ps(0.5f), vt = _mm_set1_ps(top), vz = _mm_setzero_ps();
+    for (; tx + 8 <= p->tw; tx += 8) {
+      __m128 a = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(m + tx), vb), vm), vh);
+      __m128 b = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(m + tx + 4), vb), vm), vh);
+      __m128i ia = _mm_srli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(a, vz), vt)), shift);
+      __m128i ib = _mm_srli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(b, vz), vt)), shift);
+      __m128i w16 = _mm_packs_epi32(ia, ib);
+      _mm_storel_epi64((__m128i*)(out + tx), _mm_packus_epi16(w16, w16));
+    }
+#elif defined(TC001_NEON)
+    const float32x4_t vb = vdupq_n_f32(bias), vh = vdupq_n_f32(0.5f);
+    const float32x4_t vt = vdupq_n_f32(top), vz = vdupq_n_f32(0.f);
+    const int32x4_t vs = vdupq_n_s32(-shift);
+    for (; tx + 8 <= p->tw; tx += 8) {
+      float32x4_t a = vmlaq_n_f32(vh, vaddq_f32(vld1q_f32(m + tx), vb), mul);
+      float32x4_t b = vmlaq_n_f32(vh, vaddq_f32(vld1q_f32(m + tx + 4), vb), mul);
+      uint32x4_t ia = vshlq_u32(vcvtq_u32_f32(vminq_f32(vmaxq_f32(a, vz), vt)), vs);
+      uint32x4_t ib = vshlq_u32(vcvtq_u32_f32(vminq_f32(vmaxq_f32(b, vz), vt)), vs);
+      uint16x8_t w16 = vcombine_u16(vmovn_u32(ia), vmovn_u32(ib));
+      vst1_u8(out + tx, vmovn_u16(w16));
+    }
+#endif
+    for (; tx < p->tw; ++tx) {
+      float u = (m[tx] + bias) * mul + 0.5f;
+      if (u < 0.f) u = 0.f;
+      if (u > top) u = top;
+      out[tx] = (uint8_t)((uint32_t)u >> shift);
+    }
+  }
+}
+
+/* ===== Public API ===== */
+static TC001_THREAD_LOCAL tc001_thumb_plan tls_plan;
+
+tc001_status tc001_thumbnail(const tc001_frame* f, uint8_t* dst,
+                             int thumb_w, int thumb_h, int pitch, int use_agc)
+{
+  if (!f || !f->data || !dst || f->format != TC001_FMT_U16) return TC001_ERR_PARAM;
+  if (f->width <= 0 || f->height <= 0 || f->stride < f->width * 2) return TC001_ERR_PARAM;
+  if (thumb_w <= 0 || thumb_h <= 0 || thumb_w > f->width || thumb_h > f->height) return TC001_ERR_PARAM;
+  if (pitch < thumb_w) return TC001_ERR_PARAM;
+
+  tc001_status st = tc001__thumb_plan_init(&tls_plan, f->width, f->height, thumb_w, thumb_h);
+  if (st != TC001_OK) return st;
+
+  /* AGC range: reuse the stats the library attached, else track min/max
+     in the same pass as the downscale */
+  int track = use_agc && !f->stats;
+  uint16_t lo = 0xFFFF, hi = 0;
+  for (int y = 0; y < f->height; ++y) {
+    const uint16_t* row = (const uint16_t*)(f->data + (size_t)y * f->stride);
+    tc001__thumb_row(&tls_plan, y, row);
+    if (track) tc001__minmax_u16(row, f->width, &lo, &hi);
+  }
+  if (use_agc && f->stats) { lo = f->stats->raw_min; hi = f->stats->raw_max; }
+
+  tc001__thumb_finish(&tls_plan, lo, hi, use_agc, dst, pitch);
+  return TC001_OK;
+}
@@ -0,0 +1,598 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE               /* sendmmsg */
+#endif
+#include "tc001_udp.h"
+#include "tc001_internal.h"
+#include <string.h>
+
+#ifdef _WIN32
+
+tc001_status tc001_udp_sender_create(tc001_udp_sender** out, const tc001_udp_sender_options* opts) {
+  (void)out; (void)opts;
+  return TC001_ERR_STATE;
+}
+void tc001_udp_sender_destroy(tc001_udp_sender* s) { (void)s; }
+tc001_status tc001_udp_send(tc001_udp_sender* s, const tc001_frame* f) {
+  (void)s; (void)f;
+  return TC001_ERR_STATE;
+}
+void tc001_udp_request_keyframe(tc001_udp_sender* s) { (void)s; }
+void tc001_udp_sender_get_stats(const tc001_udp_sender* s, tc001_udp_sender_stats* out) {
+  (void)s;
+  if (out) memset(out, 0, sizeof(*out));
+}
+tc001_status tc001_udp_receiver_create(tc001_udp_receiver** out, const tc001_udp_receiver_options* opts) {
+  (void)out; (void)opts;
+  return TC001_ERR_STATE;
+}
+void tc001_udp_receiver_destroy(tc001_udp_receiver* r) { (void)r; }
+int  tc001_udp_receiver_port(const tc001_udp_receiver* r) { (void)r; return 0; }
+tc001_status tc001_udp_receive(tc001_udp_receiver* r, tc001_frame* out, tc001_udp_frame_info* info,
+                               int timeout_ms) {
+  (void)r; (void)out; (void)info; (void)timeout_ms;
+  return TC001_ERR_STATE;
+}
+void tc001_udp_receiver_get_stats(const tc001_udp_receiver* r, tc001_udp_receiver_stats* out) {
+  (void)r;
+  if (out) memset(out, 0, sizeof(*out));
+}
+
+#else
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* ===== Wire format =====
+   RTP header, network order:
+     V=2, no padding/extension/CSRC; marker on the frame's last packet;
+     payload type 96; sequence number; 90 kHz timestamp; SSRC.
+   Frame header, little-endian:
+      0 frame number u32 (the sender's count; marks frame boundaries)
+      4 timestamp_ns i64    12 width u16           14 height u16
+     16 tile edge u8        17 flags u8 (FLAG_KEY)
+     18 tiles in packet u16 20 tiles in the frame u16   22 reserved u16
+     24 frame_id u32 (as delivered to the sender)
+   Then per tile: its index u16 (row-major over the tile grid) and its
+   pixels row by row; tiles on the right and bottom edges are cropped to
+   the frame. */
+#define RTP_HEADER        12
+#define FRAME_HEADER      28
+#define HEADERS           (RTP_HEADER + FRAME_HEADER)
+#define FLAG_KEY          1
+#define PACKET_MAX        65507
+#define DEFAULT_TILE      16
+#define DEFAULT_KEYFRAMES 25
+#define DEFAULT_MTU       1400
+#define BATCH             64      /* packets per sendmmsg */
+#define SOCKET_BUF        (1 << 20)
+#define SENDER_SILENT_NS  1000000000LL    /* before another SSRC is followed */
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+static uint32_t get16(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | (get16(p + 2) << 16); }
+
+static void put16be(uint8_t* p, uint32_t v) { p[0] = (uint8_t)(v >> 8); p[1] = (uint8_t)v; }
+static void put32be(uint8_t* p, uint32_t v) { put16be(p, v >> 16); put16be(p + 2, v); }
+static uint32_t get16be(const uint8_t* p) { return ((uint32_t)p[0] << 8) | p[1]; }
+
+static int tile_count(int n, int tile) { return (n + tile - 1) / tile; }
+
+/* ===== Sender ===== */
+struct tc001_udp_sender {
+  int       fd;
+  struct sockaddr_in to;
+  int       tile, threshold, key_interval, mtu;
+  int       per_packet;           /* tiles that fit one packet */
+  uint32_t  ssrc;
+  uint16_t  seq;
+  uint32_t  frame_no;
+  int       since_key;
+  int       force_key;
+  int       width, height, tiles_x, tiles_y;
+  uint16_t* ref;                  /* what the receiver holds */
+  uint16_t* changed;              /* indices of the tiles to send */
+  uint8_t*  pkt;                  /* BATCH packets of mtu bytes */
+  size_t    pkt_len[BATCH];
+  int       npkt;
+  tc001_udp_sender_stats stats;
+};
+
+tc001_status tc001_udp_sender_create(tc001_udp_sender** out, const tc001_udp_sender_options* opts) {
+  if (!out || !opts || !opts->host || opts->port <= 0 || opts->port > 65535 || opts->threshold < 0 ||
+      opts->mtu < 0 || opts->mtu > PACKET_MAX)
+    return TC001_ERR_PARAM;
+  const int tile = opts->tile ? opts->tile : DEFAULT_TILE;
+  const int mtu = opts->mtu ? opts->mtu : DEFAULT_MTU;
+  const int per_packet = (mtu - HEADERS) / (2 + tile * tile * 2);
+  if (tile < 4 || tile > 32 || per_packet < 1) return TC001_ERR_PARAM;
+  struct sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons((uint16_t)opts->port);
+  if (inet_pton(AF_INET, opts->host, &to.sin_addr) != 1) return TC001_ERR_PARAM;
+
+  tc001_udp_sender* s = (tc001_udp_sender*)calloc(1, sizeof(*s));
+  if (!s) return TC001_ERR_ALLOC;
+  s->to = to;
+  s->tile = tile;
+  s->mtu = mtu;
+  s->per_packet = per_packet;
+  s->threshold = opts->threshold;
+  s->key_interval = opts->keyframe_interval ? opts->keyframe_interval : DEFAULT_KEYFRAMES;
+  s->force_key = 1;
+  const uint64_t seed = (uint64_t)tc001__wall_ns() ^ ((uint64_t)tc001__pid() << 32);
+  s->ssrc = (uint32_t)(seed ^ (seed >> 29));
+  s->seq = (uint16_t)(seed >> 7);
+  s->pkt = (uint8_t*)malloc((size_t)BATCH * mtu);
+  s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (!s->pkt || s->fd < 0) {
+    tc001_status st = s->pkt ? TC001_ERR_IO : TC001_ERR_ALLOC;
+    tc001_udp_sender_destroy(s);
+    return st;
+  }
+  fcntl(s->fd, F_SETFD, FD_CLOEXEC);
+  int buf = SOCKET_BUF;
+  setsockopt(s->fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof buf);
+  *out = s;
+  return TC001_OK;
+}
+
+void tc001_udp_sender_destroy(tc001_udp_sender* s) {
+  if (!s) return;
+  if (s->fd >= 0) close(s->fd);
+  free(s->ref);
+  free(s->changed);
+  free(s->pkt);
+  free(s);
+}
+
+void tc001_udp_request_keyframe(tc001_udp_sender* s) {
+  if (s) s->force_key = 1;
+}
+
+void tc001_udp_sender_get_stats(const tc001_udp_sender* s, tc001_udp_sender_stats* out) {
+  if (!out) return;
+  if (s) *out = s->stats;
+  else memset(out, 0, sizeof(*out));
+}
+
+/* Sends the batched packets; 0 if any failed. */
+static int flush(tc001_udp_sender* s) {
+  int ok = 1;
+#ifdef __linux__
+  struct mmsghdr m[BATCH];
+  struct iovec v[BATCH];
+  memset(m, 0, sizeof(m[0]) * (size_t)s->npkt);
+  for (int i = 0; i < s->npkt; ++i) {
+    v[i].iov_base = s->pkt + (size_t)i * s->mtu;
+    v[i].iov_len = s->pkt_len[i];
+    m[i].msg_hdr.msg_name = &s->to;
+    m[i].msg_hdr.msg_namelen = sizeof(s->to);
+    m[i].msg_hdr.msg_iov = &v[i];
+    m[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (int i = 0; i < s->npkt;) {
+    int n = sendmmsg(s->fd, m + i, (unsigned)(s->npkt - i), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {                 /* skip the packet that failed */
+      s->stats.send_errors++;
+      ok = 0;
+      ++i;
+      continue;
+    }
+    i += n;
+  }
+#else
+  for (int i = 0; i < s->npkt; ++i) {
+    ssize_t n;
+    do n = sendto(s->fd, s->pkt + (size_t)i * s->mtu, s->pkt_len[i], 0,
+                  (const struct sockaddr*)&s->to, sizeof(s->to));
+    while (n < 0 && errno == EINTR);
+    if (n < 0) {
+      s->stats.send_errors++;
+      ok = 0;
+    }
+  }
+#endif
+  s->npkt = 0;
+  return ok;
+}
+
+/* 1 when some pixel of the tile moved by more than the threshold. */
+static int tile_changed(const tc001_udp_sender* s, const tc001_frame* f, int x0, int y0, int tw, int th) {
+  for (int y = y0; y < y0 + th; ++y) {
+    const uint16_t* a = (const uint16_t*)(f->data + (size_t)y * f->stride) + x0;
+    const uint16_t* b = s->ref + (size_t)y * s->width + x0;
+    if (s->threshold == 0) {
+      if (memcmp(a, b, (size_t)tw * 2)) return 1;
+      continue;
+    }
+    for (int x = 0; x < tw; ++x) {
+      int d = (int)a[x] - (int)b[x];
+      if (d > s->threshold || -d > s->threshold) return 1;
+    }
+  }
+  return 0;
+}
+
+/* Starts packet s->npkt; returns where its tiles go. */
+static uint8_t* packet_begin(tc001_udp_sender* s, const tc001_frame* f, int key, uint32_t rtp_ts,
+                             int ntiles) {
+  uint8_t* p = s->pkt + (size_t)s->npkt * s->mtu;
+  p[0] = 0x80;                    /* V=2 */
+  p[1] = TC001_UDP_PAYLOAD_TYPE;
+  put16be(p + 2, s->seq++);
+  put32be(p + 4, rtp_ts);
+  put32be(p + 8, s->ssrc);
+  uint8_t* h = p + RTP_HEADER;
+  memset(h, 0, FRAME_HEADER);
+  put32(h, s->frame_no);
+  put32(h + 4, (uint32_t)f->timestamp_ns);
+  put32(h + 8, (uint32_t)((uint64_t)f->timestamp_ns >> 32));
+  put16(h + 12, (uint32_t)f->width);
+  put16(h + 14, (uint32_t)f->height);
+  h[16] = (uint8_t)s->tile;
+  h[17] = key ? FLAG_KEY : 0;
+  put16(h + 20, (uint32_t)ntiles);
+  put32(h + 24, f->frame_id);
+  return h + FRAME_HEADER;
+}
+
+static void packet_end(tc001_udp_sender* s, uint8_t* end, int tiles_in_packet, int last) {
+  uint8_t* p = s->pkt + (size_t)s->npkt * s->mtu;
+  if (last) p[1] |= 0x80;         /* marker */
+  put16(p + RTP_HEADER + 18, (uint32_t)tiles_in_packet);
+  s->pkt_len[s->npkt++] = (size_t)(end - p);
+}
+
+tc001_status tc001_udp_send(tc001_udp_sender* s, const tc001_frame* f) {
+  if (!s || !f || !f->data || f->format != TC001_FMT_U16 || f->width <= 0 || f->height <= 0 ||
+      f->width > 65535 || f->height > 65535)
+    return TC001_ERR_PARAM;
+  const int64_t t0 = tc001__now_ns();
+  const int tiles_x = tile_count(f->width, s->tile), tiles_y = tile_count(f->height, s->tile);
+  const int total = tiles_x * tiles_y;
+  if (total > 65535) return TC001_ERR_PARAM;
+
+  int key = s->force_key || (s->key_interval > 0 && s->since_key >= s->key_interval);
+  if (f->width != s->width || f->height != s->height) {
+    uint16_t* ref = (uint16_t*)malloc((size_t)f->width * f->height * 2);
+    uint16_t* changed = (uint16_t*)malloc((size_t)total * sizeof(uint16_t));
+    if (!ref || !changed) {
+      free(ref);
+      free(changed);
+      return TC001_ERR_ALLOC;
+    }
+    free(s->ref);
+    free(s->changed);
+    s->ref = ref;
+    s->changed = changed;
+    s->width = f->width;
+    s->height = f->height;
+    s->tiles_x = tiles_x;
+    s->tiles_y = tiles_y;
+    key = 1;
+  }
+  s->force_key = 0;
+  s->since_key = key ? 1 : s->since_key + 1;
+
+  int n = 0;
+  for (int i = 0; i < total; ++i) {
+    const int x0 = (i % tiles_x) * s->tile, y0 = (i / tiles_x) * s->tile;
+    const int tw = f->width - x0 < s->tile ? f->width - x0 : s->tile;
+    const int th = f->height - y0 < s->tile ? f->height - y0 : s->tile;
+    if (key || tile_changed(s, f, x0, y0, tw, th)) s->changed[n++] = (uint16_t)i;
+  }
+
+  /* pack; the receiver's copy of a tile is updated as it is queued */
+  const int64_t ts = f->timestamp_ns;
+  const uint32_t rtp_ts = (uint32_t)(ts / 100000 * 9 + ts % 100000 * 9 / 100000);
+  int ok = 1;
+  int k = 0;
+  do {
+    const int in_packet = n - k < s->per_packet ? n - k : s->per_packet;
+    uint8_t* p = packet_begin(s, f, key, rtp_ts, n);
+    for (int j = 0; j < in_packet; ++j, ++k) {
+      const int i = s->changed[k];
+      const int x0 = (i % tiles_x) * s->tile, y0 = (i / tiles_x) * s->tile;
+      const int tw = f->width - x0 < s->tile ? f->width - x0 : s->tile;
+      const int th = f->height - y0 < s->tile ? f->height - y0 : s->tile;
+      put16(p, (uint32_t)i);
+      p += 2;
+      for (int y = y0; y < y0 + th; ++y) {
+        const uint8_t* row = f->data + (size_t)y * f->stride + (size_t)x0 * 2;
+        memcpy(p, row, (size_t)tw * 2);
+        memcpy(s->ref + (size_t)y * s->width + x0, row, (size_t)tw * 2);
+        p += (size_t)tw * 2;
+      }
+    }
+    packet_end(s, p, in_packet, k == n);
+    s->stats.bytes += s->pkt_len[s->npkt - 1];
+    s->stats.packets++;
+    if (s->npkt == BATCH && !flush(s)) ok = 0;
+  } while (k < n);
+  if (s->npkt && !flush(s)) ok = 0;
+
+  s->frame_no++;
+  s->stats.frames++;
+  s->stats.keyframes += key;
+  s->stats.tiles += (uint64_t)total;
+  s->stats.tiles_sent += (uint64_t)n;
+  s->stats.diff_ns += (uint64_t)(tc001__now_ns() - t0);
+  return ok ? TC001_OK : TC001_ERR_IO;
+}
+
+/* ===== Receiver ===== */
+struct tc001_udp_receiver {
+  int       fd;
+  int       port;
+  uint8_t*  pkt;
+  size_t    pkt_len;
+  int       held;                 /* pkt opens the next frame; not yet applied */
+  int       width, height, tile, tiles;
+  uint16_t* img;
+  uint8_t*  valid;                /* per tile: equal to the sender's reference */
+  int       invalid;              /* tiles not valid */
+  int       have_ssrc, have_seq, have_no;
+  uint32_t  ssrc;                 /* the sender followed */
+  int64_t   ssrc_seen_ns;         /* its last packet */
+  uint16_t  next_seq;
+  uint32_t  last_no;              /* of the last frame finished */
+
+  /* the frame being assembled */
+  int       assembling;
+  uint32_t  frame_no, frame_id;
+  int64_t   timestamp_ns;
+  int       key, expected, got, gap;
+  int       last_index;           /* of the last tile applied; -1 = none yet */
+  tc001_udp_receiver_stats stats;
+};
+
+tc001_status tc001_udp_receiver_create(tc001_udp_receiver** out, const tc001_udp_receiver_options* opts) {
+  if (!out || !opts || opts->port < 0 || opts->port > 65535) return TC001_ERR_PARAM;
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons((uint16_t)opts->port);
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (opts->address && inet_pton(AF_INET, opts->address, &sa.sin_addr) != 1) return TC001_ERR_PARAM;
+
+  tc001_udp_receiver* r = (tc001_udp_receiver*)calloc(1, sizeof(*r));
+  if (!r) return TC001_ERR_ALLOC;
+  r->pkt = (uint8_t*)malloc(PACKET_MAX);
+  r->fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (!r->pkt || r->fd < 0) {
+    tc001_status st = r->pkt ? TC001_ERR_IO : TC001_ERR_ALLOC;
+    tc001_udp_receiver_destroy(r);
+    return st;
+  }
+  fcntl(r->fd, F_SETFD, FD_CLOEXEC);
+  int buf = SOCKET_BUF;           /* a keyframe arrives as one burst */
+  setsockopt(r->fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof buf);
+  socklen_t len = sizeof(sa);
+  if (bind(r->fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 ||
+      getsockname(r->fd, (struct sockaddr*)&sa, &len) != 0) {
+    tc001_udp_receiver_destroy(r);
+    return TC001_ERR_IO;
+  }
+  r->port = ntohs(sa.sin_port);
+  *out = r;
+  return TC001_OK;
+}
+
+void tc001_udp_receiver_destroy(tc001_udp_receiver* r) {
+  if (!r) return;
+  if (r->fd >= 0) close(r->fd);
+  free(r->pkt);
+  free(r->img);
+  free(r->valid);
+  free(r);
+}
+
+int tc001_udp_receiver_port(const tc001_udp_receiver* r) { return r ? r->port : 0; }
+
+void tc001_udp_receiver_get_stats(const tc001_udp_receiver* r, tc001_udp_receiver_stats* out) {
+  if (!out) return;
+  if (r) *out = r->stats;
+  else memset(out, 0, sizeof(*out));
+}
+
+/* Tiles [from, to) may have been in a lost packet. */
+static void invalidate(tc001_udp_receiver* r, int from, int to) {
+  for (int i = from; i < to; ++i) {
+    r->invalid += r->valid[i];
+    r->valid[i] = 0;
+  }
+}
+
+static void finish(tc001_udp_receiver* r, tc001_frame* out, tc001_udp_frame_info* info) {
+  const int complete = r->got == r->expected && !r->gap;
+  if (r->got < r->expected) invalidate(r, r->last_index + 1, r->tiles);   /* the tail is missing */
+  r->assembling = 0;
+  r->have_no = 1;
+  r->last_no = r->frame_no;
+  r->stats.frames++;
+  r->stats.exact_frames += r->invalid == 0;
+  memset(out, 0, sizeof(*out));
+  out->width = r->width;
+  out->height = r->height;
+  out->stride = r->width * 2;
+  out->format = TC001_FMT_U16;
+  out->data = (const uint8_t*)r->img;
+  out->frame_id = r->frame_id;
+  out->timestamp_ns = r->timestamp_ns;
+  if (info) {
+    info->exact = r->invalid == 0;
+    info->keyframe = r->key;
+    info->tiles = r->got;
+    info->complete = complete;
+  }
+}
+
+/* Checks r->pkt and returns its frame header, or NULL. */
+static const uint8_t* parse(const tc001_udp_receiver* r) {
+  if (r->pkt_len < HEADERS || (r->pkt[0] & 0xC0) != 0x80 || (r->pkt[1] & 0x7F) != TC001_UDP_PAYLOAD_TYPE)
+    return NULL;
+  const uint8_t* h = r->pkt + RTP_HEADER;
+  const int w = (int)get16(h + 12), ht = (int)get16(h + 14), tile = h[16];
+  if (!w || !ht || tile < 4 || tile > 32) return NULL;
+  if ((int)get16(h + 20) > tile_count(w, tile) * tile_count(ht, tile)) return NULL;
+  return h;
+}
+
+/* Sizes the image and tile map for the frame h opens; everything is
+   invalid after a change. */
+static tc001_status frame_begin(tc001_udp_receiver* r, const uint8_t* h) {
+  const int w = (int)get16(h + 12), ht = (int)get16(h + 14), tile = h[16];
+  if (w != r->width || ht != r->height || tile != r->tile) {
+    const int tiles = tile_count(w, tile) * tile_count(ht, tile);
+    uint16_t* img = (uint16_t*)calloc((size_t)w * ht, 2);
+    uint8_t* valid = (uint8_t*)calloc((size_t)tiles, 1);
+    if (!img || !valid) {
+      free(img);
+      free(valid);
+      return TC001_ERR_ALLOC;
+    }
+    free(r->img);
+    free(r->valid);
+    r->img = img;
+    r->valid = valid;
+    r->width = w;
+    r->height = ht;
+    r->tile = tile;
+    r->tiles = r->invalid = tiles;
+  }
+  r->assembling = 1;
+  r->frame_no = get32(h);
+  r->frame_id = get32(h + 24);
+  r->timestamp_ns = (int64_t)((uint64_t)get32(h + 4) | ((uint64_t)get32(h + 8) << 32));
+  r->key = h[17] & FLAG_KEY;
+  r->expected = (int)get16(h + 20);
+  r->got = 0;
+  r->gap = 0;
+  r->last_index = -1;
+  return TC001_OK;
+}
+
+/* Copies the packet's tiles into r->img; 0 if it is malformed. Tiles come
+   in increasing index order. */
+static int apply(tc001_udp_receiver* r, const uint8_t* h) {
+  const int tile = r->tile;
+  const int tiles_x = tile_count(r->width, tile);
+  const uint8_t* p = h + FRAME_HEADER;
+  const uint8_t* end = r->pkt + r->pkt_len;
+  const int n = (int)get16(h + 18);
+  for (int j = 0; j < n; ++j) {
+    if (end - p < 2) return 0;
+    const int i = (int)get16(p);
+    p += 2;
+    if (i >= r->tiles || i <= r->last_index) return 0;
+    const int x0 = (i % tiles_x) * tile, y0 = (i / tiles_x) * tile;
+    const int tw = r->width - x0 < tile ? r->width - x0 : tile;
+    const int th = r->height - y0 < tile ? r->height - y0 : tile;
+    if (end - p < (ptrdiff_t)tw * th * 2) return 0;
+    for (int y = y0; y < y0 + th; ++y) {
+      memcpy(r->img + (size_t)y * r->width + x0, p, (size_t)tw * 2);
+      p += (size_t)tw * 2;
+    }
+    r->invalid -= !r->valid[i];
+    r->valid[i] = 1;
+    r->last_index = i;
+    r->got++;
+  }
+  return 1;
+}
+
+tc001_status tc001_udp_receive(tc001_udp_receiver* r, tc001_frame* out, tc001_udp_frame_info* info,
+                               int timeout_ms) {
+  if (!r || !out) return TC001_ERR_PARAM;
+  const int64_t deadline = tc001__now_ns() + (int64_t)timeout_ms * 1000000;
+  for (;;) {
+    if (!r->held) {
+      const int64_t left = deadline - tc001__now_ns();
+      struct pollfd pfd = { r->fd, POLLIN, 0 };
+      int ready = left > 0 ? poll(&pfd, 1, (int)((left + 999999) / 1000000)) : 0;
+      if (ready < 0 && errno == EINTR) continue;
+      if (ready <= 0) return ready < 0 ? TC001_ERR_IO : TC001_ERR_STATE;
+      ssize_t n = recv(r->fd, r->pkt, PACKET_MAX, 0);
+      if (n < 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        return TC001_ERR_IO;
+      }
+      r->pkt_len = (size_t)n;
+      r->stats.packets++;
+      r->stats.bytes += (uint64_t)n;
+    }
+    r->held = 0;
+    const uint8_t* h = parse(r);
+    if (!h) {
+      r->stats.invalid++;
+      continue;
+    }
+    const uint32_t ssrc = (get16be(r->pkt + 8) << 16) | get16be(r->pkt + 10);
+    const int64_t now = tc001__now_ns();
+    if (r->have_ssrc && ssrc != r->ssrc) {
+      if (now - r->ssrc_seen_ns < SENDER_SILENT_NS) {
+        r->stats.foreign++;       /* a second stream, not to be merged */
+        continue;
+      }
+      /* a new sender (or the same one restarted, with a new sequence):
+         nothing held is its reference */
+      r->have_seq = 0;
+      r->have_no = 0;
+      r->assembling = 0;
+      if (r->valid) invalidate(r, 0, r->tiles);
+      r->stats.sender_changes++;
+    }
+    r->have_ssrc = 1;
+    r->ssrc = ssrc;
+    r->ssrc_seen_ns = now;
+    const uint16_t seq = (uint16_t)get16be(r->pkt + 2);
+    const uint16_t d = r->have_seq ? (uint16_t)(seq - r->next_seq) : 0;
+    if (d >= 0x8000) {            /* behind what was already applied */
+      r->stats.late++;
+      continue;
+    }
+    const uint32_t no = get32(h);
+    if (r->assembling && no != r->frame_no) {
+      r->held = 1;                /* the previous frame lost its tail */
+      finish(r, out, info);
+      return TC001_OK;
+    }
+
+    const int opens = !r->assembling;
+    if (opens) {
+      tc001_status st = frame_begin(r, h);
+      if (st != TC001_OK) return st;
+    }
+    r->have_seq = 1;
+    r->next_seq = (uint16_t)(seq + 1);
+    if (d) {
+      /* The missing packets carried tiles between the last one applied and
+         this packet's first; a whole frame missing could have carried any. */
+      const int next = get16(h + 18) ? (int)get16(h + FRAME_HEADER) : r->tiles;
+      if (opens && r->have_no && no - r->last_no != 1) invalidate(r, 0, r->tiles);
+      else invalidate(r, r->last_index + 1, next < r->tiles ? next : r->tiles);
+      r->stats.lost += d;
+      r->gap = 1;
+    }
+    if (!apply(r, h)) {
+      r->stats.invalid++;
+      r->gap = 1;
+    }
+    if (r->got >= r->expected) {
+      finish(r, out, info);
+      return TC001_OK;
+    }
+  }
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <signal.h>
 #include "tc001.h"
+#include "tc001_rec.h"
 
 #ifdef _WIN32
 #include <windows.h>   // for Sleep
@@ -34,13 +35,10 @@ static void on_frame(const tc001_frame* f, void* user) {
     const int count = f->width * f->height;
     const uint16_t* px = (const uint16_t*)f->data;
 
-    // min/max on raw U16
-    uint16_t lo = 0xFFFF, hi = 0;
-    for (int i = 0; i < count; ++i) {
-        uint16_t v = px[i];
-        if (v < lo) lo = v;
-        if (v > hi) hi = v;
-    }
+    // min/max come with the frame (tc001_enable_stats), else compute them
+    tc001_frame_stats own;
+    const tc001_frame_stats* st = f->stats;
+    if (!st) st = tc001_compute_stats(f, &own) == TC001_OK ? &own : NULL;
 
     // scratch for 8-bit preview
     if (g_u8_cap < count) {
@@ -56,21 +54,28 @@ static void on_frame(const tc001_frame* f, void* user) {
     // show coarse preview (downsample to keep it readable)
     ascii_preview(g_u8, f->width, f->height, /*sx=*/2, /*sy=*/2);
 
-    printf("\nframe: %dx%d fmt=%d  min=%u  max=%u\n",
-           f->width, f->height, f->format, (unsigned)lo, (unsigned)hi);
+    printf("\nframe: %dx%d fmt=%d", f->width, f->height, f->format);
+    if (st) printf("  min=%u  max=%u  median=%u", (unsigned)st->raw_min,
+                   (unsigned)st->raw_max, (unsigned)st->median_raw);
+    putchar('\n');
     fflush(stdout);
 }
 
-int main(void) {
+int main(int argc, char** argv) {
     signal(SIGINT, on_sigint);
 
     tc001_handle* h = NULL;
     char err[256] = {0};
 
-    if (tc001_open(&h, 0, 0, err, sizeof err) != TC001_OK) {
+    // reader [recording]: play a file instead of the camera
+    tc001_status st = argc > 1 ? tc001_open_replay(&h, argv[1], NULL, err, sizeof err)
+                               : tc001_open(&h, 0, 0, err, sizeof err);
+    if (st != TC001_OK) {
         fprintf(stderr, "open failed: %s\n", err);
         return 1;
     }
+    if (tc001_enable_stats(h, 1) != TC001_OK)
+        fprintf(stderr, "stats unavailable, computing them per frame\n");
     if (tc001_start(h, on_frame, NULL, err, sizeof err) != TC001_OK) {
         fprintf(stderr, "start failed: %s\n", err);
         tc001_close(h);
@@ -78,7 +83,7 @@ int main(void) {
     }
 
     printf("Streaming… Ctrl+C to stop.\n");
-    while (running) {
+    while (running && !tc001_replay_done(h)) {
     #ifdef _WIN32
         Sleep(50);
     #else
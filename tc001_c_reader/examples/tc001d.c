@@ -0,0 +1,91 @@
+/* tc001d: serves one camera (or a recording) to local clients.
+
+   tc001d [-s socket] [-n max_clients] [-r recording [-x speed] [-l]]
+
+   Clients subscribe with tc001_daemon_subscribe and read frames from the
+   shared-memory ring they are handed. Run one tc001d per camera, each on
+   its own socket. */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tc001.h"
+#include "tc001_daemon.h"
+#include "tc001_rec.h"
+
+#define STATS_EVERY_MS 5000
+
+static volatile sig_atomic_t running = 1;
+static void on_signal(int signo) { (void)signo; running = 0; }
+
+static void usage(void) {
+    fprintf(stderr, "usage: tc001d [-s socket] [-n max_clients] [-r recording [-x speed] [-l]]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* sock = "/tmp/tc001d.sock";
+    const char* replay = NULL;
+    tc001_replay_options ro = { 1.0, 0, 0, 0 };
+    int max_clients = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-l")) { ro.loop = 1; continue; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "-s")) sock = v;
+        else if (!strcmp(a, "-n")) max_clients = atoi(v);
+        else if (!strcmp(a, "-r")) replay = v;
+        else if (!strcmp(a, "-x")) ro.speed = atof(v);
+        else { usage(); return 2; }
+        ++i;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    tc001_handle* h = NULL;
+    char err[256] = {0};
+    tc001_status st = replay ? tc001_open_replay(&h, replay, &ro, err, sizeof err)
+                             : tc001_open(&h, 0, 0, err, sizeof err);
+    if (st != TC001_OK) {
+        fprintf(stderr, "open failed: %s\n", err);
+        return 1;
+    }
+
+    tc001_daemon_options o = {0};
+    o.socket_path = sock;
+    o.max_clients = max_clients;
+    tc001_daemon* d = NULL;
+    if ((st = tc001_daemon_create(&d, h, &o)) != TC001_OK) {
+        fprintf(stderr, "cannot listen on %s (%d)\n", sock, (int)st);
+        tc001_close(h);
+        return 1;
+    }
+    if (tc001_daemon_start(d, err, sizeof err) != TC001_OK) {
+        fprintf(stderr, "start failed: %s\n", err);
+        tc001_daemon_destroy(d);
+        tc001_close(h);
+        return 1;
+    }
+    printf("tc001d: serving on %s\n", sock);
+
+    int waited = 0;
+    while (running && !tc001_replay_done(h)) {
+        tc001_daemon_serve(d, 100);
+        if ((waited += 100) < STATS_EVERY_MS) continue;   /* roughly; serve may return early */
+        waited = 0;
+        tc001_daemon_stats s;
+        tc001_daemon_get_stats(d, &s);
+        printf("clients %d streams %d frames %llu published %llu, %.1f us/frame, "
+               "attach mean %.0f us max %.0f us, rejected %llu\n",
+               s.clients, s.streams, (unsigned long long)s.frames, (unsigned long long)s.published,
+               s.frames ? s.frame_ns / 1e3 / s.frames : 0.0,
+               s.attaches ? s.attach_ns / 1e3 / s.attaches : 0.0, s.attach_ns_max / 1e3,
+               (unsigned long long)s.rejected);
+        fflush(stdout);
+    }
+
+    tc001_daemon_destroy(d);
+    tc001_close(h);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/* tc001httpd: serves one camera (or a recording) to browsers.
+
+   tc001httpd [-a address] [-p port] [-q quality] [-r recording [-x speed] [-l]]
+
+   Open http://address:port/ for the live view; /stream is the MJPEG
+   stream itself, /frame.jpg one frame and /raw one frame's raw pixels.
+   Binds to 127.0.0.1:8080 unless told otherwise; use -a 0.0.0.0 to serve
+   the LAN. */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tc001.h"
+#include "tc001_http.h"
+#include "tc001_rec.h"
+
+#define STATS_EVERY_MS 5000
+
+static volatile sig_atomic_t running = 1;
+static void on_signal(int signo) { (void)signo; running = 0; }
+
+static void usage(void) {
+    fprintf(stderr, "usage: tc001httpd [-a address] [-p port] [-q quality] [-r recording [-x speed] [-l]]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* replay = NULL;
+    tc001_replay_options ro = { 1.0, 0, 0, 0 };
+    tc001_http_options o = {0};
+    o.port = 8080;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-l")) { ro.loop = 1; continue; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "-a")) o.address = v;
+        else if (!strcmp(a, "-p")) o.port = atoi(v);
+        else if (!strcmp(a, "-q")) o.quality = atoi(v);
+        else if (!strcmp(a, "-r")) replay = v;
+        else if (!strcmp(a, "-x")) ro.speed = atof(v);
+        else { usage(); return 2; }
+        ++i;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    tc001_handle* h = NULL;
+    char err[256] = {0};
+    tc001_status st = replay ? tc001_open_replay(&h, replay, &ro, err, sizeof err)
+                             : tc001_open(&h, 0, 0, err, sizeof err);
+    if (st != TC001_OK) {
+        fprintf(stderr, "open failed: %s\n", err);
+        return 1;
+    }
+    tc001_enable_stats(h, 1);   /* the JPEG AGC reuses the frame's min/max */
+
+    tc001_http* s = NULL;
+    if ((st = tc001_http_create(&s, &o)) != TC001_OK) {
+        fprintf(stderr, "cannot listen on %s:%d (%d)\n", o.address ? o.address : "127.0.0.1", o.port, (int)st);
+        tc001_close(h);
+        return 1;
+    }
+    if (tc001_start(h, tc001_http_on_frame, s, err, sizeof err) != TC001_OK) {
+        fprintf(stderr, "start failed: %s\n", err);
+        tc001_http_destroy(s);
+        tc001_close(h);
+        return 1;
+    }
+    printf("tc001httpd: http://%s:%d/\n", o.address ? o.address : "127.0.0.1", tc001_http_port(s));
+
+    int waited = 0;
+    while (running && !tc001_replay_done(h)) {
+        tc001_http_serve(s, 100);
+        if ((waited += 100) < STATS_EVERY_MS) continue;   /* roughly; serve may return early */
+        waited = 0;
+        tc001_http_stats hs;
+        tc001_http_get_stats(s, &hs);
+        printf("clients %d viewers %d frames %llu encoded %llu (%.0f us), sent %llu dropped %llu, %.1f MB\n",
+               hs.clients, hs.viewers, (unsigned long long)hs.frames, (unsigned long long)hs.encoded,
+               hs.encoded ? hs.encode_ns / 1e3 / hs.encoded : 0.0, (unsigned long long)hs.sent,
+               (unsigned long long)hs.dropped, hs.bytes_sent / 1e6);
+        fflush(stdout);
+    }
+
+    tc001_stop(h);
+    tc001_http_destroy(s);
+    tc001_close(h);
+    return 0;
+}
@@ -0,0 +1,112 @@
+/* tc001udp: forwards a camera's raw frames over UDP, or receives them.
+
+   tc001udp send host port [-t threshold] [-k keyframe_interval] [-r recording [-x speed] [-l]]
+   tc001udp recv port
+
+   The sender only sends the tiles that changed; the receiver prints what
+   arrives once a second. */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc001.h"
+#include "tc001_rec.h"
+#include "tc001_udp.h"
+
+static volatile sig_atomic_t running = 1;
+static void on_signal(int signo) { (void)signo; running = 0; }
+
+static void usage(void) {
+    fprintf(stderr, "usage: tc001udp send host port [-t threshold] [-k keyframe_interval] "
+                    "[-r recording [-x speed] [-l]]\n"
+                    "       tc001udp recv port\n");
+}
+
+static void on_frame(const tc001_frame* f, void* user) {
+    tc001_udp_send((tc001_udp_sender*)user, f);
+}
+
+static int send_main(int argc, char** argv) {
+    tc001_udp_sender_options o = {0};
+    o.host = argv[0];
+    o.port = atoi(argv[1]);
+    const char* replay = NULL;
+    tc001_replay_options ro = { 1.0, 0, 0, 0 };
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-l")) { ro.loop = 1; continue; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "-t")) o.threshold = atoi(v);
+        else if (!strcmp(a, "-k")) o.keyframe_interval = atoi(v);
+        else if (!strcmp(a, "-r")) replay = v;
+        else if (!strcmp(a, "-x")) ro.speed = atof(v);
+        else { usage(); return 2; }
+        ++i;
+    }
+    tc001_udp_sender* s = NULL;
+    if (tc001_udp_sender_create(&s, &o) != TC001_OK) {
+        fprintf(stderr, "bad destination %s:%d\n", o.host, o.port);
+        return 1;
+    }
+    tc001_handle* h = NULL;
+    char err[256] = {0};
+    tc001_status st = replay ? tc001_open_replay(&h, replay, &ro, err, sizeof err)
+                             : tc001_open(&h, 0, 0, err, sizeof err);
+    if (st != TC001_OK || tc001_start(h, on_frame, s, err, sizeof err) != TC001_OK) {
+        fprintf(stderr, "cannot start: %s\n", err);
+        tc001_close(h);
+        tc001_udp_sender_destroy(s);
+        return 1;
+    }
+    while (running && !tc001_replay_done(h)) {
+        sleep(1);
+        tc001_udp_sender_stats ss;
+        tc001_udp_sender_get_stats(s, &ss);
+        printf("frames %llu (%llu keyframes), %.1f%% of tiles, %.1f KB/frame, %.0f us/frame\n",
+               (unsigned long long)ss.frames, (unsigned long long)ss.keyframes,
+               ss.tiles ? 100.0 * ss.tiles_sent / ss.tiles : 0.0,
+               ss.frames ? ss.bytes / 1024.0 / ss.frames : 0.0,
+               ss.frames ? ss.diff_ns / 1e3 / ss.frames : 0.0);
+        fflush(stdout);
+    }
+    tc001_stop(h);
+    tc001_close(h);
+    tc001_udp_sender_destroy(s);
+    return 0;
+}
+
+static int recv_main(const char* port) {
+    tc001_udp_receiver_options o = {0};
+    o.port = atoi(port);
+    tc001_udp_receiver* r = NULL;
+    if (tc001_udp_receiver_create(&r, &o) != TC001_OK) {
+        fprintf(stderr, "cannot bind port %s\n", port);
+        return 1;
+    }
+    unsigned long long frames = 0, exact = 0;
+    while (running) {
+        tc001_frame f;
+        tc001_udp_frame_info info;
+        if (tc001_udp_receive(r, &f, &info, 100) != TC001_OK) continue;
+        exact += (unsigned long long)info.exact;
+        if (++frames % 25) continue;
+        tc001_udp_receiver_stats rs;
+        tc001_udp_receiver_get_stats(r, &rs);
+        printf("frame %u %dx%d: %llu frames, %llu exact, %llu packets lost\n", (unsigned)f.frame_id,
+               f.width, f.height, frames, exact, (unsigned long long)rs.lost);
+        fflush(stdout);
+    }
+    tc001_udp_receiver_destroy(r);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    if (argc >= 4 && !strcmp(argv[1], "send")) return send_main(argc - 2, argv + 2);
+    if (argc == 3 && !strcmp(argv[1], "recv")) return recv_main(argv[2]);
+    usage();
+    return 2;
+}
@@ -8,8 +8,18 @@
 #include <string.h>
 #include <time.h>
 
-// OpenCV for streaming/display
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// OpenCV for display only; rendering and the MJPG stream are the library's
 #include <opencv2/opencv.hpp>
+#include "tc001_render.h"
+#include "tc001_snapshot.h"
 
 // Raw sensor dimensions
 #define RAW_W        256
@@ -17,139 +27,306 @@
 #define PIXEL_COUNT  (RAW_W * RAW_H)
 #define FRAME_SIZE   (PIXEL_COUNT * 2)
 
-#define CLOCK_MONOTONIC 1 // Use monotonic clock for timing
-
 // Output dimensions (rotated 90° CW)
 #define IMAGE_WIDTH  RAW_H   // 192
 #define IMAGE_HEIGHT RAW_W   // 256
+#define RGB_BYTES    (PIXEL_COUNT * 3)
+
+#define REPORT_EVERY 100     // frames between stage latency reports
+
+static int64_t now_ns(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 // --------------------------------------------------------------------
-// Simple OpenCV‐based streamer
+// Latest-frame mailbox
+//
+// The posting thread fills `back`, then swaps it with `pending`
+// under a lock held only for the pointer swap, so posting never waits for
+// a stage. A stage swaps `pending` into `front` and works on that. A frame
+// still pending when the next one is posted is overwritten: each stage
+// drops frames on its own when it falls behind.
 // --------------------------------------------------------------------
-static cv::VideoWriter _writer;
-static bool            _writer_init = false;
-
-static void stream_frame(const uint8_t* rgb)
-{
-    // wrap raw RGB into an OpenCV Mat (height, width, 3 channels)
-    cv::Mat frame(IMAGE_HEIGHT,
-                  IMAGE_WIDTH,
-                  CV_8UC3,
-                  const_cast<uint8_t*>(rgb));
-
-    // lazily initialize VideoWriter (MJPG @ 25fps -> "stream.avi")
-    if (! _writer_init) {
-        int fourcc = cv::VideoWriter::fourcc('M','J','P','G');
-        double fps = 25.0;
-        _writer.open("stream.avi", fourcc, fps,
-                     cv::Size(IMAGE_WIDTH, IMAGE_HEIGHT), true);
-        if (! _writer.isOpened()) {
-            fprintf(stderr, "⚠️  Could not open video writer\n");
-        }
-        _writer_init = true;
+struct stage_stats {
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> latency_sum_ns{0};   // post -> stage finished
+    std::atomic<int64_t>  latency_max_ns{0};
+    std::atomic<uint64_t> work_sum_ns{0};      // time inside the stage
+};
+
+struct image_writer;
+
+struct mailbox {
+    uint8_t* back    = nullptr;   // owned by the posting thread
+    uint8_t* pending = nullptr;
+    uint8_t* front   = nullptr;   // owned by the stage thread
+    int64_t  pending_ts = 0;
+    bool     fresh = false;
+    bool     stop  = false;
+    std::mutex              m;
+    std::condition_variable cv;
+    std::thread             worker;
+    stage_stats             stats;
+};
+
+static bool mailbox_init(mailbox* mb, size_t bytes)
+{
+    mb->back    = (uint8_t*)malloc(bytes);
+    mb->pending = (uint8_t*)malloc(bytes);
+    mb->front   = (uint8_t*)malloc(bytes);
+    return mb->back && mb->pending && mb->front;
+}
+
+static void mailbox_post(mailbox* mb, int64_t ts)
+{
+    {
+        std::lock_guard<std::mutex> lk(mb->m);
+        if (mb->fresh) mb->stats.dropped++;
+        uint8_t* t = mb->pending; mb->pending = mb->back; mb->back = t;
+        mb->pending_ts = ts;
+        mb->fresh = true;
     }
+    mb->cv.notify_one();
+}
+
+// Blocks until a frame is pending; false once stopped.
+static bool mailbox_take(mailbox* mb, int64_t* ts)
+{
+    std::unique_lock<std::mutex> lk(mb->m);
+    mb->cv.wait(lk, [mb] { return mb->fresh || mb->stop; });
+    if (!mb->fresh) return false;
+    uint8_t* t = mb->front; mb->front = mb->pending; mb->pending = t;
+    *ts = mb->pending_ts;
+    mb->fresh = false;
+    return true;
+}
+
+// Non-blocking mailbox_take, for a stage pumped by its caller.
+static bool mailbox_poll(mailbox* mb, int64_t* ts)
+{
+    std::lock_guard<std::mutex> lk(mb->m);
+    if (!mb->fresh) return false;
+    uint8_t* t = mb->front; mb->front = mb->pending; mb->pending = t;
+    *ts = mb->pending_ts;
+    mb->fresh = false;
+    return true;
+}
+
+typedef void (*stage_fn)(image_writer* w, const uint8_t* buf, int64_t posted);
+
+static void stage_run(image_writer* w, mailbox* mb, stage_fn work, int64_t posted)
+{
+    int64_t t0 = now_ns();
+    work(w, mb->front, posted);
+    int64_t t1 = now_ns();
+    stage_stats* s = &mb->stats;
+    s->work_sum_ns += (uint64_t)(t1 - t0);
+    s->latency_sum_ns += (uint64_t)(t1 - posted);
+    if (t1 - posted > s->latency_max_ns) s->latency_max_ns = t1 - posted;
+    s->done++;
+}
 
-    // write to file/stream
-    if (_writer.isOpened()) {
-        _writer.write(frame);
+static void stage_loop(image_writer* w, mailbox* mb, stage_fn work)
+{
+    int64_t posted;
+    while (mailbox_take(mb, &posted)) stage_run(w, mb, work, posted);
+}
+
+// Stops the worker (if any) and frees the buffers.
+static void mailbox_stop(mailbox* mb)
+{
+    {
+        std::lock_guard<std::mutex> lk(mb->m);
+        mb->stop = true;
     }
+    mb->cv.notify_one();
+    if (mb->worker.joinable()) mb->worker.join();
+    free(mb->back);
+    free(mb->pending);
+    free(mb->front);
+    mb->back = mb->pending = mb->front = nullptr;
+}
 
-    // display on screen
-    cv::imshow("Thermal Camera", frame);
-    cv::waitKey(1);  // needed to refresh the window
+static void report_stage(const char* name, mailbox* mb)
+{
+    stage_stats* s = &mb->stats;
+    uint64_t n = s->done;
+    if (!n) return;
+    printf("  %-7s done=%llu dropped=%llu latency mean=%.1fms max=%.1fms work mean=%.1fms\n",
+           name, (unsigned long long)n, (unsigned long long)s->dropped.load(),
+           s->latency_sum_ns / (double)n / 1e6, s->latency_max_ns / 1e6,
+           s->work_sum_ns / (double)n / 1e6);
 }
 
-static void save_bmp(const char* fname, const uint8_t* rgb) {
-    uint32_t row_bytes = IMAGE_WIDTH * 3;
-    uint32_t pad_size  = (4 - (row_bytes % 4)) % 4;
-    uint32_t data_size = (row_bytes + pad_size) * IMAGE_HEIGHT;
-    uint32_t file_size = 54 + data_size;
-
-    uint8_t file_hdr[14] = {
-        'B','M',
-        file_size & 0xFF, (file_size>>8)&0xFF,
-        (file_size>>16)&0xFF, (file_size>>24)&0xFF,
-        0,0, 0,0,
-        54,0,0,0
-    };
-    uint8_t info_hdr[40] = {
-        40,0,0,0,
-        IMAGE_WIDTH & 0xFF, (IMAGE_WIDTH>>8)&0xFF,
-        (IMAGE_WIDTH>>16)&0xFF, (IMAGE_WIDTH>>24)&0xFF,
-        IMAGE_HEIGHT & 0xFF, (IMAGE_HEIGHT>>8)&0xFF,
-        (IMAGE_HEIGHT>>16)&0xFF, (IMAGE_HEIGHT>>24)&0xFF,
-        1,0, 24,0
-    };
-
-    FILE* f = fopen(fname, "wb");
-    if (!f) return;
-    fwrite(file_hdr, 1, 14, f);
-    fwrite(info_hdr, 1, 40, f);
-
-    uint8_t pad[3] = {0,0,0};
-    for (int y = IMAGE_HEIGHT - 1; y >= 0; y--) {
-        fwrite(rgb + (size_t)y * row_bytes, 1, row_bytes, f);
-        fwrite(pad, 1, pad_size, f);
+// --------------------------------------------------------------------
+// Writer: capture thread -> encoder stage (render, record) -> display
+// stage (OpenCV, run by image_writer_pump). Everything a camera needs
+// lives here; the display list is the only state writers share.
+// --------------------------------------------------------------------
+struct image_writer {
+    tc001_render_ctx* render = nullptr;   // used by the encoder thread only
+    std::string       window;
+    mailbox           enc_box;            // raw 16-bit frames
+    mailbox           disp_box;           // rendered RGB
+    uint32_t          idx = 0;            // frames posted by the capture path
+};
+
+static void encode_frame(image_writer* w, const uint8_t* raw, int64_t posted)
+{
+    tc001_frame f = {};
+    f.width  = RAW_W;
+    f.height = RAW_H;
+    f.stride = RAW_W * 2;
+    f.format = TC001_FMT_U16;
+    f.data   = raw;
+
+    tc001_render_image img;
+    tc001_status st = tc001_render_frame(w->render, &f, &img);
+    if (st == TC001_ERR_ALLOC || st == TC001_ERR_PARAM) return;
+    if (st != TC001_OK) fprintf(stderr, "⚠️  Could not write video frame (%d)\n", (int)st);
+    if (img.flat) {
+        fprintf(stderr, "⚠️ Frame %u is flat (min=%u max=%u)\n", img.index, img.raw_min, img.raw_max);
+    } else {
+        printf("Frame %u: min=%u max=%u\n", img.index, img.raw_min, img.raw_max);
     }
-    fclose(f);
+
+    if (w->window.empty()) return;
+    memcpy(w->disp_box.back, img.rgb, RGB_BYTES);
+    mailbox_post(&w->disp_box, posted);
 }
 
-void process_frame(const uint8_t* raw, int size) {
-    // 1) Read raw 16-bit pixels
-    uint16_t* pixels = malloc(PIXEL_COUNT * sizeof(uint16_t));
-    if (!pixels) return;
-    int count = size/2;
-    if (count > PIXEL_COUNT) count = PIXEL_COUNT;
-    for (int i = 0; i < count; i++) {
-        pixels[i] = raw[2*i] | (raw[2*i+1] << 8);
+static void display_frame(image_writer* w, const uint8_t* rgb, int64_t)
+{
+    cv::Mat frame(IMAGE_HEIGHT, IMAGE_WIDTH, CV_8UC3, const_cast<uint8_t*>(rgb));
+    cv::imshow(w->window.c_str(), frame);
+}
+
+// HighGUI must be driven from one thread (the main one on macOS), so the
+// display stages of all writers are run by image_writer_pump.
+static std::mutex                 displays_m;
+static std::vector<image_writer*> displays;
+
+int image_writer_pump(int wait_ms)
+{
+    {
+        std::lock_guard<std::mutex> lk(displays_m);
+        for (image_writer* w : displays) {
+            int64_t posted;
+            if (mailbox_poll(&w->disp_box, &posted)) stage_run(w, &w->disp_box, display_frame, posted);
+        }
     }
+    return cv::waitKey(wait_ms > 0 ? wait_ms : 1);  // also refreshes the windows
+}
 
-    // 2) Find min/max
-    uint16_t mn = UINT16_MAX, mx = 0;
-    for (int i = 0; i < count; i++) {
-        if (pixels[i] < mn) mn = pixels[i];
-        if (pixels[i] > mx) mx = pixels[i];
+image_writer* image_writer_open(const char* avi_path, const char* window)
+{
+    image_writer* w = new image_writer;
+    tc001_render_options o = {};
+    o.rotation = 90;
+    o.avi_path = avi_path;
+    o.fps      = 25.0;
+    o.quality  = 90;
+    if (window) w->window = window;
+    bool ok = tc001_render_create(&w->render, &o) == TC001_OK &&
+              mailbox_init(&w->enc_box, FRAME_SIZE) &&
+              (!window || mailbox_init(&w->disp_box, RGB_BYTES));
+    if (!ok) {
+        fprintf(stderr, "⚠️  Could not open image writer\n");
+        image_writer_close(w);
+        return nullptr;
     }
-    int flat = (mn == mx);
+    w->enc_box.worker = std::thread(stage_loop, w, &w->enc_box, encode_frame);
+    if (window) {
+        std::lock_guard<std::mutex> lk(displays_m);
+        displays.push_back(w);
+    }
+    return w;
+}
+
+void image_writer_print_report(image_writer* w)
+{
+    if (!w) return;
+    report_stage("encode", &w->enc_box);
+    report_stage("display", &w->disp_box);
+}
 
-    // 3) Build grayscale RGB (raw orientation)
-    uint8_t* rgb_raw = malloc(PIXEL_COUNT * 3);
-    if (!rgb_raw) { free(pixels); return; }
+void image_writer_close(image_writer* w)
+{
+    if (!w) return;
+    {
+        std::lock_guard<std::mutex> lk(displays_m);
+        for (size_t i = 0; i < displays.size(); ++i)
+            if (displays[i] == w) { displays.erase(displays.begin() + i); break; }
+    }
+    // the encoder posts to the display stage, so it stops first
+    mailbox_stop(&w->enc_box);
+    mailbox_stop(&w->disp_box);
+    if (w->render && tc001_render_destroy(w->render) != TC001_OK)
+        fprintf(stderr, "⚠️  Video file may be incomplete\n");
+    w->render = nullptr;
+    image_writer_print_report(w);
+    delete w;
+}
+
+void image_writer_process(image_writer* w, const uint8_t* raw, int size)
+{
+    if (!w) return;
+    int64_t t_in = now_ns();
+
+    // Raw little-endian 16-bit pixels; a short frame is padded with its
+    // minimum so the AGC range is unchanged
+    uint16_t* px = (uint16_t*)w->enc_box.back;
+    int count = size / 2;
+    if (count > PIXEL_COUNT) count = PIXEL_COUNT;
+    if (count <= 0) return;
+    uint16_t mn = UINT16_MAX;
     for (int i = 0; i < count; i++) {
-        uint8_t g = flat
-                  ? (uint8_t)(pixels[i] & 0xFF)
-                  : (uint8_t)(255.0 * (pixels[i] - mn) / (mx - mn));
-        rgb_raw[3*i + 0] = g;
-        rgb_raw[3*i + 1] = g;
-        rgb_raw[3*i + 2] = g;
+        px[i] = raw[2*i] | (raw[2*i+1] << 8);
+        if (count < PIXEL_COUNT && px[i] < mn) mn = px[i];
     }
-    free(pixels);
-
-    // 4) Allocate rotated buffer (rotated 90° CW)
-    uint8_t* rgb_rot = malloc(PIXEL_COUNT * 3);
-    if (!rgb_rot) { free(rgb_raw); return; }
-
-    // 5) Rotate: raw(r,c) -> rot(c, RAW_H-1-r)
-    for (int r = 0; r < RAW_H; r++) {
-        for (int c = 0; c < RAW_W; c++) {
-            int src_i = r * RAW_W + c;
-            int dst_row = c;
-            int dst_col = (RAW_H - 1) - r;
-            int dst_i = dst_row * IMAGE_WIDTH + dst_col;
-            memcpy(&rgb_rot[3*dst_i], &rgb_raw[3*src_i], 3);
-        }
+    for (int i = count; i < PIXEL_COUNT; i++) px[i] = mn;
+
+    // Hand off to the encoder stage; it cannot block us
+    mailbox_post(&w->enc_box, t_in);
+    w->idx++;
+
+    if (w->idx % REPORT_EVERY == 0) {
+        printf("capture: %.2fms in process_frame\n", (now_ns() - t_in) / 1e6);
+        image_writer_print_report(w);
     }
-    free(rgb_raw);
+}
 
-    // 6) Stream instead of saving BMP
-    static int idx = 0;
-    if (flat) {
-        fprintf(stderr, "⚠️ Frame %d is flat (min=%u max=%u)\n", idx, mn, mx);
-    } else {
-        printf("Frame %d: min=%u max=%u\n", idx, mn, mx);
+// --------------------------------------------------------------------
+// Single-camera shorthands
+// --------------------------------------------------------------------
+static image_writer* _default;
+static bool          _default_tried = false;
+
+void process_frame(const uint8_t* raw, int size)
+{
+    if (!_default && !_default_tried) {
+        _default_tried = true;
+        _default = image_writer_open("stream.avi", "Thermal Camera");
     }
-    stream_frame(rgb_rot);
-    idx++;
+    image_writer_process(_default, raw, size);
+}
+
+void image_writer_report(void)
+{
+    image_writer_print_report(_default);
+}
 
-    free(rgb_rot);
+void image_writer_shutdown(void)
+{
+    image_writer_close(_default);
+    _default = nullptr;
+    _default_tried = false;
+}
+
+static void save_bmp(const char* fname, const uint8_t* rgb) {
+    // assembled in one buffer and written with a single call
+    tc001_snapshot_save_rgb(fname, rgb, IMAGE_WIDTH, IMAGE_HEIGHT, IMAGE_WIDTH * 3, TC001_SNAP_BMP);
 }
@@ -2,6 +2,45 @@
 #define IMAGE_WRITER_H
 
 #include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One camera's preview: its own render context, video file and encoder
+// thread. Each camera can feed its own writer from its own capture thread;
+// the windows of all writers are drawn by image_writer_pump, which the
+// application calls from its main thread (HighGUI is single-threaded).
+typedef struct image_writer image_writer;
+
+// Records to avi_path (MJPG @ 25fps) and shows frames in a window titled
+// window; either may be NULL to skip it. NULL on failure.
+image_writer* image_writer_open(const char* avi_path, const char* window);
+
+// Copies one raw 256x192 frame and hands it to the writer's encoder
+// thread, which renders and records it and passes it on for display.
+// Never waits for either stage.
+void image_writer_process(image_writer* w, const uint8_t* raw_frame, int size);
+
+// Shows the newest rendered frame of every writer with a window, then
+// runs the HighGUI event loop for wait_ms (at least 1). Main thread only;
+// call it in the application's loop. Returns the key pressed, or -1.
+int image_writer_pump(int wait_ms);
+
+// Prints per-stage counts, drops and latency.
+void image_writer_print_report(image_writer* w);
+
+// Stops both stages, closes the video file and frees w.
+void image_writer_close(image_writer* w);
+
+// Single-camera shorthands over a writer opened on first use, recording
+// to "stream.avi" and showing "Thermal Camera".
 void process_frame(const uint8_t* raw_frame, int size);
+void image_writer_report(void);
+void image_writer_shutdown(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
 
 #endif // IMAGE_WRITER_H